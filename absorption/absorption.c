@@ -0,0 +1,88 @@
+#include "absorption.h"
+#include "../cell/cell.h"
+#include <stdlib.h>
+
+/**
+ * @brief Computes the absorption probabilities by Gauss-Seidel sweeps.
+ * @param graph The graph
+ * @param partition Partition of the graph
+ * @param vertex_to_class Mapping vertex -> class
+ * @param links Links between classes
+ * @param eps Convergence threshold
+ * @param max_iter Maximum number of sweeps
+ * @param result Output
+ * @return 0 on success, -1 on error
+ */
+int ComputeAbsorption(t_adjacency_list graph, const t_partition *partition, const int *vertex_to_class,
+                      t_link_array *links, float eps, int max_iter, t_absorption *result) {
+    if (!partition || !vertex_to_class || !links || !result || max_iter <= 0) return -1;
+    int n = graph.size;
+
+    // one column per persistent class
+    int *column = (int *)malloc(partition->nb_class * sizeof(int)); // class -> column, -1 if transient
+    if (!column) return -1;
+    int k = 0;
+    for (int c = 0; c < partition->nb_class; c++) {
+        column[c] = is_class_persistent(c, links) ? k++ : -1;
+    }
+
+    result->nb_vertices = n;
+    result->nb_targets = k;
+    result->iterations = 0;
+    result->target_class = (int *)malloc((k > 0 ? k : 1) * sizeof(int));
+    result->prob = (float *)calloc((size_t)n * (k > 0 ? k : 1), sizeof(float));
+    if (!result->target_class || !result->prob) {
+        free(column);
+        FreeAbsorption(result);
+        return -1;
+    }
+    for (int c = 0; c < partition->nb_class; c++) {
+        if (column[c] >= 0) result->target_class[column[c]] = c;
+    }
+
+    // a vertex of a persistent class is absorbed in its own class
+    for (int v = 0; v < n; v++) {
+        int c = vertex_to_class[v];
+        if (c >= 0 && column[c] >= 0) result->prob[(size_t)v * k + column[c]] = 1.0f;
+    }
+
+    // Gauss-Seidel sweeps over the transient vertices, in partition order
+    for (int it = 0; it < max_iter && k > 0; it++) {
+        float max_change = 0.0f;
+        for (int c = 0; c < partition->nb_class; c++) {
+            if (column[c] >= 0) continue;
+            const t_class *cls = partition->classes[c];
+            for (int i = 0; i < cls->nb_vertices; i++) {
+                int v = cls->vertices[i] - 1;
+                float *row = result->prob + (size_t)v * k;
+                for (int t = 0; t < k; t++) {
+                    float sum = 0.0f;
+                    for (t_cell *e = graph.array[v].head; e != NULL; e = e->next) {
+                        if (e->arrival < 1 || e->arrival > n) continue;
+                        sum += e->probability * result->prob[(size_t)(e->arrival - 1) * k + t];
+                    }
+                    float change = sum > row[t] ? sum - row[t] : row[t] - sum;
+                    if (change > max_change) max_change = change;
+                    row[t] = sum;
+                }
+            }
+        }
+        result->iterations = it + 1;
+        if (max_change < eps) break;
+    }
+
+    free(column);
+    return 0;
+}
+
+/**
+ * @brief Frees the arrays of an absorption result.
+ * @param result The result to free
+ */
+void FreeAbsorption(t_absorption *result) {
+    if (result == NULL) return;
+    free(result->target_class);
+    free(result->prob);
+    result->target_class = NULL;
+    result->prob = NULL;
+}
@@ -0,0 +1,49 @@
+#ifndef ABSORPTION_H
+#define ABSORPTION_H
+
+#include "../adjacency_list/adjacency_list.h"
+#include "../tarjan/tarjan.h"
+#include "../hasse/hasse.h"
+
+/**
+ * @brief Absorption probabilities of a Markov graph.
+ *
+ * prob[v * nb_targets + k] is the probability that the chain started in
+ * vertex v+1 ends up in the persistent class target_class[k].
+ */
+typedef struct s_absorption {
+    int nb_vertices;   // number of vertices of the graph
+    int nb_targets;    // number of persistent classes
+    int *target_class; // class index (in the partition) of each column
+    float *prob;       // row-major nb_vertices x nb_targets
+    int iterations;    // number of Gauss-Seidel sweeps done
+} t_absorption;
+
+/**
+ * @brief Computes the probability of being absorbed in each persistent class.
+ *
+ * Vertices of a persistent class are fixed (1 for their own class, 0 for the
+ * others); the transient vertices are solved by Gauss-Seidel sweeps of
+ * x(v) = sum_w p(v,w) x(w). The sweeps follow the partition order: tarjan()
+ * produces the classes in reverse topological order, so the successors of a
+ * class are updated before it and one sweep is exact on the class DAG.
+ *
+ * @param graph The graph
+ * @param partition Partition of the graph (from tarjan)
+ * @param vertex_to_class Mapping vertex -> class (from create_vertex_class_array)
+ * @param links Links between classes (from list_class_links)
+ * @param eps Convergence threshold on the largest change of a sweep
+ * @param max_iter Maximum number of sweeps
+ * @param result Output (free with FreeAbsorption)
+ * @return 0 on success, -1 on error
+ */
+int ComputeAbsorption(t_adjacency_list graph, const t_partition *partition, const int *vertex_to_class,
+                      t_link_array *links, float eps, int max_iter, t_absorption *result);
+
+/**
+ * @brief Frees the arrays of an absorption result.
+ * @param result The result to free
+ */
+void FreeAbsorption(t_absorption *result);
+
+#endif //ABSORPTION_H
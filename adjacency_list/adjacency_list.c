@@ -36,27 +36,67 @@ t_adjacency_list* empty_adjacency_list(int size) {
 
 
 void display_adjacency_list(p_adjacency_list p_adj_list) {
-    // check if the adjacency list pointer is NULL
-    if (p_adj_list == NULL) {
-        // nothing to display if the structure does not exist
-        return;
-    }
+    t_writer w;
+    writer_init(&w, stdout, 0);
+    write_adjacency_list(&w, p_adj_list, NULL);
+    writer_close(&w);
+}
 
-    // check if the internal array is NULL
-    if (p_adj_list->array == NULL) {
+/**
+ * @brief Writes the complete adjacency list
+ * @param w Destination writer
+ * @param p_adj_list Pointer to the adjacency list
+ * @param ids External ids of the vertices, NULL to print the vertex numbers
+ */
+void write_adjacency_list(t_writer *w, const t_adjacency_list *p_adj_list, const t_id_map *ids) {
+    // nothing to display if the structure or its array does not exist
+    if (p_adj_list == NULL || p_adj_list->array == NULL) {
         return;
     }
 
     // loop through all vertices in the graph
     for (int i = 0; i < p_adj_list->size; i++) {
 
-        // display the index of the current vertex
-        printf("List for vertex %d : ", i + 1);
+        // display the id of the current vertex
+        writer_puts(w, "List for vertex ");
+        write_vertex_id(w, ids, i + 1);
+        writer_puts(w, " : [head @] -> ");
 
-        // display the linked list of outgoing edges for this vertex
-        DisplayList(p_adj_list->array[i]);
+        // display the linked list of outgoing edges, same layout as DisplayList()
+        for (t_cell *curr = p_adj_list->array[i].head; curr != NULL; curr = curr->next) {
+            writer_char(w, '(');
+            write_vertex_id(w, ids, curr->arrival);
+            writer_puts(w, ", ");
+            writer_fixed(w, curr->probability, 2);
+            writer_puts(w, curr->next != NULL ? ") @-> " : ")");
+        }
 
         // move to the next line after printing the list
-        printf("\n");
+        writer_char(w, '\n');
+    }
+}
+
+/**
+ * @brief Frees every cell and the list array of an adjacency list
+ * @param p_adj_list Pointer to the adjacency list
+ * @note The structure itself is not freed since graphs are usually passed by value
+ */
+void free_adjacency_list(p_adjacency_list p_adj_list) {
+    if (p_adj_list == NULL || p_adj_list->array == NULL) {
+        return;
     }
+
+    // free the linked list of outgoing edges of each vertex
+    for (int i = 0; i < p_adj_list->size; i++) {
+        t_cell *curr = p_adj_list->array[i].head;
+        while (curr != NULL) {
+            t_cell *next = curr->next;
+            free(curr);
+            curr = next;
+        }
+    }
+
+    free(p_adj_list->array);
+    p_adj_list->array = NULL;
+    p_adj_list->size = 0;
 }
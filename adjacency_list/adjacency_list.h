@@ -2,6 +2,8 @@
 #define ADJACENCY_LIST_H
 
 #include "../list/list.h"
+#include "../writer/writer.h"
+#include "../idmap/idmap.h"
 
 
 /**
@@ -25,4 +27,18 @@ t_adjacency_list* empty_adjacency_list(int size);
  */
 void display_adjacency_list(p_adjacency_list p_adj_list);
 
+/**
+ * @brief Writes the adjacency list in the format of display_adjacency_list()
+ * @param w Destination writer
+ * @param p_adj_list Adjacency list to write
+ * @param ids External ids of the vertices, NULL to print the vertex numbers
+ */
+void write_adjacency_list(t_writer *w, const t_adjacency_list *p_adj_list, const t_id_map *ids);
+
+/**
+ * @brief Frees every cell and the list array of an adjacency list
+ * @param p_adj_list Adjacency list to clear (the structure itself is not freed)
+ */
+void free_adjacency_list(p_adjacency_list p_adj_list);
+
 #endif //ADJACENCY_LIST_H
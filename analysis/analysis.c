@@ -0,0 +1,646 @@
+#include "analysis.h"
+#include "../utils/utils.h"
+#include "../spectral/spectral.h"
+#include "../sparse/sparse.h"
+#include "../status/status.h"
+#include "../scheduler/scheduler.h"
+#include <stdatomic.h>
+#include <stdlib.h>
+#include <string.h>
+
+/**
+ * @brief Default options: stationary vectors, eps = 1e-6, automatic cap, one thread.
+ * @return The options
+ */
+t_analysis_options DefaultAnalysisOptions(void) {
+    t_analysis_options options = { ANALYSIS_STATIONARY, 1e-6f, 0, 1 };
+    return options;
+}
+
+/**
+ * @brief Analyses one class through its view. When known is given (same
+ *        inner edges, same options), its period is taken instead of being
+ *        computed again; its SLEM, lazy choice and iteration cap are taken
+ *        too only with same_values (same probabilities), as they depend on
+ *        the probabilities and not only on the edges. dense, if given, is
+ *        the class matrix the period is computed on (a matrix passed by the
+ *        caller is not necessarily strongly connected).
+ */
+static int analyze_class(const t_sparse_view *V, p_matrix dense, const t_analysis_options *options, const float *guess,
+                         const t_stationary_entry *known, int same_values, t_class_analysis *result) {
+    if (V == NULL || options == NULL || result == NULL) return MARKOV_ERR_ARG;
+    result->size = V->size;
+    result->period = 0;
+    result->slem = -1.0f;
+    result->lazy = 0;
+    result->max_iter = 0;
+    result->iterations = 0;
+    result->stationary = NULL;
+
+    if (options->flags & ANALYSIS_PERIOD) {
+        result->period = known ? known->period : dense ? getPeriod(dense) : GetPeriodFromView(V);
+    }
+    if (!(options->flags & ANALYSIS_STATIONARY)) return MARKOV_OK;
+
+    // the SLEM tells how fast the power method converges; a value of 1 means
+    // another eigenvalue on the unit circle (periodic), so the lazy walk is solved instead
+    const t_stationary_entry *solved = same_values ? known : NULL;
+    result->slem = solved ? solved->slem : EstimateSLEMFromView(V, 0);
+    result->lazy = solved ? solved->lazy
+                          : (options->flags & ANALYSIS_FORCE_LAZY) || result->period > 1 || result->slem >= 1.0f - 1e-6f;
+
+    result->max_iter = solved ? solved->max_iter : options->max_iter;
+    if (result->max_iter <= 0) {
+        // the SLEM above is the one of the walk solved unless it is lazy: no second estimate
+        result->max_iter = result->lazy ? SuggestIterationCapFromView(V, 1, options->eps)
+                                        : IterationCapFromSLEM(result->slem, options->eps);
+        if (result->max_iter < 0) result->max_iter = 10000;
+    }
+    // the lazy walk is applied on the fly, no class matrix is built; a class
+    // of at most SMALL_MATRIX_MAX vertices is solved by the small kernels
+    result->stationary = StationaryVectorFromView(V, guess, result->lazy, result->max_iter, options->eps, &result->iterations);
+    return MARKOV_OK;
+}
+
+/**
+ * @brief analyze_class() on a dense class matrix, through a CSR copy of it.
+ */
+static int analyze_dense_class(p_matrix S, const t_analysis_options *options, const float *guess, t_class_analysis *result) {
+    if (S == NULL || S->size <= 0) return MARKOV_ERR_ARG;
+    p_sparse_matrix CSR = CreateSparseFromMatrix(S);
+    if (CSR == NULL) return MARKOV_ERR_ALLOC;
+    t_sparse_view V = SparseRangeView(CSR, 0, S->size);
+    int status = analyze_class(&V, S, options, guess, NULL, 0, result);
+    DestroySparseMatrix(CSR);
+    return status;
+}
+
+/**
+ * @brief Computes the period and/or the stationary vector of one class matrix.
+ * @param S The class matrix.
+ * @param options What to compute.
+ * @param result Output (free with FreeClassAnalysis).
+ * @return MARKOV_OK or a negative t_markov_status.
+ */
+int AnalyzeClassMatrix(p_matrix S, const t_analysis_options *options, t_class_analysis *result) {
+    return analyze_dense_class(S, options, NULL, result);
+}
+
+/**
+ * @brief Same as AnalyzeClassMatrix(), with the solver started from a guess.
+ * @param S The class matrix.
+ * @param options What to compute.
+ * @param guess Initial vector, NULL for uniform.
+ * @param result Output (free with FreeClassAnalysis).
+ * @return MARKOV_OK or a negative t_markov_status.
+ */
+int AnalyzeClassMatrixFrom(p_matrix S, const t_analysis_options *options, const float *guess, t_class_analysis *result) {
+    return analyze_dense_class(S, options, guess, result);
+}
+
+/**
+ * @brief Mixes the bits of a 64-bit value (splitmix64 finalizer).
+ */
+static uint64_t mix64(uint64_t z) {
+    z = (z ^ (z >> 30)) * 0xbf58476d1ce4e5b9ULL;
+    z = (z ^ (z >> 27)) * 0x94d049bb133111ebULL;
+    return z ^ (z >> 31);
+}
+
+/**
+ * @brief A vertex of a class and its row in the class matrix.
+ */
+typedef struct s_class_vertex {
+    int vertex;
+    int row;
+} t_class_vertex;
+
+static int compare_class_vertex(const void *a, const void *b) {
+    return ((const t_class_vertex *)a)->vertex - ((const t_class_vertex *)b)->vertex;
+}
+
+/**
+ * @brief Sorts the vertices of a class and hashes the sorted list.
+ * @return The key (never 0)
+ */
+static uint64_t class_key(const t_class *cls, t_class_vertex *sorted) {
+    for (int i = 0; i < cls->nb_vertices; i++) {
+        sorted[i].vertex = cls->vertices[i];
+        sorted[i].row = i;
+    }
+    qsort(sorted, cls->nb_vertices, sizeof(t_class_vertex), compare_class_vertex);
+    uint64_t key = (uint64_t)cls->nb_vertices;
+    for (int i = 0; i < cls->nb_vertices; i++) key = mix64(key ^ (uint64_t)sorted[i].vertex);
+    return key ? key : 1;
+}
+
+/**
+ * @brief Fingerprints of a class, read from the adjacency list: one of its
+ *        inner edges, one of the inner edges and their probabilities.
+ *
+ * Each row is hashed in list order and the rows are summed, keyed by their
+ * vertex, so the fingerprints do not depend on the order of the class
+ * vertices. Reordering the edges of a row only causes a miss.
+ */
+static void class_fingerprints(t_adjacency_list graph, const t_class *cls, int *position,
+                               uint64_t *pattern, uint64_t *values) {
+    *pattern = *values = 0;
+    for (int i = 0; i < cls->nb_vertices; i++) position[cls->vertices[i] - 1] = i;
+    for (int i = 0; i < cls->nb_vertices; i++) {
+        uint64_t row = mix64((uint64_t)cls->vertices[i]), row_pattern = row, row_values = row;
+        for (t_cell *e = graph.array[cls->vertices[i] - 1].head; e != NULL; e = e->next) {
+            int j = e->arrival - 1;
+            if (j < 0 || j >= graph.size || position[j] < 0) continue;
+            uint32_t bits;
+            memcpy(&bits, &e->probability, sizeof(bits));
+            if (e->probability != 0.0f) row_pattern = mix64(row_pattern ^ (uint64_t)e->arrival);
+            row_values = mix64(row_values ^ (((uint64_t)e->arrival << 32) | bits));
+        }
+        *pattern += row_pattern;
+        *values += row_values;
+    }
+    for (int i = 0; i < cls->nb_vertices; i++) position[cls->vertices[i] - 1] = -1;
+}
+
+static int same_options(const t_analysis_options *a, const t_analysis_options *b) {
+    return a->flags == b->flags && a->eps == b->eps && a->max_iter == b->max_iter;
+}
+
+/**
+ * @brief Slot of a class in the cache: the slot holding it, or the empty slot where it goes.
+ */
+static int find_entry(const t_stationary_cache *cache, uint64_t key, const t_class_vertex *sorted, int size) {
+    int mask = cache->nb_slots - 1;
+    int s = (int)(key & (uint64_t)mask);
+    while (cache->entries[s].key != 0) {
+        const t_stationary_entry *e = &cache->entries[s];
+        if (e->key == key && e->size == size) {
+            int k = 0;
+            while (k < size && e->vertices[k] == sorted[k].vertex) k++;
+            if (k == size) return s;
+        }
+        s = (s + 1) & mask;
+    }
+    return s;
+}
+
+/**
+ * @brief Moves the entries used by the current run into a table of nb_slots
+ *        slots and frees the others.
+ * @return 0 on success, -1 on allocation error (the cache is left unchanged)
+ */
+static int rebuild_cache(t_stationary_cache *cache, int nb_slots) {
+    t_stationary_entry *entries = (t_stationary_entry *)calloc(nb_slots, sizeof(t_stationary_entry));
+    if (entries == NULL) return -1;
+    int nb_entries = 0;
+    for (int s = 0; s < cache->nb_slots; s++) {
+        t_stationary_entry *e = &cache->entries[s];
+        if (e->key == 0) continue;
+        if (e->run != cache->run) {
+            free(e->vertices);
+            free(e->stationary);
+            continue;
+        }
+        int t = (int)(e->key & (uint64_t)(nb_slots - 1));
+        while (entries[t].key != 0) t = (t + 1) & (nb_slots - 1);
+        entries[t] = *e;
+        nb_entries++;
+    }
+    free(cache->entries);
+    cache->entries = entries;
+    cache->nb_slots = nb_slots;
+    cache->nb_entries = nb_entries;
+    return 0;
+}
+
+/**
+ * @brief Puts a class in an empty cache slot, without results yet, so that
+ *        the next classes cannot take the same slot.
+ * @return MARKOV_OK or MARKOV_ERR_ALLOC
+ */
+static int reserve_entry(t_stationary_cache *cache, int slot, uint64_t key, const t_class_vertex *sorted, int size) {
+    t_stationary_entry *e = &cache->entries[slot];
+    e->vertices = (int *)malloc(size * sizeof(int));
+    if (e->vertices == NULL) return MARKOV_ERR_ALLOC;
+    for (int k = 0; k < size; k++) e->vertices[k] = sorted[k].vertex;
+    e->key = key;
+    e->size = size;
+    e->run = cache->run;
+    cache->nb_entries++;
+    return MARKOV_OK;
+}
+
+/**
+ * @brief Per-class work of AnalyzeGraphCached(), prepared sequentially and
+ *        run by the worker threads.
+ */
+typedef struct s_class_task {
+    int cls;                         // class index in the partition
+    int size;                        // number of vertices (largest classes go first)
+    t_analysis_options options;      // options of this class
+    int slot;                        // cache slot, -1 without cache
+    uint64_t pattern;                // fingerprints saved with the results
+    uint64_t values;
+    const t_stationary_entry *known; // entry with the same inner edges, or NULL
+    int same_values;                 // 1 if known also has the same probabilities
+    t_class_vertex *sorted;          // sorted vertices (part of a shared array)
+    float *guess;                    // start vector, NULL for uniform (part of a shared array)
+    int status;
+} t_class_task;
+
+static int compare_task_size(const void *a, const void *b) {
+    return ((const t_class_task *)b)->size - ((const t_class_task *)a)->size;
+}
+
+/**
+ * @brief Looks a class up in the cache. If nothing changed, its results are
+ *        copied and 0 is returned; otherwise the task is filled in (start
+ *        vector, known entry, reserved slot) and 1 is returned.
+ * @return 0, 1 or a negative t_markov_status
+ */
+static int prepare_class(t_adjacency_list graph, const t_class *cls, int *position, t_stationary_cache *cache,
+                         t_class_task *task, t_class_analysis *ca) {
+    int n = cls->nb_vertices;
+    uint64_t key = class_key(cls, task->sorted);
+    class_fingerprints(graph, cls, position, &task->pattern, &task->values);
+    task->slot = find_entry(cache, key, task->sorted, n);
+    t_stationary_entry *e = &cache->entries[task->slot];
+    const t_analysis_options *options = &task->options;
+
+    if (e->key == 0) {
+        cache->cold++;
+        task->guess = NULL;
+        return reserve_entry(cache, task->slot, key, task->sorted, n) == MARKOV_OK ? 1 : MARKOV_ERR_ALLOC;
+    }
+    e->run = cache->run;
+    int same = same_options(&e->options, options) && e->pattern == task->pattern;
+
+    if (same && e->values == task->values && (e->stationary || !(options->flags & ANALYSIS_STATIONARY))) {
+        // nothing changed: copy the saved results
+        ca->size = n;
+        ca->period = e->period;
+        ca->slem = e->slem;
+        ca->lazy = e->lazy;
+        ca->max_iter = e->max_iter;
+        ca->iterations = 0;
+        ca->stationary = NULL;
+        if (e->stationary) {
+            ca->stationary = (float *)malloc(n * sizeof(float));
+            if (ca->stationary == NULL) return MARKOV_ERR_ALLOC;
+            for (int k = 0; k < n; k++) ca->stationary[task->sorted[k].row] = e->stationary[k];
+        }
+        cache->reused++;
+        return 0;
+    }
+
+    // start from the previous vector of the same class, in the current row order
+    task->known = same ? e : NULL;
+    task->same_values = same && e->values == task->values;
+    if (e->stationary) {
+        for (int k = 0; k < n; k++) task->guess[task->sorted[k].row] = e->stationary[k];
+        cache->warm++;
+    } else {
+        task->guess = NULL;
+        cache->cold++;
+    }
+    return 1;
+}
+
+/**
+ * @brief Saves the results of a class in its (reserved) cache slot.
+ * @return MARKOV_OK or MARKOV_ERR_ALLOC
+ */
+static int store_entry(t_stationary_cache *cache, const t_class_task *task, const t_class_analysis *ca) {
+    t_stationary_entry *e = &cache->entries[task->slot];
+    free(e->stationary);
+    e->stationary = NULL;
+    if (ca->stationary) {
+        e->stationary = (float *)malloc(ca->size * sizeof(float));
+        if (e->stationary == NULL) return MARKOV_ERR_ALLOC;
+        for (int k = 0; k < ca->size; k++) e->stationary[k] = ca->stationary[task->sorted[k].row];
+    }
+    e->pattern = task->pattern;
+    e->values = task->values;
+    e->options = task->options;
+    e->period = ca->period;
+    e->slem = ca->slem;
+    e->lazy = ca->lazy;
+    e->max_iter = ca->max_iter;
+    return MARKOV_OK;
+}
+
+/**
+ * @brief Shared state of the threads that run the class tasks.
+ */
+typedef struct s_class_pool {
+    const t_sparse_matrix *S;     // the whole graph, read through class views
+    const int *position;          // position of each vertex in its class
+    const t_partition *partition;
+    t_class_task *tasks;   // sorted by decreasing size
+    int nb_tasks;
+    atomic_int next;       // next task to take
+    t_class_analysis *results;
+} t_class_pool;
+
+/**
+ * @brief Takes tasks until there is none left. Every class is read in place
+ *        from the shared matrix, results go to the slot of their class.
+ */
+static void class_worker_run(void *arg) {
+    t_class_pool *pool = (t_class_pool *)arg;
+    int i;
+    while ((i = atomic_fetch_add(&pool->next, 1)) < pool->nb_tasks) {
+        t_class_task *task = &pool->tasks[i];
+        t_sparse_view V = SparseClassView(pool->S, pool->partition->classes[task->cls], pool->position);
+        task->status = analyze_class(&V, NULL, &task->options, task->guess, task->known,
+                                     task->same_values, &pool->results[task->cls]);
+    }
+}
+
+/**
+ * @brief Runs the tasks with nb_threads runners on the current scheduler (the
+ *        calling thread is one of them). Without a scheduler, a temporary one
+ *        is started; if that fails, the calling thread does all the work.
+ */
+static void run_class_tasks(t_class_pool *pool, int nb_threads) {
+    if (nb_threads > pool->nb_tasks) nb_threads = pool->nb_tasks;
+    t_scheduler *s = scheduler_current();
+    t_scheduler *own = NULL;
+    if (s == NULL && nb_threads > 1) s = own = scheduler_create(nb_threads);
+
+    t_task_group group;
+    task_group_init(&group);
+    for (int k = 1; s && k < nb_threads; k++) scheduler_spawn(s, &group, class_worker_run, pool);
+    class_worker_run(pool);
+    scheduler_wait(s, &group);
+    scheduler_destroy(own);
+}
+
+/**
+ * @brief Number of cache slots (power of 2) for count entries, at most half full.
+ */
+static int cache_slots_for(int count) {
+    int nb_slots = 16;
+    while (nb_slots < 2 * count) nb_slots <<= 1;
+    return nb_slots;
+}
+
+/**
+ * @brief Classifies a graph and analyses each of its classes, without printing.
+ * @param graph The graph.
+ * @param options What to compute (NULL for the defaults).
+ * @param result Output (free with FreeGraphAnalysis).
+ * @return MARKOV_OK or a negative t_markov_status.
+ */
+int AnalyzeGraph(t_adjacency_list graph, const t_analysis_options *options, t_graph_analysis *result) {
+    return AnalyzeGraphCached(graph, options, NULL, result);
+}
+
+/**
+ * @brief Initializes an empty cache.
+ * @param cache The cache.
+ */
+void InitStationaryCache(t_stationary_cache *cache) {
+    if (cache != NULL) memset(cache, 0, sizeof(*cache));
+}
+
+/**
+ * @brief Fills the class part of a result from its partition and links.
+ * @param result Result whose partition, vertex_to_class and links are set;
+ *        the results of a previous classes[] array are freed.
+ * @return MARKOV_OK, MARKOV_ERR_ALLOC or MARKOV_ERR_ARG.
+ */
+int ClassifyGraphAnalysis(t_graph_analysis *result) {
+    if (result == NULL || result->partition == NULL) return MARKOV_ERR_ARG;
+    int nb_class = result->partition->nb_class;
+    if (result->classes != NULL) {
+        for (int c = 0; c < nb_class; c++) FreeClassAnalysis(&result->classes[c]);
+    }
+    free(result->classes);
+    result->classes = (t_class_analysis *)calloc(nb_class > 0 ? nb_class : 1, sizeof(t_class_analysis));
+    int *transient = classify_classes(result->partition, &result->links);
+    if (result->classes == NULL || transient == NULL) {
+        free(transient);
+        return MARKOV_ERR_ALLOC;
+    }
+
+    result->irreducible = nb_class == 1;
+    result->nb_absorbing = 0;
+    for (int c = 0; c < nb_class; c++) {
+        t_class_analysis *ca = &result->classes[c];
+        ca->size = result->partition->classes[c]->nb_vertices;
+        ca->persistent = !transient[c];
+        ca->absorbing = ca->persistent && ca->size == 1;
+        ca->slem = -1.0f;
+        result->nb_absorbing += ca->absorbing;
+    }
+    free(transient);
+    return MARKOV_OK;
+}
+
+/**
+ * @brief The per-class part of AnalyzeGraphCached(). The previous per-class
+ *        results are dropped first; on error the class results are left
+ *        partly filled, the classification is kept.
+ * @param S CSR matrix of the graph without duplicates, NULL to build one.
+ * @return MARKOV_OK or a negative t_markov_status.
+ */
+static int analyze_graph_classes(t_adjacency_list graph, const t_sparse_matrix *S, const t_analysis_options *options,
+                                 t_stationary_cache *cache, t_graph_analysis *result) {
+    int nb_class = result->partition->nb_class;
+    for (int c = 0; c < nb_class; c++) {
+        t_class_analysis *ca = &result->classes[c];
+        FreeClassAnalysis(ca);
+        ca->period = 0;
+        ca->slem = -1.0f;
+        ca->lazy = 0;
+        ca->max_iter = 0;
+        ca->iterations = 0;
+    }
+    if (!(options->flags & (ANALYSIS_PERIOD | ANALYSIS_STATIONARY))) return MARKOV_OK;
+
+    // position[] maps a vertex to its row in a class matrix; with a cache,
+    // sorted[] and guess[] give each class a segment for its sorted vertices
+    // and its start vector (the classes are disjoint, n entries are enough)
+    t_class_task *tasks = (t_class_task *)calloc(nb_class > 0 ? nb_class : 1, sizeof(t_class_task));
+    int *position = (int *)malloc((graph.size > 0 ? graph.size : 1) * sizeof(int));
+    t_class_vertex *sorted = cache ? (t_class_vertex *)malloc(graph.size * sizeof(t_class_vertex)) : NULL;
+    float *guess = cache ? (float *)malloc(graph.size * sizeof(float)) : NULL;
+    // room for one new entry per class, the entries of the last run are still there
+    int status = MARKOV_OK;
+    if (cache && cache->nb_slots < 2 * (cache->nb_entries + nb_class)) {
+        status = rebuild_cache(cache, cache_slots_for(cache->nb_entries + nb_class)) == 0 ? MARKOV_OK : MARKOV_ERR_ALLOC;
+    }
+    if (tasks == NULL || position == NULL || (cache && (sorted == NULL || guess == NULL)) || status != MARKOV_OK) {
+        free(tasks);
+        free(position);
+        free(sorted);
+        free(guess);
+        return MARKOV_ERR_ALLOC;
+    }
+    for (int v = 0; v < graph.size; v++) position[v] = -1;
+    if (cache) cache->run++;
+
+    // cache lookups, in class order: they modify the cache, so they are not shared
+    int nb_tasks = 0, offset = 0;
+    for (int c = 0; c < nb_class && status == MARKOV_OK; c++) {
+        t_class_analysis *ca = &result->classes[c];
+        t_class_task *task = &tasks[nb_tasks];
+        memset(task, 0, sizeof(*task));
+        task->cls = c;
+        task->size = ca->size;
+        task->slot = -1;
+        task->options = *options;
+        // stationary distributions only exist on persistent classes
+        if (!ca->persistent && !(options->flags & ANALYSIS_ALL_CLASSES)) task->options.flags &= ~ANALYSIS_STATIONARY;
+        if (!(task->options.flags & (ANALYSIS_PERIOD | ANALYSIS_STATIONARY))) continue;
+
+        int todo = 1;
+        if (cache) {
+            task->sorted = sorted + offset;
+            task->guess = guess + offset;
+            offset += ca->size;
+            todo = prepare_class(graph, result->partition->classes[c], position, cache, task, ca);
+            if (todo < 0) status = todo;
+        }
+        if (todo > 0) nb_tasks++;
+    }
+    free(position);
+
+    // the solves, largest classes first so that a big class does not start
+    // last and keep one thread busy alone; every class is a view of one CSR
+    // matrix of the graph (an edge given twice keeps its last value, as in
+    // the dense matrices) instead of a dense copy of its own
+    if (status == MARKOV_OK && nb_tasks > 0) {
+        qsort(tasks, nb_tasks, sizeof(t_class_task), compare_task_size);
+        p_sparse_matrix own = NULL;
+        if (S == NULL) {
+            S = own = CreateSparseFromAdjList(graph);
+            if (own != NULL && SparseRemoveDuplicates(own) != 0) {
+                DestroySparseMatrix(own);
+                S = own = NULL;
+            }
+        }
+        int *class_position = CreateClassPositions(result->partition, graph.size);
+        if (S == NULL || class_position == NULL) {
+            status = MARKOV_ERR_ALLOC;
+        } else {
+            t_class_pool pool = { S, class_position, result->partition, tasks, nb_tasks, 0, result->classes };
+            run_class_tasks(&pool, options->nb_threads);
+        }
+        DestroySparseMatrix(own);
+        free(class_position);
+    }
+    for (int i = 0; i < nb_tasks && status == MARKOV_OK; i++) {
+        status = tasks[i].status;
+        if (status == MARKOV_OK && cache) status = store_entry(cache, &tasks[i], &result->classes[tasks[i].cls]);
+    }
+    free(tasks);
+    free(sorted);
+    free(guess);
+
+    // drop the classes that disappeared
+    if (cache && status == MARKOV_OK) {
+        int alive = 0;
+        for (int s = 0; s < cache->nb_slots; s++) alive += cache->entries[s].key != 0 && cache->entries[s].run == cache->run;
+        if (alive < cache->nb_entries && rebuild_cache(cache, cache_slots_for(alive)) != 0) status = MARKOV_ERR_ALLOC;
+    }
+    return status;
+}
+
+/**
+ * @brief Runs the period / stationary part of AnalyzeGraph() on a classified result.
+ * @param graph The graph.
+ * @param S CSR matrix of the graph without duplicates, NULL to build one.
+ * @param options What to compute (NULL for the defaults).
+ * @param result Classified result, its class results are replaced.
+ * @return MARKOV_OK or a negative t_markov_status.
+ */
+int AnalyzeGraphClasses(t_adjacency_list graph, const t_sparse_matrix *S, const t_analysis_options *options,
+                        t_graph_analysis *result) {
+    if (result == NULL || result->partition == NULL || result->classes == NULL) return MARKOV_ERR_ARG;
+    t_analysis_options defaults = DefaultAnalysisOptions();
+    if (options == NULL) options = &defaults;
+    int status = analyze_graph_classes(graph, S, options, NULL, result);
+    if (status != MARKOV_OK) {
+        for (int c = 0; c < result->partition->nb_class; c++) FreeClassAnalysis(&result->classes[c]);
+    }
+    return status;
+}
+
+/**
+ * @brief AnalyzeGraph() reusing the results of the previous calls.
+ * @param graph The graph.
+ * @param options What to compute (NULL for the defaults).
+ * @param cache Results of the previous calls, updated (may be NULL).
+ * @param result Output (free with FreeGraphAnalysis).
+ * @return MARKOV_OK or a negative t_markov_status.
+ */
+int AnalyzeGraphCached(t_adjacency_list graph, const t_analysis_options *options, t_stationary_cache *cache,
+                       t_graph_analysis *result) {
+    if (result == NULL) return MARKOV_ERR_ARG;
+    t_analysis_options defaults = DefaultAnalysisOptions();
+    if (options == NULL) options = &defaults;
+
+    memset(result, 0, sizeof(*result));
+    links_init(&result->links);
+    result->nb_vertices = graph.size;
+
+    result->partition = tarjan(graph);
+    if (result->partition == NULL) return MARKOV_ERR_ALLOC;
+
+    result->vertex_to_class = create_vertex_class_array(graph.size, result->partition);
+    if (result->vertex_to_class == NULL
+        || list_class_links(&graph, result->vertex_to_class, &result->links) != 0
+        || ClassifyGraphAnalysis(result) != MARKOV_OK) {
+        FreeGraphAnalysis(result);
+        return MARKOV_ERR_ALLOC;
+    }
+
+    int status = analyze_graph_classes(graph, NULL, options, cache, result);
+    if (status != MARKOV_OK) FreeGraphAnalysis(result);
+    return status;
+}
+
+/**
+ * @brief Frees the stationary vector of a class result.
+ * @param result The result to free.
+ */
+void FreeClassAnalysis(t_class_analysis *result) {
+    if (result == NULL) return;
+    free(result->stationary);
+    result->stationary = NULL;
+}
+
+/**
+ * @brief Frees the entries of a cache.
+ * @param cache The cache.
+ */
+void FreeStationaryCache(t_stationary_cache *cache) {
+    if (cache == NULL) return;
+    for (int s = 0; s < cache->nb_slots; s++) {
+        free(cache->entries[s].vertices);
+        free(cache->entries[s].stationary);
+    }
+    free(cache->entries);
+    InitStationaryCache(cache);
+}
+
+/**
+ * @brief Frees everything owned by a graph result.
+ * @param result The result to free.
+ */
+void FreeGraphAnalysis(t_graph_analysis *result) {
+    if (result == NULL) return;
+    if (result->classes && result->partition) {
+        for (int c = 0; c < result->partition->nb_class; c++) FreeClassAnalysis(&result->classes[c]);
+    }
+    free(result->classes);
+    free(result->vertex_to_class);
+    free(result->links.links);
+    DestroyPartition(result->partition);
+    result->classes = NULL;
+    result->vertex_to_class = NULL;
+    result->partition = NULL;
+    links_init(&result->links);
+}
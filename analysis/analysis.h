@@ -0,0 +1,219 @@
+#ifndef ANALYSIS_H
+#define ANALYSIS_H
+
+#include <stdint.h>
+#include "../adjacency_list/adjacency_list.h"
+#include "../tarjan/tarjan.h"
+#include "../hasse/hasse.h"
+#include "../matrix/matrix.h"
+#include "../sparse/sparse.h"
+
+/**
+ * @brief What AnalyzeGraph() / AnalyzeClassMatrix() compute.
+ */
+enum {
+    ANALYSIS_PERIOD = 1 << 0,       // period of each class (gcd of its breadth-first levels, O(edges))
+    ANALYSIS_STATIONARY = 1 << 1,   // stationary vector of each persistent class
+    ANALYSIS_ALL_CLASSES = 1 << 2,  // also solve the transient classes (substochastic)
+    ANALYSIS_FORCE_LAZY = 1 << 3    // always solve the lazy walk 0.5(M + I)
+};
+
+/**
+ * @brief Options of an analysis.
+ */
+typedef struct s_analysis_options {
+    unsigned flags;  // ANALYSIS_* flags
+    float eps;       // tolerance of the stationary solver
+    int max_iter;    // iteration cap of the solver, 0 = from the spectral gap
+    int nb_threads;  // threads for the per-class work (<= 1 = the calling thread only)
+} t_analysis_options;
+
+/**
+ * @brief Results for one class.
+ */
+typedef struct s_class_analysis {
+    int size;          // number of vertices of the class
+    int persistent;    // 1 if no edge leaves the class
+    int absorbing;     // 1 if persistent with a single vertex
+    int period;        // period of the class, 0 if not computed
+    float slem;        // SLEM estimate of the class matrix, -1 if not computed
+    int lazy;          // 1 if the stationary vector was solved on the lazy walk
+    int max_iter;      // iteration cap given to the solver
+    int iterations;    // power iterations done, 0 if the vector came from a cache
+    float *stationary; // stationary vector in the order of the class vertices, NULL if
+                       // not computed or if the solver did not reach eps within
+                       // max_iter iterations (iterations == max_iter then)
+} t_class_analysis;
+
+/**
+ * @brief Results for a whole graph.
+ */
+typedef struct s_graph_analysis {
+    int nb_vertices;            // number of vertices of the graph
+    p_partition partition;      // classes, in tarjan() order
+    int *vertex_to_class;       // class index of each vertex (0-based)
+    t_link_array links;         // links between classes
+    int irreducible;            // 1 if the graph has a single class
+    int nb_absorbing;           // number of absorbing states
+    t_class_analysis *classes;  // one entry per class of the partition
+} t_graph_analysis;
+
+/**
+ * @brief Saved results of one class, found again by its set of vertices.
+ */
+typedef struct s_stationary_entry {
+    uint64_t key;       // hash of the sorted vertices, 0 = empty slot
+    int size;           // number of vertices
+    int *vertices;      // vertices of the class, sorted
+    uint64_t pattern;   // fingerprint of the edges inside the class
+    uint64_t values;    // fingerprint of the edges and their probabilities
+    t_analysis_options options; // options the results were computed with
+    int period;
+    float slem;
+    int lazy;
+    int max_iter;
+    float *stationary;  // in the order of vertices[], NULL if not computed
+    unsigned run;       // last AnalyzeGraphCached() call that used the entry
+} t_stationary_entry;
+
+/**
+ * @brief Per-class results kept between the analyses of an evolving graph.
+ *
+ * A class whose vertices and inner probabilities did not change reuses its
+ * results; a class whose probabilities changed is solved again starting from
+ * its previous stationary vector, and keeps its period when the set of its
+ * inner edges is the same (its SLEM, lazy choice and iteration cap depend
+ * on the probabilities, so they are computed again).
+ */
+typedef struct s_stationary_cache {
+    t_stationary_entry *entries; // hash table (open addressing)
+    int nb_entries;              // used slots
+    int nb_slots;                // size of the table (power of 2, 0 before the first use)
+    unsigned run;                // number of AnalyzeGraphCached() calls
+    long long reused;            // classes taken from the cache as they were
+    long long warm;              // classes solved from their previous vector
+    long long cold;              // classes solved from scratch
+} t_stationary_cache;
+
+/**
+ * @brief Default options: stationary vectors, eps = 1e-6, automatic cap, one thread.
+ * @return The options
+ */
+t_analysis_options DefaultAnalysisOptions(void);
+
+/**
+ * @brief Computes the period and/or the stationary vector of one class matrix.
+ *
+ * The stationary vector is solved on the lazy walk 0.5(M + I) when the class
+ * is periodic, when its SLEM is 1 or when ANALYSIS_FORCE_LAZY is set. The
+ * iteration cap comes from the spectral gap unless options->max_iter > 0.
+ *
+ * @param S The class matrix.
+ * @param options What to compute.
+ * @param result Output (free with FreeClassAnalysis).
+ * @return MARKOV_OK or a negative t_markov_status.
+ */
+int AnalyzeClassMatrix(p_matrix S, const t_analysis_options *options, t_class_analysis *result);
+
+/**
+ * @brief Same as AnalyzeClassMatrix(), with the stationary solver started
+ *        from a previous solution.
+ *
+ * @param S The class matrix.
+ * @param options What to compute.
+ * @param guess Initial vector in the order of the rows of S, NULL for uniform.
+ * @param result Output (free with FreeClassAnalysis).
+ * @return MARKOV_OK or a negative t_markov_status.
+ */
+int AnalyzeClassMatrixFrom(p_matrix S, const t_analysis_options *options, const float *guess, t_class_analysis *result);
+
+/**
+ * @brief Classifies a graph and analyses each of its classes, without printing.
+ *
+ * Runs tarjan(), the class links and the classification, then the period
+ * and/or stationary computations selected by options->flags. No class
+ * matrix is built: one CSR matrix of the graph is made, and each class is
+ * a view of it (GetPeriodFromView(), EstimateSLEMFromView(),
+ * StationaryVectorFromView() in sparse/sparse.h). With
+ * options->nb_threads > 1 the classes are handed to that many tasks of the
+ * current scheduler (scheduler/scheduler.h; a temporary one is started if
+ * there is none), largest first; the results are the same as with one thread.
+ *
+ * @param graph The graph.
+ * @param options What to compute (NULL for DefaultAnalysisOptions()).
+ * @param result Output (free with FreeGraphAnalysis).
+ * @return MARKOV_OK or a negative t_markov_status.
+ */
+int AnalyzeGraph(t_adjacency_list graph, const t_analysis_options *options, t_graph_analysis *result);
+
+/**
+ * @brief Fills the class part of a result (classes[] with the size and type
+ *        of each class, irreducible, nb_absorbing) from its partition and
+ *        links, the first step of AnalyzeGraph().
+ * @param result Result whose partition, vertex_to_class and links are set;
+ *        a previous classes[] array (one entry per class of that same
+ *        partition) is freed with the results it holds, then replaced.
+ * @return MARKOV_OK, MARKOV_ERR_ALLOC, or MARKOV_ERR_ARG without a partition.
+ */
+int ClassifyGraphAnalysis(t_graph_analysis *result);
+
+/**
+ * @brief Runs the period / stationary part of AnalyzeGraph() on a result
+ *        that is already classified (ClassifyGraphAnalysis()), so that the
+ *        partition and the links of a graph are computed once for several
+ *        analyses (see context/context.h).
+ *
+ * The previous period and stationary results of the classes are dropped.
+ *
+ * @param graph The graph.
+ * @param S CSR matrix of the graph without duplicate edges
+ *        (SparseRemoveDuplicates()), NULL to build one for the call.
+ * @param options What to compute (NULL for DefaultAnalysisOptions()).
+ * @param result Classified result; on error its classification is kept and
+ *        the class results are empty.
+ * @return MARKOV_OK or a negative t_markov_status.
+ */
+int AnalyzeGraphClasses(t_adjacency_list graph, const t_sparse_matrix *S, const t_analysis_options *options,
+                        t_graph_analysis *result);
+
+/**
+ * @brief Initializes an empty cache.
+ * @param cache The cache.
+ */
+void InitStationaryCache(t_stationary_cache *cache);
+
+/**
+ * @brief Same as AnalyzeGraph(), reusing the results of the previous calls
+ *        with the same cache for the classes that did not change.
+ *
+ * The entries of classes that no longer exist are dropped at the end of
+ * the call, so the cache follows the graph as it evolves.
+ *
+ * @param graph The graph.
+ * @param options What to compute (NULL for DefaultAnalysisOptions()).
+ * @param cache Results of the previous calls, updated (NULL = AnalyzeGraph()).
+ * @param result Output (free with FreeGraphAnalysis).
+ * @return MARKOV_OK or a negative t_markov_status.
+ */
+int AnalyzeGraphCached(t_adjacency_list graph, const t_analysis_options *options, t_stationary_cache *cache,
+                       t_graph_analysis *result);
+
+/**
+ * @brief Frees the entries of a cache.
+ * @param cache The cache (may be NULL).
+ */
+void FreeStationaryCache(t_stationary_cache *cache);
+
+/**
+ * @brief Frees the stationary vector of a class result.
+ * @param result The result to free.
+ */
+void FreeClassAnalysis(t_class_analysis *result);
+
+/**
+ * @brief Frees everything owned by a graph result.
+ * @param result The result to free.
+ */
+void FreeGraphAnalysis(t_graph_analysis *result);
+
+#endif //ANALYSIS_H
@@ -0,0 +1,99 @@
+#include "arena.h"
+#include "../profiling/profiling.h"
+#include <stdalign.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define ARENA_DEFAULT_BLOCK (64 * 1024)
+#define ARENA_ALIGN alignof(max_align_t)
+
+// room taken by the header, so the data of a block is aligned too
+#define ARENA_HEADER ((sizeof(t_arena_block) + ARENA_ALIGN - 1) / ARENA_ALIGN * ARENA_ALIGN)
+
+/**
+ * @brief Initializes an empty arena.
+ * @param a The arena
+ * @param block_size Size of its blocks, 0 for the default
+ */
+void arena_init(t_arena *a, size_t block_size) {
+    a->head = NULL;
+    a->current = NULL;
+    a->block_size = block_size > 0 ? block_size : ARENA_DEFAULT_BLOCK;
+}
+
+/**
+ * @brief Allocates size bytes, aligned for any type.
+ * @param a The arena
+ * @param size Number of bytes
+ * @return The memory, NULL on allocation error
+ */
+void *arena_alloc(t_arena *a, size_t size) {
+    size = (size + ARENA_ALIGN - 1) / ARENA_ALIGN * ARENA_ALIGN;
+    if (size == 0) size = ARENA_ALIGN;
+
+    // the next blocks that are already there (after a reset) are tried first
+    t_arena_block *b = a->current;
+    while (b != NULL && b->size - b->used < size) {
+        b = b->next;
+        if (b != NULL) b->used = 0;
+    }
+    if (b == NULL) {
+        size_t bytes = size > a->block_size ? size : a->block_size;
+        if (bytes > SIZE_MAX - ARENA_HEADER) return NULL;
+        b = (t_arena_block *)malloc(ARENA_HEADER + bytes);
+        PROF_COUNT(PROF_ALLOCATIONS, 1);
+        if (b == NULL) return NULL;
+        b->size = bytes;
+        b->used = 0;
+        // the new block goes after the current one, before the unused ones
+        if (a->current == NULL) {
+            b->next = a->head;
+            a->head = b;
+        } else {
+            b->next = a->current->next;
+            a->current->next = b;
+        }
+    }
+    a->current = b;
+    void *p = (char *)b + ARENA_HEADER + b->used;
+    b->used += size;
+    return p;
+}
+
+/**
+ * @brief Same as arena_alloc(), zero-filled.
+ * @return The memory, NULL on error
+ */
+void *arena_calloc(t_arena *a, size_t count, size_t size) {
+    if (size != 0 && count > SIZE_MAX / size) return NULL;
+    void *p = arena_alloc(a, count * size);
+    if (p != NULL) memset(p, 0, count * size);
+    return p;
+}
+
+/**
+ * @brief Forgets every allocation, keeping the blocks.
+ * @param a The arena
+ */
+void arena_reset(t_arena *a) {
+    // the other blocks are cleared when arena_alloc() moves to them
+    a->current = a->head;
+    if (a->head != NULL) a->head->used = 0;
+}
+
+/**
+ * @brief Frees the blocks of an arena.
+ * @param a The arena
+ */
+void arena_free(t_arena *a) {
+    if (a == NULL) return;
+    t_arena_block *b = a->head;
+    while (b != NULL) {
+        t_arena_block *next = b->next;
+        free(b);
+        b = next;
+    }
+    a->head = NULL;
+    a->current = NULL;
+}
@@ -0,0 +1,66 @@
+#ifndef ARENA_H
+#define ARENA_H
+
+#include <stddef.h>
+
+/**
+ * @brief Block of an arena; the memory handed out follows the header.
+ */
+typedef struct s_arena_block {
+    struct s_arena_block *next;
+    size_t size;  // bytes after the header
+    size_t used;
+} t_arena_block;
+
+/**
+ * @brief Bump allocator for scratch data that dies all at once.
+ *
+ * arena_alloc() hands out pieces of large blocks; there is no per-piece
+ * free. arena_reset() makes the whole arena available again but keeps its
+ * blocks, so a loop that resets the arena after each item stops calling
+ * malloc() once the first items have grown it to its working size.
+ * An arena is not thread-safe: use one per thread.
+ */
+typedef struct s_arena {
+    t_arena_block *head;     // first block
+    t_arena_block *current;  // block being filled
+    size_t block_size;       // size of a new block (larger requests get their own)
+} t_arena;
+
+/**
+ * @brief Initializes an empty arena (no memory is allocated yet).
+ * @param a The arena
+ * @param block_size Size of its blocks in bytes, 0 for the default (64 KiB)
+ */
+void arena_init(t_arena *a, size_t block_size);
+
+/**
+ * @brief Allocates size bytes, aligned for any type; the memory is not zeroed.
+ * @param a The arena
+ * @param size Number of bytes
+ * @return The memory, NULL on allocation error
+ */
+void *arena_alloc(t_arena *a, size_t size);
+
+/**
+ * @brief Same as arena_alloc(), zero-filled.
+ * @param a The arena
+ * @param count Number of elements
+ * @param size Size of an element
+ * @return The memory, NULL on allocation error or overflow
+ */
+void *arena_calloc(t_arena *a, size_t count, size_t size);
+
+/**
+ * @brief Forgets every allocation, keeping the blocks for the next ones.
+ * @param a The arena
+ */
+void arena_reset(t_arena *a);
+
+/**
+ * @brief Frees the blocks of an arena.
+ * @param a The arena (may be NULL)
+ */
+void arena_free(t_arena *a);
+
+#endif //ARENA_H
@@ -0,0 +1,388 @@
+#include "batch.h"
+#include "../arena/arena.h"
+#include "../status/status.h"
+#include "../scheduler/scheduler.h"
+#include <limits.h>
+#include <pthread.h>
+#include <stdarg.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define BATCH_DEFAULT_WINDOW 256
+
+/**
+ * @brief One graph of the input: its file (manifest), or its text inside the
+ *        concatenated file (name NULL).
+ */
+typedef struct s_batch_item {
+    const char *name;
+    const char *text;
+    size_t len;
+} t_batch_item;
+
+/**
+ * @brief Output line of one graph, kept until its turn to be written. The
+ *        buffers are reused from one window to the next.
+ */
+typedef struct s_batch_text {
+    char *data;
+    size_t len;
+    size_t cap;
+    int failed;  // the graph could not be analysed
+    int error;   // the line could not be allocated
+} t_batch_text;
+
+/**
+ * @brief Arenas handed to the tasks. A thread waiting inside AnalyzeGraph()
+ *        may run another task, so the arenas are taken per task rather
+ *        than per thread; there are never more tasks at once than graphs
+ *        in a window.
+ */
+typedef struct s_arena_pool {
+    pthread_mutex_t lock;
+    t_arena *arenas;
+    int *free_ids;  // stack of the arenas not in use
+    int nb_free;
+} t_arena_pool;
+
+typedef struct s_batch_job {
+    t_analysis_options analysis;
+    const char *source;         // name of the input file
+    const t_batch_item *items;
+    int first;                  // first graph of the window
+    t_batch_text *texts;        // one per graph of the window
+    t_arena_pool *pool;
+} t_batch_job;
+
+/**
+ * @brief Default options of a batch.
+ * @return The options
+ */
+t_batch_options DefaultBatchOptions(void) {
+    t_batch_options options;
+    options.input = BATCH_MANIFEST;
+    options.analysis = DefaultAnalysisOptions();
+    options.analysis.flags = 0;
+    options.window = 0;
+    return options;
+}
+
+/**
+ * @brief Appends formatted text to an output line.
+ */
+static void text_printf(t_batch_text *t, const char *format, ...) {
+    if (t->error) return;
+    for (;;) {
+        va_list args;
+        va_start(args, format);
+        int n = vsnprintf(t->data ? t->data + t->len : NULL, t->cap - t->len, format, args);
+        va_end(args);
+        if (n < 0) {
+            t->error = 1;
+            return;
+        }
+        if ((size_t)n < t->cap - t->len) {
+            t->len += (size_t)n;
+            return;
+        }
+        size_t cap = t->cap * 2 > t->len + n + 1 ? t->cap * 2 : t->len + n + 1;
+        char *grown = (char *)realloc(t->data, cap);
+        if (grown == NULL) {
+            t->error = 1;
+            return;
+        }
+        t->data = grown;
+        t->cap = cap;
+    }
+}
+
+/**
+ * @brief Reads a whole file, followed by a '\0', into an arena (or with
+ *        malloc() if arena is NULL).
+ * @return The text, NULL on error (status set)
+ */
+static char *read_text(const char *filename, t_arena *arena, size_t *len, int *status) {
+    FILE *file = fopen(filename, "rb");
+    if (file == NULL) {
+        *status = MARKOV_ERR_IO;
+        return NULL;
+    }
+    long size = -1;
+    if (fseek(file, 0, SEEK_END) == 0) size = ftell(file);
+    if (size < 0 || fseek(file, 0, SEEK_SET) != 0) {
+        fclose(file);
+        *status = MARKOV_ERR_IO;
+        return NULL;
+    }
+    char *text = arena ? (char *)arena_alloc(arena, (size_t)size + 1) : (char *)malloc((size_t)size + 1);
+    if (text == NULL) {
+        fclose(file);
+        *status = MARKOV_ERR_ALLOC;
+        return NULL;
+    }
+    *len = fread(text, 1, (size_t)size, file);
+    text[*len] = '\0';
+    fclose(file);
+    return text;
+}
+
+static const char *skip_blanks(const char *p, const char *end) {
+    while (p < end && (*p == ' ' || *p == '\t' || *p == '\r' || *p == '\n' || *p == '\v' || *p == '\f')) p++;
+    return p;
+}
+
+/**
+ * @brief Parses a graph in the format of loadGraph() from text[0, end), the
+ *        lists and the cells in the arena. As in loadGraph(), the edges are
+ *        read until the first line that is not an edge, and each one is put
+ *        at the head of the list of its start vertex.
+ * @return MARKOV_OK or a negative t_markov_status
+ */
+static int parse_graph(const char *p, const char *end, t_arena *arena, t_adjacency_list *graph) {
+    char *next;
+    p = skip_blanks(p, end);
+    if (p >= end) return MARKOV_ERR_FORMAT;
+    long n = strtol(p, &next, 10);
+    if (next == p || n <= 0 || n > INT_MAX) return MARKOV_ERR_FORMAT;
+    p = next;
+
+    graph->size = (int)n;
+    graph->array = (t_std_list *)arena_calloc(arena, (size_t)n, sizeof(t_std_list));
+    if (graph->array == NULL) return MARKOV_ERR_ALLOC;
+    for (;;) {
+        // a token never spans a line, so one that starts before end stops before it
+        p = skip_blanks(p, end);
+        if (p >= end) break;
+        long start = strtol(p, &next, 10);
+        if (next == p) break;
+        p = skip_blanks(next, end);
+        if (p >= end) break;
+        long arrival = strtol(p, &next, 10);
+        if (next == p) break;
+        p = skip_blanks(next, end);
+        if (p >= end) break;
+        float probability = strtof(p, &next);
+        if (next == p) break;
+        p = next;
+
+        if (start < 1 || start > n || arrival < 1 || arrival > n) return MARKOV_ERR_FORMAT;
+        t_cell *cell = (t_cell *)arena_alloc(arena, sizeof(t_cell));
+        if (cell == NULL) return MARKOV_ERR_ALLOC;
+        cell->arrival = (int)arrival;
+        cell->probability = probability;
+        cell->next = graph->array[start - 1].head;
+        graph->array[start - 1].head = cell;
+    }
+    return MARKOV_OK;
+}
+
+/**
+ * @brief Appends an item to a growing array.
+ * @return 0 on success, -1 on allocation error
+ */
+static int add_item(t_batch_item **items, int *count, int *cap, t_batch_item item) {
+    if (*count == *cap) {
+        int grown_cap = *cap > 0 ? *cap * 2 : 64;
+        t_batch_item *grown = (t_batch_item *)realloc(*items, grown_cap * sizeof(t_batch_item));
+        if (grown == NULL) return -1;
+        *items = grown;
+        *cap = grown_cap;
+    }
+    (*items)[(*count)++] = item;
+    return 0;
+}
+
+/**
+ * @brief Cuts the input into graphs: the lines of a manifest (cut in place),
+ *        or the text of each graph of a concatenated file.
+ * @return 0 on success, -1 on allocation error
+ */
+static int split_input(char *text, size_t len, t_batch_input input, t_batch_item **items, int *count) {
+    int cap = 0;
+    *items = NULL;
+    *count = 0;
+    char *line = text, *end = text + len;
+    while (line < end) {
+        char *eol = memchr(line, '\n', (size_t)(end - line));
+        if (eol == NULL) eol = end;
+        char *first = (char *)skip_blanks(line, eol);
+
+        if (input == BATCH_MANIFEST) {
+            // a file name: the line without its surrounding blanks
+            char *last = eol;
+            while (last > first && (last[-1] == ' ' || last[-1] == '\t' || last[-1] == '\r')) last--;
+            if (last > first && *first != '#') {
+                *last = '\0';
+                if (add_item(items, count, &cap, (t_batch_item){ first, NULL, 0 }) != 0) return -1;
+            }
+        } else if (first < eol) {
+            // a line with a single token is the vertex count of a new graph;
+            // anything before the first one is skipped
+            const char *after = first;
+            while (after < eol && *after != ' ' && *after != '\t' && *after != '\r') after++;
+            if (skip_blanks(after, eol) == eol) {
+                if (*count > 0) (*items)[*count - 1].len = (size_t)(line - (*items)[*count - 1].text);
+                if (add_item(items, count, &cap, (t_batch_item){ NULL, line, 0 }) != 0) return -1;
+            }
+        }
+        line = eol + 1;
+    }
+    if (input == BATCH_CONCATENATED && *count > 0) {
+        (*items)[*count - 1].len = (size_t)(end - (*items)[*count - 1].text);
+    }
+    return 0;
+}
+
+/**
+ * @brief Writes the result of one graph after its name.
+ */
+static void format_result(t_batch_text *out, const t_graph_analysis *analysis, unsigned flags) {
+    const t_partition *partition = analysis->partition;
+    text_printf(out, "\t%d\t%d\t%d\t%d", analysis->nb_vertices, partition->nb_class,
+                analysis->nb_absorbing, analysis->irreducible);
+    for (int c = 0; c < partition->nb_class; c++) {
+        const t_class *cls = partition->classes[c];
+        const t_class_analysis *ca = &analysis->classes[c];
+        text_printf(out, "\t%s:%c", cls->name, ca->persistent ? 'P' : 'T');
+        if ((flags & ANALYSIS_PERIOD) && ca->period > 0) text_printf(out, ":p=%d", ca->period);
+        if ((flags & ANALYSIS_STATIONARY) && ca->stationary) {
+            text_printf(out, ":pi=");
+            for (int k = 0; k < cls->nb_vertices; k++) {
+                text_printf(out, "%s%d=%.9g", k > 0 ? "," : "", cls->vertices[k], ca->stationary[k]);
+            }
+        }
+    }
+    text_printf(out, "\n");
+}
+
+/**
+ * @brief Reads, parses and analyses one graph; the arena is reset before.
+ */
+static void analyze_item(const t_batch_job *job, int index, t_arena *arena, t_batch_text *out) {
+    const t_batch_item *item = &job->items[index];
+    out->len = 0;
+    out->failed = 0;
+    if (item->name) text_printf(out, "%s", item->name);
+    else text_printf(out, "%s#%d", job->source, index + 1);
+
+    int status = MARKOV_OK;
+    const char *text = item->text;
+    size_t len = item->len;
+    if (text == NULL) text = read_text(item->name, arena, &len, &status);
+
+    t_adjacency_list graph;
+    t_graph_analysis analysis;
+    if (status == MARKOV_OK) status = parse_graph(text, text + len, arena, &graph);
+    if (status == MARKOV_OK) status = AnalyzeGraph(graph, &job->analysis, &analysis);
+    if (status != MARKOV_OK) {
+        text_printf(out, "\terror=%s\n", markov_strerror(status));
+        out->failed = 1;
+        return;
+    }
+    format_result(out, &analysis, job->analysis.flags);
+    FreeGraphAnalysis(&analysis);
+    // the graph lives in the arena: nothing else to free
+}
+
+/**
+ * @brief Graphs [begin, end) of the window, with one arena of the pool.
+ */
+static void batch_range(void *ctx, int begin, int end) {
+    t_batch_job *job = (t_batch_job *)ctx;
+    t_arena_pool *pool = job->pool;
+    pthread_mutex_lock(&pool->lock);
+    int id = pool->free_ids[--pool->nb_free];
+    pthread_mutex_unlock(&pool->lock);
+
+    for (int i = begin; i < end; i++) {
+        arena_reset(&pool->arenas[id]);
+        analyze_item(job, job->first + i, &pool->arenas[id], &job->texts[i]);
+    }
+
+    pthread_mutex_lock(&pool->lock);
+    pool->free_ids[pool->nb_free++] = id;
+    pthread_mutex_unlock(&pool->lock);
+}
+
+/**
+ * @brief Analyses many small graphs in one process.
+ * @param filename The manifest or the concatenated file
+ * @param options The options
+ * @param out Destination of the lines
+ * @param summary Output counts
+ * @return MARKOV_OK or a negative t_markov_status
+ */
+int AnalyzeBatch(const char *filename, const t_batch_options *options, t_writer *out, t_batch_summary *summary) {
+    if (summary) summary->nb_graphs = summary->nb_failed = 0;
+    if (filename == NULL || out == NULL) return MARKOV_ERR_ARG;
+    t_batch_options opts = options ? *options : DefaultBatchOptions();
+
+    int status = MARKOV_OK;
+    size_t len = 0;
+    char *text = read_text(filename, NULL, &len, &status);
+    if (text == NULL) return status;
+    t_batch_item *items = NULL;
+    int count = 0;
+    if (split_input(text, len, opts.input, &items, &count) != 0) {
+        free(items);
+        free(text);
+        return MARKOV_ERR_ALLOC;
+    }
+
+    int window = opts.window > 0 ? opts.window : BATCH_DEFAULT_WINDOW;
+    if (window > count) window = count > 0 ? count : 1;
+    t_arena_pool pool;
+    pool.arenas = (t_arena *)malloc(window * sizeof(t_arena));
+    pool.free_ids = (int *)malloc(window * sizeof(int));
+    pool.nb_free = window;
+    t_batch_text *texts = (t_batch_text *)calloc(window, sizeof(t_batch_text));
+    if (!pool.arenas || !pool.free_ids || !texts || pthread_mutex_init(&pool.lock, NULL) != 0) {
+        free(pool.arenas);
+        free(pool.free_ids);
+        free(texts);
+        free(items);
+        free(text);
+        return MARKOV_ERR_ALLOC;
+    }
+    for (int i = 0; i < window; i++) {
+        arena_init(&pool.arenas[i], 0);
+        pool.free_ids[i] = i;
+    }
+
+    // the graphs are analysed on their own, the threads go to the graphs
+    t_batch_job job = { opts.analysis, filename, items, 0, texts, &pool };
+    job.analysis.nb_threads = 1;
+    int failed = 0;
+    for (int first = 0; first < count && status == MARKOV_OK; first += window) {
+        int nb = count - first < window ? count - first : window;
+        job.first = first;
+        scheduler_parallel_for(scheduler_current(), 0, nb, 1, batch_range, &job);
+        // in input order, whatever the order the graphs were finished in
+        for (int i = 0; i < nb; i++) {
+            if (texts[i].error) {
+                status = MARKOV_ERR_ALLOC;
+                break;
+            }
+            writer_write(out, texts[i].data, texts[i].len);
+            failed += texts[i].failed;
+        }
+        if (out->error) status = MARKOV_ERR_IO;
+    }
+
+    for (int i = 0; i < window; i++) {
+        arena_free(&pool.arenas[i]);
+        free(texts[i].data);
+    }
+    pthread_mutex_destroy(&pool.lock);
+    free(pool.arenas);
+    free(pool.free_ids);
+    free(texts);
+    free(items);
+    free(text);
+    if (summary) {
+        summary->nb_graphs = count;
+        summary->nb_failed = failed;
+    }
+    return status;
+}
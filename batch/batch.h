@@ -0,0 +1,66 @@
+#ifndef BATCH_H
+#define BATCH_H
+
+#include "../analysis/analysis.h"
+#include "../writer/writer.h"
+
+/**
+ * @brief What the input file of AnalyzeBatch() holds.
+ */
+typedef enum {
+    BATCH_MANIFEST,     // one graph file per line (blank lines and lines starting with '#' skipped)
+    BATCH_CONCATENATED  // graphs one after the other, each starting with its vertex count alone on a line
+} t_batch_input;
+
+/**
+ * @brief Options of a batch.
+ */
+typedef struct s_batch_options {
+    t_batch_input input;          // kind of input file
+    t_analysis_options analysis;  // what to compute for each graph (nb_threads is
+                                  // ignored: the graphs themselves are shared between the threads)
+    int window;                   // graphs analysed between two writes, 0 = default (256)
+} t_batch_options;
+
+/**
+ * @brief Counts of a batch.
+ */
+typedef struct s_batch_summary {
+    int nb_graphs;  // graphs found in the input
+    int nb_failed;  // graphs that could not be read or analysed
+} t_batch_summary;
+
+/**
+ * @brief Default options: manifest input, classes only, eps = 1e-6, default window.
+ * @return The options
+ */
+t_batch_options DefaultBatchOptions(void);
+
+/**
+ * @brief Analyses many small graphs in one process.
+ *
+ * The graphs are shared between the threads of scheduler_current(), one
+ * graph per task. Each task parses its graph from memory into a scratch
+ * arena (the text, the lists and the cells) taken from a pool, and resets
+ * the arena for the next graph, so the lists do not cost one malloc() per
+ * edge. The results are written in input order, one line per graph:
+ *
+ *     name  vertices  classes  absorbing  irreducible  class...
+ *
+ * separated by tabs, where each class is "C1:P" or "C1:T" (persistent or
+ * transient), followed by ":p=<period>" with ANALYSIS_PERIOD and by
+ * ":pi=<vertex>=<probability>,..." with ANALYSIS_STATIONARY (persistent
+ * classes, probabilities with 9 significant digits). A graph that cannot be
+ * read or analysed gives "name  error=<message>". The graphs of a
+ * concatenated file are named file#1, file#2, ...
+ *
+ * @param filename The manifest or the concatenated file
+ * @param options The options (NULL for DefaultBatchOptions())
+ * @param out Destination of the lines
+ * @param summary Output counts (may be NULL)
+ * @return MARKOV_OK (even if some graphs failed), MARKOV_ERR_IO if the input
+ *         cannot be read or the output written, MARKOV_ERR_ALLOC, MARKOV_ERR_ARG
+ */
+int AnalyzeBatch(const char *filename, const t_batch_options *options, t_writer *out, t_batch_summary *summary);
+
+#endif //BATCH_H
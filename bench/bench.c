@@ -0,0 +1,305 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include "generators.h"
+#include "../utils/utils.h"
+#include "../sparse/sparse.h"
+#include "../spectral/spectral.h"
+#include "../analysis/analysis.h"
+#include "../small_matrix/small_matrix.h"
+#include "../status/status.h"
+#include "../profiling/profiling.h"
+
+/**
+ * @brief Stages of the analysis pipeline that are timed.
+ */
+enum {
+    STAGE_READ,
+    STAGE_TARJAN,
+    STAGE_LINKS,
+    STAGE_REDUCE,
+    STAGE_SPARSE,
+    STAGE_PERIOD,
+    STAGE_STATIONARY,
+    STAGE_ANALYZE,
+    NB_STAGES
+};
+
+static const char *stage_names[NB_STAGES] = {
+    "readGraph", "tarjan", "list_class_links", "removeTransitiveLinks",
+    "CreateSparseFromAdjList", "GetPeriodFromView", "stationary", "AnalyzeGraph"
+};
+
+static const char *generator_names[] = { "random", "birthdeath", "grid", "blocks", "dag", "small" };
+#define NB_GENERATORS 6
+
+/**
+ * @brief Command line options of the benchmark.
+ */
+typedef struct s_bench_options {
+    int size;               // approximate number of vertices of each generated graph
+    int repeat;             // number of timed runs of each stage
+    uint64_t seed;          // seed of the generators
+    const char *generator;  // "all" or one of generator_names
+    const char *json;       // JSON output file ("-" for stdout), NULL for none
+    const char *tmp_file;   // file used to time readGraph
+} t_bench_options;
+
+/**
+ * @brief Result of one generator: the timings of every stage for every run.
+ */
+typedef struct s_bench_result {
+    const char *generator;
+    int vertices;
+    int edges;
+    int classes;
+    double *ms[NB_STAGES];
+} t_bench_result;
+
+static int compare_double(const void *a, const void *b) {
+    double x = *(const double *)a, y = *(const double *)b;
+    return (x > y) - (x < y);
+}
+
+/**
+ * @brief Nearest-rank percentile of a sorted array.
+ */
+static double percentile(const double *sorted, int count, double pct) {
+    int rank = (int)ceil(pct / 100.0 * count);
+    if (rank < 1) rank = 1;
+    if (rank > count) rank = count;
+    return sorted[rank - 1];
+}
+
+/**
+ * @brief Builds the graph of a generator with about 'size' vertices.
+ */
+static t_adjacency_list build_graph(const char *name, int size, uint64_t seed) {
+    if (strcmp(name, "random") == 0) return generate_random_sparse(size, 4, seed);
+    if (strcmp(name, "birthdeath") == 0) return generate_birth_death(size, 0.3f, 0.2f);
+    if (strcmp(name, "grid") == 0) {
+        int side = (int)sqrt((double)size);
+        if (side < 1) side = 1;
+        return generate_grid_walk(side, side);
+    }
+    if (strcmp(name, "blocks") == 0) {
+        int block = size < 20 ? size : 20;
+        return generate_block_chain(size / block, block, 0.001f, seed);
+    }
+    if (strcmp(name, "small") == 0) return generate_small_chains(size, SMALL_MATRIX_MAX, seed);
+    // dag: levels of 4 cycles of 5 vertices
+    int depth = size / 20 > 0 ? size / 20 : 1;
+    return generate_scc_dag(depth, 4, 5, seed);
+}
+
+static int count_edges(t_adjacency_list graph) {
+    int edges = 0;
+    for (int i = 0; i < graph.size; i++)
+        for (t_cell *c = graph.array[i].head; c != NULL; c = c->next) edges++;
+    return edges;
+}
+
+/**
+ * @brief Runs every stage of the pipeline once on the graph stored in the temporary file.
+ * @param opt Benchmark options
+ * @param res Result where the timing of run 'run' is stored
+ * @param run Index of the run
+ */
+static void run_pipeline(const t_bench_options *opt, t_bench_result *res, int run) {
+    double t0 = prof_now_ms();
+    t_adjacency_list graph = readGraph(opt->tmp_file);
+    res->ms[STAGE_READ][run] = prof_now_ms() - t0;
+
+    t0 = prof_now_ms();
+    p_partition partition = tarjan(graph);
+    res->ms[STAGE_TARJAN][run] = prof_now_ms() - t0;
+    res->classes = partition->nb_class;
+
+    t0 = prof_now_ms();
+    int *vertex_to_class = create_vertex_class_array(graph.size, partition);
+    t_link_array links;
+    links_init(&links);
+    list_class_links(&graph, vertex_to_class, &links);
+    res->ms[STAGE_LINKS][run] = prof_now_ms() - t0;
+
+    // the transitive reduction works in place: time it on a copy
+    t_link_array reduced = links;
+    reduced.links = (t_link *)malloc((links.size > 0 ? links.size : 1) * sizeof(t_link));
+    if (links.size > 0) memcpy(reduced.links, links.links, links.size * sizeof(t_link));
+    t0 = prof_now_ms();
+    removeTransitiveLinks(&reduced);
+    res->ms[STAGE_REDUCE][run] = prof_now_ms() - t0;
+    free(reduced.links);
+
+    // the stages of AnalyzeGraph(): one CSR matrix, every class read through its view
+    t0 = prof_now_ms();
+    p_sparse_matrix S = CreateSparseFromAdjList(graph);
+    if (S) SparseRemoveDuplicates(S);
+    res->ms[STAGE_SPARSE][run] = prof_now_ms() - t0;
+    int *position = CreateClassPositions(partition, graph.size);
+    int *period = (int *)calloc(partition->nb_class > 0 ? partition->nb_class : 1, sizeof(int));
+
+    t0 = prof_now_ms();
+    for (int c = 0; S && position && period && c < partition->nb_class; c++) {
+        t_sparse_view V = SparseClassView(S, partition->classes[c], position);
+        period[c] = GetPeriodFromView(&V);
+    }
+    res->ms[STAGE_PERIOD][run] = prof_now_ms() - t0;
+
+    // stationary vector of every persistent class, solved as AnalyzeGraph() does
+    t0 = prof_now_ms();
+    for (int c = 0; S && position && period && c < partition->nb_class; c++) {
+        if (!is_class_persistent(c, &links)) continue;
+        t_sparse_view V = SparseClassView(S, partition->classes[c], position);
+        float slem = EstimateSLEMFromView(&V, 0);
+        int lazy = period[c] > 1 || slem >= 1.0f - 1e-6f;
+        int max_it = lazy ? SuggestIterationCapFromView(&V, 1, 1e-6f) : IterationCapFromSLEM(slem, 1e-6f);
+        if (max_it < 0) max_it = 10000;
+        free(StationaryVectorFromView(&V, NULL, lazy, max_it, 1e-6f, NULL));
+    }
+    res->ms[STAGE_STATIONARY][run] = prof_now_ms() - t0;
+    free(period);
+    free(position);
+    DestroySparseMatrix(S);
+
+    // the whole analysis as the CLI and the batch mode run it
+    t_analysis_options options = DefaultAnalysisOptions();
+    options.flags |= ANALYSIS_PERIOD;
+    t_graph_analysis analysis;
+    t0 = prof_now_ms();
+    if (AnalyzeGraph(graph, &options, &analysis) == MARKOV_OK) FreeGraphAnalysis(&analysis);
+    res->ms[STAGE_ANALYZE][run] = prof_now_ms() - t0;
+
+    free(links.links);
+    free(vertex_to_class);
+    DestroyPartition(partition);
+    free_adjacency_list(&graph);
+}
+
+/**
+ * @brief Generates the graph of one generator and times the pipeline 'repeat' times.
+ */
+static int bench_generator(const t_bench_options *opt, const char *name, t_bench_result *res) {
+    memset(res, 0, sizeof(*res));
+    res->generator = name;
+
+    t_adjacency_list graph = build_graph(name, opt->size, opt->seed);
+    if (graph.array == NULL) return -1;
+    res->vertices = graph.size;
+    res->edges = count_edges(graph);
+    int written = write_graph_file(graph, opt->tmp_file);
+    free_adjacency_list(&graph);
+    if (written != 0) {
+        fprintf(stderr, "markov_bench: cannot write '%s'\n", opt->tmp_file);
+        return -1;
+    }
+
+    for (int s = 0; s < NB_STAGES; s++) {
+        res->ms[s] = (double *)calloc(opt->repeat, sizeof(double));
+        if (!res->ms[s]) return -1;
+    }
+    for (int run = 0; run < opt->repeat; run++) run_pipeline(opt, res, run);
+    for (int s = 0; s < NB_STAGES; s++) qsort(res->ms[s], opt->repeat, sizeof(double), compare_double);
+
+    remove(opt->tmp_file);
+    return 0;
+}
+
+static void print_table(const t_bench_options *opt, const t_bench_result *res, int count) {
+    for (int r = 0; r < count; r++) {
+        printf("%s: %d vertices, %d edges, %d classes\n",
+               res[r].generator, res[r].vertices, res[r].edges, res[r].classes);
+        for (int s = 0; s < NB_STAGES; s++) {
+            printf("  %-24s", stage_names[s]);
+            printf("median %10.3f ms   p95 %10.3f ms\n",
+                   percentile(res[r].ms[s], opt->repeat, 50.0),
+                   percentile(res[r].ms[s], opt->repeat, 95.0));
+        }
+        printf("\n");
+    }
+}
+
+static void write_json(FILE *out, const t_bench_options *opt, const t_bench_result *res, int count) {
+    fprintf(out, "{\n  \"benchmark\": \"markov_bench\",\n");
+    fprintf(out, "  \"size\": %d,\n  \"repeat\": %d,\n  \"seed\": %llu,\n",
+            opt->size, opt->repeat, (unsigned long long)opt->seed);
+    fprintf(out, "  \"results\": [\n");
+    for (int r = 0; r < count; r++) {
+        fprintf(out, "    {\"generator\": \"%s\", \"vertices\": %d, \"edges\": %d, \"classes\": %d, \"stages\": {\n",
+                res[r].generator, res[r].vertices, res[r].edges, res[r].classes);
+        for (int s = 0; s < NB_STAGES; s++) {
+            const double *ms = res[r].ms[s];
+            fprintf(out, "      \"%s\": {\"min_ms\": %.6f, \"median_ms\": %.6f, \"p95_ms\": %.6f, \"max_ms\": %.6f}%s\n",
+                    stage_names[s],
+                    ms[0], percentile(ms, opt->repeat, 50.0), percentile(ms, opt->repeat, 95.0),
+                    ms[opt->repeat - 1], s + 1 < NB_STAGES ? "," : "");
+        }
+        fprintf(out, "    }}%s\n", r + 1 < count ? "," : "");
+    }
+    fprintf(out, "  ]\n}\n");
+}
+
+static void usage(const char *prog) {
+    printf("Usage: %s [options]\n", prog);
+    printf("  --size N           approximate number of vertices (default 200)\n");
+    printf("  --repeat R         timed runs per stage (default 5)\n");
+    printf("  --seed S           generator seed (default 1)\n");
+    printf("  --generator NAME   all | random | birthdeath | grid | blocks | dag | small (default all)\n");
+    printf("  --json FILE        write the results as JSON ('-' for stdout)\n");
+    printf("  --tmp FILE         temporary graph file (default markov_bench_graph.txt)\n");
+}
+
+int main(int argc, char **argv) {
+    t_bench_options opt = { 200, 5, 1, "all", NULL, "markov_bench_graph.txt" };
+
+    for (int i = 1; i < argc; i++) {
+        const char *arg = argv[i];
+        const char *val = i + 1 < argc ? argv[i + 1] : NULL;
+        if (strcmp(arg, "--help") == 0 || strcmp(arg, "-h") == 0) { usage(argv[0]); return 0; }
+        if (val == NULL) { usage(argv[0]); return 1; }
+        if (strcmp(arg, "--size") == 0) opt.size = atoi(val);
+        else if (strcmp(arg, "--repeat") == 0) opt.repeat = atoi(val);
+        else if (strcmp(arg, "--seed") == 0) opt.seed = strtoull(val, NULL, 10);
+        else if (strcmp(arg, "--generator") == 0) opt.generator = val;
+        else if (strcmp(arg, "--json") == 0) opt.json = val;
+        else if (strcmp(arg, "--tmp") == 0) opt.tmp_file = val;
+        else { usage(argv[0]); return 1; }
+        i++;
+    }
+    if (opt.size < 1 || opt.repeat < 1) { usage(argv[0]); return 1; }
+
+    t_bench_result results[NB_GENERATORS];
+    int count = 0;
+    for (int g = 0; g < NB_GENERATORS; g++) {
+        if (strcmp(opt.generator, "all") != 0 && strcmp(opt.generator, generator_names[g]) != 0) continue;
+        if (bench_generator(&opt, generator_names[g], &results[count]) != 0) {
+            fprintf(stderr, "markov_bench: generator '%s' failed\n", generator_names[g]);
+            return 1;
+        }
+        count++;
+    }
+    if (count == 0) {
+        fprintf(stderr, "markov_bench: unknown generator '%s'\n", opt.generator);
+        return 1;
+    }
+
+    if (opt.json && strcmp(opt.json, "-") == 0) {
+        write_json(stdout, &opt, results, count);
+    } else {
+        print_table(&opt, results, count);
+        if (opt.json) {
+            FILE *out = fopen(opt.json, "wt");
+            if (!out) {
+                fprintf(stderr, "markov_bench: cannot write '%s'\n", opt.json);
+                return 1;
+            }
+            write_json(out, &opt, results, count);
+            fclose(out);
+        }
+    }
+
+    for (int r = 0; r < count; r++)
+        for (int s = 0; s < NB_STAGES; s++) free(results[r].ms[s]);
+    return 0;
+}
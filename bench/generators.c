@@ -0,0 +1,247 @@
+#include "generators.h"
+#include "../cell/cell.h"
+#include <stdio.h>
+#include <stdlib.h>
+
+/**
+ * @brief xorshift64* step: small and fast pseudo-random generator for the generators.
+ */
+static uint64_t next_random(uint64_t *state) {
+    uint64_t x = *state;
+    x ^= x >> 12;
+    x ^= x << 25;
+    x ^= x >> 27;
+    *state = x;
+    return x * 0x2545f4914f6cdd1dULL;
+}
+
+/**
+ * @brief Uniform integer in [0, bound).
+ */
+static int random_below(uint64_t *state, int bound) {
+    return (int)((next_random(state) >> 33) % (uint64_t)bound);
+}
+
+/**
+ * @brief Uniform float in (0, 1].
+ */
+static float random_unit(uint64_t *state) {
+    return (float)((next_random(state) >> 40) + 1) / 16777216.0f;
+}
+
+/**
+ * @brief Turns a heap allocated adjacency list into a value, like readGraph() does.
+ */
+static t_adjacency_list take_graph(t_adjacency_list *gp) {
+    t_adjacency_list g = { NULL, 0 };
+    if (gp == NULL) return g;
+    g = *gp;
+    free(gp);
+    return g;
+}
+
+/**
+ * @brief Random sparse chain with 'degree' distinct successors per vertex.
+ * @param n Number of vertices
+ * @param degree Number of successors per vertex
+ * @param seed Random seed
+ * @return The generated graph
+ */
+t_adjacency_list generate_random_sparse(int n, int degree, uint64_t seed) {
+    uint64_t state = seed ? seed : 1;
+    if (degree > n) degree = n;
+    t_adjacency_list *gp = empty_adjacency_list(n);
+    if (gp == NULL) return take_graph(NULL);
+
+    int *succ = (int *)malloc(degree * sizeof(int));
+    float *weight = (float *)malloc(degree * sizeof(float));
+    for (int i = 0; i < n && succ && weight; i++) {
+        float sum = 0.0f;
+        for (int d = 0; d < degree; d++) {
+            // draw until the successor is new for this vertex
+            int j, dup;
+            do {
+                j = random_below(&state, n);
+                dup = 0;
+                for (int k = 0; k < d; k++) if (succ[k] == j) dup = 1;
+            } while (dup);
+            succ[d] = j;
+            weight[d] = random_unit(&state);
+            sum += weight[d];
+        }
+        for (int d = 0; d < degree; d++) {
+            addCellToList(&gp->array[i], succ[d] + 1, weight[d] / sum);
+        }
+    }
+    free(succ);
+    free(weight);
+    return take_graph(gp);
+}
+
+/**
+ * @brief Birth-death chain on 1..n.
+ * @param n Number of vertices
+ * @param p Probability to move up
+ * @param q Probability to move down
+ * @return The generated graph
+ */
+t_adjacency_list generate_birth_death(int n, float p, float q) {
+    t_adjacency_list *gp = empty_adjacency_list(n);
+    if (gp == NULL) return take_graph(NULL);
+
+    for (int i = 0; i < n; i++) {
+        float stay = 1.0f;
+        if (i + 1 < n) { addCellToList(&gp->array[i], i + 2, p); stay -= p; }
+        if (i > 0) { addCellToList(&gp->array[i], i, q); stay -= q; }
+        if (stay > 0.0f) addCellToList(&gp->array[i], i + 1, stay);
+    }
+    return take_graph(gp);
+}
+
+/**
+ * @brief Random walk on a grid with reflecting borders.
+ * @param width Number of columns
+ * @param height Number of rows
+ * @return The generated graph
+ */
+t_adjacency_list generate_grid_walk(int width, int height) {
+    t_adjacency_list *gp = empty_adjacency_list(width * height);
+    if (gp == NULL) return take_graph(NULL);
+
+    const int dr[4] = { -1, 1, 0, 0 };
+    const int dc[4] = { 0, 0, -1, 1 };
+    for (int r = 0; r < height; r++) {
+        for (int c = 0; c < width; c++) {
+            int v = r * width + c;
+            float stay = 0.0f;
+            for (int k = 0; k < 4; k++) {
+                int nr = r + dr[k], nc = c + dc[k];
+                // a move across the border is reflected: the walker stays in place
+                if (nr < 0 || nr >= height || nc < 0 || nc >= width) stay += 0.25f;
+                else addCellToList(&gp->array[v], nr * width + nc + 1, 0.25f);
+            }
+            if (stay > 0.0f) addCellToList(&gp->array[v], v + 1, stay);
+        }
+    }
+    return take_graph(gp);
+}
+
+/**
+ * @brief Nearly decomposable chain made of dense blocks.
+ * @param nb_blocks Number of blocks
+ * @param block_size Number of vertices per block
+ * @param coupling Probability of leaving the block
+ * @param seed Random seed
+ * @return The generated graph
+ */
+t_adjacency_list generate_block_chain(int nb_blocks, int block_size, float coupling, uint64_t seed) {
+    uint64_t state = seed ? seed : 1;
+    int n = nb_blocks * block_size;
+    t_adjacency_list *gp = empty_adjacency_list(n);
+    if (gp == NULL) return take_graph(NULL);
+    if (nb_blocks < 2) coupling = 0.0f;
+
+    for (int b = 0; b < nb_blocks; b++) {
+        for (int k = 0; k < block_size; k++) {
+            int v = b * block_size + k;
+            // uniform move inside the block
+            for (int t = 0; t < block_size; t++) {
+                addCellToList(&gp->array[v], b * block_size + t + 1, (1.0f - coupling) / (float)block_size);
+            }
+            // rare jump to a random vertex of another block
+            if (coupling > 0.0f) {
+                int other = (b + 1 + random_below(&state, nb_blocks - 1)) % nb_blocks;
+                addCellToList(&gp->array[v], other * block_size + random_below(&state, block_size) + 1, coupling);
+            }
+        }
+    }
+    return take_graph(gp);
+}
+
+/**
+ * @brief Small chains side by side.
+ * @param n Total number of vertices
+ * @param max_size Largest chain
+ * @param seed Random seed
+ * @return The generated graph
+ */
+t_adjacency_list generate_small_chains(int n, int max_size, uint64_t seed) {
+    uint64_t state = seed ? seed : 1;
+    if (max_size < 2) max_size = 2;
+    t_adjacency_list *gp = empty_adjacency_list(n);
+    if (gp == NULL) return take_graph(NULL);
+
+    for (int first = 0; first < n;) {
+        int size = 2 + random_below(&state, max_size - 1);
+        if (size > n - first) size = n - first;
+        for (int k = 0; k < size; k++) {
+            // the ring keeps the chain strongly connected, the other two
+            // successors (possibly the vertex itself) make it aperiodic most of the time
+            int succ[3] = { (k + 1) % size, random_below(&state, size), random_below(&state, size) };
+            float weight[3], sum = 0.0f;
+            for (int d = 0; d < 3; d++) sum += weight[d] = random_unit(&state);
+            for (int d = 0; d < 3; d++) addCellToList(&gp->array[first + k], first + succ[d] + 1, weight[d] / sum);
+        }
+        first += size;
+    }
+    return take_graph(gp);
+}
+
+/**
+ * @brief Deep DAG of cycles.
+ * @param depth Number of levels
+ * @param width Number of cycles per level
+ * @param cycle_size Number of vertices per cycle
+ * @param seed Random seed
+ * @return The generated graph
+ */
+t_adjacency_list generate_scc_dag(int depth, int width, int cycle_size, uint64_t seed) {
+    uint64_t state = seed ? seed : 1;
+    int n = depth * width * cycle_size;
+    t_adjacency_list *gp = empty_adjacency_list(n);
+    if (gp == NULL) return take_graph(NULL);
+
+    for (int l = 0; l < depth; l++) {
+        for (int w = 0; w < width; w++) {
+            int base = (l * width + w) * cycle_size; // first vertex of the cycle
+            for (int k = 0; k < cycle_size; k++) {
+                int v = base + k;
+                int next = base + (k + 1) % cycle_size;
+                if (k == 0 && l + 1 < depth) {
+                    // the entry vertex leaks into two cycles of the next level
+                    int a = ((l + 1) * width + random_below(&state, width)) * cycle_size;
+                    int b = ((l + 1) * width + random_below(&state, width)) * cycle_size;
+                    addCellToList(&gp->array[v], next + 1, 0.5f);
+                    if (a == b) {
+                        addCellToList(&gp->array[v], a + 1, 0.5f);
+                    } else {
+                        addCellToList(&gp->array[v], a + 1, 0.25f);
+                        addCellToList(&gp->array[v], b + 1, 0.25f);
+                    }
+                } else {
+                    addCellToList(&gp->array[v], next + 1, 1.0f);
+                }
+            }
+        }
+    }
+    return take_graph(gp);
+}
+
+/**
+ * @brief Writes a graph in the readGraph() format.
+ * @param graph Graph to write
+ * @param filename Output file path
+ * @return 0 on success, -1 on error
+ */
+int write_graph_file(t_adjacency_list graph, const char *filename) {
+    FILE *file = fopen(filename, "wt");
+    if (file == NULL) return -1;
+
+    fprintf(file, "%d\n", graph.size);
+    for (int i = 0; i < graph.size; i++) {
+        for (t_cell *c = graph.array[i].head; c != NULL; c = c->next) {
+            fprintf(file, "%d %d %.9g\n", i + 1, c->arrival, c->probability);
+        }
+    }
+    return fclose(file) == 0 ? 0 : -1;
+}
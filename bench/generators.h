@@ -0,0 +1,75 @@
+#ifndef GENERATORS_H
+#define GENERATORS_H
+
+#include <stdint.h>
+#include "../adjacency_list/adjacency_list.h"
+
+/**
+ * @brief Random sparse chain: every vertex gets 'degree' random successors
+ *        with random probabilities summing to 1.
+ * @param n Number of vertices
+ * @param degree Number of successors per vertex
+ * @param seed Random seed
+ * @return The generated graph (free with free_adjacency_list)
+ */
+t_adjacency_list generate_random_sparse(int n, int degree, uint64_t seed);
+
+/**
+ * @brief Birth-death chain on 1..n: up with probability p, down with q, stay otherwise.
+ * @param n Number of vertices
+ * @param p Probability to move up
+ * @param q Probability to move down
+ * @return The generated graph
+ */
+t_adjacency_list generate_birth_death(int n, float p, float q);
+
+/**
+ * @brief Random walk on a width x height grid (uniform over the 4 neighbours, reflecting borders).
+ * @param width Number of columns
+ * @param height Number of rows
+ * @return The generated graph
+ */
+t_adjacency_list generate_grid_walk(int width, int height);
+
+/**
+ * @brief Nearly decomposable chain: dense blocks coupled by a small probability.
+ * @param nb_blocks Number of blocks
+ * @param block_size Number of vertices per block
+ * @param coupling Probability of leaving the block at each step
+ * @param seed Random seed
+ * @return The generated graph
+ */
+t_adjacency_list generate_block_chain(int nb_blocks, int block_size, float coupling, uint64_t seed);
+
+/**
+ * @brief Deep DAG of strongly connected components: 'depth' levels of 'width'
+ *        cycles of 'cycle_size' vertices; every cycle leaks into two cycles of
+ *        the next level, the cycles of the last level are closed (persistent).
+ * @param depth Number of levels
+ * @param width Number of cycles per level
+ * @param cycle_size Number of vertices per cycle
+ * @param seed Random seed
+ * @return The generated graph
+ */
+t_adjacency_list generate_scc_dag(int depth, int width, int cycle_size, uint64_t seed);
+
+/**
+ * @brief Many small irreducible chains side by side, as in a batch of tiny
+ *        graphs: each one has 2 .. max_size vertices in a ring, and every
+ *        vertex has two more random successors in its chain.
+ * @param n Total number of vertices
+ * @param max_size Largest chain
+ * @param seed Random seed
+ * @return The generated graph
+ */
+t_adjacency_list generate_small_chains(int n, int max_size, uint64_t seed);
+
+/**
+ * @brief Writes a graph in the format read by readGraph().
+ * @param graph Graph to write
+ * @param filename Output file path
+ * @return 0 on success, -1 if the file could not be written
+ */
+int write_graph_file(t_adjacency_list graph, const char *filename);
+
+#endif //GENERATORS_H
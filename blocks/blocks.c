@@ -0,0 +1,551 @@
+#include "blocks.h"
+#include "../cell/cell.h"
+#include "../status/status.h"
+#include "../scheduler/scheduler.h"
+#include <math.h>
+#include <stdlib.h>
+#include <string.h>
+
+/**
+ * @brief Links between the blocks (one per pair of classes joined by a
+ *        coupling entry), then their levels from the sinks and the sources.
+ * @return 0 on success, -1 on allocation error
+ */
+static int build_levels(t_block_matrix *B) {
+    int nb = B->nb_blocks;
+    int *block_of_row = (int *)malloc((B->size > 0 ? B->size : 1) * sizeof(int));
+    int *last_link = (int *)malloc((nb > 0 ? nb : 1) * sizeof(int)); // block -> last block linked to it
+    t_link_array links;
+    links_init(&links);
+    int status = (block_of_row && last_link) ? 0 : -1;
+    for (int b = 0; b < nb && status == 0; b++) {
+        last_link[b] = -1;
+        for (int r = B->block_start[b]; r < B->block_start[b + 1]; r++) block_of_row[r] = b;
+    }
+    // the rows of a block are consecutive: last_link filters the repeated
+    // links without the linear search of links_add()
+    for (int b = 0; b < nb && status == 0; b++) {
+        for (int r = B->block_start[b]; r < B->block_start[b + 1] && status == 0; r++) {
+            for (int e = B->outer_start[r]; e < B->outer_start[r + 1]; e++) {
+                int a = block_of_row[B->outer_col[e]];
+                if (last_link[a] == b) continue;
+                last_link[a] = b;
+                if (links.size == links.length) {
+                    int length = links.length == 0 ? 8 : links.length * 2;
+                    t_link *grown = (t_link *)realloc(links.links, length * sizeof(t_link));
+                    if (grown == NULL) {
+                        status = -1;
+                        break;
+                    }
+                    links.links = grown;
+                    links.length = length;
+                }
+                links.links[links.size++] = (t_link){ b, a };
+            }
+        }
+    }
+    if (status == 0) {
+        status = class_levels_build(nb, &links, 1, &B->heights) == 0
+                 && class_levels_build(nb, &links, 0, &B->depths) == 0 ? 0 : -1;
+    }
+    free(links.links);
+    free(block_of_row);
+    free(last_link);
+    return status;
+}
+
+/**
+ * @brief Builds the block-triangular form of a graph.
+ * @param graph The graph
+ * @param partition Its classes, in reverse topological order
+ * @param B Output
+ * @return MARKOV_OK or a negative t_markov_status
+ */
+int CreateBlockMatrix(t_adjacency_list graph, const t_partition *partition, t_block_matrix *B) {
+    if (B == NULL) return MARKOV_ERR_ARG;
+    memset(B, 0, sizeof(*B));
+    if (partition == NULL || graph.size <= 0) return MARKOV_ERR_ARG;
+    int n = graph.size, nb = partition->nb_class;
+    B->size = n;
+    B->nb_blocks = nb;
+
+    int *block_of = (int *)malloc(n * sizeof(int));
+    B->block_start = (int *)malloc((nb + 1) * sizeof(int));
+    B->vertex = (int *)malloc(n * sizeof(int));
+    B->row_of = (int *)malloc(n * sizeof(int));
+    B->inner_start = (int *)calloc(n + 1, sizeof(int));
+    B->outer_start = (int *)calloc(n + 1, sizeof(int));
+    B->in_start = (int *)calloc(n + 1, sizeof(int));
+    B->persistent = (int *)malloc((nb > 0 ? nb : 1) * sizeof(int));
+    if (!block_of || !B->block_start || !B->vertex || !B->row_of || !B->inner_start || !B->outer_start
+        || !B->in_start || !B->persistent) {
+        free(block_of);
+        FreeBlockMatrix(B);
+        return MARKOV_ERR_ALLOC;
+    }
+
+    // rows: the classes one after the other, each vertex exactly once
+    int status = MARKOV_OK, r = 0;
+    for (int v = 0; v < n; v++) block_of[v] = -1;
+    for (int b = 0; b < nb && status == MARKOV_OK; b++) {
+        const t_class *cls = partition->classes[b];
+        B->block_start[b] = r;
+        B->persistent[b] = 1;
+        for (int k = 0; k < cls->nb_vertices; k++) {
+            int v = cls->vertices[k] - 1;
+            if (v < 0 || v >= n || block_of[v] >= 0) {
+                status = MARKOV_ERR_ARG;
+                break;
+            }
+            block_of[v] = b;
+            B->vertex[r] = v;
+            B->row_of[v] = r++;
+        }
+    }
+    B->block_start[nb] = r;
+    if (status == MARKOV_OK && r != n) status = MARKOV_ERR_ARG;
+
+    // count the entries of each row; a coupling must go to an earlier block
+    for (int row = 0; row < n && status == MARKOV_OK; row++) {
+        int v = B->vertex[row];
+        for (t_cell *c = graph.array[v].head; c != NULL; c = c->next) {
+            int w = c->arrival - 1;
+            if (w < 0 || w >= n) continue;
+            if (block_of[w] == block_of[v]) {
+                B->inner_start[row + 1]++;
+            } else if (block_of[w] < block_of[v]) {
+                B->outer_start[row + 1]++;
+                B->in_start[B->row_of[w] + 1]++;
+                B->persistent[block_of[v]] = 0;
+            } else {
+                status = MARKOV_ERR_ARG;
+                break;
+            }
+        }
+    }
+    if (status == MARKOV_OK) {
+        for (int row = 0; row < n; row++) {
+            B->inner_start[row + 1] += B->inner_start[row];
+            B->outer_start[row + 1] += B->outer_start[row];
+            B->in_start[row + 1] += B->in_start[row];
+        }
+        int nb_inner = B->inner_start[n] > 0 ? B->inner_start[n] : 1;
+        int nb_outer = B->outer_start[n] > 0 ? B->outer_start[n] : 1;
+        B->inner_col = (int *)malloc(nb_inner * sizeof(int));
+        B->inner_val = (float *)malloc(nb_inner * sizeof(float));
+        B->outer_col = (int *)malloc(nb_outer * sizeof(int));
+        B->outer_val = (float *)malloc(nb_outer * sizeof(float));
+        B->in_row = (int *)malloc(nb_outer * sizeof(int));
+        B->in_val = (float *)malloc(nb_outer * sizeof(float));
+        if (!B->inner_col || !B->inner_val || !B->outer_col || !B->outer_val || !B->in_row || !B->in_val) {
+            status = MARKOV_ERR_ALLOC;
+        }
+    }
+
+    // fill, keeping the order of each list; the transpose is filled by source row
+    int *fill = status == MARKOV_OK ? (int *)malloc(n * sizeof(int)) : NULL;
+    if (status == MARKOV_OK && fill == NULL) status = MARKOV_ERR_ALLOC;
+    if (status == MARKOV_OK) {
+        memcpy(fill, B->in_start, n * sizeof(int));
+        for (int row = 0; row < n; row++) {
+            int v = B->vertex[row];
+            int ei = B->inner_start[row], eo = B->outer_start[row];
+            for (t_cell *c = graph.array[v].head; c != NULL; c = c->next) {
+                int w = c->arrival - 1;
+                if (w < 0 || w >= n) continue;
+                if (block_of[w] == block_of[v]) {
+                    B->inner_col[ei] = B->row_of[w];
+                    B->inner_val[ei++] = c->probability;
+                } else {
+                    int col = B->row_of[w];
+                    B->outer_col[eo] = col;
+                    B->outer_val[eo++] = c->probability;
+                    B->in_row[fill[col]] = row;
+                    B->in_val[fill[col]++] = c->probability;
+                }
+            }
+        }
+        if (build_levels(B) != 0) status = MARKOV_ERR_ALLOC;
+    }
+    free(fill);
+    free(block_of);
+    if (status != MARKOV_OK) FreeBlockMatrix(B);
+    return status;
+}
+
+/**
+ * @brief Frees the arrays of a block matrix.
+ * @param B The block matrix
+ */
+void FreeBlockMatrix(t_block_matrix *B) {
+    if (B == NULL) return;
+    free(B->block_start);
+    free(B->vertex);
+    free(B->row_of);
+    free(B->inner_start);
+    free(B->inner_col);
+    free(B->inner_val);
+    free(B->outer_start);
+    free(B->outer_col);
+    free(B->outer_val);
+    free(B->in_start);
+    free(B->in_row);
+    free(B->in_val);
+    free(B->persistent);
+    class_levels_free(&B->heights);
+    class_levels_free(&B->depths);
+    memset(B, 0, sizeof(*B));
+}
+
+static int converged(float change, float x, float eps) {
+    float scale = fabsf(x) > 1.0f ? fabsf(x) : 1.0f;
+    return change <= eps * scale;
+}
+
+/**
+ * @brief Backward substitution x = c + P x on the transient blocks, k
+ *        right-hand sides (x is row-major, size x k). The rows of the
+ *        persistent blocks are set by the caller.
+ */
+typedef struct s_backward {
+    const t_block_matrix *B;
+    float *x;          // rows x k
+    float *rhs;        // rows x k, the coupling terms of each row
+    int k;
+    float constant;    // c: 0 for absorption, 1 for hitting times
+    const int *fixed;  // per block: 1 if its rows are set by the caller
+    float eps;
+    int max_iter;
+    int *sweeps;       // per block
+} t_backward;
+
+static void backward_block(void *arg, int b) {
+    t_backward *job = (t_backward *)arg;
+    const t_block_matrix *B = job->B;
+    int k = job->k, first = B->block_start[b], last = B->block_start[b + 1];
+    float *x = job->x;
+    if (job->fixed[b]) return;
+
+    // the coupling terms only read earlier blocks, already final: they are
+    // summed once, the sweeps add the diagonal block to them
+    float *rhs = job->rhs + (size_t)first * k;
+    for (int r = first; r < last; r++) {
+        for (int t = 0; t < k; t++) {
+            float sum = job->constant;
+            for (int e = B->outer_start[r]; e < B->outer_start[r + 1]; e++) {
+                float p = B->outer_val[e], y = x[(size_t)B->outer_col[e] * k + t];
+                // a path of positive probability to a never-ending wait
+                if (isinf(y) && p > 0.0f) sum = INFINITY;
+                else if (p != 0.0f) sum += p * y;
+            }
+            rhs[(size_t)(r - first) * k + t] = sum;
+        }
+    }
+
+    // a single vertex, x = rhs + d x: solved exactly
+    float d = 0.0f;
+    for (int e = B->inner_start[first]; last - first == 1 && e < B->inner_start[first + 1]; e++) d += B->inner_val[e];
+    if (last - first == 1 && d < 1.0f) {
+        for (int t = 0; t < k; t++) x[(size_t)first * k + t] = rhs[t] / (1.0f - d);
+        job->sweeps[b] = 1;
+        return;
+    }
+
+    // a class is strongly connected: one infinite entry makes them all infinite
+    int infinite = 0;
+    for (int i = 0; i < (last - first) * k; i++) infinite |= isinf(rhs[i]);
+    for (int r = first; r < last; r++) {
+        for (int t = 0; t < k; t++) x[(size_t)r * k + t] = infinite ? INFINITY : 0.0f;
+    }
+    int it = 0;
+    while (!infinite && it < job->max_iter) {
+        it++;
+        int done = 1;
+        for (int r = first; r < last; r++) {
+            for (int t = 0; t < k; t++) {
+                float sum = rhs[(size_t)(r - first) * k + t];
+                for (int e = B->inner_start[r]; e < B->inner_start[r + 1]; e++) {
+                    sum += B->inner_val[e] * x[(size_t)B->inner_col[e] * k + t];
+                }
+                float *xr = &x[(size_t)r * k + t];
+                if (!converged(fabsf(sum - *xr), sum, job->eps)) done = 0;
+                *xr = sum;
+            }
+        }
+        if (done) break;
+    }
+    job->sweeps[b] = it;
+}
+
+/**
+ * @brief Runs the backward substitution.
+ * @return The largest number of sweeps done on one block, -1 on allocation error
+ */
+static int solve_backward(t_backward *job) {
+    job->sweeps = (int *)calloc(job->B->nb_blocks > 0 ? job->B->nb_blocks : 1, sizeof(int));
+    job->rhs = (float *)malloc((size_t)(job->B->size > 0 ? job->B->size : 1) * job->k * sizeof(float));
+    int most = -1;
+    if (job->sweeps && job->rhs) {
+        for_each_class_level(&job->B->heights, backward_block, job);
+        most = 0;
+        for (int b = 0; b < job->B->nb_blocks; b++) {
+            if (job->sweeps[b] > most) most = job->sweeps[b];
+        }
+    }
+    free(job->sweeps);
+    free(job->rhs);
+    return most;
+}
+
+/**
+ * @brief Absorption probabilities by backward substitution.
+ * @param B The block matrix
+ * @param eps Convergence threshold of a class
+ * @param max_iter Maximum number of sweeps on one class
+ * @param result Output
+ * @return MARKOV_OK or a negative t_markov_status
+ */
+int BlockAbsorption(const t_block_matrix *B, float eps, int max_iter, t_absorption *result) {
+    if (B == NULL || result == NULL || max_iter <= 0) return MARKOV_ERR_ARG;
+    int n = B->size, k = 0;
+    for (int b = 0; b < B->nb_blocks; b++) k += B->persistent[b];
+
+    result->nb_vertices = n;
+    result->nb_targets = k;
+    result->iterations = 0;
+    result->target_class = (int *)malloc((k > 0 ? k : 1) * sizeof(int));
+    result->prob = (float *)calloc((size_t)n * (k > 0 ? k : 1), sizeof(float));
+    float *x = (float *)calloc((size_t)n * (k > 0 ? k : 1), sizeof(float));
+    if (!result->target_class || !result->prob || !x) {
+        free(x);
+        FreeAbsorption(result);
+        return MARKOV_ERR_ALLOC;
+    }
+
+    // one column per persistent class, where its vertices are absorbed
+    int t = 0;
+    for (int b = 0; b < B->nb_blocks; b++) {
+        if (!B->persistent[b]) continue;
+        result->target_class[t] = b;
+        for (int r = B->block_start[b]; r < B->block_start[b + 1]; r++) x[(size_t)r * k + t] = 1.0f;
+        t++;
+    }
+
+    int status = MARKOV_OK;
+    if (k > 0) {
+        t_backward job = { B, x, NULL, k, 0.0f, B->persistent, eps, max_iter, NULL };
+        result->iterations = solve_backward(&job);
+        if (result->iterations < 0) status = MARKOV_ERR_ALLOC;
+    }
+    for (int r = 0; r < n && status == MARKOV_OK; r++) {
+        memcpy(result->prob + (size_t)B->vertex[r] * k, x + (size_t)r * k, k * sizeof(float));
+    }
+    free(x);
+    if (status != MARKOV_OK) FreeAbsorption(result);
+    return status;
+}
+
+/**
+ * @brief Expected steps before entering a target class, by backward substitution.
+ * @param B The block matrix
+ * @param target Target classes, NULL for the persistent ones
+ * @param eps Convergence threshold of a class
+ * @param max_iter Maximum number of sweeps on one class
+ * @param times Output, per vertex
+ * @return MARKOV_OK or a negative t_markov_status
+ */
+int BlockHittingTimes(const t_block_matrix *B, const int *target, float eps, int max_iter, float *times) {
+    if (B == NULL || times == NULL || max_iter <= 0) return MARKOV_ERR_ARG;
+    int n = B->size;
+    float *x = (float *)malloc(n * sizeof(float));
+    int *fixed = (int *)malloc((B->nb_blocks > 0 ? B->nb_blocks : 1) * sizeof(int));
+    if (!x || !fixed) {
+        free(x);
+        free(fixed);
+        return MARKOV_ERR_ALLOC;
+    }
+
+    // 0 in a target, never from a persistent class that is not one
+    for (int b = 0; b < B->nb_blocks; b++) {
+        int hit = target ? target[b] != 0 : B->persistent[b];
+        fixed[b] = hit || B->persistent[b];
+        for (int r = B->block_start[b]; r < B->block_start[b + 1]; r++) x[r] = hit ? 0.0f : INFINITY;
+    }
+
+    t_backward job = { B, x, NULL, 1, 1.0f, fixed, eps, max_iter, NULL };
+    int status = solve_backward(&job) < 0 ? MARKOV_ERR_ALLOC : MARKOV_OK;
+    for (int r = 0; r < n && status == MARKOV_OK; r++) times[B->vertex[r]] = x[r];
+    free(x);
+    free(fixed);
+    return status;
+}
+
+/**
+ * @brief Forward substitution y = s + y P over the classes, by depth.
+ */
+typedef struct s_forward {
+    const t_block_matrix *B;
+    const float *start;  // per vertex
+    float *y;            // per row
+    float *next;         // per row, scratch of the sweeps
+    float *entry;        // per row, what enters the row from outside its class
+    float eps;
+    int max_iter;
+} t_forward;
+
+static void forward_block(void *arg, int b) {
+    t_forward *job = (t_forward *)arg;
+    const t_block_matrix *B = job->B;
+    int first = B->block_start[b], last = B->block_start[b + 1];
+    float *y = job->y, *next = job->next, *entry = job->entry;
+
+    // what enters the class: the start plus the flow from the classes
+    // before it, already final
+    for (int r = first; r < last; r++) {
+        float sum = job->start[B->vertex[r]];
+        for (int e = B->in_start[r]; e < B->in_start[r + 1]; e++) sum += y[B->in_row[e]] * B->in_val[e];
+        entry[r] = sum;
+        y[r] = sum;
+    }
+    if (B->persistent[b]) return;
+
+    float d = 0.0f;
+    for (int e = B->inner_start[first]; last - first == 1 && e < B->inner_start[first + 1]; e++) d += B->inner_val[e];
+    if (last - first == 1 && d < 1.0f) {
+        y[first] = entry[first] / (1.0f - d);
+        return;
+    }
+
+    // Jacobi sweeps y = entry + y D, one row of D scattered at a time
+    for (int it = 0; it < job->max_iter; it++) {
+        for (int r = first; r < last; r++) next[r] = entry[r];
+        for (int r = first; r < last; r++) {
+            if (y[r] == 0.0f) continue;
+            for (int e = B->inner_start[r]; e < B->inner_start[r + 1]; e++) next[B->inner_col[e]] += y[r] * B->inner_val[e];
+        }
+        int done = 1;
+        for (int r = first; r < last; r++) {
+            if (!converged(fabsf(next[r] - y[r]), next[r], job->eps)) done = 0;
+            y[r] = next[r];
+        }
+        if (done) break;
+    }
+}
+
+/**
+ * @brief Expected occupation from a start distribution, by forward substitution.
+ * @param B The block matrix
+ * @param start Start distribution, per vertex
+ * @param eps Convergence threshold of a class
+ * @param max_iter Maximum number of sweeps on one class
+ * @param visits Output, per vertex
+ * @return MARKOV_OK or a negative t_markov_status
+ */
+int BlockOccupation(const t_block_matrix *B, const float *start, float eps, int max_iter, float *visits) {
+    if (B == NULL || start == NULL || visits == NULL || max_iter <= 0) return MARKOV_ERR_ARG;
+    int n = B->size;
+    float *y = (float *)malloc(n * sizeof(float));
+    float *next = (float *)malloc(n * sizeof(float));
+    float *entry = (float *)malloc(n * sizeof(float));
+    if (!y || !next || !entry) {
+        free(y);
+        free(next);
+        free(entry);
+        return MARKOV_ERR_ALLOC;
+    }
+    t_forward job = { B, start, y, next, entry, eps, max_iter };
+    for_each_class_level(&B->depths, forward_block, &job);
+    for (int r = 0; r < n; r++) visits[B->vertex[r]] = y[r];
+    free(y);
+    free(next);
+    free(entry);
+    return MARKOV_OK;
+}
+
+/**
+ * @brief One step next = cur P of the evolution, for a range of blocks.
+ */
+typedef struct s_evolve {
+    const t_block_matrix *B;
+    const float *cur;   // per row
+    float *next;        // per row
+    const char *active; // per block: 1 if it holds mass in cur
+    char *next_active;  // per block: 1 if it holds mass in next
+} t_evolve;
+
+static void evolve_blocks(void *arg, int begin, int end) {
+    t_evolve *job = (t_evolve *)arg;
+    const t_block_matrix *B = job->B;
+    const float *cur = job->cur;
+    float *next = job->next;
+    for (int b = begin; b < end; b++) {
+        int first = B->block_start[b], last = B->block_start[b + 1];
+        // what enters the block from the classes before it
+        int fed = 0;
+        for (int r = first; r < last; r++) {
+            float sum = 0.0f;
+            for (int e = B->in_start[r]; e < B->in_start[r + 1]; e++) sum += cur[B->in_row[e]] * B->in_val[e];
+            next[r] = sum;
+            fed |= sum != 0.0f;
+        }
+        // the flow inside the class, one row of the block scattered at a time
+        if (job->active[b]) {
+            for (int r = first; r < last; r++) {
+                if (cur[r] == 0.0f) continue;
+                for (int e = B->inner_start[r]; e < B->inner_start[r + 1]; e++) next[B->inner_col[e]] += cur[r] * B->inner_val[e];
+            }
+        }
+        int mass = fed;
+        for (int r = first; r < last && !mass; r++) mass = next[r] != 0.0f;
+        job->next_active[b] = (char)mass;
+    }
+}
+
+/**
+ * @brief Distribution after a number of steps, one block at a time.
+ * @param B The block matrix
+ * @param start Start distribution, per vertex
+ * @param steps Number of steps
+ * @param dist Output, per vertex (may be start)
+ * @return MARKOV_OK or a negative t_markov_status
+ */
+int BlockTransient(const t_block_matrix *B, const float *start, int steps, float *dist) {
+    if (B == NULL || start == NULL || dist == NULL || steps < 0) return MARKOV_ERR_ARG;
+    int n = B->size, nb = B->nb_blocks;
+    float *cur = (float *)malloc((n > 0 ? n : 1) * sizeof(float));
+    float *next = (float *)malloc((n > 0 ? n : 1) * sizeof(float));
+    char *active = (char *)calloc(nb > 0 ? nb : 1, 1);
+    char *next_active = (char *)calloc(nb > 0 ? nb : 1, 1);
+    if (!cur || !next || !active || !next_active) {
+        free(cur);
+        free(next);
+        free(active);
+        free(next_active);
+        return MARKOV_ERR_ALLOC;
+    }
+    for (int b = 0; b < nb; b++) {
+        for (int r = B->block_start[b]; r < B->block_start[b + 1]; r++) {
+            cur[r] = start[B->vertex[r]];
+            if (cur[r] != 0.0f) active[b] = 1;
+        }
+    }
+
+    // a block without mass only reads the coupling entries that reach it
+    t_scheduler *s = scheduler_current();
+    for (int t = 0; t < steps; t++) {
+        t_evolve job = { B, cur, next, active, next_active };
+        scheduler_parallel_for(s, 0, nb, 1, evolve_blocks, &job);
+        float *swap = cur;
+        cur = next;
+        next = swap;
+        char *swap_active = active;
+        active = next_active;
+        next_active = swap_active;
+    }
+    for (int r = 0; r < n; r++) dist[B->vertex[r]] = cur[r];
+    free(cur);
+    free(next);
+    free(active);
+    free(next_active);
+    return MARKOV_OK;
+}
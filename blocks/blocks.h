@@ -0,0 +1,136 @@
+#ifndef BLOCKS_H
+#define BLOCKS_H
+
+#include "../adjacency_list/adjacency_list.h"
+#include "../tarjan/tarjan.h"
+#include "../absorption/absorption.h"
+
+/**
+ * @brief Transition matrix in block-triangular form, one block per class.
+ *
+ * The rows are the vertices renumbered class by class, in partition order:
+ * block b is made of rows block_start[b] .. block_start[b + 1] - 1, the
+ * vertices of class b in the order of the class. The entries of a row are
+ * split between its diagonal block (transitions that stay in the class) and
+ * its coupling entries (transitions to another class). tarjan() and
+ * ForwardBackwardSCC() give the classes in reverse topological order, so
+ * every coupling entry points to an earlier block: the matrix is block
+ * triangular and the systems of the chain can be solved one class at a time,
+ * by substitution over the class DAG.
+ *
+ * Blocks are also grouped by height (0 for a persistent class, else one more
+ * than its highest successor) and by depth (0 for a class with no
+ * predecessor, else one more than its deepest predecessor): the blocks of a
+ * height (resp. depth) only depend on lower ones in the backward (resp.
+ * forward) substitution and are solved in parallel (class_levels_build(),
+ * for_each_class_level()).
+ */
+typedef struct s_block_matrix {
+    int size;           // number of vertices
+    int nb_blocks;      // number of classes
+    int *block_start;   // nb_blocks + 1 offsets into the rows
+    int *vertex;        // row -> vertex (0-based)
+    int *row_of;        // vertex -> row
+    int *inner_start;   // size + 1 offsets of the diagonal-block entries of each row
+    int *inner_col;     // their column (a row of the same block)
+    float *inner_val;
+    int *outer_start;   // size + 1 offsets of the coupling entries of each row
+    int *outer_col;     // their column (a row of an earlier block)
+    float *outer_val;
+    int *in_start;      // size + 1 offsets of the coupling entries that reach each row
+    int *in_row;        // their source row
+    float *in_val;
+    int *persistent;    // per block: 1 if the class has no coupling entry
+    t_class_levels heights; // blocks grouped by height (levels from the sinks)
+    t_class_levels depths;  // blocks grouped by depth (levels from the sources)
+} t_block_matrix;
+
+/**
+ * @brief Builds the block-triangular form of a graph.
+ * @param graph The graph (arrivals outside [1, n] are skipped; an edge given
+ *        twice gives two entries, as in ComputeAbsorption()).
+ * @param partition Its classes in reverse topological order (tarjan(),
+ *        ForwardBackwardSCC()).
+ * @param B Output (free with FreeBlockMatrix).
+ * @return MARKOV_OK, MARKOV_ERR_ALLOC, or MARKOV_ERR_ARG if a vertex is in no
+ *         class or the classes are not in reverse topological order.
+ */
+int CreateBlockMatrix(t_adjacency_list graph, const t_partition *partition, t_block_matrix *B);
+
+/**
+ * @brief Frees the arrays of a block matrix.
+ * @param B The block matrix (may be NULL).
+ */
+void FreeBlockMatrix(t_block_matrix *B);
+
+/**
+ * @brief ComputeAbsorption() by backward substitution: the transient classes
+ *        are solved by height, each one by Gauss-Seidel sweeps on its own
+ *        diagonal block (a single vertex is solved exactly), the classes it
+ *        leads to being already known.
+ * @param B The block matrix.
+ * @param eps Convergence threshold of a class (change relative to max(1, |x|)).
+ * @param max_iter Maximum number of sweeps on one class.
+ * @param result Output (free with FreeAbsorption); iterations is the largest
+ *        number of sweeps done on one class.
+ * @return MARKOV_OK or a negative t_markov_status.
+ */
+int BlockAbsorption(const t_block_matrix *B, float eps, int max_iter, t_absorption *result);
+
+/**
+ * @brief Expected number of steps before the chain enters a target class.
+ *
+ * h(v) = 0 in a target class and h(v) = 1 + sum_w p(v, w) h(w) elsewhere,
+ * solved by backward substitution. A vertex from which some path avoids the
+ * targets forever (it reaches a persistent class that is not a target) gets
+ * INFINITY.
+ *
+ * @param B The block matrix.
+ * @param target Per class: 1 for a target, NULL for the persistent classes
+ *        (the expected time to absorption).
+ * @param eps Convergence threshold of a class (relative).
+ * @param max_iter Maximum number of sweeps on one class.
+ * @param times Output: one entry per vertex (0-based).
+ * @return MARKOV_OK or a negative t_markov_status.
+ */
+int BlockHittingTimes(const t_block_matrix *B, const int *target, float eps, int max_iter, float *times);
+
+/**
+ * @brief Expected occupation from a start distribution (the fundamental
+ *        matrix applied to it), by forward substitution over the classes
+ *        (by depth).
+ *
+ * For a vertex of a transient class, visits[v] is the expected number of
+ * visits to v (the start counts as a visit); for a vertex of a persistent
+ * class it is the probability that the chain enters that class at v (or
+ * starts there). The solve of a class only needs the classes before it.
+ * BlockTransient() gives the distribution after a given number of steps.
+ *
+ * @param B The block matrix.
+ * @param start Start distribution, one entry per vertex (0-based).
+ * @param eps Convergence threshold of a class (relative).
+ * @param max_iter Maximum number of sweeps on one class.
+ * @param visits Output: one entry per vertex (0-based).
+ * @return MARKOV_OK or a negative t_markov_status.
+ */
+int BlockOccupation(const t_block_matrix *B, const float *start, float eps, int max_iter, float *visits);
+
+/**
+ * @brief Transient evolution: the distribution after a number of steps,
+ *        dist = start P^steps.
+ *
+ * Each step is computed block by block: a block takes the flow inside its
+ * class and the coupling entries that reach it, and only writes its own
+ * rows, so the blocks of a step run in parallel on scheduler_current()
+ * without locks. The flow inside a block is only computed while the block
+ * holds mass.
+ *
+ * @param B The block matrix.
+ * @param start Start distribution, one entry per vertex (0-based).
+ * @param steps Number of steps (0 gives start back).
+ * @param dist Output: one entry per vertex (0-based), may be start.
+ * @return MARKOV_OK or a negative t_markov_status.
+ */
+int BlockTransient(const t_block_matrix *B, const float *start, int steps, float *dist);
+
+#endif //BLOCKS_H
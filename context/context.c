@@ -0,0 +1,226 @@
+#include "context.h"
+#include "../status/status.h"
+#include <stdlib.h>
+#include <string.h>
+
+// parts of a per-class request that can be added to a previous one
+#define CONTEXT_CLASS_PARTS (ANALYSIS_PERIOD | ANALYSIS_STATIONARY | ANALYSIS_ALL_CLASSES)
+
+/**
+ * @brief Initializes a context on a graph; nothing is computed yet.
+ * @param ctx The context.
+ * @param graph The graph (not copied).
+ * @param nb_threads Threads for the per-class work.
+ */
+void InitAnalysisContext(t_analysis_context *ctx, t_adjacency_list graph, int nb_threads) {
+    if (ctx == NULL) return;
+    memset(ctx, 0, sizeof(*ctx));
+    ctx->graph = graph;
+    ctx->nb_threads = nb_threads;
+    ctx->status = MARKOV_OK;
+    ctx->analysis.nb_vertices = graph.size;
+    links_init(&ctx->analysis.links);
+    links_init(&ctx->hasse);
+}
+
+/**
+ * @brief Records the error of a stage.
+ * @return NULL, for the accessors to return
+ */
+static void *fail(t_analysis_context *ctx, int status) {
+    ctx->status = status;
+    return NULL;
+}
+
+/**
+ * @brief Strongly connected classes of the graph, in tarjan() order.
+ * @param ctx The context.
+ * @return The partition, NULL on error.
+ */
+const t_partition *ContextPartition(t_analysis_context *ctx) {
+    if (ctx == NULL) return NULL;
+    if (!(ctx->done & CONTEXT_PARTITION)) {
+        ctx->analysis.partition = tarjan(ctx->graph);
+        if (ctx->analysis.partition == NULL) return fail(ctx, MARKOV_ERR_ALLOC);
+        ctx->done |= CONTEXT_PARTITION;
+    }
+    return ctx->analysis.partition;
+}
+
+/**
+ * @brief Class index of each vertex (0-based).
+ * @param ctx The context.
+ * @return The array, NULL on error.
+ */
+const int *ContextVertexToClass(t_analysis_context *ctx) {
+    if (ctx == NULL) return NULL;
+    if (!(ctx->done & CONTEXT_VERTEX_CLASS)) {
+        const t_partition *partition = ContextPartition(ctx);
+        if (partition == NULL) return NULL;
+        ctx->analysis.vertex_to_class = create_vertex_class_array(ctx->graph.size, partition);
+        if (ctx->analysis.vertex_to_class == NULL) return fail(ctx, MARKOV_ERR_ALLOC);
+        ctx->done |= CONTEXT_VERTEX_CLASS;
+    }
+    return ctx->analysis.vertex_to_class;
+}
+
+/**
+ * @brief Links between the classes.
+ * @param ctx The context.
+ * @return The links, NULL on error.
+ */
+const t_link_array *ContextClassLinks(t_analysis_context *ctx) {
+    if (ctx == NULL) return NULL;
+    if (!(ctx->done & CONTEXT_CLASS_LINKS)) {
+        const int *vertex_to_class = ContextVertexToClass(ctx);
+        if (vertex_to_class == NULL) return NULL;
+        if (list_class_links(&ctx->graph, vertex_to_class, &ctx->analysis.links) != 0) {
+            free(ctx->analysis.links.links);
+            links_init(&ctx->analysis.links);
+            return fail(ctx, MARKOV_ERR_ALLOC);
+        }
+        ctx->done |= CONTEXT_CLASS_LINKS;
+    }
+    return &ctx->analysis.links;
+}
+
+/**
+ * @brief Classifies the classes once: the class part of the analysis and the
+ *        transient flags.
+ * @return MARKOV_OK or a negative t_markov_status
+ */
+static int classify(t_analysis_context *ctx) {
+    if (ctx->done & CONTEXT_CLASSIFICATION) return MARKOV_OK;
+    if (ContextClassLinks(ctx) == NULL) return ctx->status;
+    int status = ClassifyGraphAnalysis(&ctx->analysis);
+    if (status != MARKOV_OK) {
+        ctx->status = status;
+        return status;
+    }
+    int nb_class = ctx->analysis.partition->nb_class;
+    ctx->transient = (int *)malloc((nb_class > 0 ? nb_class : 1) * sizeof(int));
+    if (ctx->transient == NULL) {
+        ctx->status = MARKOV_ERR_ALLOC;
+        return MARKOV_ERR_ALLOC;
+    }
+    for (int c = 0; c < nb_class; c++) ctx->transient[c] = !ctx->analysis.classes[c].persistent;
+    ctx->done |= CONTEXT_CLASSIFICATION;
+    return MARKOV_OK;
+}
+
+/**
+ * @brief Transient flag of each class.
+ * @param ctx The context.
+ * @return The flags, NULL on error.
+ */
+const int *ContextTransient(t_analysis_context *ctx) {
+    if (ctx == NULL || classify(ctx) != MARKOV_OK) return NULL;
+    return ctx->transient;
+}
+
+/**
+ * @brief Links of the Hasse diagram.
+ * @param ctx The context.
+ * @return The links, NULL on error.
+ */
+const t_link_array *ContextHasseLinks(t_analysis_context *ctx) {
+    if (ctx == NULL) return NULL;
+    if (!(ctx->done & CONTEXT_HASSE_LINKS)) {
+        const t_link_array *links = ContextClassLinks(ctx);
+        if (links == NULL) return NULL;
+        // reduced on a copy: the class links stay as list_class_links() gave them
+        ctx->hasse.links = (t_link *)malloc((links->size > 0 ? links->size : 1) * sizeof(t_link));
+        if (ctx->hasse.links == NULL) return fail(ctx, MARKOV_ERR_ALLOC);
+        if (links->size > 0) memcpy(ctx->hasse.links, links->links, links->size * sizeof(t_link));
+        ctx->hasse.size = ctx->hasse.length = links->size;
+        removeTransitiveLinks(&ctx->hasse);
+        ctx->done |= CONTEXT_HASSE_LINKS;
+    }
+    return &ctx->hasse;
+}
+
+/**
+ * @brief Dense transition matrix.
+ * @param ctx The context.
+ * @return The matrix, NULL on error.
+ */
+p_matrix ContextMatrix(t_analysis_context *ctx) {
+    if (ctx == NULL) return NULL;
+    if (!(ctx->done & CONTEXT_MATRIX)) {
+        ctx->matrix = CreateMatFromAdjList(ctx->graph);
+        if (ctx->matrix == NULL) return fail(ctx, MARKOV_ERR_ALLOC);
+        ctx->done |= CONTEXT_MATRIX;
+    }
+    return ctx->matrix;
+}
+
+/**
+ * @brief CSR transition matrix without duplicate edges.
+ * @param ctx The context.
+ * @return The matrix, NULL on error.
+ */
+const t_sparse_matrix *ContextSparse(t_analysis_context *ctx) {
+    if (ctx == NULL) return NULL;
+    if (!(ctx->done & CONTEXT_SPARSE)) {
+        ctx->sparse = CreateSparseFromAdjList(ctx->graph);
+        if (ctx->sparse == NULL || SparseRemoveDuplicates(ctx->sparse) != 0) {
+            DestroySparseMatrix(ctx->sparse);
+            ctx->sparse = NULL;
+            return fail(ctx, MARKOV_ERR_ALLOC);
+        }
+        ctx->done |= CONTEXT_SPARSE;
+    }
+    return ctx->sparse;
+}
+
+/**
+ * @brief 1 if two requests solve the stationary vectors the same way.
+ */
+static int same_solver(const t_analysis_options *a, const t_analysis_options *b) {
+    return a->eps == b->eps && a->max_iter == b->max_iter
+           && (a->flags & ANALYSIS_FORCE_LAZY) == (b->flags & ANALYSIS_FORCE_LAZY);
+}
+
+/**
+ * @brief Classification and per-class results.
+ * @param ctx The context.
+ * @param options What to compute (NULL for the defaults).
+ * @return The results, NULL on error.
+ */
+const t_graph_analysis *ContextAnalysis(t_analysis_context *ctx, const t_analysis_options *options) {
+    if (ctx == NULL || classify(ctx) != MARKOV_OK) return NULL;
+    t_analysis_options request = DefaultAnalysisOptions();
+    request.nb_threads = ctx->nb_threads;
+    if (options != NULL) request = *options;
+    if (!(request.flags & (ANALYSIS_PERIOD | ANALYSIS_STATIONARY))) return &ctx->analysis;
+
+    if ((ctx->done & CONTEXT_CLASS_RESULTS) && same_solver(&ctx->class_options, &request)) {
+        unsigned missing = request.flags & CONTEXT_CLASS_PARTS & ~ctx->class_options.flags;
+        if (missing == 0) return &ctx->analysis;
+        // one more pass, keeping what the previous requests asked for
+        request.flags |= ctx->class_options.flags & CONTEXT_CLASS_PARTS;
+    }
+
+    const t_sparse_matrix *S = ContextSparse(ctx);
+    if (S == NULL) return NULL;
+    ctx->done &= ~CONTEXT_CLASS_RESULTS;
+    int status = AnalyzeGraphClasses(ctx->graph, S, &request, &ctx->analysis);
+    if (status != MARKOV_OK) return fail(ctx, status);
+    ctx->class_options = request;
+    ctx->done |= CONTEXT_CLASS_RESULTS;
+    return &ctx->analysis;
+}
+
+/**
+ * @brief Frees everything the context computed.
+ * @param ctx The context (may be NULL).
+ */
+void FreeAnalysisContext(t_analysis_context *ctx) {
+    if (ctx == NULL) return;
+    FreeGraphAnalysis(&ctx->analysis);
+    free(ctx->transient);
+    free(ctx->hasse.links);
+    DestroyMatrix(ctx->matrix);
+    DestroySparseMatrix(ctx->sparse);
+    InitAnalysisContext(ctx, ctx->graph, ctx->nb_threads);
+}
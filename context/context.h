@@ -0,0 +1,128 @@
+#ifndef CONTEXT_H
+#define CONTEXT_H
+
+#include "../adjacency_list/adjacency_list.h"
+#include "../tarjan/tarjan.h"
+#include "../hasse/hasse.h"
+#include "../matrix/matrix.h"
+#include "../sparse/sparse.h"
+#include "../analysis/analysis.h"
+
+/**
+ * @brief Stages of an analysis context already computed.
+ */
+enum {
+    CONTEXT_PARTITION = 1 << 0,       // tarjan()
+    CONTEXT_VERTEX_CLASS = 1 << 1,    // create_vertex_class_array()
+    CONTEXT_CLASS_LINKS = 1 << 2,     // list_class_links()
+    CONTEXT_CLASSIFICATION = 1 << 3,  // ClassifyGraphAnalysis(), transient flags
+    CONTEXT_HASSE_LINKS = 1 << 4,     // links without the transitive ones
+    CONTEXT_MATRIX = 1 << 5,          // CreateMatFromAdjList()
+    CONTEXT_SPARSE = 1 << 6,          // CSR matrix without duplicate edges
+    CONTEXT_CLASS_RESULTS = 1 << 7    // periods / stationary vectors
+};
+
+/**
+ * @brief A graph and what has been computed on it.
+ *
+ * Each accessor computes its stage on the first call (and the stages it
+ * depends on), then returns the same data: a graph is decomposed once and
+ * densified at most once, however many printers or analyses run on it. The
+ * returned data belongs to the context and stays valid until
+ * FreeAnalysisContext(). The graph is not copied and must not change while
+ * the context is used; a context is used by one thread at a time (the
+ * per-class work itself runs on nb_threads threads).
+ *
+ * The per-class results are kept with the options they were computed with.
+ * A request that asks for a part already computed with the same solver
+ * settings (eps, max_iter, ANALYSIS_FORCE_LAZY) is served as it is;
+ * otherwise the classes are analysed again, with the parts already computed
+ * added to the request when the settings are the same.
+ */
+typedef struct s_analysis_context {
+    t_adjacency_list graph;        // the graph (not owned)
+    int nb_threads;                // threads for the per-class work
+    unsigned done;                 // CONTEXT_* stages computed
+    int status;                    // error of the last failed stage, MARKOV_OK if none
+    t_graph_analysis analysis;     // partition, vertex_to_class, links, classes
+    int *transient;                // per class: 1 if transient
+    t_link_array hasse;            // links without the transitive ones
+    p_matrix matrix;               // dense transition matrix
+    p_sparse_matrix sparse;        // CSR transition matrix, duplicates removed
+    t_analysis_options class_options; // options of the per-class results
+} t_analysis_context;
+
+/**
+ * @brief Initializes a context on a graph; nothing is computed yet.
+ * @param ctx The context.
+ * @param graph The graph (not copied).
+ * @param nb_threads Threads for the per-class work (<= 1 = the calling thread).
+ */
+void InitAnalysisContext(t_analysis_context *ctx, t_adjacency_list graph, int nb_threads);
+
+/**
+ * @brief Strongly connected classes of the graph, in tarjan() order.
+ * @param ctx The context.
+ * @return The partition, NULL on error (ctx->status).
+ */
+const t_partition *ContextPartition(t_analysis_context *ctx);
+
+/**
+ * @brief Class index of each vertex (0-based).
+ * @param ctx The context.
+ * @return The array, NULL on error.
+ */
+const int *ContextVertexToClass(t_analysis_context *ctx);
+
+/**
+ * @brief Links between the classes (list_class_links()).
+ * @param ctx The context.
+ * @return The links, NULL on error.
+ */
+const t_link_array *ContextClassLinks(t_analysis_context *ctx);
+
+/**
+ * @brief Transient flag of each class (classify_classes()).
+ * @param ctx The context.
+ * @return The flags, NULL on error.
+ */
+const int *ContextTransient(t_analysis_context *ctx);
+
+/**
+ * @brief Links of the Hasse diagram: the class links without the transitive ones.
+ * @param ctx The context.
+ * @return The links, NULL on error.
+ */
+const t_link_array *ContextHasseLinks(t_analysis_context *ctx);
+
+/**
+ * @brief Dense transition matrix (CreateMatFromAdjList()), n^2 floats.
+ * @param ctx The context.
+ * @return The matrix (read only), NULL on error.
+ */
+p_matrix ContextMatrix(t_analysis_context *ctx);
+
+/**
+ * @brief CSR transition matrix, an edge given twice keeping its last value
+ *        as in the dense matrix.
+ * @param ctx The context.
+ * @return The matrix (read only), NULL on error.
+ */
+const t_sparse_matrix *ContextSparse(t_analysis_context *ctx);
+
+/**
+ * @brief Classification and per-class results, as AnalyzeGraph() gives them.
+ * @param ctx The context.
+ * @param options What to compute (NULL for DefaultAnalysisOptions() with
+ *        the threads of the context).
+ * @return The results (may hold more than requested), NULL on error.
+ */
+const t_graph_analysis *ContextAnalysis(t_analysis_context *ctx, const t_analysis_options *options);
+
+/**
+ * @brief Frees everything the context computed (not the graph).
+ * @param ctx The context (may be NULL).
+ */
+void FreeAnalysisContext(t_analysis_context *ctx);
+
+#endif //CONTEXT_H
@@ -0,0 +1,262 @@
+#include "ctmc.h"
+#include "../cell/cell.h"
+#include "../sparse/sparse.h"
+#include "../status/status.h"
+#include "../report/report.h"
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+/**
+ * @brief Checks that every off-diagonal rate is non negative.
+ * @param rates Rate graph
+ * @param report Output
+ * @return MARKOV_OK or MARKOV_ERR_ARG
+ */
+int ValidateRateGraph(t_adjacency_list rates, t_rate_report *report) {
+    if (report == NULL || rates.size < 0 || (rates.size > 0 && rates.array == NULL)) return MARKOV_ERR_ARG;
+    memset(report, 0, sizeof(*report));
+    for (int i = 0; i < rates.size; i++) {
+        for (t_cell *curr = rates.array[i].head; curr != NULL; curr = curr->next) {
+            if (curr->arrival == i + 1 || curr->probability >= 0.0f) continue; // NaN is caught too
+            if (report->negative++ == 0) {
+                report->vertex = i + 1;
+                report->arrival = curr->arrival;
+                report->rate = curr->probability;
+            }
+        }
+    }
+    report->valid = report->negative == 0;
+    return MARKOV_OK;
+}
+
+/**
+ * @brief Checks a rate graph and prints the report.
+ * @param rates Rate graph
+ * @param ids External ids of the vertices, NULL to print the vertex numbers
+ * @return 1 if the graph is a rate graph, 0 if not, negative status on error
+ */
+int checkIfRateGraph(t_adjacency_list rates, const t_id_map *ids) {
+    t_rate_report report;
+    int status = ValidateRateGraph(rates, &report);
+    if (status != MARKOV_OK) return status;
+
+    t_writer w;
+    writer_init(&w, stdout, 0);
+    FormatRateReport(&w, &report, ids);
+    writer_close(&w);
+    return report.valid;
+}
+
+/**
+ * @brief Sum of the off-diagonal rates leaving vertex i (0-based).
+ */
+static float exit_rate(t_adjacency_list rates, int i) {
+    float total = 0.0f;
+    for (t_cell *curr = rates.array[i].head; curr != NULL; curr = curr->next) {
+        // self-loops have no meaning in a CTMC: the diagonal is -exit rate
+        if (curr->arrival != i + 1) total += curr->probability;
+    }
+    return total;
+}
+
+/**
+ * @brief Computes the largest exit rate of the chain.
+ * @param rates Rate graph
+ * @return The largest exit rate
+ */
+float MaxExitRate(t_adjacency_list rates) {
+    float max = 0.0f;
+    for (int i = 0; i < rates.size; i++) {
+        float r = exit_rate(rates, i);
+        if (r > max) max = r;
+    }
+    return max;
+}
+
+/**
+ * @brief Builds P = I + Q / lambda as a new adjacency list.
+ * @param rates Rate graph
+ * @param lambda Uniformization rate (raised to MaxExitRate() if smaller)
+ * @return The uniformized adjacency list
+ */
+t_adjacency_list UniformizeRateGraph(t_adjacency_list rates, float lambda) {
+    float max = MaxExitRate(rates);
+    if (lambda < max) lambda = max;
+    // a chain without any transition: every state stays where it is
+    if (lambda <= 0.0f) lambda = 1.0f;
+
+    t_adjacency_list *gp = empty_adjacency_list(rates.size);
+    if (gp == NULL) {
+        t_adjacency_list empty = { NULL, 0 };
+        return empty;
+    }
+
+    for (int i = 0; i < rates.size; i++) {
+        float out = 0.0f;
+        for (t_cell *curr = rates.array[i].head; curr != NULL; curr = curr->next) {
+            if (curr->arrival == i + 1 || curr->probability <= 0.0f) continue;
+            addCellToList(&gp->array[i], curr->arrival, curr->probability / lambda);
+            out += curr->probability;
+        }
+        // probability of staying: 1 - exit rate / lambda
+        float stay = 1.0f - out / lambda;
+        if (stay > 0.0f) addCellToList(&gp->array[i], i + 1, stay);
+    }
+
+    t_adjacency_list g = *gp;
+    free(gp);
+    return g;
+}
+
+/**
+ * @brief Computes Fox-Glynn truncated Poisson weights.
+ *
+ * The weights are built outward from the mode m = floor(qt), starting at
+ * w_m = 1, so they never underflow before the truncation points are reached.
+ * Past the mode the ratio between two weights is qt / (k + 1) < 1, so the
+ * remaining tail is bounded by a geometric series; the same holds below the
+ * mode with ratio k / qt. Each side stops once its bound drops below
+ * epsilon / 2 (relative to w_m <= total).
+ *
+ * @param qt Poisson parameter
+ * @param epsilon Allowed truncation error
+ * @param pw Output weights
+ * @return 0 on success, -1 on error
+ */
+int FoxGlynn(double qt, double epsilon, t_poisson_weights *pw) {
+    if (pw == NULL || qt < 0.0 || epsilon <= 0.0 || epsilon >= 1.0) return -1;
+    pw->weights = NULL;
+
+    if (qt == 0.0) {
+        // no time elapsed: zero jumps with probability 1
+        pw->left = pw->right = 0;
+        pw->weights = (double *)malloc(sizeof(double));
+        if (!pw->weights) return -1;
+        pw->weights[0] = 1.0;
+        pw->total = 1.0;
+        return 0;
+    }
+
+    int mode = (int)floor(qt);
+    double half = epsilon / 2.0;
+
+    // left truncation point
+    int left = mode;
+    double w = 1.0;
+    while (left > 0) {
+        double ratio = (double)left / qt;
+        if (ratio < 1.0 && w * ratio / (1.0 - ratio) < half) break;
+        w *= ratio;
+        left--;
+    }
+
+    // right truncation point
+    int right = mode;
+    w = 1.0;
+    for (;;) {
+        double ratio = qt / (double)(right + 1);
+        if (ratio < 1.0 && w * ratio / (1.0 - ratio) < half) break;
+        w *= ratio;
+        right++;
+    }
+
+    int count = right - left + 1;
+    pw->weights = (double *)malloc(count * sizeof(double));
+    if (!pw->weights) return -1;
+    pw->left = left;
+    pw->right = right;
+
+    // fill the weights from the mode outward with the same recurrences
+    double *wm = pw->weights + (mode - left);
+    wm[0] = 1.0;
+    for (int k = mode; k > left; k--) {
+        wm[k - 1 - mode] = wm[k - mode] * (double)k / qt;
+    }
+    for (int k = mode; k < right; k++) {
+        wm[k + 1 - mode] = wm[k - mode] * qt / (double)(k + 1);
+    }
+
+    // sum from the small weights to the large ones to limit rounding
+    double total = 0.0;
+    int lo = 0, hi = count - 1;
+    while (lo <= hi) {
+        if (pw->weights[lo] < pw->weights[hi]) total += pw->weights[lo++];
+        else total += pw->weights[hi--];
+    }
+    pw->total = total;
+    return 0;
+}
+
+/**
+ * @brief Frees the weights computed by FoxGlynn().
+ * @param pw Weights to free
+ */
+void FreePoissonWeights(t_poisson_weights *pw) {
+    if (pw == NULL) return;
+    free(pw->weights);
+    pw->weights = NULL;
+}
+
+/**
+ * @brief Transient distributions at time t by uniformization.
+ * @param rates Rate graph
+ * @param block Row-major block of k initial distributions, overwritten with Pi(t)
+ * @param k Number of distributions
+ * @param t Time
+ * @param epsilon Allowed truncation error
+ * @return 0 on success, -1 on error
+ */
+int TransientDistributionBlock(t_adjacency_list rates, float *block, int k, float t, float epsilon) {
+    if (block == NULL || k <= 0 || t < 0.0f || rates.size <= 0) return -1;
+
+    float lambda = MaxExitRate(rates);
+    if (lambda <= 0.0f) return 0; // no transition: the distributions never change
+
+    t_adjacency_list uniform = UniformizeRateGraph(rates, lambda);
+    p_sparse_matrix P = CreateSparseFromAdjList(uniform);
+    free_adjacency_list(&uniform);
+    if (P == NULL) return -1;
+
+    t_poisson_weights pw;
+    if (FoxGlynn((double)lambda * (double)t, (double)epsilon, &pw) != 0) {
+        DestroySparseMatrix(P);
+        return -1;
+    }
+
+    size_t count = (size_t)rates.size * (size_t)k;
+    float *cur = (float *)malloc(count * sizeof(float));
+    float *next = (float *)malloc(count * sizeof(float));
+    double *acc = (double *)calloc(count, sizeof(double));
+    if (!cur || !next || !acc) {
+        free(cur); free(next); free(acc);
+        FreePoissonWeights(&pw);
+        DestroySparseMatrix(P);
+        return -1;
+    }
+    memcpy(cur, block, count * sizeof(float));
+
+    // cur = Pi(0) * P^i; accumulate the Poisson weighted terms of [left, right]
+    for (int i = 0; i <= pw.right; i++) {
+        if (i >= pw.left) {
+            double w = pw.weights[i - pw.left] / pw.total;
+            for (size_t x = 0; x < count; x++) acc[x] += w * cur[x];
+        }
+        if (i < pw.right) {
+            PropagateBlock(P, cur, next, k);
+            float *swap = cur;
+            cur = next;
+            next = swap;
+        }
+    }
+
+    for (size_t x = 0; x < count; x++) block[x] = (float)acc[x];
+
+    free(cur);
+    free(next);
+    free(acc);
+    FreePoissonWeights(&pw);
+    DestroySparseMatrix(P);
+    return 0;
+}
@@ -0,0 +1,106 @@
+#ifndef CTMC_H
+#define CTMC_H
+
+#include "../adjacency_list/adjacency_list.h"
+#include "../idmap/idmap.h"
+
+/**
+ * @brief Poisson weights truncated with the Fox-Glynn method.
+ *
+ * weights[i] is the (scaled) probability of i + left jumps of a Poisson
+ * process of parameter qt; the weights outside [left, right] are dropped.
+ * Divide by 'total' to get probabilities.
+ */
+typedef struct s_poisson_weights {
+    int left;        // first kept number of jumps
+    int right;       // last kept number of jumps
+    double *weights; // right - left + 1 scaled weights
+    double total;    // sum of the kept weights
+} t_poisson_weights;
+
+/**
+ * @brief Result of ValidateRateGraph().
+ */
+typedef struct s_rate_report {
+    int valid;          // 1 if every off-diagonal rate is >= 0
+    long long negative; // negative (or NaN) off-diagonal rates
+    int vertex;         // start vertex of the first of them (1-based), 0 if none
+    int arrival;        // its arrival vertex (1-based)
+    float rate;         // its value
+} t_rate_report;
+
+/**
+ * @brief Checks that a graph can be read as a CTMC rate graph (every
+ *        off-diagonal rate is >= 0), without printing.
+ * @param rates Adjacency list whose edge values are transition rates
+ * @param report Output
+ * @return MARKOV_OK or MARKOV_ERR_ARG
+ * @note The file format is the one of readGraph(): "start end rate" lines.
+ *       Self-loops are ignored, the diagonal of the generator is implied.
+ */
+int ValidateRateGraph(t_adjacency_list rates, t_rate_report *report);
+
+/**
+ * @brief ValidateRateGraph() followed by FormatRateReport() on stdout.
+ * @param rates Adjacency list whose edge values are transition rates
+ * @param ids External ids of the vertices, NULL to print the vertex numbers
+ * @return 1 if the graph is a rate graph, 0 if not, negative status on error
+ */
+int checkIfRateGraph(t_adjacency_list rates, const t_id_map *ids);
+
+/**
+ * @brief Computes the largest exit rate of the chain (max over i of sum_{j != i} q_ij).
+ * @param rates Rate graph
+ * @return The largest exit rate, 0 if the graph has no transition
+ */
+float MaxExitRate(t_adjacency_list rates);
+
+/**
+ * @brief Uniformizes a rate graph into a discrete time Markov graph.
+ *
+ * P = I + Q / lambda, i.e. p_ij = q_ij / lambda for i != j and
+ * p_ii = 1 - (exit rate of i) / lambda. The result is a normal adjacency
+ * list, so tarjan(), the Hasse functions and the stationary solvers can be
+ * used on it directly: classes and stationary distribution are the ones of the CTMC.
+ *
+ * @param rates Rate graph
+ * @param lambda Uniformization rate; values below MaxExitRate() (e.g. 0) select MaxExitRate()
+ * @return The uniformized adjacency list (free with free_adjacency_list)
+ */
+t_adjacency_list UniformizeRateGraph(t_adjacency_list rates, float lambda);
+
+/**
+ * @brief Computes the Fox-Glynn truncated Poisson weights.
+ *
+ * The left and right truncation points are chosen so that the dropped
+ * probability mass is at most epsilon.
+ *
+ * @param qt Poisson parameter (uniformization rate x time), >= 0
+ * @param epsilon Allowed truncation error, in (0, 1)
+ * @param pw Output weights (free with FreePoissonWeights)
+ * @return 0 on success, -1 on invalid argument or allocation error
+ */
+int FoxGlynn(double qt, double epsilon, t_poisson_weights *pw);
+
+/**
+ * @brief Frees the weights computed by FoxGlynn().
+ * @param pw Weights to free
+ */
+void FreePoissonWeights(t_poisson_weights *pw);
+
+/**
+ * @brief Computes the transient distributions at time t of k initial distributions.
+ *
+ * Uses uniformization: Pi(t) = sum_i Poisson(lambda t; i) * Pi(0) * P^i, with
+ * the sum truncated by Fox-Glynn and the products computed with PropagateBlock().
+ *
+ * @param rates Rate graph
+ * @param block Row-major block of k initial distributions (rates.size x k), overwritten with Pi(t)
+ * @param k Number of distributions in the block
+ * @param t Time (>= 0)
+ * @param epsilon Allowed truncation error
+ * @return 0 on success, -1 on error
+ */
+int TransientDistributionBlock(t_adjacency_list rates, float *block, int k, float t, float epsilon);
+
+#endif //CTMC_H
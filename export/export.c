@@ -0,0 +1,308 @@
+#include "export.h"
+#include "../cell/cell.h"
+#include "../status/status.h"
+#include "../writer/writer.h"
+#include <stdio.h>
+#include <stdlib.h>
+
+// large buffer: a 1M-edge graph is written in a few dozen fwrite calls
+#define EXPORT_BUFFER_SIZE (1 << 20)
+
+/**
+ * @brief Options that export everything.
+ * @return The options
+ */
+t_export_options DefaultExportOptions(void) {
+    t_export_options options = { 0, 1.0, 1, NULL };
+    return options;
+}
+
+/**
+ * @brief Writes the alphabetic ID of a vertex (1 -> A, 27 -> AA, ...).
+ * @param vertex Vertex number (1-based)
+ * @param out Destination, at least 16 chars
+ * @return Length of the ID
+ */
+int vertex_alpha_id(int vertex, char *out) {
+    char temp[16];
+    int index = 0;
+
+    vertex--;
+    while (vertex >= 0) {
+        temp[index++] = (char)('A' + (vertex % 26));
+        vertex = (vertex / 26) - 1;
+    }
+    for (int j = 0; j < index; j++) out[j] = temp[index - j - 1];
+    out[index] = '\0';
+    return index;
+}
+
+/**
+ * @brief SplitMix64 finalizer, used to hash the edge positions.
+ */
+static uint64_t mix64(uint64_t x) {
+    x += 0x9E3779B97F4A7C15ULL;
+    x = (x ^ (x >> 30)) * 0xBF58476D1CE4E5B9ULL;
+    x = (x ^ (x >> 27)) * 0x94D049BB133111EBULL;
+    return x ^ (x >> 31);
+}
+
+/**
+ * @brief Edge selection shared by the exporters.
+ */
+typedef struct s_edge_filter {
+    int active;             // 0 if every edge is kept
+    long long max_edges;    // 0 = no cap
+    uint64_t threshold;     // keep the edge if its hash is below this value
+    uint64_t seed;
+    long long kept;         // edges kept so far
+    long long total;        // edges seen so far
+} t_edge_filter;
+
+static void filter_init(t_edge_filter *f, const t_export_options *options) {
+    t_export_options all = DefaultExportOptions();
+    if (options == NULL) options = &all;
+    double rate = options->sample_rate;
+    if (!(rate > 0.0) || rate > 1.0) rate = 1.0;
+
+    f->max_edges = options->max_edges > 0 ? options->max_edges : 0;
+    f->threshold = rate >= 1.0 ? UINT64_MAX : (uint64_t)(rate * 18446744073709551615.0);
+    f->seed = options->seed;
+    f->active = f->max_edges > 0 || rate < 1.0;
+    f->kept = 0;
+    f->total = 0;
+}
+
+/**
+ * @brief Decides if the next edge is written. Must be called once per edge, in order.
+ */
+static int filter_keep(t_edge_filter *f) {
+    long long position = f->total++;
+    if (!f->active) {
+        f->kept++;
+        return 1;
+    }
+    if (f->max_edges > 0 && f->kept >= f->max_edges) return 0;
+    if (f->threshold != UINT64_MAX && mix64(f->seed ^ mix64((uint64_t)position)) > f->threshold) return 0;
+    f->kept++;
+    return 1;
+}
+
+/**
+ * @brief Marks the vertices touched by a kept edge (first pass of a limited export).
+ * @return Array of graph.size flags, NULL on allocation error
+ */
+static char *mark_used_vertices(t_adjacency_list graph, const t_export_options *options) {
+    char *used = (char *)calloc(graph.size > 0 ? graph.size : 1, 1);
+    if (used == NULL) return NULL;
+    t_edge_filter f;
+    filter_init(&f, options);
+    for (int i = 0; i < graph.size; i++) {
+        for (t_cell *e = graph.array[i].head; e != NULL; e = e->next) {
+            if (e->arrival < 1 || e->arrival > graph.size || !filter_keep(&f)) continue;
+            used[i] = 1;
+            used[e->arrival - 1] = 1;
+        }
+    }
+    return used;
+}
+
+/**
+ * @brief Opens the output file and its writer.
+ * @return MARKOV_OK, MARKOV_ERR_IO or MARKOV_ERR_ALLOC
+ */
+static int open_output(const char *filename, FILE **file, t_writer *w) {
+    *file = fopen(filename, "w");
+    if (*file == NULL) return MARKOV_ERR_IO;
+    if (writer_init(w, *file, EXPORT_BUFFER_SIZE) != 0) {
+        fclose(*file);
+        return MARKOV_ERR_ALLOC;
+    }
+    return MARKOV_OK;
+}
+
+/**
+ * @brief Flushes the writer and closes the file.
+ * @return MARKOV_OK or MARKOV_ERR_IO
+ */
+static int close_output(FILE *file, t_writer *w) {
+    int status = writer_close(w);
+    if (fclose(file) != 0) status = -1;
+    return status == 0 ? MARKOV_OK : MARKOV_ERR_IO;
+}
+
+/**
+ * @brief Writes the note on the edges left out by a limited export.
+ */
+static void write_omitted(t_writer *w, const t_edge_filter *f, const char *comment) {
+    if (f->kept == f->total) return;
+    writer_puts(w, comment);
+    writer_puts(w, " ");
+    writer_int(w, f->total - f->kept);
+    writer_puts(w, " of ");
+    writer_int(w, f->total);
+    writer_puts(w, " edges omitted\n");
+}
+
+/**
+ * @brief Exports the graph in Mermaid format.
+ * @param graph The graph
+ * @param filename Output file
+ * @param options Limits, NULL to export everything
+ * @return MARKOV_OK, MARKOV_ERR_IO or MARKOV_ERR_ALLOC
+ */
+int ExportGraphMermaid(t_adjacency_list graph, const char *filename, const t_export_options *options) {
+    t_edge_filter f;
+    filter_init(&f, options);
+    char *used = NULL;
+    if (f.active && (used = mark_used_vertices(graph, options)) == NULL) return MARKOV_ERR_ALLOC;
+
+    FILE *file;
+    t_writer w;
+    int status = open_output(filename, &file, &w);
+    if (status != MARKOV_OK) {
+        free(used);
+        return status;
+    }
+
+    // Mermaid configuration header (layout and theme used by MermaidChart)
+    writer_puts(&w, "---\nconfig:\n   layout: elk\n   theme: neo\n   look: neo\n---\n\nflowchart LR\n");
+
+    // vertex definitions: A((1)), B((2)), ...
+    const t_id_map *ids = options ? options->ids : NULL;
+    char id[16], to[16];
+    for (int i = 0; i < graph.size; i++) {
+        if (used && !used[i]) continue;
+        writer_write(&w, id, vertex_alpha_id(i + 1, id));
+        writer_puts(&w, "((");
+        write_vertex_id(&w, ids, i + 1);
+        writer_puts(&w, "))\n");
+    }
+    writer_char(&w, '\n');
+
+    // edges: source -->|proba| destination
+    for (int i = 0; i < graph.size; i++) {
+        int id_len = vertex_alpha_id(i + 1, id);
+        for (t_cell *e = graph.array[i].head; e != NULL; e = e->next) {
+            // an arrival outside the graph has no vertex to point to
+            if (e->arrival < 1 || e->arrival > graph.size || !filter_keep(&f)) continue;
+            writer_write(&w, id, id_len);
+            writer_puts(&w, " -->|");
+            writer_fixed(&w, e->probability, 2);
+            writer_char(&w, '|');
+            writer_write(&w, to, vertex_alpha_id(e->arrival, to));
+            writer_char(&w, '\n');
+        }
+    }
+    write_omitted(&w, &f, "%%");
+
+    free(used);
+    return close_output(file, &w);
+}
+
+/**
+ * @brief Exports the graph in Graphviz DOT format.
+ * @param graph The graph
+ * @param filename Output file
+ * @param options Limits, NULL to export everything
+ * @return MARKOV_OK, MARKOV_ERR_IO or MARKOV_ERR_ALLOC
+ */
+int ExportGraphDot(t_adjacency_list graph, const char *filename, const t_export_options *options) {
+    t_edge_filter f;
+    filter_init(&f, options);
+    char *used = NULL;
+    if (f.active && (used = mark_used_vertices(graph, options)) == NULL) return MARKOV_ERR_ALLOC;
+
+    FILE *file;
+    t_writer w;
+    int status = open_output(filename, &file, &w);
+    if (status != MARKOV_OK) {
+        free(used);
+        return status;
+    }
+
+    // DOT accepts numerals as node names, so the ids are used directly
+    const t_id_map *ids = options ? options->ids : NULL;
+    writer_puts(&w, "digraph markov {\n  rankdir=LR;\n  node [shape=circle];\n");
+    for (int i = 0; i < graph.size; i++) {
+        if (used && !used[i]) continue;
+        writer_puts(&w, "  ");
+        write_vertex_id(&w, ids, i + 1);
+        writer_puts(&w, ";\n");
+    }
+    for (int i = 0; i < graph.size; i++) {
+        for (t_cell *e = graph.array[i].head; e != NULL; e = e->next) {
+            if (e->arrival < 1 || e->arrival > graph.size || !filter_keep(&f)) continue;
+            writer_puts(&w, "  ");
+            write_vertex_id(&w, ids, i + 1);
+            writer_puts(&w, " -> ");
+            write_vertex_id(&w, ids, e->arrival);
+            writer_puts(&w, " [label=\"");
+            writer_fixed(&w, e->probability, 2);
+            writer_puts(&w, "\"];\n");
+        }
+    }
+    write_omitted(&w, &f, "  //");
+    writer_puts(&w, "}\n");
+
+    free(used);
+    return close_output(file, &w);
+}
+
+/**
+ * @brief Exports the Hasse diagram in Mermaid format.
+ * @param partition The partition
+ * @param links Links between classes
+ * @param filename Output file
+ * @param ids External ids of the vertices, NULL to print the vertex numbers
+ * @return MARKOV_OK, MARKOV_ERR_IO or MARKOV_ERR_ALLOC
+ */
+int ExportHasseMermaid(const t_partition *partition, const t_link_array *links, const char *filename,
+                       const t_id_map *ids) {
+    if (partition == NULL || links == NULL) return MARKOV_ERR_ARG;
+    FILE *file;
+    t_writer w;
+    int status = open_output(filename, &file, &w);
+    if (status != MARKOV_OK) return status;
+    write_hasse_mermaid(&w, partition, links, ids);
+    return close_output(file, &w);
+}
+
+/**
+ * @brief Exports the Hasse diagram in Graphviz DOT format.
+ * @param partition The partition
+ * @param links Links between classes
+ * @param filename Output file
+ * @param ids External ids of the vertices, NULL to print the vertex numbers
+ * @return MARKOV_OK, MARKOV_ERR_IO or MARKOV_ERR_ALLOC
+ */
+int ExportHasseDot(const t_partition *partition, const t_link_array *links, const char *filename,
+                   const t_id_map *ids) {
+    if (partition == NULL || links == NULL) return MARKOV_ERR_ARG;
+    FILE *file;
+    t_writer w;
+    int status = open_output(filename, &file, &w);
+    if (status != MARKOV_OK) return status;
+
+    writer_puts(&w, "digraph hasse {\n  rankdir=TB;\n  node [shape=box];\n");
+    for (int c = 0; c < partition->nb_class; ++c) {
+        const t_class *cls = partition->classes[c];
+        writer_puts(&w, "  C");
+        writer_int(&w, c + 1);
+        writer_puts(&w, " [label=\"");
+        for (int k = 0; k < cls->nb_vertices; ++k) {
+            if (k) writer_puts(&w, ", ");
+            write_vertex_id(&w, ids, cls->vertices[k]);
+        }
+        writer_puts(&w, "\"];\n");
+    }
+    for (int i = 0; i < links->size; ++i) {
+        writer_puts(&w, "  C");
+        writer_int(&w, links->links[i].start + 1);
+        writer_puts(&w, " -> C");
+        writer_int(&w, links->links[i].end + 1);
+        writer_puts(&w, ";\n");
+    }
+    writer_puts(&w, "}\n");
+    return close_output(file, &w);
+}
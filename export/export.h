@@ -0,0 +1,83 @@
+#ifndef EXPORT_H
+#define EXPORT_H
+
+#include <stdint.h>
+#include "../adjacency_list/adjacency_list.h"
+#include "../tarjan/tarjan.h"
+#include "../hasse/hasse.h"
+#include "../idmap/idmap.h"
+
+/**
+ * @brief Limits applied when exporting a large graph.
+ *
+ * The selection is deterministic: an edge is kept or dropped from a hash of
+ * its position and of the seed, so two exports with the same options are
+ * identical. Only the vertices touched by a kept edge are declared when a
+ * limit is active. With an id map, the vertices are labelled with their
+ * external ids.
+ */
+typedef struct s_export_options {
+    long long max_edges; // write at most this many edges, 0 = no cap
+    double sample_rate;  // keep each edge with this probability, in ]0, 1] (1 = all)
+    uint64_t seed;       // seed of the sampling
+    const t_id_map *ids; // external ids of the vertices, NULL = vertex numbers
+} t_export_options;
+
+/**
+ * @brief Options that export everything.
+ * @return The options
+ */
+t_export_options DefaultExportOptions(void);
+
+/**
+ * @brief Writes the alphabetic ID of a vertex (1 -> A, 27 -> AA, ...).
+ *
+ * Reentrant replacement of the old rotating static buffer.
+ *
+ * @param vertex Vertex number (1-based)
+ * @param out Destination, at least 16 chars
+ * @return Length of the ID
+ */
+int vertex_alpha_id(int vertex, char *out);
+
+/**
+ * @brief Exports the graph in Mermaid format (same layout as exportToMermaid()).
+ * @param graph The graph
+ * @param filename Output file
+ * @param options Limits, NULL to export everything
+ * @return MARKOV_OK, MARKOV_ERR_IO or MARKOV_ERR_ALLOC
+ */
+int ExportGraphMermaid(t_adjacency_list graph, const char *filename, const t_export_options *options);
+
+/**
+ * @brief Exports the graph in Graphviz DOT format.
+ * @param graph The graph
+ * @param filename Output file
+ * @param options Limits, NULL to export everything
+ * @return MARKOV_OK, MARKOV_ERR_IO or MARKOV_ERR_ALLOC
+ */
+int ExportGraphDot(t_adjacency_list graph, const char *filename, const t_export_options *options);
+
+/**
+ * @brief Exports the Hasse diagram in Mermaid format (same layout as print_hasse_mermaid()).
+ * @param partition The partition
+ * @param links Links between classes
+ * @param filename Output file
+ * @param ids External ids of the vertices, NULL to print the vertex numbers
+ * @return MARKOV_OK, MARKOV_ERR_IO or MARKOV_ERR_ALLOC
+ */
+int ExportHasseMermaid(const t_partition *partition, const t_link_array *links, const char *filename,
+                       const t_id_map *ids);
+
+/**
+ * @brief Exports the Hasse diagram (classes and their links) in Graphviz DOT format.
+ * @param partition The partition
+ * @param links Links between classes
+ * @param filename Output file
+ * @param ids External ids of the vertices, NULL to print the vertex numbers
+ * @return MARKOV_OK, MARKOV_ERR_IO or MARKOV_ERR_ALLOC
+ */
+int ExportHasseDot(const t_partition *partition, const t_link_array *links, const char *filename,
+                   const t_id_map *ids);
+
+#endif //EXPORT_H
@@ -0,0 +1,497 @@
+#include "fwbw.h"
+#include "../profiling/profiling.h"
+#include <limits.h>
+#include <stdatomic.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+// smallest sub-problem split by forward-backward; smaller ones stay on the
+// task that found them and are solved by a local Tarjan (each split visits
+// its whole sub-problem, which is slow when there are many small classes)
+#define FWBW_SPLIT_SIZE 1024
+// sub-problems per thread worth splitting to keep the threads busy
+#define FWBW_SPLITS_PER_THREAD 16
+// unproductive splits in a row (one part keeps almost everything) after
+// which a sub-problem is left to Tarjan, as on wide DAGs of small classes
+#define FWBW_MAX_MISSES 3
+// color of a vertex whose class is known
+#define FWBW_DONE (-1)
+
+/**
+ * @brief Graph in compressed rows, forward and reverse.
+ */
+typedef struct s_csr {
+    int *start;  // n + 1 offsets
+    int *target; // 0-based vertices
+} t_csr;
+
+/**
+ * @brief State shared by the tasks of one decomposition.
+ *
+ * Each sub-problem owns a segment of order[] and a color: the vertices of
+ * the segment are exactly the vertices of that color. A task only recolors
+ * its own vertices, with fresh colors, so the colors it reads on the other
+ * vertices never become its own.
+ */
+typedef struct s_fwbw {
+    int n;
+    t_csr forward;
+    t_csr backward;
+    atomic_int *color;    // per vertex: color of its sub-problem, FWBW_DONE once classified
+    int *component;       // per vertex: class number (unordered)
+    int *order;           // vertices, grouped by sub-problem
+    int *index;           // per vertex: visit number of the local Tarjan, -1 = not visited
+    int *low;             // per vertex: lowlink of the local Tarjan
+    atomic_int next_color;
+    atomic_int next_component;
+    atomic_int failed;    // an allocation failed in a task
+    int split_size;       // smallest sub-problem to split
+    t_scheduler *scheduler;
+    t_task_group group;
+} t_fwbw;
+
+/**
+ * @brief A sub-problem: the vertices order[begin, end), all of color color.
+ */
+typedef struct s_fwbw_task {
+    t_fwbw *state;
+    int begin;
+    int end;
+    int color;
+    int misses; // unproductive splits that led to this sub-problem
+} t_fwbw_task;
+
+/**
+ * @brief Builds the forward and backward rows of a graph, with two passes
+ *        over the lists (one to count, one to fill).
+ * @return 0 on success, -1 on allocation error
+ */
+static int build_csr(t_adjacency_list graph, t_csr *forward, t_csr *backward) {
+    int n = graph.size;
+    forward->start = (int *)calloc(n + 1, sizeof(int));
+    backward->start = (int *)calloc(n + 1, sizeof(int));
+    if (forward->start == NULL || backward->start == NULL) return -1;
+
+    for (int u = 0; u < n; u++) {
+        for (t_cell *c = graph.array[u].head; c != NULL; c = c->next) {
+            int v = c->arrival - 1;
+            if (v < 0 || v >= n) continue;
+            forward->start[u + 1]++;
+            backward->start[v + 1]++;
+        }
+    }
+    for (int u = 0; u < n; u++) {
+        forward->start[u + 1] += forward->start[u];
+        backward->start[u + 1] += backward->start[u];
+    }
+
+    int m = forward->start[n] > 0 ? forward->start[n] : 1;
+    forward->target = (int *)malloc(m * sizeof(int));
+    backward->target = (int *)malloc(m * sizeof(int));
+    int *fill = (int *)malloc((n > 0 ? n : 1) * sizeof(int));
+    if (forward->target == NULL || backward->target == NULL || fill == NULL) {
+        free(fill);
+        return -1;
+    }
+    // the forward rows are filled in list order, the backward ones through fill[]
+    for (int u = 0; u < n; u++) fill[u] = backward->start[u];
+    int e = 0;
+    for (int u = 0; u < n; u++) {
+        for (t_cell *c = graph.array[u].head; c != NULL; c = c->next) {
+            int v = c->arrival - 1;
+            if (v < 0 || v >= n) continue;
+            forward->target[e++] = v;
+            backward->target[fill[v]++] = u;
+        }
+    }
+    free(fill);
+    return 0;
+}
+
+static void free_csr(t_csr *csr) {
+    free(csr->start);
+    free(csr->target);
+}
+
+/**
+ * @brief Removes, one at a time, the vertices with no remaining predecessor
+ *        or successor: each is a class of its own.
+ * @return Number of vertices left, in order[0, left); -1 on allocation error
+ */
+static int trim(t_fwbw *st) {
+    int n = st->n;
+    int *in = (int *)malloc(n * sizeof(int));
+    int *out = (int *)malloc(n * sizeof(int));
+    int *queue = (int *)malloc(n * sizeof(int));
+    if (in == NULL || out == NULL || queue == NULL) {
+        free(in); free(out); free(queue);
+        return -1;
+    }
+
+    int head = 0, tail = 0;
+    for (int v = 0; v < n; v++) {
+        in[v] = st->backward.start[v + 1] - st->backward.start[v];
+        out[v] = st->forward.start[v + 1] - st->forward.start[v];
+        if (in[v] == 0 || out[v] == 0) {
+            atomic_store_explicit(&st->color[v], FWBW_DONE, memory_order_relaxed);
+            queue[tail++] = v;
+        }
+    }
+    while (head < tail) {
+        int v = queue[head++];
+        st->component[v] = atomic_fetch_add(&st->next_component, 1);
+        // the neighbors lose an edge
+        for (int e = st->forward.start[v]; e < st->forward.start[v + 1]; e++) {
+            int w = st->forward.target[e];
+            if (atomic_load_explicit(&st->color[w], memory_order_relaxed) == FWBW_DONE) continue;
+            if (--in[w] == 0) {
+                atomic_store_explicit(&st->color[w], FWBW_DONE, memory_order_relaxed);
+                queue[tail++] = w;
+            }
+        }
+        for (int e = st->backward.start[v]; e < st->backward.start[v + 1]; e++) {
+            int u = st->backward.target[e];
+            if (atomic_load_explicit(&st->color[u], memory_order_relaxed) == FWBW_DONE) continue;
+            if (--out[u] == 0) {
+                atomic_store_explicit(&st->color[u], FWBW_DONE, memory_order_relaxed);
+                queue[tail++] = u;
+            }
+        }
+    }
+
+    int left = 0;
+    for (int v = 0; v < n; v++) {
+        if (atomic_load_explicit(&st->color[v], memory_order_relaxed) != FWBW_DONE) st->order[left++] = v;
+    }
+    free(in); free(out); free(queue);
+    return left;
+}
+
+/**
+ * @brief Visits, from the vertices already in queue[0, tail), the vertices of
+ *        color from along the rows of csr, recoloring them to color to.
+ *        With done >= 0, the vertices of color done are visited too and
+ *        classified (color FWBW_DONE, class component).
+ * @return The new tail
+ */
+static int search(t_fwbw *st, const t_csr *csr, int *queue, int tail, int from, int to, int done, int component) {
+    for (int head = 0; head < tail; head++) {
+        int v = queue[head];
+        for (int e = csr->start[v]; e < csr->start[v + 1]; e++) {
+            int w = csr->target[e];
+            int c = atomic_load_explicit(&st->color[w], memory_order_relaxed);
+            if (c == from) {
+                atomic_store_explicit(&st->color[w], to, memory_order_relaxed);
+                queue[tail++] = w;
+            } else if (done >= 0 && c == done) {
+                atomic_store_explicit(&st->color[w], FWBW_DONE, memory_order_relaxed);
+                st->component[w] = component;
+                queue[tail++] = w;
+            }
+        }
+    }
+    return tail;
+}
+
+static void fwbw_task_run(void *arg);
+
+/**
+ * @brief Hands a sub-problem to another task, or keeps it on the local stack
+ *        when it is too small to be split.
+ * @return 0 on success, -1 on allocation error
+ */
+static int push_sub_problem(t_fwbw_task sub, t_fwbw_task **stack, int *nb, int *capacity) {
+    if (sub.end <= sub.begin) return 0;
+    if (sub.end - sub.begin >= sub.state->split_size) {
+        t_fwbw_task *task = (t_fwbw_task *)malloc(sizeof(t_fwbw_task));
+        if (task != NULL) {
+            *task = sub;
+            scheduler_spawn(sub.state->scheduler, &sub.state->group, fwbw_task_run, task);
+            return 0;
+        }
+    }
+    if (*nb >= *capacity) {
+        int new_capacity = *capacity > 0 ? 2 * *capacity : 16;
+        t_fwbw_task *temp = (t_fwbw_task *)realloc(*stack, new_capacity * sizeof(t_fwbw_task));
+        if (temp == NULL) return -1;
+        *stack = temp;
+        *capacity = new_capacity;
+    }
+    (*stack)[(*nb)++] = sub;
+    return 0;
+}
+
+/**
+ * @brief Splits one sub-problem: finds the class of a pivot, then regroups
+ *        the forward-only, backward-only and unreached vertices in three
+ *        segments of order[begin, end) with fresh colors.
+ * @return 0 on success, -1 on allocation error
+ */
+static int split(t_fwbw *st, t_fwbw_task *t, int *queue, t_fwbw_task **stack, int *nb, int *capacity) {
+    int begin = t->begin, end = t->end, color = t->color;
+
+    // pseudo-random pivot: on a chain of classes, the first vertex would
+    // often be an end and leave one large sub-problem at every step
+    uint64_t h = ((uint64_t)begin * 0x9e3779b97f4a7c15ULL) ^ ((uint64_t)end * 0xbf58476d1ce4e5b9ULL);
+    h ^= h >> 31;
+    int pivot = st->order[begin + (int)(h % (uint64_t)(end - begin))];
+
+    int forward = atomic_fetch_add(&st->next_color, 1);
+    int backward = atomic_fetch_add(&st->next_color, 1);
+    int component = atomic_fetch_add(&st->next_component, 1);
+
+    // forward: the vertices reached from the pivot take the color forward
+    atomic_store_explicit(&st->color[pivot], forward, memory_order_relaxed);
+    queue[0] = pivot;
+    search(st, &st->forward, queue, 1, color, forward, -1, 0);
+
+    // backward: reached and forward = class of the pivot, reached only = backward
+    atomic_store_explicit(&st->color[pivot], FWBW_DONE, memory_order_relaxed);
+    st->component[pivot] = component;
+    queue[0] = pivot;
+    search(st, &st->backward, queue, 1, color, backward, forward, component);
+
+    // regroup order[begin, end) as [forward | backward | unreached]
+    int nb_forward = 0, nb_backward = 0, nb_rest = 0;
+    for (int i = begin; i < end; i++) {
+        int c = atomic_load_explicit(&st->color[st->order[i]], memory_order_relaxed);
+        if (c == forward) nb_forward++;
+        else if (c == backward) nb_backward++;
+        else if (c == color) nb_rest++;
+    }
+    int f = 0, b = nb_forward, r = nb_forward + nb_backward;
+    for (int i = begin; i < end; i++) {
+        int v = st->order[i];
+        int c = atomic_load_explicit(&st->color[v], memory_order_relaxed);
+        if (c == forward) queue[f++] = v;
+        else if (c == backward) queue[b++] = v;
+        else if (c == color) queue[r++] = v;
+    }
+    for (int i = 0; i < r; i++) st->order[begin + i] = queue[i];
+
+    int b0 = begin + nb_forward, r0 = b0 + nb_backward;
+    t_fwbw_task parts[3] = {
+        { st, begin, b0, forward, 0 },
+        { st, b0, r0, backward, 0 },
+        { st, r0, r0 + nb_rest, color, 0 }
+    };
+    for (int p = 0; p < 3; p++) {
+        // a part keeping more than 7/8 of the vertices: the split hardly helped
+        if (8LL * (parts[p].end - parts[p].begin) > 7LL * (end - begin)) parts[p].misses = t->misses + 1;
+        if (push_sub_problem(parts[p], stack, nb, capacity) != 0) return -1;
+    }
+    return 0;
+}
+
+/**
+ * @brief Classifies a small sub-problem with an iterative Tarjan restricted
+ *        to its color. work holds 3 * (end - begin) ints.
+ */
+static void tarjan_segment(t_fwbw *st, const t_fwbw_task *t, int *work) {
+    int k = t->end - t->begin;
+    int *stack = work;          // Tarjan stack
+    int *call = work + k;       // DFS path
+    int *edge = work + 2 * k;   // next edge of each vertex of the path
+    int counter = 0, sp = 0;
+
+    for (int i = t->begin; i < t->end; i++) {
+        int root = st->order[i];
+        if (st->index[root] != -1) continue;
+        st->index[root] = st->low[root] = counter++;
+        stack[sp++] = root;
+        call[0] = root;
+        edge[0] = st->forward.start[root];
+        int depth = 1;
+
+        while (depth > 0) {
+            int v = call[depth - 1];
+            if (edge[depth - 1] < st->forward.start[v + 1]) {
+                int w = st->forward.target[edge[depth - 1]++];
+                // other colors are other sub-problems, FWBW_DONE finished classes
+                if (atomic_load_explicit(&st->color[w], memory_order_relaxed) != t->color) continue;
+                if (st->index[w] == -1) {
+                    st->index[w] = st->low[w] = counter++;
+                    stack[sp++] = w;
+                    call[depth] = w;
+                    edge[depth] = st->forward.start[w];
+                    depth++;
+                } else if (st->index[w] < st->low[v]) {
+                    st->low[v] = st->index[w];
+                }
+                continue;
+            }
+            depth--;
+            if (st->low[v] == st->index[v]) {
+                // v is the root of a class: pop it
+                int component = atomic_fetch_add(&st->next_component, 1);
+                int w;
+                do {
+                    w = stack[--sp];
+                    atomic_store_explicit(&st->color[w], FWBW_DONE, memory_order_relaxed);
+                    st->component[w] = component;
+                } while (w != v);
+            }
+            if (depth > 0 && st->low[v] < st->low[call[depth - 1]]) st->low[call[depth - 1]] = st->low[v];
+        }
+    }
+}
+
+/**
+ * @brief Task body: splits its sub-problem and the small ones it produces.
+ */
+static void fwbw_task_run(void *arg) {
+    t_fwbw_task first = *(t_fwbw_task *)arg;
+    t_fwbw *st = first.state;
+    free(arg);
+
+    // sub-problems only shrink, so queue is large enough for all of them
+    int *queue = (int *)malloc(3 * (size_t)(first.end - first.begin) * sizeof(int));
+    t_fwbw_task *stack = NULL;
+    int nb = 0, capacity = 0;
+    int ok = queue != NULL;
+    if (ok) {
+        stack = (t_fwbw_task *)malloc(sizeof(t_fwbw_task));
+        ok = stack != NULL;
+        if (ok) {
+            stack[nb++] = first;
+            capacity = 1;
+        }
+    }
+    while (ok && nb > 0) {
+        t_fwbw_task t = stack[--nb];
+        if (t.end - t.begin < st->split_size || t.misses >= FWBW_MAX_MISSES) tarjan_segment(st, &t, queue);
+        else ok = split(st, &t, queue, &stack, &nb, &capacity) == 0;
+    }
+    if (!ok) atomic_store(&st->failed, 1);
+    free(queue);
+    free(stack);
+}
+
+/**
+ * @brief Numbers the classes in reverse topological order (sinks first,
+ *        ties by smallest vertex) and builds the partition.
+ */
+static p_partition build_partition(t_fwbw *st) {
+    int n = st->n;
+    int nb = atomic_load(&st->next_component);
+    int *label = (int *)malloc((nb > 0 ? nb : 1) * sizeof(int));   // class number -> rank by smallest vertex
+    int *count = (int *)calloc(nb + 1, sizeof(int));                // vertices, then first vertex, per rank
+    int *members = (int *)malloc((n > 0 ? n : 1) * sizeof(int));
+    int *out = (int *)calloc(nb > 0 ? nb : 1, sizeof(int));          // links to classes not yet numbered
+    int *queue = (int *)malloc((nb > 0 ? nb : 1) * sizeof(int));
+    p_partition part = CreatePartition();
+    if (!label || !count || !members || !out || !queue || !part) goto fail;
+
+    // deterministic class numbers: by smallest vertex
+    for (int c = 0; c < nb; c++) label[c] = -1;
+    int next = 0;
+    for (int v = 0; v < n; v++) {
+        int c = st->component[v];
+        if (label[c] < 0) label[c] = next++;
+        st->component[v] = label[c];
+        count[label[c] + 1]++;
+    }
+    for (int c = 0; c < nb; c++) count[c + 1] += count[c];
+    for (int v = 0; v < n; v++) members[count[st->component[v]]++] = v;
+    for (int c = nb; c > 0; c--) count[c] = count[c - 1];
+    count[0] = 0;
+
+    // Kahn's algorithm on the reversed links, starting from the sinks
+    for (int v = 0; v < n; v++) {
+        for (int e = st->forward.start[v]; e < st->forward.start[v + 1]; e++) {
+            if (st->component[st->forward.target[e]] != st->component[v]) out[st->component[v]]++;
+        }
+    }
+    int head = 0, tail = 0;
+    for (int c = 0; c < nb; c++) if (out[c] == 0) queue[tail++] = c;
+    while (head < tail) {
+        int c = queue[head++];
+        char name[16];
+        snprintf(name, sizeof(name), "C%d", head);
+        name[9] = '\0'; // CreateClass keeps 10 characters, as tarjan()
+        p_class cls = CreateClass(name);
+        if (cls == NULL || AddClassToPartition(part, cls) != 0) {
+            DestroyClass(cls);
+            goto fail;
+        }
+        for (int i = count[c]; i < count[c + 1]; i++) {
+            int v = members[i];
+            if (AddVertexToClass(cls, v + 1) != 0) goto fail;
+            for (int e = st->backward.start[v]; e < st->backward.start[v + 1]; e++) {
+                int p = st->component[st->backward.target[e]];
+                if (p != c && --out[p] == 0) queue[tail++] = p;
+            }
+        }
+    }
+    free(label); free(count); free(members); free(out); free(queue);
+    return part;
+
+fail:
+    free(label); free(count); free(members); free(out); free(queue);
+    DestroyPartition(part);
+    return NULL;
+}
+
+/**
+ * @brief Strongly connected classes by forward-backward decomposition.
+ * @param graph The graph.
+ * @param s Scheduler running the tasks (NULL = the calling thread only).
+ * @return p_partition The partition, NULL on allocation error.
+ */
+p_partition ForwardBackwardSCC(t_adjacency_list graph, t_scheduler *s) {
+    if (graph.size <= 0) return CreatePartition();
+    PROF_BEGIN(PROF_STAGE_TARJAN);
+    int n = graph.size;
+
+    t_fwbw st = { 0 };
+    st.n = n;
+    st.scheduler = s;
+    st.color = (atomic_int *)malloc(n * sizeof(atomic_int));
+    st.component = (int *)malloc(n * sizeof(int));
+    st.order = (int *)malloc(n * sizeof(int));
+    st.index = (int *)malloc(n * sizeof(int));
+    st.low = (int *)malloc(n * sizeof(int));
+    atomic_init(&st.next_color, 1); // 0 = color of the vertices left by the trim
+    atomic_init(&st.next_component, 0);
+    atomic_init(&st.failed, 0);
+    task_group_init(&st.group);
+
+    p_partition part = NULL;
+    int ok = st.color && st.component && st.order
+             && st.index && st.low && build_csr(graph, &st.forward, &st.backward) == 0;
+    if (ok) {
+        for (int v = 0; v < n; v++) {
+            atomic_init(&st.color[v], 0);
+            st.index[v] = -1;
+        }
+        int left = trim(&st);
+        ok = left >= 0;
+        // split until there are a few sub-problems per thread; alone, the
+        // calling thread runs Tarjan on everything the trim left
+        int nb_threads = scheduler_nb_threads(s);
+        st.split_size = nb_threads > 1 ? left / (FWBW_SPLITS_PER_THREAD * nb_threads) : INT_MAX;
+        if (st.split_size < FWBW_SPLIT_SIZE) st.split_size = FWBW_SPLIT_SIZE;
+        if (ok && left > 0) {
+            t_fwbw_task *root = (t_fwbw_task *)malloc(sizeof(t_fwbw_task));
+            ok = root != NULL;
+            if (ok) {
+                *root = (t_fwbw_task){ &st, 0, left, 0, 0 };
+                fwbw_task_run(root);
+                scheduler_wait(s, &st.group);
+                ok = !atomic_load(&st.failed);
+            }
+        }
+    }
+    if (ok) part = build_partition(&st);
+
+    free_csr(&st.forward);
+    free_csr(&st.backward);
+    free(st.color);
+    free(st.component);
+    free(st.order);
+    free(st.index);
+    free(st.low);
+    PROF_END(PROF_STAGE_TARJAN);
+    return part;
+}
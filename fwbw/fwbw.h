@@ -0,0 +1,29 @@
+#ifndef FWBW_H
+#define FWBW_H
+
+#include "../adjacency_list/adjacency_list.h"
+#include "../tarjan/tarjan.h"
+#include "../scheduler/scheduler.h"
+
+/**
+ * @brief Strongly connected classes by forward-backward decomposition, a
+ *        parallel alternative to tarjan().
+ *
+ * The vertices with no predecessor or no successor are first trimmed off as
+ * single classes. The rest is split recursively: from a pivot, the vertices
+ * both reached forward and backward form its class, and the forward-only,
+ * backward-only and unreached vertices are three independent sub-problems,
+ * handed to the scheduler as separate tasks.
+ *
+ * The result has the layout of tarjan(): classes in reverse topological
+ * order (no link from a class towards a later one), named "C1", "C2", ...
+ * It does not depend on the number of threads, but the order of
+ * independent classes may differ from tarjan()'s.
+ *
+ * @param graph The graph (arrivals outside [1, n] are ignored, as in tarjan()).
+ * @param s Scheduler running the tasks (NULL = the calling thread only).
+ * @return The partition (free with DestroyPartition), NULL on allocation error.
+ */
+p_partition ForwardBackwardSCC(t_adjacency_list graph, t_scheduler *s);
+
+#endif //FWBW_H
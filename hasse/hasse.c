@@ -1,4 +1,6 @@
 #include "hasse.h"
+#include "../profiling/profiling.h"
+#include "../scheduler/scheduler.h"
 #include <stdio.h>
 #include <string.h>
 #include <stdlib.h>
@@ -19,21 +21,27 @@ void links_init(t_link_array *a) {
  * @param a Pointer to the link array
  * @param start Origin class index
  * @param end Destination class index
+ * @return 0 on success, -1 on allocation error (the array is left unchanged)
  */
-void links_add(t_link_array *a, int start, int end) {
+int links_add(t_link_array *a, int start, int end) {
     // Prevent duplicate links
     for (int i = 0; i < a->size; ++i) {
-        if (a->links[i].start == start && a->links[i].end == end) return;
+        if (a->links[i].start == start && a->links[i].end == end) return 0;
     }
 
     // Resize array if needed
     if (a->size == a->length) {
-        a->length = (a->length == 0) ? 8 : a->length * 2;
-        a->links = (t_link*)realloc(a->links, a->length * sizeof *a->links);
+        int length = (a->length == 0) ? 8 : a->length * 2;
+        t_link *temp = (t_link*)realloc(a->links, length * sizeof *a->links);
+        PROF_COUNT(PROF_ALLOCATIONS, 1);
+        if (temp == NULL) return -1;
+        a->links = temp;
+        a->length = length;
     }
 
     // Insert new link
     a->links[a->size++] = (t_link){ start, end };
+    return 0;
 }
 
 /**
@@ -45,6 +53,7 @@ void links_add(t_link_array *a, int start, int end) {
 int *create_vertex_class_array(int vertex_count, const t_partition *partition) {
     // vertex_class[v] will store the index of the class that vertex v belongs to.
     int *vertex_class = (int*)malloc(vertex_count * sizeof *vertex_class);
+    PROF_COUNT(PROF_ALLOCATIONS, 1);
     if (!vertex_class) return NULL;
 
     // Here, -1 means: this vertex has not been assigned to any class yet.
@@ -71,8 +80,11 @@ int *create_vertex_class_array(int vertex_count, const t_partition *partition) {
  * @param graph Pointer to the adjacency list
  * @param vertex_to_class Mapping from vertex to class
  * @param class_links Output: list of links between classes
+ * @return 0 on success, -1 on allocation error
  */
-void list_class_links(const t_adjacency_list *graph, const int *vertex_to_class, t_link_array *class_links) {
+int list_class_links(const t_adjacency_list *graph, const int *vertex_to_class, t_link_array *class_links) {
+    PROF_BEGIN(PROF_STAGE_CLASS_LINKS);
+    int status = 0;
     // For each vertex i in the graph
     for (int i= 0; i < graph->size; ++i) {
         // Ci = class of vertex i
@@ -83,6 +95,7 @@ void list_class_links(const t_adjacency_list *graph, const int *vertex_to_class,
         while (neighbor != NULL) {
             int j_id= neighbor->arrival; // Neighbor vertex ID
             int j = j_id - 1; // Convert to 0-based index
+            PROF_COUNT(PROF_EDGES_SCANNED, 1);
 
             if (j >= 0 && j < graph->size) {
                 // Cj = class of neighbor j
@@ -92,57 +105,73 @@ void list_class_links(const t_adjacency_list *graph, const int *vertex_to_class,
                 if (Ci != Cj) {
                     // Add the link (Ci → Cj) unless it already exists.
                     // links_add() handles duplicate prevention and resizing.
-                    links_add(class_links, Ci, Cj);
+                    if (links_add(class_links, Ci, Cj) != 0) status = -1;
                 }
             }
             // Move to the next neighbor in the adjacency list
             neighbor = neighbor->next;
         }
     }
+    PROF_END(PROF_STAGE_CLASS_LINKS);
+    return status;
 }
 
 /**
- * @brief Writes a Mermaid Hasse diagram to a file.
+ * @brief Writes a Mermaid Hasse diagram.
+ * @param w Destination writer
  * @param P Pointer to the partition structure
  * @param L Pointer to the list of class links
- * @param filename Output file path
+ * @param ids External ids of the vertices, NULL to print the vertex numbers
  */
-void print_hasse_mermaid(const t_partition *P, const t_link_array *L, const char *filename)
+void write_hasse_mermaid(t_writer *w, const t_partition *P, const t_link_array *L, const t_id_map *ids)
 {
-    FILE *file = fopen(filename, "wt");
-    if (file == NULL) {
-        perror("Could not open file for writing");
-        exit(EXIT_FAILURE);
-    }
-
     // Mermaid front‑matter
-    fprintf(file, "---\n");
-    fprintf(file, "config:\n");
-    fprintf(file, "   layout: elk\n");
-    fprintf(file, "   theme: neo\n");
-    fprintf(file, "   look: neo\n");
-    fprintf(file, "---\n\n");
+    writer_puts(w, "---\nconfig:\n   layout: elk\n   theme: neo\n   look: neo\n---\n\n");
 
-    fprintf(file,"flowchart TD\n");
+    writer_puts(w, "flowchart TD\n");
 
     // Print classes
     for (int c = 0; c < P->nb_class; ++c) {
         const t_class *cls = P->classes[c];
-        fprintf(file,"  C%d[\"", c+1);
+        writer_puts(w, "  C");
+        writer_int(w, c + 1);
+        writer_puts(w, "[\"");
         for (int k = 0; k < cls->nb_vertices; ++k) {
-            if (k) fprintf(file,", ");
-            fprintf(file,"%d", cls->vertices[k]);
+            if (k) writer_puts(w, ", ");
+            write_vertex_id(w, ids, cls->vertices[k]);
         }
-        fprintf(file, "\"]\n");
+        writer_puts(w, "\"]\n");
     }
 
     // Print links
     for (int i = 0; i < L->size; ++i) {
-        fprintf(file,"  C%d --> C%d\n", L->links[i].start + 1, L->links[i].end + 1);
+        writer_puts(w, "  C");
+        writer_int(w, L->links[i].start + 1);
+        writer_puts(w, " --> C");
+        writer_int(w, L->links[i].end + 1);
+        writer_char(w, '\n');
     }
+}
 
-    fclose(file);
-    printf("Mermaid file '%s' generated successfully.\n", filename);
+/**
+ * @brief Writes a Mermaid Hasse diagram to a file.
+ * @param P Pointer to the partition structure
+ * @param L Pointer to the list of class links
+ * @param filename Output file path
+ * @return 0 on success, -1 if the file cannot be written
+ */
+int print_hasse_mermaid(const t_partition *P, const t_link_array *L, const char *filename)
+{
+    FILE *file = fopen(filename, "wt");
+    if (file == NULL) {
+        return -1;
+    }
+    t_writer w;
+    writer_init(&w, file, 0);
+    write_hasse_mermaid(&w, P, L, NULL);
+    int status = writer_close(&w);
+    if (fclose(file) != 0) status = -1;
+    return status;
 }
 
 /**
@@ -151,6 +180,7 @@ void print_hasse_mermaid(const t_partition *P, const t_link_array *L, const char
  */
 void removeTransitiveLinks(t_link_array *p_link_array)
 {
+    PROF_BEGIN(PROF_STAGE_TRANSITIVE_REDUCTION);
     int i = 0;
     // Iterate over each candidate link (A -> C)
     while (i < p_link_array->size) {
@@ -182,6 +212,7 @@ void removeTransitiveLinks(t_link_array *p_link_array)
             i++;
         }
     }
+    PROF_END(PROF_STAGE_TRANSITIVE_REDUCTION);
 }
 
 
@@ -243,7 +274,6 @@ int is_state_absorbing(int class_id, t_partition *partition, t_link_array *class
  */
 int is_graph_irreducible(t_partition *partition) {
     if (partition == NULL) {
-        printf("Error: NULL partition provided\n");
         return 0;
     }
 
@@ -251,69 +281,242 @@ int is_graph_irreducible(t_partition *partition) {
 }
 
 /**
- * @brief Displays all graph characteristics: class types, state types,
- *        absorbing states, and overall reducibility.
+ * @brief Marks the transient classes in one pass over the links.
  * @param partition Pointer to the partition
  * @param class_links Pointer to class‑to‑class link array
+ * @return Newly allocated array, 1 for a transient class and 0 for a persistent one, NULL on error
  */
-void display_graph_characteristics(t_partition *partition, t_link_array *class_links) {
+int *classify_classes(const t_partition *partition, const t_link_array *class_links) {
+    if (partition == NULL || class_links == NULL) return NULL;
+    int *transient = (int *)calloc(partition->nb_class > 0 ? partition->nb_class : 1, sizeof(int));
+    if (transient == NULL) return NULL;
+    // a class with a link towards another class is transient
+    for (int i = 0; i < class_links->size; i++) {
+        int start = class_links->links[i].start;
+        if (start >= 0 && start < partition->nb_class && class_links->links[i].end != start) {
+            transient[start] = 1;
+        }
+    }
+    return transient;
+}
 
-    printf("For classes:\n");
+/**
+ * @brief Writes all graph characteristics: class types, state types,
+ *        absorbing states, and overall reducibility.
+ * @param w Destination writer
+ * @param partition Pointer to the partition
+ * @param transient Transient flag of each class (from classify_classes)
+ * @param ids External ids of the vertices, NULL to print the vertex numbers
+ */
+void write_graph_characteristics(t_writer *w, const t_partition *partition, const int *transient, const t_id_map *ids) {
+    writer_puts(w, "For classes:\n");
     for (int i = 0; i < partition->nb_class; i++) {
         t_class *current_class = partition->classes[i];
 
-        printf("  Class %s (Class #%d) {", current_class->name, i + 1);
+        writer_printf(w, "  Class %s (Class #%d) {", current_class->name, i + 1);
         for (int j = 0; j < current_class->nb_vertices; j++) {
-            if (j > 0) printf(", ");
-            printf("%d", current_class->vertices[j]);
+            if (j > 0) writer_puts(w, ", ");
+            write_vertex_id(w, ids, current_class->vertices[j]);
         }
-        printf("}: ");
+        writer_puts(w, "}: ");
 
-        printf(is_class_transient(i, class_links) ? "transient\n" : "persistent\n");
+        writer_puts(w, transient[i] ? "transient\n" : "persistent\n");
     }
 
-    printf("\nFor states (transient or absorbing):\n");
+    writer_puts(w, "\nFor states (transient or absorbing):\n");
     for (int i = 0; i < partition->nb_class; i++) {
         t_class *current_class = partition->classes[i];
+        // single‑vertex persistent class = absorbing
+        int absorbing = !transient[i] && current_class->nb_vertices == 1;
 
         for (int j = 0; j < current_class->nb_vertices; j++) {
-            int vertex = current_class->vertices[j];
-            printf("  State %d (in %s, Class #%d): ",
-                   vertex, current_class->name, i + 1);
-
-            if (is_class_transient(i, class_links)) {
-                printf("transient\n");
-            } else {
-                printf("persistent");
-                if (is_state_absorbing(i, partition, class_links)) {
-                    printf(", absorbing\n");
-                } else {
-                    printf("\n");
-                }
-            }
+            writer_puts(w, "  State ");
+            write_vertex_id(w, ids, current_class->vertices[j]);
+            writer_printf(w, " (in %s, Class #%d): %s\n", current_class->name, i + 1,
+                          transient[i] ? "transient" : absorbing ? "persistent, absorbing" : "persistent");
         }
     }
 
-    printf("\nFor states (absorbing):\n");
+    writer_puts(w, "\nFor states (absorbing):\n");
     int has_absorbing = 0;
     for (int i = 0; i < partition->nb_class; i++) {
-        if (is_state_absorbing(i, partition, class_links)) {
-            t_class *current_class = partition->classes[i];
-            printf("  State %d (in %s, Class #%d) is absorbing\n",
-                   current_class->vertices[0], current_class->name, i + 1);
+        t_class *current_class = partition->classes[i];
+        if (!transient[i] && current_class->nb_vertices == 1) {
+            writer_puts(w, "  State ");
+            write_vertex_id(w, ids, current_class->vertices[0]);
+            writer_printf(w, " (in %s, Class #%d) is absorbing\n", current_class->name, i + 1);
             has_absorbing = 1;
         }
     }
     if (!has_absorbing) {
-        printf("  No absorbing states\n");
+        writer_puts(w, "  No absorbing states\n");
     }
 
-    printf("\nIs the graph reductible:\n");
-    if (is_graph_irreducible(partition)) {
-        printf("  The Markov graph is irreducible\n");
+    writer_puts(w, "\nIs the graph reductible:\n");
+    if (partition->nb_class == 1) {
+        writer_puts(w, "  The Markov graph is irreducible\n");
     } else {
-        printf("  The Markov graph is reducible\n");
+        writer_puts(w, "  The Markov graph is reducible\n");
+    }
+
+    writer_puts(w, "\n");
+}
+
+/**
+ * @brief Displays all graph characteristics: class types, state types,
+ *        absorbing states, and overall reducibility.
+ * @param partition Pointer to the partition
+ * @param class_links Pointer to class‑to‑class link array
+ */
+void display_graph_characteristics(t_partition *partition, t_link_array *class_links) {
+    int *transient = classify_classes(partition, class_links);
+    if (transient == NULL) return;
+
+    t_writer w;
+    writer_init(&w, stdout, 0);
+    write_graph_characteristics(&w, partition, transient, NULL);
+    writer_close(&w);
+    free(transient);
+}
+
+/**
+ * @brief Computes a topological order of the classes and the level of each
+ *        class, then groups the classes by level.
+ * @param nb_classes Number of classes
+ * @param class_links Links between the classes (duplicates allowed)
+ * @param from_sinks 0: level = longest path from a source, 1: longest path to a sink
+ * @param levels Output (free with class_levels_free)
+ * @return 0 on success, -1 on allocation error, bad link or cycle
+ */
+int class_levels_build(int nb_classes, const t_link_array *class_links, int from_sinks, t_class_levels *levels) {
+    if (levels == NULL) return -1;
+    memset(levels, 0, sizeof(t_class_levels));
+    if (class_links == NULL || nb_classes < 0) return -1;
+    int nb = nb_classes > 0 ? nb_classes : 1;
+    int nb_links = class_links->size;
+
+    levels->nb_classes = nb_classes;
+    levels->order = (int *)malloc(nb * sizeof(int));
+    levels->level = (int *)calloc(nb, sizeof(int));
+    int *succ_start = (int *)calloc(nb + 1, sizeof(int));
+    int *succ = (int *)malloc((nb_links > 0 ? nb_links : 1) * sizeof(int));
+    int *in_degree = (int *)calloc(nb, sizeof(int));
+    PROF_COUNT(PROF_ALLOCATIONS, 5);
+    int status = (levels->order && levels->level && succ_start && succ && in_degree) ? 0 : -1;
+
+    // successors of each class, in compressed rows
+    for (int i = 0; i < nb_links && status == 0; i++) {
+        int a = class_links->links[i].start, b = class_links->links[i].end;
+        if (a < 0 || a >= nb_classes || b < 0 || b >= nb_classes || a == b) status = -1;
+        else {
+            succ_start[a + 1]++;
+            in_degree[b]++;
+        }
+    }
+    if (status == 0) {
+        for (int c = 0; c < nb_classes; c++) succ_start[c + 1] += succ_start[c];
+        int *fill = (int *)malloc(nb * sizeof(int));
+        PROF_COUNT(PROF_ALLOCATIONS, 1);
+        if (fill == NULL) status = -1;
+        else {
+            memcpy(fill, succ_start, nb_classes * sizeof(int));
+            for (int i = 0; i < nb_links; i++) succ[fill[class_links->links[i].start]++] = class_links->links[i].end;
+            free(fill);
+        }
+    }
+
+    // Kahn: the order array doubles as the queue of the classes left with no predecessor
+    if (status == 0) {
+        int tail = 0;
+        for (int c = 0; c < nb_classes; c++) {
+            if (in_degree[c] == 0) levels->order[tail++] = c;
+        }
+        for (int head = 0; head < tail; head++) {
+            int a = levels->order[head];
+            for (int e = succ_start[a]; e < succ_start[a + 1]; e++) {
+                if (--in_degree[succ[e]] == 0) levels->order[tail++] = succ[e];
+            }
+        }
+        // a class never freed lies on a cycle
+        if (tail != nb_classes) status = -1;
+    }
+
+    // longest paths, relaxed along the order (from the sources) or against it (to the sinks)
+    if (status == 0) {
+        for (int k = 0; k < nb_classes; k++) {
+            int a = levels->order[from_sinks ? nb_classes - 1 - k : k];
+            for (int e = succ_start[a]; e < succ_start[a + 1]; e++) {
+                int b = succ[e];
+                if (from_sinks) {
+                    if (levels->level[b] + 1 > levels->level[a]) levels->level[a] = levels->level[b] + 1;
+                } else if (levels->level[a] + 1 > levels->level[b]) {
+                    levels->level[b] = levels->level[a] + 1;
+                }
+            }
+            if (levels->level[a] + 1 > levels->nb_levels) levels->nb_levels = levels->level[a] + 1;
+        }
+    }
+
+    // group by level, in class order inside a level (counting sort)
+    if (status == 0) {
+        levels->level_start = (int *)calloc(levels->nb_levels + 1, sizeof(int));
+        levels->by_level = (int *)malloc(nb * sizeof(int));
+        PROF_COUNT(PROF_ALLOCATIONS, 2);
+        if (levels->level_start == NULL || levels->by_level == NULL) status = -1;
+    }
+    if (status == 0) {
+        for (int c = 0; c < nb_classes; c++) levels->level_start[levels->level[c] + 1]++;
+        for (int l = 0; l < levels->nb_levels; l++) levels->level_start[l + 1] += levels->level_start[l];
+        // in_degree is all zeros after Kahn: reused as the fill cursor of each level
+        for (int c = 0; c < nb_classes; c++) {
+            int l = levels->level[c];
+            levels->by_level[levels->level_start[l] + in_degree[l]++] = c;
+        }
     }
 
-    printf("\n");
+    free(succ_start);
+    free(succ);
+    free(in_degree);
+    if (status != 0) class_levels_free(levels);
+    return status;
+}
+
+/**
+ * @brief Frees the arrays of a class level structure.
+ * @param levels The levels (may be NULL)
+ */
+void class_levels_free(t_class_levels *levels) {
+    if (levels == NULL) return;
+    free(levels->order);
+    free(levels->level);
+    free(levels->level_start);
+    free(levels->by_level);
+    memset(levels, 0, sizeof(t_class_levels));
+}
+
+typedef struct s_class_level_job {
+    t_class_fn fn;
+    void *ctx;
+    const int *classes;
+} t_class_level_job;
+
+static void class_level_range(void *arg, int begin, int end) {
+    t_class_level_job *job = (t_class_level_job *)arg;
+    for (int i = begin; i < end; i++) job->fn(job->ctx, job->classes[i]);
+}
+
+/**
+ * @brief Runs fn on every class, level after level; the classes of a level
+ *        are shared between the threads of scheduler_current().
+ * @param levels The levels (class_levels_build)
+ * @param fn Called once per class
+ * @param ctx Passed to fn
+ */
+void for_each_class_level(const t_class_levels *levels, t_class_fn fn, void *ctx) {
+    t_scheduler *s = scheduler_current();
+    t_class_level_job job = { fn, ctx, levels->by_level };
+    for (int l = 0; l < levels->nb_levels; l++) {
+        // grain 1: a class can be as costly as the rest of its level
+        scheduler_parallel_for(s, levels->level_start[l], levels->level_start[l + 1], 1, class_level_range, &job);
+    }
 }
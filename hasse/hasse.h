@@ -2,6 +2,8 @@
 #define __HASSE_H__
 
 #include "../tarjan/tarjan.h"
+#include "../writer/writer.h"
+#include "../idmap/idmap.h"
 
 /**
  * @brief Represents a directed link between two classes.
@@ -45,8 +47,9 @@ int *create_vertex_class_array(int vertex_count, const t_partition *P);
  * @param G Pointer to adjacency list of the original graph
  * @param vertex_to_class Array that maps each vertex to its class index
  * @param class_links Output structure that accumulates class‑to‑class links
+ * @return 0 on success, -1 on allocation error
  */
-void list_class_links(const t_adjacency_list *G, const int *vertex_to_class, t_link_array *class_links);
+int list_class_links(const t_adjacency_list *G, const int *vertex_to_class, t_link_array *class_links);
 
 /**
  * @brief Exports a Hasse diagram (class graph) into a Mermaid diagram file.
@@ -54,8 +57,18 @@ void list_class_links(const t_adjacency_list *G, const int *vertex_to_class, t_l
  * @param P Pointer to partition structure containing all classes
  * @param L Pointer to class link array
  * @param filename Path to the output file (.md, .mmd, ...)
+ * @return 0 on success, -1 if the file cannot be written
  */
-void print_hasse_mermaid(const t_partition *P, const t_link_array *L, const char *filename);
+int print_hasse_mermaid(const t_partition *P, const t_link_array *L, const char *filename);
+
+/**
+ * @brief Writes the Mermaid Hasse diagram of print_hasse_mermaid() to a writer.
+ * @param w Destination writer
+ * @param P Pointer to the partition structure
+ * @param L Pointer to the list of class links
+ * @param ids External ids of the vertices, NULL to print the vertex numbers
+ */
+void write_hasse_mermaid(t_writer *w, const t_partition *P, const t_link_array *L, const t_id_map *ids);
 
 /**
  * @brief Initializes a t_link_array structure.
@@ -71,8 +84,9 @@ void links_init(t_link_array *a);
  * @param a Pointer to the dynamic link array
  * @param start Origin class index
  * @param end Destination class index
+ * @return 0 on success, -1 on allocation error
  */
-void links_add(t_link_array *a, int start, int end);
+int links_add(t_link_array *a, int start, int end);
 
 /**
  * @brief Removes all links that are transitively implied by others.
@@ -141,4 +155,79 @@ int is_graph_irreducible(t_partition *partition);
  */
 void display_graph_characteristics(t_partition *partition, t_link_array *links);
 
+/**
+ * @brief Marks the transient classes (one pass over the links).
+ *
+ * @param partition Pointer to the partition structure
+ * @param links Pointer to class links
+ * @return Newly allocated array, transient[c] = 1 if class c is transient, NULL on error
+ */
+int *classify_classes(const t_partition *partition, const t_link_array *links);
+
+/**
+ * @brief Writes the report of display_graph_characteristics() to a writer.
+ *
+ * @param w Destination writer
+ * @param partition Pointer to the partition structure
+ * @param transient Transient flag of each class (from classify_classes)
+ * @param ids External ids of the vertices, NULL to print the vertex numbers
+ */
+void write_graph_characteristics(t_writer *w, const t_partition *partition, const int *transient, const t_id_map *ids);
+
+/**
+ * @brief Topological order and levels of the class graph.
+ *
+ * With levels from the sources, the level of a class is 0 if no link reaches
+ * it, else one more than the level of its deepest predecessor; with levels
+ * from the sinks, it is 0 for a class with no outgoing link (persistent), else
+ * one more than the level of its highest successor. Either way, every link
+ * joins two different levels, so the classes of one level do not depend on
+ * each other and can be processed concurrently once the lower levels are done.
+ */
+typedef struct {
+    int nb_classes;
+    int *order;        /**< Classes in topological order (each before its successors) */
+    int *level;        /**< Level of each class */
+    int nb_levels;
+    int *level_start;  /**< nb_levels + 1 offsets into by_level */
+    int *by_level;     /**< Classes sorted by level, by index inside a level */
+} t_class_levels;
+
+/**
+ * @brief Computes a topological order of the classes (Kahn) and their
+ *        longest-path levels, in O(nb_classes + links).
+ *
+ * @param nb_classes Number of classes
+ * @param class_links Links between the classes (list_class_links(); duplicates allowed)
+ * @param from_sinks 0 for levels from the sources (forward propagation),
+ *        1 for levels from the sinks (backward substitution, e.g. absorption)
+ * @param levels Output structure (free with class_levels_free)
+ * @return 0 on success, -1 on allocation error, link out of range or cycle
+ */
+int class_levels_build(int nb_classes, const t_link_array *class_links, int from_sinks, t_class_levels *levels);
+
+/**
+ * @brief Frees the arrays of a class level structure.
+ * @param levels The levels (may be NULL)
+ */
+void class_levels_free(t_class_levels *levels);
+
+/**
+ * @brief Work done on one class by for_each_class_level().
+ */
+typedef void (*t_class_fn)(void *ctx, int class_id);
+
+/**
+ * @brief Level-parallel executor: runs fn on every class, level 0 first.
+ *
+ * The classes of one level are shared between the threads of
+ * scheduler_current() and the call waits for the whole level before starting
+ * the next one; without a scheduler the classes run in by_level order.
+ *
+ * @param levels The levels (class_levels_build)
+ * @param fn Called once per class, concurrently within a level
+ * @param ctx Passed to fn
+ */
+void for_each_class_level(const t_class_levels *levels, t_class_fn fn, void *ctx);
+
 #endif
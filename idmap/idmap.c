@@ -0,0 +1,207 @@
+#include "idmap.h"
+#include <limits.h>
+#include <stdlib.h>
+#include <string.h>
+
+/**
+ * @brief Mixes the bits of an id (splitmix64 finalizer), so that ids with a
+ *        common stride do not fall in the same slots.
+ */
+static uint64_t hash_id(int64_t id) {
+    uint64_t z = (uint64_t)id;
+    z = (z ^ (z >> 30)) * 0xbf58476d1ce4e5b9ULL;
+    z = (z ^ (z >> 27)) * 0x94d049bb133111ebULL;
+    return z ^ (z >> 31);
+}
+
+/**
+ * @brief Slot of an id: the slot holding it, or the empty slot where it goes.
+ */
+static int find_slot(const t_id_map *ids, int64_t id) {
+    int mask = ids->nb_slots - 1;
+    int s = (int)(hash_id(id) & (uint64_t)mask);
+    while (ids->slots[s].index != 0 && ids->slots[s].id != id) {
+        s = (s + 1) & mask;
+    }
+    return s;
+}
+
+/**
+ * @brief Inserts every id of external[] in an empty table.
+ */
+static void fill_slots(t_id_map *ids) {
+    for (int i = 0; i < ids->count; i++) {
+        int s = find_slot(ids, ids->external[i]);
+        ids->slots[s].id = ids->external[i];
+        ids->slots[s].index = i + 1;
+    }
+}
+
+/**
+ * @brief Rebuilds the hash table with nb_slots slots.
+ * @return 0 on success, -1 on allocation error (the map is left unchanged)
+ */
+static int rehash(t_id_map *ids, int nb_slots) {
+    t_id_slot *slots = (t_id_slot *)calloc(nb_slots, sizeof(t_id_slot));
+    if (slots == NULL) return -1;
+    free(ids->slots);
+    ids->slots = slots;
+    ids->nb_slots = nb_slots;
+    fill_slots(ids);
+    return 0;
+}
+
+/**
+ * @brief Initializes an empty map.
+ * @param ids The map
+ * @param expected Expected number of ids
+ * @return 0 on success, -1 on allocation error
+ */
+int id_map_init(t_id_map *ids, int expected) {
+    if (ids == NULL) return -1;
+    if (expected < 16) expected = 16;
+    if (expected > INT_MAX / 4) expected = INT_MAX / 4;
+
+    // at most half of the slots are used
+    int nb_slots = 1;
+    while (nb_slots < 2 * expected) nb_slots <<= 1;
+
+    ids->count = 0;
+    ids->capacity = expected;
+    ids->nb_slots = nb_slots;
+    ids->external = (int64_t *)malloc((size_t)expected * sizeof(int64_t));
+    ids->slots = (t_id_slot *)calloc(nb_slots, sizeof(t_id_slot));
+    if (ids->external == NULL || ids->slots == NULL) {
+        id_map_free(ids);
+        return -1;
+    }
+    return 0;
+}
+
+/**
+ * @brief Frees the arrays of a map.
+ * @param ids The map
+ */
+void id_map_free(t_id_map *ids) {
+    if (ids == NULL) return;
+    free(ids->external);
+    free(ids->slots);
+    ids->external = NULL;
+    ids->slots = NULL;
+    ids->count = ids->capacity = ids->nb_slots = 0;
+}
+
+/**
+ * @brief Returns the dense index of an id, adding it if it is new.
+ * @param ids The map
+ * @param id External id
+ * @return Dense index, -1 on error
+ */
+int id_map_insert(t_id_map *ids, int64_t id) {
+    int s = find_slot(ids, id);
+    if (ids->slots[s].index != 0) return ids->slots[s].index - 1;
+
+    if (ids->count >= ids->capacity) {
+        if (ids->capacity > INT_MAX / 2) return -1;
+        int64_t *temp = (int64_t *)realloc(ids->external, 2 * (size_t)ids->capacity * sizeof(int64_t));
+        if (temp == NULL) return -1;
+        ids->external = temp;
+        ids->capacity *= 2;
+    }
+    // keep the load factor under 1/2
+    if (2 * (ids->count + 1) > ids->nb_slots) {
+        if (ids->nb_slots > INT_MAX / 2 || rehash(ids, 2 * ids->nb_slots) != 0) return -1;
+        s = find_slot(ids, id);
+    }
+
+    ids->external[ids->count] = id;
+    ids->slots[s].id = id;
+    ids->slots[s].index = ++ids->count;
+    return ids->count - 1;
+}
+
+/**
+ * @brief Looks up an id.
+ * @param ids The map
+ * @param id External id
+ * @return Dense index, -1 if the id is unknown
+ */
+int id_map_find(const t_id_map *ids, int64_t id) {
+    if (ids == NULL || ids->slots == NULL) return -1;
+    return ids->slots[find_slot(ids, id)].index - 1;
+}
+
+/**
+ * @brief An id and its index before sorting.
+ */
+typedef struct s_id_entry {
+    int64_t id;
+    int index;
+} t_id_entry;
+
+static int compare_entry(const void *a, const void *b) {
+    int64_t x = ((const t_id_entry *)a)->id;
+    int64_t y = ((const t_id_entry *)b)->id;
+    return (x > y) - (x < y);
+}
+
+/**
+ * @brief Renumbers the ids in increasing order.
+ * @param ids The map
+ * @return Array old index -> new index, NULL on allocation error
+ */
+int *id_map_sort(t_id_map *ids) {
+    int n = ids->count;
+    int *perm = (int *)malloc((n > 0 ? n : 1) * sizeof(int));
+    if (perm == NULL) return NULL;
+
+    // already sorted (the usual case: ids 1..n in file order) -> identity
+    int is_sorted = 1;
+    for (int i = 0; i < n; i++) {
+        perm[i] = i;
+        if (i > 0 && ids->external[i - 1] > ids->external[i]) is_sorted = 0;
+    }
+    if (is_sorted) return perm;
+
+    t_id_entry *entries = (t_id_entry *)malloc((size_t)n * sizeof(t_id_entry));
+    if (entries == NULL) {
+        free(perm);
+        return NULL;
+    }
+    for (int i = 0; i < n; i++) {
+        entries[i].id = ids->external[i];
+        entries[i].index = i;
+    }
+    qsort(entries, n, sizeof(t_id_entry), compare_entry);
+    for (int i = 0; i < n; i++) {
+        ids->external[i] = entries[i].id;
+        perm[entries[i].index] = i;
+    }
+    free(entries);
+
+    // the slots store dense indices: refill them
+    memset(ids->slots, 0, (size_t)ids->nb_slots * sizeof(t_id_slot));
+    fill_slots(ids);
+    return perm;
+}
+
+/**
+ * @brief External id of a vertex.
+ * @param ids The map, NULL for the identity
+ * @param vertex Vertex number (1-based)
+ * @return The id
+ */
+int64_t id_map_external(const t_id_map *ids, int vertex) {
+    if (ids == NULL || vertex < 1 || vertex > ids->count) return vertex;
+    return ids->external[vertex - 1];
+}
+
+/**
+ * @brief Writes the external id of a vertex.
+ * @param w Destination writer
+ * @param ids The map, NULL for the identity
+ * @param vertex Vertex number (1-based)
+ */
+void write_vertex_id(t_writer *w, const t_id_map *ids, int vertex) {
+    writer_int(w, id_map_external(ids, vertex));
+}
@@ -0,0 +1,82 @@
+#ifndef IDMAP_H
+#define IDMAP_H
+
+#include <stdint.h>
+#include "../writer/writer.h"
+
+/**
+ * @brief Mapping between the external ids of a graph file (any 64-bit
+ *        integers) and the dense vertex numbers 1..count used by the library.
+ *
+ * external[v - 1] is the id of vertex v; the hash table (open addressing,
+ * linear probing) gives the vertex of an id. A slot keeps the id next to its
+ * index, so a lookup touches one cache line instead of two.
+ */
+typedef struct s_id_slot {
+    int64_t id; // external id
+    int index;  // dense index + 1, 0 = empty slot
+} t_id_slot;
+
+typedef struct s_id_map {
+    int count;         // number of ids
+    int capacity;      // allocated length of external[]
+    int64_t *external; // dense index -> external id
+    t_id_slot *slots;  // hash table
+    int nb_slots;      // size of the hash table (power of 2)
+} t_id_map, *p_id_map;
+
+/**
+ * @brief Initializes an empty map.
+ * @param ids The map
+ * @param expected Expected number of ids (sizes the table, may be 0)
+ * @return 0 on success, -1 on allocation error
+ */
+int id_map_init(t_id_map *ids, int expected);
+
+/**
+ * @brief Frees the arrays of a map.
+ * @param ids The map (may be NULL)
+ */
+void id_map_free(t_id_map *ids);
+
+/**
+ * @brief Returns the dense index of an id, adding it if it is new.
+ * @param ids The map
+ * @param id External id
+ * @return Dense index (0-based), -1 on allocation error or if the map is full
+ */
+int id_map_insert(t_id_map *ids, int64_t id);
+
+/**
+ * @brief Looks up an id.
+ * @param ids The map
+ * @param id External id
+ * @return Dense index (0-based), -1 if the id is unknown
+ */
+int id_map_find(const t_id_map *ids, int64_t id);
+
+/**
+ * @brief Renumbers the ids in increasing order, so that a file whose ids are
+ *        already 1..n keeps its numbering.
+ * @param ids The map
+ * @return Newly allocated array old index -> new index, NULL on allocation error
+ */
+int *id_map_sort(t_id_map *ids);
+
+/**
+ * @brief External id of a vertex.
+ * @param ids The map, NULL for the identity
+ * @param vertex Vertex number (1-based)
+ * @return The id, or the vertex number itself if ids is NULL or it is out of range
+ */
+int64_t id_map_external(const t_id_map *ids, int vertex);
+
+/**
+ * @brief Writes the external id of a vertex.
+ * @param w Destination writer
+ * @param ids The map, NULL for the identity
+ * @param vertex Vertex number (1-based)
+ */
+void write_vertex_id(t_writer *w, const t_id_map *ids, int vertex);
+
+#endif //IDMAP_H
@@ -0,0 +1,845 @@
+#include "incremental.h"
+#include "../cell/cell.h"
+#include "../status/status.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+// gap between the topological keys of consecutive classes, leaves room for splits
+#define ORD_SPACING (1LL << 24)
+
+/**
+ * @brief A class slot with its topological key (search results, sorted by key).
+ */
+typedef struct s_ord_entry {
+    long long ord;
+    long long tie;
+    int cls;
+} t_ord_entry;
+
+/**
+ * @brief Growable list of t_ord_entry.
+ */
+typedef struct s_ord_list {
+    t_ord_entry *items;
+    int size;
+    int capacity;
+} t_ord_list;
+
+static int ord_list_push(t_ord_list *l, long long ord, long long tie, int cls) {
+    if (l->size == l->capacity) {
+        int capacity = l->capacity ? 2 * l->capacity : 16;
+        t_ord_entry *temp = (t_ord_entry *)realloc(l->items, capacity * sizeof(t_ord_entry));
+        if (temp == NULL) return -1;
+        l->items = temp;
+        l->capacity = capacity;
+    }
+    l->items[l->size].ord = ord;
+    l->items[l->size].tie = tie;
+    l->items[l->size].cls = cls;
+    l->size++;
+    return 0;
+}
+
+static int compare_ord(const void *a, const void *b) {
+    const t_ord_entry *x = (const t_ord_entry *)a, *y = (const t_ord_entry *)b;
+    if (x->ord != y->ord) return (x->ord > y->ord) - (x->ord < y->ord);
+    return (x->tie > y->tie) - (x->tie < y->tie);
+}
+
+/**
+ * @brief Compares the topological keys of two classes.
+ * @return Negative, 0 or positive like strcmp
+ */
+static int compare_classes(const t_incremental *inc, int a, int b) {
+    const t_inc_class *x = &inc->classes[a], *y = &inc->classes[b];
+    if (x->ord != y->ord) return (x->ord > y->ord) - (x->ord < y->ord);
+    return (x->tie > y->tie) - (x->tie < y->tie);
+}
+
+/**
+ * @brief Adds delta to the count of the edge towards cls, creating or
+ *        removing the entry as needed.
+ * @return The new count, -1 on allocation error
+ */
+static int edges_add(t_class_edges *l, int cls, int delta) {
+    int i = 0;
+    while (i < l->size && l->edges[i].cls != cls) i++;
+    if (i == l->size) {
+        if (delta <= 0) return 0;
+        if (l->size == l->capacity) {
+            int capacity = l->capacity ? 2 * l->capacity : 4;
+            t_class_edge *temp = (t_class_edge *)realloc(l->edges, capacity * sizeof(t_class_edge));
+            if (temp == NULL) return -1;
+            l->edges = temp;
+            l->capacity = capacity;
+        }
+        l->edges[l->size].cls = cls;
+        l->edges[l->size].count = 0;
+        l->size++;
+    }
+    l->edges[i].count += delta;
+    int count = l->edges[i].count;
+    if (count <= 0) {
+        // swap with the last entry
+        l->edges[i] = l->edges[--l->size];
+        count = 0;
+    }
+    return count;
+}
+
+/**
+ * @brief Adds delta to the number of edges from class a to class b.
+ * @return The new count, -1 on allocation error
+ */
+static int link_classes(t_incremental *inc, int a, int b, int delta) {
+    int count = edges_add(&inc->classes[a].out, b, delta);
+    if (count < 0 || edges_add(&inc->classes[b].in, a, delta) < 0) return -1;
+    return count;
+}
+
+static int class_add_vertex(t_inc_class *c, int vertex) {
+    if (c->nb_vertices == c->capacity) {
+        int capacity = c->capacity ? 2 * c->capacity : 4;
+        int *temp = (int *)realloc(c->vertices, capacity * sizeof(int));
+        if (temp == NULL) return -1;
+        c->vertices = temp;
+        c->capacity = capacity;
+    }
+    c->vertices[c->nb_vertices++] = vertex;
+    return 0;
+}
+
+/**
+ * @brief Returns a free class slot (reused or new), empty and alive.
+ * @return The slot, -1 on allocation error
+ */
+static int new_class(t_incremental *inc) {
+    int slot;
+    if (inc->nb_free > 0) {
+        slot = inc->free_slots[--inc->nb_free];
+    } else {
+        if (inc->nb_slots == inc->slots_capacity) {
+            int capacity = inc->slots_capacity ? 2 * inc->slots_capacity : 16;
+            t_inc_class *classes = (t_inc_class *)realloc(inc->classes, capacity * sizeof(t_inc_class));
+            if (classes) inc->classes = classes;
+            int *free_slots = (int *)realloc(inc->free_slots, capacity * sizeof(int));
+            if (free_slots) inc->free_slots = free_slots;
+            unsigned *forward = (unsigned *)realloc(inc->mark_forward, capacity * sizeof(unsigned));
+            if (forward) inc->mark_forward = forward;
+            unsigned *backward = (unsigned *)realloc(inc->mark_backward, capacity * sizeof(unsigned));
+            if (backward) inc->mark_backward = backward;
+            if (!classes || !free_slots || !forward || !backward) return -1;
+            inc->slots_capacity = capacity;
+        }
+        slot = inc->nb_slots++;
+        inc->mark_forward[slot] = 0;
+        inc->mark_backward[slot] = 0;
+    }
+    memset(&inc->classes[slot], 0, sizeof(t_inc_class));
+    inc->classes[slot].alive = 1;
+    inc->classes[slot].tie = inc->next_tie++;
+    inc->nb_classes++;
+    return slot;
+}
+
+/**
+ * @brief Frees the arrays of a class and gives its slot back.
+ */
+static void free_class(t_incremental *inc, int slot) {
+    t_inc_class *c = &inc->classes[slot];
+    free(c->vertices);
+    free(c->out.edges);
+    free(c->in.edges);
+    memset(c, 0, sizeof(t_inc_class));
+    inc->free_slots[inc->nb_free++] = slot;
+    inc->nb_classes--;
+}
+
+/**
+ * @brief Starts a new search: the marks of older searches become stale.
+ */
+static void next_epoch(t_incremental *inc) {
+    if (++inc->epoch == 0) {
+        memset(inc->mark_forward, 0, inc->nb_slots * sizeof(unsigned));
+        memset(inc->mark_backward, 0, inc->nb_slots * sizeof(unsigned));
+        inc->epoch = 1;
+    }
+}
+
+/**
+ * @brief Gives new topological keys to every class, spaced by ORD_SPACING,
+ *        keeping their order.
+ * @return 0 on success, -1 on allocation error
+ */
+static int renumber_classes(t_incremental *inc) {
+    t_ord_list all = { NULL, 0, 0 };
+    for (int s = 0; s < inc->nb_slots; s++) {
+        if (inc->classes[s].alive && ord_list_push(&all, inc->classes[s].ord, inc->classes[s].tie, s) != 0) {
+            free(all.items);
+            return -1;
+        }
+    }
+    qsort(all.items, all.size, sizeof(t_ord_entry), compare_ord);
+    for (int i = 0; i < all.size; i++) inc->classes[all.items[i].cls].ord = (long long)(i + 1) * ORD_SPACING;
+    free(all.items);
+    return 0;
+}
+
+/**
+ * @brief Copies the lists of a graph in the same order, and fills the
+ *        reverse graph.
+ * @return MARKOV_OK, MARKOV_ERR_FORMAT or MARKOV_ERR_ALLOC
+ */
+static int copy_graph(t_incremental *inc, t_adjacency_list graph) {
+    int n = graph.size;
+    for (int i = 0; i < n; i++) {
+        t_cell **tail = &inc->graph.array[i].head;
+        for (t_cell *e = graph.array[i].head; e != NULL; e = e->next) {
+            if (e->arrival < 1 || e->arrival > n) return MARKOV_ERR_FORMAT;
+            t_cell *copy = create_cell(e->arrival, e->probability);
+            if (copy == NULL) return MARKOV_ERR_ALLOC;
+            *tail = copy;
+            tail = &copy->next;
+            if (addCellToList(&inc->reverse.array[e->arrival - 1], i + 1, e->probability) != 0) return MARKOV_ERR_ALLOC;
+        }
+    }
+    return MARKOV_OK;
+}
+
+/**
+ * @brief Builds the engine from a graph.
+ * @param inc Engine to initialize
+ * @param graph The graph, copied
+ * @return MARKOV_OK, MARKOV_ERR_ARG, MARKOV_ERR_FORMAT or MARKOV_ERR_ALLOC
+ */
+int IncrementalInit(t_incremental *inc, t_adjacency_list graph) {
+    if (inc == NULL || graph.size <= 0 || graph.array == NULL) return MARKOV_ERR_ARG;
+    memset(inc, 0, sizeof(t_incremental));
+    int n = graph.size;
+
+    t_adjacency_list *copy = empty_adjacency_list(n);
+    t_adjacency_list *reverse = empty_adjacency_list(n);
+    if (copy) inc->graph = *copy;
+    if (reverse) inc->reverse = *reverse;
+    free(copy);
+    free(reverse);
+    inc->vertex_class = (int *)malloc(n * sizeof(int));
+    inc->index = (int *)malloc(n * sizeof(int));
+    inc->low = (int *)malloc(n * sizeof(int));
+    if (!inc->graph.array || !inc->reverse.array || !inc->vertex_class || !inc->index || !inc->low) {
+        FreeIncremental(inc);
+        return MARKOV_ERR_ALLOC;
+    }
+    for (int v = 0; v < n; v++) inc->index[v] = inc->low[v] = -1;
+
+    int status = copy_graph(inc, graph);
+    p_partition partition = status == MARKOV_OK ? tarjan(inc->graph) : NULL;
+    if (status == MARKOV_OK && partition == NULL) status = MARKOV_ERR_ALLOC;
+
+    // tarjan() gives the classes in reverse topological order
+    for (int c = 0; status == MARKOV_OK && c < partition->nb_class; c++) {
+        int slot = new_class(inc);
+        if (slot < 0) {
+            status = MARKOV_ERR_ALLOC;
+            break;
+        }
+        const t_class *cls = partition->classes[c];
+        inc->classes[slot].ord = (long long)(partition->nb_class - c) * ORD_SPACING;
+        for (int k = 0; k < cls->nb_vertices; k++) {
+            inc->vertex_class[cls->vertices[k] - 1] = slot;
+            if (class_add_vertex(&inc->classes[slot], cls->vertices[k]) != 0) status = MARKOV_ERR_ALLOC;
+        }
+    }
+    DestroyPartition(partition);
+
+    // class edges with their multiplicity
+    for (int i = 0; status == MARKOV_OK && i < n; i++) {
+        for (t_cell *e = inc->graph.array[i].head; e != NULL; e = e->next) {
+            int a = inc->vertex_class[i], b = inc->vertex_class[e->arrival - 1];
+            if (a != b && link_classes(inc, a, b, 1) < 0) {
+                status = MARKOV_ERR_ALLOC;
+                break;
+            }
+        }
+    }
+
+    if (status != MARKOV_OK) FreeIncremental(inc);
+    return status;
+}
+
+/**
+ * @brief Collects the classes reachable from (forward) or reaching (backward)
+ *        a class whose key stays within the key of the bound class.
+ * @return 0 on success, -1 on allocation error
+ */
+static int search_classes(t_incremental *inc, int from, int bound, int forward, t_ord_list *found) {
+    unsigned *mark = forward ? inc->mark_forward : inc->mark_backward;
+    t_ord_list stack = { NULL, 0, 0 };
+    mark[from] = inc->epoch;
+    int status = ord_list_push(found, inc->classes[from].ord, inc->classes[from].tie, from);
+    if (status == 0) status = ord_list_push(&stack, 0, 0, from);
+
+    while (status == 0 && stack.size > 0) {
+        int c = stack.items[--stack.size].cls;
+        const t_class_edges *next = forward ? &inc->classes[c].out : &inc->classes[c].in;
+        for (int i = 0; status == 0 && i < next->size; i++) {
+            int t = next->edges[i].cls;
+            if (mark[t] == inc->epoch) continue;
+            int side = compare_classes(inc, t, bound);
+            if (forward ? side > 0 : side < 0) continue;
+            mark[t] = inc->epoch;
+            status = ord_list_push(found, inc->classes[t].ord, inc->classes[t].tie, t);
+            if (status == 0) status = ord_list_push(&stack, 0, 0, t);
+        }
+    }
+    free(stack.items);
+    return status;
+}
+
+/**
+ * @brief Merges the classes marked by both searches into the largest one.
+ * @return The merged class, -1 on allocation error
+ */
+static int merge_classes(t_incremental *inc, const t_ord_list *forward) {
+    unsigned epoch = inc->epoch;
+    int survivor = -1;
+    for (int i = 0; i < forward->size; i++) {
+        int c = forward->items[i].cls;
+        if (inc->mark_backward[c] != epoch) continue;
+        if (survivor < 0 || inc->classes[c].nb_vertices > inc->classes[survivor].nb_vertices) survivor = c;
+    }
+
+    for (int i = 0; i < forward->size; i++) {
+        int m = forward->items[i].cls;
+        if (m == survivor || inc->mark_backward[m] != epoch) continue;
+        t_inc_class *cm = &inc->classes[m];
+        inc->touched += cm->nb_vertices;
+
+        // the vertices move to the survivor
+        for (int k = 0; k < cm->nb_vertices; k++) {
+            inc->vertex_class[cm->vertices[k] - 1] = survivor;
+            if (class_add_vertex(&inc->classes[survivor], cm->vertices[k]) != 0) return -1;
+        }
+        // links towards other merged classes disappear, the others move to the survivor
+        for (int k = 0; k < cm->out.size; k++) {
+            t_class_edge e = cm->out.edges[k];
+            if (edges_add(&inc->classes[e.cls].in, m, -e.count) < 0) return -1;
+            int merged = inc->mark_forward[e.cls] == epoch && inc->mark_backward[e.cls] == epoch;
+            if (!merged && link_classes(inc, survivor, e.cls, e.count) < 0) return -1;
+        }
+        for (int k = 0; k < cm->in.size; k++) {
+            t_class_edge e = cm->in.edges[k];
+            if (edges_add(&inc->classes[e.cls].out, m, -e.count) < 0) return -1;
+            int merged = inc->mark_forward[e.cls] == epoch && inc->mark_backward[e.cls] == epoch;
+            if (!merged && link_classes(inc, e.cls, survivor, e.count) < 0) return -1;
+        }
+        free_class(inc, m);
+    }
+    return survivor;
+}
+
+/**
+ * @brief Gives a class the key of a pool entry.
+ */
+static void set_key(t_inc_class *c, const t_ord_entry *key) {
+    c->ord = key->ord;
+    c->tie = key->tie;
+}
+
+/**
+ * @brief Restores a topological order after the link a -> b was created
+ *        with key(a) > key(b), merging the classes of a new cycle.
+ * @return MARKOV_OK or MARKOV_ERR_ALLOC
+ */
+static int reorder_after_link(t_incremental *inc, int a, int b) {
+    t_ord_list forward = { NULL, 0, 0 }, backward = { NULL, 0, 0 }, pool = { NULL, 0, 0 };
+    next_epoch(inc);
+
+    // forward from b and backward from a, inside [key(b), key(a)]
+    int status = search_classes(inc, b, a, 1, &forward);
+    if (status == 0) status = search_classes(inc, a, b, 0, &backward);
+    inc->touched = forward.size + backward.size;
+
+    // the keys of the visited classes are given back in a valid order
+    for (int i = 0; status == 0 && i < forward.size; i++) {
+        status = ord_list_push(&pool, forward.items[i].ord, forward.items[i].tie, -1);
+    }
+    for (int i = 0; status == 0 && i < backward.size; i++) {
+        const t_ord_entry *e = &backward.items[i];
+        if (inc->mark_forward[e->cls] != inc->epoch) status = ord_list_push(&pool, e->ord, e->tie, -1);
+    }
+
+    // a is reached from b: the classes on the cycle are those found by both searches
+    int merged = -1;
+    if (status == 0 && inc->mark_forward[a] == inc->epoch) {
+        merged = merge_classes(inc, &forward);
+        if (merged < 0) status = -1;
+    }
+
+    if (status == 0) {
+        qsort(pool.items, pool.size, sizeof(t_ord_entry), compare_ord);
+        qsort(forward.items, forward.size, sizeof(t_ord_entry), compare_ord);
+        qsort(backward.items, backward.size, sizeof(t_ord_entry), compare_ord);
+        unsigned epoch = inc->epoch;
+
+        // classes reaching a first (smallest keys), then the merged class,
+        // then the classes reached from b (largest keys)
+        int next = 0;
+        for (int i = 0; i < backward.size; i++) {
+            int c = backward.items[i].cls;
+            if (inc->mark_forward[c] == epoch) continue;
+            set_key(&inc->classes[c], &pool.items[next++]);
+        }
+        if (merged >= 0) set_key(&inc->classes[merged], &pool.items[next]);
+        int last = pool.size;
+        for (int i = forward.size - 1; i >= 0; i--) {
+            int c = forward.items[i].cls;
+            if (inc->mark_backward[c] == epoch) continue;
+            set_key(&inc->classes[c], &pool.items[--last]);
+        }
+    }
+
+    free(forward.items);
+    free(backward.items);
+    free(pool.items);
+    return status == 0 ? MARKOV_OK : MARKOV_ERR_ALLOC;
+}
+
+/**
+ * @brief Adds the edge start -> end and updates the classes.
+ * @param inc The engine
+ * @param start Start vertex (1-based)
+ * @param end End vertex (1-based)
+ * @param probability Probability of the edge
+ * @return MARKOV_OK, MARKOV_ERR_ARG or MARKOV_ERR_ALLOC
+ */
+int IncrementalAddEdge(t_incremental *inc, int start, int end, float probability) {
+    int n = inc->graph.size;
+    if (start < 1 || start > n || end < 1 || end > n) return MARKOV_ERR_ARG;
+    if (addCellToList(&inc->graph.array[start - 1], end, probability) != 0) return MARKOV_ERR_ALLOC;
+    if (addCellToList(&inc->reverse.array[end - 1], start, probability) != 0) return MARKOV_ERR_ALLOC;
+    inc->touched = 0;
+
+    int a = inc->vertex_class[start - 1], b = inc->vertex_class[end - 1];
+    if (a == b) return MARKOV_OK;
+    int count = link_classes(inc, a, b, 1);
+    if (count < 0) return MARKOV_ERR_ALLOC;
+
+    // an existing link, or a new one that follows the order: nothing moves
+    if (count > 1 || compare_classes(inc, a, b) < 0) return MARKOV_OK;
+    return reorder_after_link(inc, a, b);
+}
+
+/**
+ * @brief Unlinks the first cell with the given arrival from a list.
+ * @return 0 if a cell was removed, -1 if there is none
+ */
+static int remove_cell(t_std_list *list, int arrival) {
+    for (t_cell **p = &list->head; *p != NULL; p = &(*p)->next) {
+        if ((*p)->arrival == arrival) {
+            t_cell *cell = *p;
+            *p = cell->next;
+            free(cell);
+            return 0;
+        }
+    }
+    return -1;
+}
+
+/**
+ * @brief Tells if start still reaches end inside a class, by two breadth-first
+ *        searches (forward from start, backward from end) that stop when they meet.
+ *
+ * If it does, every path that used the removed edge start -> end can go
+ * around it, so the class is still strongly connected. In a large class the
+ * searches usually meet after visiting a small part of it.
+ *
+ * @return 1 if end is reached, 0 if not, -1 on allocation error
+ */
+static int still_connected(t_incremental *inc, int cls, int start, int end) {
+    if (start == end) return 1;
+    int n = inc->classes[cls].nb_vertices;
+    int *queue[2];
+    queue[0] = (int *)malloc(n * sizeof(int));
+    queue[1] = (int *)malloc(n * sizeof(int));
+    if (queue[0] == NULL || queue[1] == NULL) {
+        free(queue[0]);
+        free(queue[1]);
+        return -1;
+    }
+
+    // index[] is free outside split_class(): it marks the side (0 or 1) that saw a vertex
+    int head[2] = { 0, 0 }, tail[2] = { 1, 1 }, found = 0;
+    queue[0][0] = start - 1;
+    queue[1][0] = end - 1;
+    inc->index[start - 1] = 0;
+    inc->index[end - 1] = 1;
+    while (!found && head[0] < tail[0] && head[1] < tail[1]) {
+        // grow the side with the smaller frontier
+        int side = tail[0] - head[0] <= tail[1] - head[1] ? 0 : 1;
+        int x = queue[side][head[side]++];
+        const t_adjacency_list *edges = side == 0 ? &inc->graph : &inc->reverse;
+        for (t_cell *e = edges->array[x].head; e != NULL; e = e->next) {
+            int y = e->arrival - 1;
+            if (inc->vertex_class[y] != cls || inc->index[y] == side) continue;
+            if (inc->index[y] >= 0) {
+                found = 1;
+                break;
+            }
+            inc->index[y] = side;
+            queue[side][tail[side]++] = y;
+        }
+    }
+    inc->touched += tail[0] + tail[1];
+
+    for (int side = 0; side < 2; side++) {
+        for (int k = 0; k < tail[side]; k++) inc->index[queue[side][k]] = -1;
+        free(queue[side]);
+    }
+    return found;
+}
+
+/**
+ * @brief Tarjan restricted to the vertices of one class and its inner edges.
+ *
+ * Iterative, so a long cycle does not overflow the call stack. On return,
+ * low[v - 1] holds the sub-class number of each vertex, numbered in reverse
+ * topological order like tarjan().
+ *
+ * @return The number of sub-classes, -1 on allocation error
+ */
+static int split_class(t_incremental *inc, int cls) {
+    const t_inc_class *c = &inc->classes[cls];
+    int n = c->nb_vertices;
+    int *scc_stack = (int *)malloc(n * sizeof(int));
+    int *frame_vertex = (int *)malloc(n * sizeof(int));
+    t_cell **frame_edge = (t_cell **)malloc(n * sizeof(t_cell *));
+    char *on_stack = (char *)calloc(n, 1); // indexed by Tarjan index
+    if (!scc_stack || !frame_vertex || !frame_edge || !on_stack) {
+        free(scc_stack);
+        free(frame_vertex);
+        free(frame_edge);
+        free(on_stack);
+        return -1;
+    }
+
+    int counter = 0, nb_scc = 0, top = 0;
+    for (int r = 0; r < n; r++) {
+        int root = c->vertices[r] - 1;
+        if (inc->index[root] >= 0) continue;
+
+        int depth = 0;
+        frame_vertex[depth] = root;
+        frame_edge[depth] = inc->graph.array[root].head;
+        inc->index[root] = inc->low[root] = counter;
+        on_stack[counter++] = 1;
+        scc_stack[top++] = root;
+
+        while (depth >= 0) {
+            int x = frame_vertex[depth];
+            t_cell *e = frame_edge[depth];
+            // next edge that stays inside the class
+            while (e != NULL && inc->vertex_class[e->arrival - 1] != cls) e = e->next;
+            if (e != NULL) {
+                frame_edge[depth] = e->next;
+                int y = e->arrival - 1;
+                if (inc->index[y] < 0) {
+                    inc->index[y] = inc->low[y] = counter;
+                    on_stack[counter++] = 1;
+                    scc_stack[top++] = y;
+                    depth++;
+                    frame_vertex[depth] = y;
+                    frame_edge[depth] = inc->graph.array[y].head;
+                } else if (on_stack[inc->index[y]] && inc->index[y] < inc->low[x]) {
+                    inc->low[x] = inc->index[y];
+                }
+                continue;
+            }
+
+            // x is done: pop its sub-class if it is a root
+            depth--;
+            if (inc->low[x] == inc->index[x]) {
+                int w;
+                do {
+                    w = scc_stack[--top];
+                    on_stack[inc->index[w]] = 0;
+                    inc->low[w] = -2 - nb_scc; // sub-class, negative so it cannot be taken for a lowlink
+                } while (w != x);
+                nb_scc++;
+            }
+            if (depth >= 0) {
+                int parent = frame_vertex[depth];
+                if (inc->low[x] >= 0 && inc->low[x] < inc->low[parent]) inc->low[parent] = inc->low[x];
+            }
+        }
+    }
+    inc->touched += counter;
+
+    for (int k = 0; k < n; k++) {
+        int v = c->vertices[k] - 1;
+        inc->low[v] = -2 - inc->low[v];
+    }
+    free(scc_stack);
+    free(frame_vertex);
+    free(frame_edge);
+    free(on_stack);
+    return nb_scc;
+}
+
+/**
+ * @brief Replaces a class by the sub-classes found by split_class().
+ * @return MARKOV_OK or MARKOV_ERR_ALLOC
+ */
+static int replace_by_subclasses(t_incremental *inc, int cls, int nb_scc) {
+    int *slot_of = (int *)malloc(nb_scc * sizeof(int));
+    int *vertices = inc->classes[cls].vertices;
+    int n = inc->classes[cls].nb_vertices;
+    if (slot_of == NULL) return MARKOV_ERR_ALLOC;
+
+    // the sub-classes take keys between the neighbours of the old class
+    long long ord = inc->classes[cls].ord;
+    long long lower = ord - ORD_SPACING, upper = ord + ORD_SPACING;
+    const t_inc_class *old = &inc->classes[cls];
+    for (int k = 0; k < old->in.size; k++) {
+        if (inc->classes[old->in.edges[k].cls].ord > lower) lower = inc->classes[old->in.edges[k].cls].ord;
+    }
+    for (int k = 0; k < old->out.size; k++) {
+        if (inc->classes[old->out.edges[k].cls].ord < upper) upper = inc->classes[old->out.edges[k].cls].ord;
+    }
+
+    // detach the old class from its neighbours, the links are rebuilt below
+    for (int k = 0; k < old->out.size; k++) edges_add(&inc->classes[old->out.edges[k].cls].in, cls, -old->out.edges[k].count);
+    for (int k = 0; k < old->in.size; k++) edges_add(&inc->classes[old->in.edges[k].cls].out, cls, -old->in.edges[k].count);
+    t_inc_class *c = &inc->classes[cls];
+    c->out.size = 0;
+    c->in.size = 0;
+    c->vertices = NULL;
+    c->nb_vertices = c->capacity = 0;
+
+    // sub-class 0 keeps the slot
+    int status = MARKOV_OK;
+    slot_of[0] = cls;
+    for (int s = 1; s < nb_scc && status == MARKOV_OK; s++) {
+        slot_of[s] = new_class(inc);
+        if (slot_of[s] < 0) status = MARKOV_ERR_ALLOC;
+    }
+    next_epoch(inc);
+    for (int s = 0; s < nb_scc && status == MARKOV_OK; s++) inc->mark_forward[slot_of[s]] = inc->epoch;
+
+    for (int k = 0; k < n && status == MARKOV_OK; k++) {
+        int v = vertices[k] - 1;
+        int slot = slot_of[inc->low[v]];
+        inc->vertex_class[v] = slot;
+        if (class_add_vertex(&inc->classes[slot], vertices[k]) != 0) status = MARKOV_ERR_ALLOC;
+    }
+
+    // edges leaving each vertex, and edges coming from outside the old class
+    for (int k = 0; k < n && status == MARKOV_OK; k++) {
+        int v = vertices[k] - 1, a = inc->vertex_class[v];
+        for (t_cell *e = inc->graph.array[v].head; e != NULL && status == MARKOV_OK; e = e->next) {
+            int b = inc->vertex_class[e->arrival - 1];
+            if (a != b && link_classes(inc, a, b, 1) < 0) status = MARKOV_ERR_ALLOC;
+        }
+        for (t_cell *e = inc->reverse.array[v].head; e != NULL && status == MARKOV_OK; e = e->next) {
+            int b = inc->vertex_class[e->arrival - 1];
+            if (inc->mark_forward[b] != inc->epoch && link_classes(inc, b, a, 1) < 0) status = MARKOV_ERR_ALLOC;
+        }
+        inc->index[v] = inc->low[v] = -1;
+    }
+    inc->touched += n;
+
+    // sub-class nb_scc - 1 comes first in topological order
+    if (status == MARKOV_OK && upper - lower - 1 < nb_scc) {
+        status = renumber_classes(inc) == 0 ? MARKOV_OK : MARKOV_ERR_ALLOC;
+        // after renumbering the old key is alone in a gap of 2 * ORD_SPACING
+        ord = inc->classes[cls].ord;
+        lower = ord - ORD_SPACING;
+        upper = ord + ORD_SPACING;
+        for (int s = 0; s < nb_scc; s++) {
+            const t_inc_class *sub = &inc->classes[slot_of[s]];
+            for (int k = 0; k < sub->in.size; k++) {
+                int p = sub->in.edges[k].cls;
+                if (inc->mark_forward[p] != inc->epoch && inc->classes[p].ord > lower) lower = inc->classes[p].ord;
+            }
+            for (int k = 0; k < sub->out.size; k++) {
+                int q = sub->out.edges[k].cls;
+                if (inc->mark_forward[q] != inc->epoch && inc->classes[q].ord < upper) upper = inc->classes[q].ord;
+            }
+        }
+        if (upper - lower - 1 < nb_scc) {
+            // more sub-classes than keys in the gap: spread every class again
+            for (int s = 0; s < nb_scc; s++) inc->classes[slot_of[s]].ord = ord + (long long)(nb_scc - 1 - s);
+            for (int t = 0; t < inc->nb_slots; t++) {
+                if (!inc->classes[t].alive || inc->mark_forward[t] == inc->epoch) continue;
+                if (inc->classes[t].ord > ord) inc->classes[t].ord += nb_scc;
+            }
+            status = renumber_classes(inc) == 0 ? status : MARKOV_ERR_ALLOC;
+            free(vertices);
+            free(slot_of);
+            return status;
+        }
+    }
+    for (int s = 0; s < nb_scc && status == MARKOV_OK; s++) {
+        inc->classes[slot_of[s]].ord = lower + (upper - lower) * (long long)(nb_scc - s) / (nb_scc + 1);
+    }
+
+    free(vertices);
+    free(slot_of);
+    return status;
+}
+
+/**
+ * @brief Removes one edge start -> end and updates the classes.
+ * @param inc The engine
+ * @param start Start vertex (1-based)
+ * @param end End vertex (1-based)
+ * @return MARKOV_OK, MARKOV_ERR_ARG or MARKOV_ERR_ALLOC
+ */
+int IncrementalRemoveEdge(t_incremental *inc, int start, int end) {
+    int n = inc->graph.size;
+    if (start < 1 || start > n || end < 1 || end > n) return MARKOV_ERR_ARG;
+    if (remove_cell(&inc->graph.array[start - 1], end) != 0) return MARKOV_ERR_ARG;
+    remove_cell(&inc->reverse.array[end - 1], start);
+    inc->touched = 0;
+
+    int a = inc->vertex_class[start - 1], b = inc->vertex_class[end - 1];
+    if (a != b) {
+        // removing a link never breaks the order
+        link_classes(inc, a, b, -1);
+        return MARKOV_OK;
+    }
+    if (inc->classes[a].nb_vertices == 1) return MARKOV_OK;
+
+    // the edge was inside a class: is the class still strongly connected?
+    int connected = still_connected(inc, a, start, end);
+    if (connected < 0) return MARKOV_ERR_ALLOC;
+    if (connected) return MARKOV_OK;
+    int nb_scc = split_class(inc, a);
+    if (nb_scc < 0) return MARKOV_ERR_ALLOC;
+    if (nb_scc == 1) {
+        const t_inc_class *c = &inc->classes[a];
+        for (int k = 0; k < c->nb_vertices; k++) inc->index[c->vertices[k] - 1] = inc->low[c->vertices[k] - 1] = -1;
+        return MARKOV_OK;
+    }
+    return replace_by_subclasses(inc, a, nb_scc);
+}
+
+/**
+ * @brief Class slot of a vertex.
+ * @param inc The engine
+ * @param vertex Vertex (1-based)
+ * @return The slot, -1 if out of range
+ */
+int IncrementalClassOf(const t_incremental *inc, int vertex) {
+    if (vertex < 1 || vertex > inc->graph.size) return -1;
+    return inc->vertex_class[vertex - 1];
+}
+
+/**
+ * @brief Tells if a class is transient.
+ * @param inc The engine
+ * @param cls Class slot
+ * @return 1 if transient, 0 if persistent, -1 if not a class
+ */
+int IncrementalIsTransient(const t_incremental *inc, int cls) {
+    if (cls < 0 || cls >= inc->nb_slots || !inc->classes[cls].alive) return -1;
+    return inc->classes[cls].out.size > 0;
+}
+
+/**
+ * @brief Copies the current classes in the layout of tarjan() / list_class_links().
+ * @param inc The engine
+ * @param partition Output partition
+ * @param vertex_to_class Output vertex -> class array
+ * @param links Output class links
+ * @return MARKOV_OK or MARKOV_ERR_ALLOC
+ */
+int IncrementalSnapshot(const t_incremental *inc, p_partition *partition, int **vertex_to_class, t_link_array *links) {
+    *partition = NULL;
+    *vertex_to_class = NULL;
+    links_init(links);
+
+    // reverse topological order: largest key first
+    t_ord_list order = { NULL, 0, 0 };
+    int *rank = (int *)malloc((inc->nb_slots > 0 ? inc->nb_slots : 1) * sizeof(int));
+    int status = rank ? MARKOV_OK : MARKOV_ERR_ALLOC;
+    for (int s = 0; s < inc->nb_slots && status == MARKOV_OK; s++) {
+        const t_inc_class *c = &inc->classes[s];
+        if (c->alive && ord_list_push(&order, -c->ord, -c->tie, s) != 0) status = MARKOV_ERR_ALLOC;
+    }
+    if (status == MARKOV_OK) qsort(order.items, order.size, sizeof(t_ord_entry), compare_ord);
+
+    p_partition part = status == MARKOV_OK ? CreatePartition() : NULL;
+    int *v2c = (int *)malloc((inc->graph.size > 0 ? inc->graph.size : 1) * sizeof(int));
+    if (!part || !v2c) status = MARKOV_ERR_ALLOC;
+
+    long long nb_links = 0;
+    for (int i = 0; i < order.size && status == MARKOV_OK; i++) {
+        const t_inc_class *c = &inc->classes[order.items[i].cls];
+        rank[order.items[i].cls] = i;
+        nb_links += c->out.size;
+        char name[16];
+        snprintf(name, sizeof(name), "C%d", i + 1);
+        name[9] = '\0'; // CreateClass keeps 10 characters, as tarjan()
+        p_class cls = CreateClass(name);
+        if (cls == NULL || AddClassToPartition(part, cls) != 0) {
+            DestroyClass(cls);
+            status = MARKOV_ERR_ALLOC;
+            break;
+        }
+        for (int k = 0; k < c->nb_vertices && status == MARKOV_OK; k++) {
+            if (AddVertexToClass(cls, c->vertices[k]) != 0) status = MARKOV_ERR_ALLOC;
+        }
+    }
+    for (int v = 0; v < inc->graph.size && status == MARKOV_OK; v++) v2c[v] = rank[inc->vertex_class[v]];
+
+    // the class edges are unique: no need for the duplicate check of links_add()
+    if (status == MARKOV_OK && nb_links > 0) {
+        links->links = (t_link *)malloc(nb_links * sizeof(t_link));
+        if (links->links == NULL) status = MARKOV_ERR_ALLOC;
+        else links->length = (int)nb_links;
+    }
+    for (int i = 0; i < order.size && status == MARKOV_OK; i++) {
+        const t_inc_class *c = &inc->classes[order.items[i].cls];
+        for (int k = 0; k < c->out.size; k++) {
+            links->links[links->size++] = (t_link){ i, rank[c->out.edges[k].cls] };
+        }
+    }
+
+    free(order.items);
+    free(rank);
+    if (status != MARKOV_OK) {
+        DestroyPartition(part);
+        free(v2c);
+        free(links->links);
+        links_init(links);
+        return status;
+    }
+    *partition = part;
+    *vertex_to_class = v2c;
+    return MARKOV_OK;
+}
+
+/**
+ * @brief Frees everything the engine owns.
+ * @param inc The engine
+ */
+void FreeIncremental(t_incremental *inc) {
+    if (inc == NULL) return;
+    free_adjacency_list(&inc->graph);
+    free_adjacency_list(&inc->reverse);
+    for (int s = 0; s < inc->nb_slots; s++) {
+        free(inc->classes[s].vertices);
+        free(inc->classes[s].out.edges);
+        free(inc->classes[s].in.edges);
+    }
+    free(inc->classes);
+    free(inc->free_slots);
+    free(inc->mark_forward);
+    free(inc->mark_backward);
+    free(inc->vertex_class);
+    free(inc->index);
+    free(inc->low);
+    memset(inc, 0, sizeof(t_incremental));
+}
@@ -0,0 +1,139 @@
+#ifndef INCREMENTAL_H
+#define INCREMENTAL_H
+
+#include "../adjacency_list/adjacency_list.h"
+#include "../tarjan/tarjan.h"
+#include "../hasse/hasse.h"
+
+/**
+ * @brief Number of edges between two classes (one entry of a class adjacency).
+ */
+typedef struct s_class_edge {
+    int cls;   // other class (slot index)
+    int count; // number of graph edges between the two classes
+} t_class_edge;
+
+/**
+ * @brief Growable list of class edges.
+ */
+typedef struct s_class_edges {
+    t_class_edge *edges;
+    int size;
+    int capacity;
+} t_class_edges;
+
+/**
+ * @brief A class of the incremental engine.
+ *
+ * The classes live in slots that keep their index until the class disappears
+ * (merged or split), so vertex_class does not move when other classes change.
+ */
+typedef struct s_inc_class {
+    int alive;         // 0 for a free slot
+    int *vertices;     // vertex numbers (1-based)
+    int nb_vertices;
+    int capacity;
+    t_class_edges out; // classes reached by an edge, with edge counts
+    t_class_edges in;  // classes with an edge towards this one
+    long long ord;     // topological key (ord, tie): a link a -> b always has key(a) < key(b)
+    long long tie;     // unique number, orders the classes with the same ord
+} t_inc_class;
+
+/**
+ * @brief Strongly connected classes, class links and transient flags of a
+ *        graph, maintained under edge insertions and deletions.
+ *
+ * An insertion between two classes only searches the classes whose
+ * topological key lies between the two ends (Pearce-Kelly dynamic
+ * topological order); if it closes a cycle, the classes on the cycle are
+ * merged. A deletion inside a class first checks, by a bidirectional
+ * search, whether the two ends are still connected; if not, it runs Tarjan
+ * on that class only and splits it. Other updates only adjust an edge count. A class is
+ * transient iff it has an outgoing link.
+ */
+typedef struct s_incremental {
+    t_adjacency_list graph;   // current edges (owned copy)
+    t_adjacency_list reverse; // predecessors: arrival = start vertex of the edge
+    int *vertex_class;        // vertex (0-based) -> class slot
+    t_inc_class *classes;     // class slots
+    int nb_slots;             // slots in use or freed
+    int slots_capacity;
+    int nb_classes;           // alive classes
+    int *free_slots;          // freed slots, reused first
+    int nb_free;
+    unsigned *mark_forward;   // per slot: epoch of the last forward visit
+    unsigned *mark_backward;  // per slot: epoch of the last backward visit
+    unsigned epoch;
+    long long next_tie;       // next unused tie value
+    int *index;               // per vertex: Tarjan index of a local split, -1 = unused
+    int *low;                 // per vertex: Tarjan lowlink, then sub-class number
+    long long touched;        // classes and vertices visited by the last update
+} t_incremental;
+
+/**
+ * @brief Builds the engine from a graph (one full Tarjan run).
+ * @param inc Engine to initialize (free with FreeIncremental)
+ * @param graph The graph, copied
+ * @return MARKOV_OK, MARKOV_ERR_ARG for an empty graph,
+ *         MARKOV_ERR_FORMAT if an edge leaves [1, n], MARKOV_ERR_ALLOC
+ */
+int IncrementalInit(t_incremental *inc, t_adjacency_list graph);
+
+/**
+ * @brief Adds the edge start -> end and updates the classes.
+ * @param inc The engine
+ * @param start Start vertex (1-based)
+ * @param end End vertex (1-based)
+ * @param probability Probability of the edge
+ * @return MARKOV_OK, MARKOV_ERR_ARG if a vertex is out of range,
+ *         MARKOV_ERR_ALLOC (the engine is then unusable and must be freed)
+ */
+int IncrementalAddEdge(t_incremental *inc, int start, int end, float probability);
+
+/**
+ * @brief Removes one edge start -> end and updates the classes.
+ * @param inc The engine
+ * @param start Start vertex (1-based)
+ * @param end End vertex (1-based)
+ * @return MARKOV_OK, MARKOV_ERR_ARG if there is no such edge,
+ *         MARKOV_ERR_ALLOC (the engine is then unusable and must be freed)
+ */
+int IncrementalRemoveEdge(t_incremental *inc, int start, int end);
+
+/**
+ * @brief Class slot of a vertex.
+ * @param inc The engine
+ * @param vertex Vertex (1-based)
+ * @return Slot of its class, -1 if the vertex is out of range
+ */
+int IncrementalClassOf(const t_incremental *inc, int vertex);
+
+/**
+ * @brief Tells if a class is transient (has a link towards another class).
+ * @param inc The engine
+ * @param cls Class slot
+ * @return 1 if transient, 0 if persistent, -1 if the slot is not a class
+ */
+int IncrementalIsTransient(const t_incremental *inc, int cls);
+
+/**
+ * @brief Copies the current classes in the layout of tarjan() / list_class_links(),
+ *        so that the printers and the analyses can use them.
+ *
+ * The classes are numbered in reverse topological order, as tarjan() does.
+ *
+ * @param inc The engine
+ * @param partition Output partition (free with DestroyPartition)
+ * @param vertex_to_class Output vertex -> class array (free with free)
+ * @param links Output class links (free its links array with free)
+ * @return MARKOV_OK or MARKOV_ERR_ALLOC
+ */
+int IncrementalSnapshot(const t_incremental *inc, p_partition *partition, int **vertex_to_class, t_link_array *links);
+
+/**
+ * @brief Frees everything the engine owns.
+ * @param inc The engine
+ */
+void FreeIncremental(t_incremental *inc);
+
+#endif //INCREMENTAL_H
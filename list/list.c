@@ -40,10 +40,13 @@ void DisplayList (t_std_list list) {
  * @param list Pointer to the list
  * @param arrival Destination vertex
  * @param probability Edge probability
+ * @return 0 on success, -1 on allocation error
  * @note Inserts at head (O(1) operation)
  */
-void addCellToList(t_std_list *list, int arrival, float probability) {
+int addCellToList(t_std_list *list, int arrival, float probability) {
     t_cell *new_cell = create_cell(arrival, probability);
+    if (new_cell == NULL) return -1;
     new_cell->next = list->head;
     list->head = new_cell;
+    return 0;
 }
\ No newline at end of file
@@ -21,8 +21,9 @@ t_std_list createEmptyList(void);
  * @param list Pointer to the list
  * @param arrival Destination vertex
  * @param probability Edge probability
+ * @return 0 on success, -1 on allocation error
  */
-void addCellToList(t_std_list *list, int arrival, float probability);
+int addCellToList(t_std_list *list, int arrival, float probability);
 
 /**
  * @brief Displays list contents
@@ -1,19 +1,593 @@
 #include <stdio.h>
 #include <stdlib.h>
-#include "adjacency_list/adjacency_list.h"
-#include "hasse/hasse.h"
-#include "utils/utils.h"
-#include "tarjan/tarjan.h"
-#include "matrix/matrix.h"
+#include <string.h>
+#include <limits.h>
+#include "markov_core.h"
 
-int main() {
+/**
+ * @brief Analyses that can be requested with --run.
+ */
+enum {
+    RUN_VALIDATE = 1 << 0,
+    RUN_DISPLAY = 1 << 1,
+    RUN_SCC = 1 << 2,
+    RUN_HASSE = 1 << 3,
+    RUN_CHARACTERISTICS = 1 << 4,
+    RUN_PERIOD = 1 << 5,
+    RUN_STATIONARY = 1 << 6,
+    RUN_ABSORPTION = 1 << 7,
+    RUN_SIMULATE = 1 << 8,
+    RUN_HITTING = 1 << 9,
+    RUN_REACH = 1 << 10,
+    RUN_TRANSIENT = 1 << 11
+};
+
+static const struct {
+    const char *name;
+    unsigned flag;
+} run_names[] = {
+    { "validate", RUN_VALIDATE },
+    { "display", RUN_DISPLAY },
+    { "scc", RUN_SCC },
+    { "hasse", RUN_HASSE },
+    { "characteristics", RUN_CHARACTERISTICS },
+    { "period", RUN_PERIOD },
+    { "stationary", RUN_STATIONARY },
+    { "absorption", RUN_ABSORPTION },
+    { "hitting", RUN_HITTING },
+    { "reach", RUN_REACH },
+    { "transient", RUN_TRANSIENT },
+    { "simulate", RUN_SIMULATE },
+};
+#define NB_RUN_NAMES (int)(sizeof(run_names) / sizeof(run_names[0]))
+
+/**
+ * @brief Options of the command line.
+ */
+typedef struct s_cli_options {
+    const char *input;        // graph file
+    int rate_format;          // 1 if the file holds CTMC rates
+    int remap;                // 1 if the vertex ids are arbitrary 64-bit integers
+    int reorder;              // 1 to renumber the vertices class by class
+    t_reorder_method reorder_method; // order inside a class
+    unsigned run;             // RUN_* flags
+    int force_lazy;           // 1 to always solve the lazy walk
+    float tolerance;          // convergence threshold of the solvers
+    t_validation_options check; // validate: row-sum tolerance, renormalization
+    int max_iter;             // iteration cap, 0 = from the spectral gap
+    int threads;              // worker threads
+    const char *output;       // text output file, NULL = stdout
+    const char *mermaid;      // Mermaid export of the graph
+    const char *hasse_file;   // Mermaid export of the Hasse diagram
+    const char *dot;          // DOT export of the graph
+    const char *hasse_dot;    // DOT export of the Hasse diagram
+    const char *results;      // CSV / JSON lines / binary dump of the analysis
+    t_export_options export;  // cap / sampling of the graph exports
+    int trajectories;         // simulate: number of trajectories
+    int steps;                // simulate: steps per trajectory
+    long long start;          // simulate: start vertex (0 = random)
+    long long target;         // simulate: target vertex (0 = none)
+    unsigned long long seed;  // simulate: seed of the generators
+    int profile;              // 0 = off, 1 = table, 2 = JSON
+    int demo;                 // run the course validation demo
+    const char *batch;        // manifest or concatenated file of --batch / --batch-concat
+    t_batch_input batch_input; // which of the two
+} t_cli_options;
+
+static void usage(const char *prog) {
+    printf("Usage: %s [options] <graph file>\n", prog);
+    printf("  -i, --input FILE       graph file (same as the positional argument)\n");
+    printf("  -f, --format FMT       list (Markov graph, default) | rate (CTMC rates, uniformized)\n");
+    printf("      --remap            vertex ids are any 64-bit integers (mapped to 1..n, printed as in the file)\n");
+    printf("      --reorder ORDER    renumber the vertices class by class before the analyses:\n");
+    printf("                         class | bfs | rcm (ids are printed as in the file)\n");
+    printf("  -r, --run LIST         comma separated analyses (default validate,scc):\n");
+    printf("                         validate, display, scc, hasse, characteristics,\n");
+    printf("                         period, stationary, absorption, hitting, reach,\n");
+    printf("                         transient, simulate, all\n");
+    printf("  -s, --solver NAME      stationary solver: power (lazy walk only if periodic, default) | lazy\n");
+    printf("  -t, --tol EPS          solver tolerance (default 1e-6)\n");
+    printf("      --check-tol EPS    validate: accepted deviation of a row sum from 1 (default 0.01)\n");
+    printf("      --renormalize      validate: rescale the rows that are off to sum to 1\n");
+    printf("      --max-iter N       solver iteration cap (default: from the spectral gap)\n");
+    printf("  -j, --threads N        threads for loading, classes, kernels and simulation (default 1)\n");
+    printf("  -o, --output FILE      write the report to FILE instead of stdout\n");
+    printf("      --batch FILE       analyse every graph file listed in FILE (one per line), one result\n");
+    printf("                         line per graph (classes; periods and stationary vectors with --run)\n");
+    printf("      --batch-concat FILE  same for graphs concatenated in FILE, each after its vertex count\n");
+    printf("      --mermaid FILE     export the graph in Mermaid format\n");
+    printf("      --hasse-mermaid FILE  export the Hasse diagram in Mermaid format\n");
+    printf("      --dot FILE         export the graph in Graphviz DOT format\n");
+    printf("      --hasse-dot FILE   export the Hasse diagram in Graphviz DOT format\n");
+    printf("      --results FILE     write the classes, links, periods and stationary vectors to FILE:\n");
+    printf("                         CSV (.csv), JSON lines (.jsonl) or binary (other extensions)\n");
+    printf("      --max-edges N      write at most N edges in the graph exports\n");
+    printf("      --sample R         keep each edge of the graph exports with probability R\n");
+    printf("      --trajectories N   simulate: number of trajectories (default 1000)\n");
+    printf("      --steps N          simulate, transient: steps per trajectory (default 1000)\n");
+    printf("      --start V          simulate, transient: start vertex (default random / uniform)\n");
+    printf("      --target V         simulate: vertex whose hitting time is measured\n");
+    printf("      --seed N           simulate: seed of the generators (default 1)\n");
+    printf("      --profile[=json]   print the profiling report at exit (needs -DMARKOV_PROFILE=ON)\n");
+    printf("      --demo             run the course validation on the DATA/ examples\n");
+    printf("  -h, --help             show this help\n");
+}
+
+/**
+ * @brief Parses a comma separated list of analyses into RUN_* flags.
+ * @return 0 on success, -1 on unknown name
+ */
+static int parse_run_list(const char *list, unsigned *run) {
+    *run = 0;
+    char buffer[256];
+    strncpy(buffer, list, sizeof(buffer) - 1);
+    buffer[sizeof(buffer) - 1] = '\0';
+
+    for (char *name = strtok(buffer, ","); name != NULL; name = strtok(NULL, ",")) {
+        if (strcmp(name, "all") == 0) {
+            for (int i = 0; i < NB_RUN_NAMES; i++) *run |= run_names[i].flag;
+            continue;
+        }
+        int found = 0;
+        for (int i = 0; i < NB_RUN_NAMES; i++) {
+            if (strcmp(name, run_names[i].name) == 0) {
+                *run |= run_names[i].flag;
+                found = 1;
+            }
+        }
+        if (!found) {
+            fprintf(stderr, "Unknown analysis '%s'\n", name);
+            return -1;
+        }
+    }
+    return 0;
+}
+
+/**
+ * @brief Parses the command line.
+ * @return 0 to continue, 1 to exit successfully (help), -1 on error
+ */
+static int parse_options(int argc, char **argv, t_cli_options *opt) {
+    memset(opt, 0, sizeof(*opt));
+    opt->run = RUN_VALIDATE | RUN_SCC;
+    opt->tolerance = 1e-6f;
+    opt->threads = 1;
+    opt->trajectories = 1000;
+    opt->steps = 1000;
+    opt->seed = 1;
+    opt->export = DefaultExportOptions();
+    opt->check = DefaultValidationOptions();
+
+    for (int i = 1; i < argc; i++) {
+        const char *arg = argv[i];
+        const char *val = i + 1 < argc ? argv[i + 1] : NULL;
+
+        // options without value
+        if (strcmp(arg, "-h") == 0 || strcmp(arg, "--help") == 0) {
+            usage(argv[0]);
+            return 1;
+        }
+        if (strcmp(arg, "--demo") == 0) { opt->demo = 1; continue; }
+        if (strcmp(arg, "--profile") == 0) { opt->profile = 1; continue; }
+        if (strcmp(arg, "--profile=json") == 0) { opt->profile = 2; continue; }
+        if (strcmp(arg, "--renormalize") == 0) { opt->check.renormalize = 1; continue; }
+        if (strcmp(arg, "--remap") == 0) { opt->remap = 1; continue; }
+        if (arg[0] != '-') {
+            opt->input = arg;
+            continue;
+        }
+
+        // options with a value
+        if (val == NULL) {
+            fprintf(stderr, "Missing value for %s\n", arg);
+            return -1;
+        }
+        if (strcmp(arg, "-i") == 0 || strcmp(arg, "--input") == 0) opt->input = val;
+        else if (strcmp(arg, "-f") == 0 || strcmp(arg, "--format") == 0) {
+            if (strcmp(val, "rate") == 0) opt->rate_format = 1;
+            else if (strcmp(val, "list") == 0) opt->rate_format = 0;
+            else { fprintf(stderr, "Unknown format '%s'\n", val); return -1; }
+        }
+        else if (strcmp(arg, "--reorder") == 0) {
+            opt->reorder = 1;
+            if (strcmp(val, "class") == 0) opt->reorder_method = REORDER_CLASS;
+            else if (strcmp(val, "bfs") == 0) opt->reorder_method = REORDER_BFS;
+            else if (strcmp(val, "rcm") == 0) opt->reorder_method = REORDER_RCM;
+            else { fprintf(stderr, "Unknown order '%s'\n", val); return -1; }
+        }
+        else if (strcmp(arg, "-r") == 0 || strcmp(arg, "--run") == 0) {
+            if (parse_run_list(val, &opt->run) != 0) return -1;
+        }
+        else if (strcmp(arg, "-s") == 0 || strcmp(arg, "--solver") == 0) {
+            if (strcmp(val, "lazy") == 0) opt->force_lazy = 1;
+            else if (strcmp(val, "power") == 0) opt->force_lazy = 0;
+            else { fprintf(stderr, "Unknown solver '%s'\n", val); return -1; }
+        }
+        else if (strcmp(arg, "-t") == 0 || strcmp(arg, "--tol") == 0) opt->tolerance = (float)atof(val);
+        else if (strcmp(arg, "--check-tol") == 0) opt->check.tolerance = atof(val);
+        else if (strcmp(arg, "--max-iter") == 0) opt->max_iter = atoi(val);
+        else if (strcmp(arg, "-j") == 0 || strcmp(arg, "--threads") == 0) opt->threads = atoi(val);
+        else if (strcmp(arg, "-o") == 0 || strcmp(arg, "--output") == 0) opt->output = val;
+        else if (strcmp(arg, "--batch") == 0) {
+            opt->batch = val;
+            opt->batch_input = BATCH_MANIFEST;
+        }
+        else if (strcmp(arg, "--batch-concat") == 0) {
+            opt->batch = val;
+            opt->batch_input = BATCH_CONCATENATED;
+        }
+        else if (strcmp(arg, "--mermaid") == 0) opt->mermaid = val;
+        else if (strcmp(arg, "--hasse-mermaid") == 0) opt->hasse_file = val;
+        else if (strcmp(arg, "--dot") == 0) opt->dot = val;
+        else if (strcmp(arg, "--hasse-dot") == 0) opt->hasse_dot = val;
+        else if (strcmp(arg, "--results") == 0) opt->results = val;
+        else if (strcmp(arg, "--max-edges") == 0) opt->export.max_edges = atoll(val);
+        else if (strcmp(arg, "--sample") == 0) opt->export.sample_rate = atof(val);
+        else if (strcmp(arg, "--trajectories") == 0) opt->trajectories = atoi(val);
+        else if (strcmp(arg, "--steps") == 0) opt->steps = atoi(val);
+        else if (strcmp(arg, "--start") == 0) opt->start = atoll(val);
+        else if (strcmp(arg, "--target") == 0) opt->target = atoll(val);
+        else if (strcmp(arg, "--seed") == 0) opt->seed = strtoull(val, NULL, 10);
+        else {
+            fprintf(stderr, "Unknown option '%s'\n", arg);
+            return -1;
+        }
+        i++;
+    }
+
+    if (opt->tolerance <= 0.0f || opt->check.tolerance < 0.0 || opt->threads < 1 || opt->max_iter < 0) {
+        fprintf(stderr, "Invalid tolerance, thread count or iteration cap\n");
+        return -1;
+    }
+    if (!opt->demo && opt->input == NULL && opt->batch == NULL) {
+        usage(argv[0]);
+        return -1;
+    }
+    return 0;
+}
+
+/**
+ * @brief Loads a graph file, stops the program if it cannot be loaded.
+ */
+static t_adjacency_list load_graph_or_exit(const char *filename) {
+    t_adjacency_list graph;
+    int status = loadGraphParallel(filename, &graph, scheduler_current());
+    if (status != MARKOV_OK) {
+        fprintf(stderr, "Could not load '%s': %s\n", filename, markov_strerror(status));
+        exit(EXIT_FAILURE);
+    }
+    return graph;
+}
+
+/**
+ * @brief Loads a graph file with arbitrary vertex ids, stops the program if it cannot be loaded.
+ */
+static t_adjacency_list load_mapped_graph_or_exit(const char *filename, t_id_map *ids) {
+    t_adjacency_list graph;
+    int status = loadGraphMapped(filename, &graph, ids);
+    if (status != MARKOV_OK) {
+        fprintf(stderr, "Could not load '%s': %s\n", filename, markov_strerror(status));
+        exit(EXIT_FAILURE);
+    }
+    return graph;
+}
+
+/**
+ * @brief Renumbers the vertices of a graph class by class. The id map is
+ *        replaced by one giving the id of the file of each new vertex, so
+ *        the printers and the command line keep using the ids of the file.
+ * @param graph The graph, replaced by the renumbered one
+ * @param method Order inside a class
+ * @param id_map Map of the file ids, initialized here if has_ids is 0
+ * @param has_ids 1 if id_map holds the ids of the file (--remap)
+ * @return 0 on success, -1 on allocation error (graph and id_map unchanged)
+ */
+static int reorder_vertices(t_adjacency_list *graph, t_reorder_method method, t_id_map *id_map, int has_ids) {
+    p_partition partition = tarjan(*graph);
+    if (partition == NULL) return -1;
+    t_vertex_order order;
+    int status = vertex_order_build(*graph, partition, method, &order);
+    DestroyPartition(partition);
+    if (status != 0) return -1;
+
+    t_adjacency_list permuted;
+    t_id_map renamed;
+    if (reorder_graph(*graph, &order, &permuted) != 0) {
+        vertex_order_free(&order);
+        return -1;
+    }
+    status = id_map_init(&renamed, graph->size);
+    for (int v = 0; v < graph->size && status == 0; v++) {
+        int old = order.old_of_new[v] + 1;
+        if (id_map_insert(&renamed, has_ids ? id_map_external(id_map, old) : old) != v) status = -1;
+    }
+    vertex_order_free(&order);
+    if (status != 0) {
+        id_map_free(&renamed);
+        free_adjacency_list(&permuted);
+        return -1;
+    }
+
+    free_adjacency_list(graph);
+    *graph = permuted;
+    if (has_ids) id_map_free(id_map);
+    *id_map = renamed;
+    return 0;
+}
+
+/**
+ * @brief Converts a vertex given on the command line (an external id with
+ *        --remap) to its vertex number.
+ * @return The vertex number, 0 for 0 (= none), -1 if the id is unknown
+ */
+static int cli_vertex(const t_id_map *ids, long long vertex) {
+    if (ids == NULL || vertex == 0) return vertex < INT_MIN || vertex > INT_MAX ? -1 : (int)vertex;
+    int index = id_map_find(ids, vertex);
+    return index < 0 ? -1 : index + 1;
+}
+
+/**
+ * @brief Prints the outcome of a Mermaid or DOT export.
+ * @param status Return value of the export
+ * @param format Name of the format written ("Mermaid", "DOT")
+ * @param filename Output file
+ */
+static void report_export(int status, const char *format, const char *filename) {
+    if (status == 0) printf("%s file '%s' generated successfully.\n", format, filename);
+    else fprintf(stderr, "Could not write '%s'\n", filename);
+}
+
+/**
+ * @brief Runs --batch / --batch-concat: one result line per graph, in the
+ *        order of the input, then the counts on stderr.
+ * @return 0 on success, 1 on error
+ */
+static int run_batch(const t_cli_options *opt) {
+    t_batch_options options = DefaultBatchOptions();
+    options.input = opt->batch_input;
+    options.analysis.eps = opt->tolerance;
+    options.analysis.max_iter = opt->max_iter;
+    if (opt->run & RUN_PERIOD) options.analysis.flags |= ANALYSIS_PERIOD;
+    if (opt->run & RUN_STATIONARY) options.analysis.flags |= ANALYSIS_STATIONARY;
+    if (opt->force_lazy) options.analysis.flags |= ANALYSIS_FORCE_LAZY;
+
+    t_writer w;
+    if (writer_init(&w, stdout, 0) != 0) return 1;
+    t_batch_summary summary;
+    int status = AnalyzeBatch(opt->batch, &options, &w, &summary);
+    if (writer_close(&w) != 0 && status == MARKOV_OK) status = MARKOV_ERR_IO;
+    fprintf(stderr, "Batch: %d graphs, %d failed\n", summary.nb_graphs, summary.nb_failed);
+    if (status != MARKOV_OK) {
+        fprintf(stderr, "Batch '%s': %s\n", opt->batch, markov_strerror(status));
+        return 1;
+    }
+    return 0;
+}
+
+/**
+ * @brief Runs the requested analyses on one graph file. The partition and the
+ *        class links are computed once, and only if an analysis needs them.
+ * @return 0 on success, 1 on error
+ */
+static int run_analysis(const t_cli_options *opt) {
+    // with --remap every printer writes the ids of the file
+    t_id_map id_map;
+    const t_id_map *ids = NULL;
+    t_adjacency_list graph;
+    if (opt->remap) {
+        graph = load_mapped_graph_or_exit(opt->input, &id_map);
+        ids = &id_map;
+    } else {
+        graph = load_graph_or_exit(opt->input);
+    }
+    t_export_options export_options = opt->export;
+    export_options.ids = ids;
+
+    if (opt->rate_format) {
+        if ((opt->run & RUN_VALIDATE) && checkIfRateGraph(graph, ids) < 0) fprintf(stderr, "Validation failed\n");
+        t_adjacency_list uniform = UniformizeRateGraph(graph, 0.0f);
+        free_adjacency_list(&graph);
+        graph = uniform;
+        if (graph.array == NULL) {
+            fprintf(stderr, "Uniformization failed\n");
+            if (ids) id_map_free(&id_map);
+            return 1;
+        }
+    }
+    if (opt->reorder) {
+        if (reorder_vertices(&graph, opt->reorder_method, &id_map, ids != NULL) != 0) {
+            fprintf(stderr, "Reordering failed\n");
+            free_adjacency_list(&graph);
+            if (ids) id_map_free(&id_map);
+            return 1;
+        }
+        ids = &id_map;
+        export_options.ids = ids;
+    }
+
+    if (opt->run & RUN_VALIDATE) {
+        if (checkIfMarkovWith(graph, &opt->check, ids) < 0) fprintf(stderr, "Validation failed\n");
+        printf("\n");
+    }
+    if (opt->run & RUN_DISPLAY) {
+        t_writer w;
+        writer_init(&w, stdout, 0);
+        write_adjacency_list(&w, &graph, ids);
+        writer_char(&w, '\n');
+        writer_close(&w);
+    }
+    if (opt->mermaid) report_export(ExportGraphMermaid(graph, opt->mermaid, &export_options), "Mermaid", opt->mermaid);
+    if (opt->dot) report_export(ExportGraphDot(graph, opt->dot, &export_options), "DOT", opt->dot);
+
+    unsigned needs_partition = RUN_SCC | RUN_HASSE | RUN_CHARACTERISTICS | RUN_PERIOD | RUN_STATIONARY | RUN_ABSORPTION
+                               | RUN_HITTING | RUN_REACH | RUN_TRANSIENT;
+    if ((opt->run & needs_partition) || opt->hasse_file || opt->hasse_dot || opt->results) {
+        t_analysis_options options = { 0, opt->tolerance, opt->max_iter, opt->threads };
+        if (opt->run & RUN_PERIOD) options.flags |= ANALYSIS_PERIOD;
+        if (opt->run & RUN_STATIONARY) options.flags |= ANALYSIS_STATIONARY;
+        if (opt->force_lazy) options.flags |= ANALYSIS_FORCE_LAZY;
+
+        // every stage below is computed once on the context and shared
+        t_analysis_context ctx;
+        InitAnalysisContext(&ctx, graph, opt->threads);
+        const t_graph_analysis *analysis = ContextAnalysis(&ctx, &options);
+        if (analysis == NULL) {
+            fprintf(stderr, "%s\n", markov_strerror(ctx.status));
+            FreeAnalysisContext(&ctx);
+            free_adjacency_list(&graph);
+            if (ids) id_map_free(&id_map);
+            return 1;
+        }
+        p_partition partition = analysis->partition;
+        int *vertex_to_class = analysis->vertex_to_class;
+        t_link_array class_links = analysis->links;
+
+        t_writer w;
+        writer_init(&w, stdout, 0);
+        if (opt->run & RUN_SCC) write_components(&w, partition, ids);
+        writer_flush(&w);
+        if (opt->run & RUN_HASSE) print_class_context(&ctx);
+        if (opt->hasse_file) report_export(ExportHasseMermaid(partition, &class_links, opt->hasse_file, ids), "Mermaid", opt->hasse_file);
+        if (opt->hasse_dot) report_export(ExportHasseDot(partition, &class_links, opt->hasse_dot, ids), "DOT", opt->hasse_dot);
+        if (opt->run & RUN_CHARACTERISTICS) {
+            const int *transient = ContextTransient(&ctx);
+            if (transient) write_graph_characteristics(&w, partition, transient, ids);
+        }
+        if (opt->run & (RUN_PERIOD | RUN_STATIONARY)) FormatClassAnalyses(&w, analysis, options.flags, ids);
+        writer_close(&w);
+        if (opt->results) {
+            if (ExportResults(analysis, opt->results, ResultsFormatOf(opt->results), ids) == MARKOV_OK) {
+                printf("Results file '%s' generated successfully.\n", opt->results);
+            } else {
+                fprintf(stderr, "Could not write '%s'\n", opt->results);
+            }
+        }
+
+        // absorption and hitting times: one small solve per transient class,
+        // over the block-triangular form of the chain
+        t_block_matrix blocks;
+        int max_iter = opt->max_iter > 0 ? opt->max_iter : 100000;
+        int blocks_status = (opt->run & (RUN_ABSORPTION | RUN_HITTING | RUN_TRANSIENT)) ? CreateBlockMatrix(graph, partition, &blocks) : MARKOV_ERR_ARG;
+        if (opt->run & RUN_ABSORPTION) {
+            t_absorption absorption;
+            if (blocks_status == MARKOV_OK && BlockAbsorption(&blocks, opt->tolerance, max_iter, &absorption) == MARKOV_OK) {
+                printf("Absorption probabilities (%d sweeps):\n", absorption.iterations);
+                for (int v = 0; v < graph.size; v++) {
+                    if (analysis->classes[vertex_to_class[v]].persistent) continue;
+                    printf("  State %lld:", (long long)id_map_external(ids, v + 1));
+                    for (int t = 0; t < absorption.nb_targets; t++) {
+                        printf(" %s=%.4f", partition->classes[absorption.target_class[t]]->name,
+                               absorption.prob[(size_t)v * absorption.nb_targets + t]);
+                    }
+                    printf("\n");
+                }
+                printf("\n");
+                FreeAbsorption(&absorption);
+            } else {
+                printf("Absorption probabilities: computation failed\n\n");
+            }
+        }
+        if (opt->run & RUN_HITTING) {
+            float *times = (float *)malloc(graph.size * sizeof(float));
+            if (blocks_status == MARKOV_OK && times
+                && BlockHittingTimes(&blocks, NULL, opt->tolerance, max_iter, times) == MARKOV_OK) {
+                printf("Expected steps before absorption:\n");
+                for (int v = 0; v < graph.size; v++) {
+                    if (analysis->classes[vertex_to_class[v]].persistent) continue;
+                    printf("  State %lld: %.4f\n", (long long)id_map_external(ids, v + 1), times[v]);
+                }
+                printf("\n");
+            } else {
+                printf("Hitting times: computation failed\n\n");
+            }
+            free(times);
+        }
+        if (opt->run & RUN_TRANSIENT) {
+            float *dist = (float *)malloc((graph.size > 0 ? graph.size : 1) * sizeof(float));
+            int start = cli_vertex(ids, opt->start);
+            int ok = blocks_status == MARKOV_OK && dist && start >= 0 && start <= graph.size;
+            if (ok) {
+                // from the --start vertex, or uniform over the states
+                for (int v = 0; v < graph.size; v++) dist[v] = start > 0 ? (float)(v == start - 1) : 1.0f / graph.size;
+                ok = BlockTransient(&blocks, dist, opt->steps, dist) == MARKOV_OK;
+            }
+            if (ok) {
+                printf("Distribution after %d steps:\n", opt->steps);
+                for (int v = 0; v < graph.size; v++) {
+                    printf("  State %lld: %.4f\n", (long long)id_map_external(ids, v + 1), dist[v]);
+                }
+                printf("\n");
+            } else {
+                printf("Transient distribution: computation failed\n\n");
+            }
+            free(dist);
+        }
+        if (blocks_status == MARKOV_OK) FreeBlockMatrix(&blocks);
+
+        // persistent classes reachable from each transient state: one bitset row per class
+        if (opt->run & RUN_REACH) {
+            t_reach_index reach;
+            int *reached = (int *)malloc((partition->nb_class > 0 ? partition->nb_class : 1) * sizeof(int));
+            if (reached && reach_index_build(partition, vertex_to_class, graph.size, &class_links, &reach) == 0) {
+                printf("Reachable persistent classes:\n");
+                for (int v = 0; v < graph.size; v++) {
+                    if (analysis->classes[vertex_to_class[v]].persistent) continue;
+                    int count = reach_state_persistent(&reach, v, reached);
+                    printf("  State %lld:", (long long)id_map_external(ids, v + 1));
+                    for (int i = 0; i < count; i++) printf(" %s", partition->classes[reached[i]]->name);
+                    printf("%s\n", reach_state_absorbing(&reach, v) ? " (absorbing state reachable)" : "");
+                }
+                printf("\n");
+                reach_index_free(&reach);
+            } else {
+                printf("Reachability: computation failed\n\n");
+            }
+            free(reached);
+        }
+
+        FreeAnalysisContext(&ctx);
+    }
+
+    if (opt->run & RUN_SIMULATE) {
+        p_sparse_matrix S = CreateSparseFromAdjList(graph);
+        p_alias_table A = CreateAliasTable(S);
+        int start = cli_vertex(ids, opt->start), target = cli_vertex(ids, opt->target);
+        t_sim_config config = { opt->trajectories, opt->steps, start, target, opt->threads, opt->seed };
+        t_sim_result result;
+        if (A && start >= 0 && target >= 0 && SimulateTrajectories(A, &config, &result) == 0) {
+            printf("Simulation (%lld steps):\n", result.total_steps);
+            for (int v = 0; v < result.size; v++) {
+                printf("  State %lld: %.4f\n", (long long)id_map_external(ids, v + 1), result.visit_freq[v]);
+            }
+            if (target > 0) {
+                printf("  Target %lld reached by %lld trajectories, mean hitting time %.3f\n",
+                       opt->target, result.nb_hits, result.mean_hitting_time);
+            }
+            printf("\n");
+            FreeSimResult(&result);
+        } else {
+            printf("Simulation failed (check --start / --target)\n\n");
+        }
+        DestroyAliasTable(A);
+        DestroySparseMatrix(S);
+    }
+
+    free_adjacency_list(&graph);
+    if (ids) id_map_free(&id_map);
+    return 0;
+}
+
+/**
+ * @brief Course validation: runs every part of the project on the DATA/ examples.
+ */
+static void run_demo(void) {
     float epsilon = 0.01;
-    t_adjacency_list example1 = readGraph("DATA/exemple1.txt");
-    t_adjacency_list example2 = readGraph("DATA/exemple2.txt");
-    t_adjacency_list example3 = readGraph("DATA/exemple3.txt");
-    t_adjacency_list example_valid_step3 = readGraph("DATA/exemple_valid_step3.txt");
-    t_adjacency_list graph_meteo = readGraph("DATA/example_meteo.txt");
-    t_adjacency_list graph_chatgpt = readGraph("DATA/exemple1_from_chatGPT.txt");
+    t_adjacency_list example1 = load_graph_or_exit("DATA/exemple1.txt");
+    t_adjacency_list example2 = load_graph_or_exit("DATA/exemple2.txt");
+    t_adjacency_list example3 = load_graph_or_exit("DATA/exemple3.txt");
+    t_adjacency_list example_valid_step3 = load_graph_or_exit("DATA/exemple_valid_step3.txt");
+    t_adjacency_list graph_meteo = load_graph_or_exit("DATA/example_meteo.txt");
+    t_adjacency_list graph_chatgpt = load_graph_or_exit("DATA/exemple1_from_chatGPT.txt");
 
 
     printf("Part 1: step 1 validation :\n");
@@ -31,34 +605,43 @@ int main() {
 
 
     printf("Part 1: step 3 validation :\n");
-    exportToMermaid(example_valid_step3, "DATA/mermaid-file.mmd");
+    report_export(exportToMermaid(example_valid_step3, "DATA/mermaid-file.mmd"), "Mermaid", "DATA/mermaid-file.mmd");
     printf("\n");
 
 
     printf("Part 2: step 1 validation :\n");
-    p_partition partition = tarjan(example_valid_step3);
-    print_component(partition);
+    // the classes, links and matrices of a graph are computed once for all the parts
+    t_analysis_context step3;
+    InitAnalysisContext(&step3, example_valid_step3, 1);
+    print_component_context(&step3);
 
 
     printf("Part 2: step 2 validation :\n");
-    int *vertex_to_class = create_vertex_class_array(example_valid_step3.size, partition);
-    t_link_array class_links;
-    links_init(&class_links);
-    list_class_links(&example_valid_step3, vertex_to_class, &class_links);
+    const t_partition *partition = ContextPartition(&step3);
+    const t_link_array *class_links = ContextClassLinks(&step3);
     //possibility to print the classes
-    //print_class(partition, class_links);
+    //print_class_context(&step3);
 
     printf("Hasse diagram (Mermaid format):\n");
-    print_hasse_mermaid(partition, &class_links,"DATA/mermaid-file-part2.mmd");
+    report_export(print_hasse_mermaid(partition, class_links,"DATA/mermaid-file-part2.mmd"), "Mermaid", "DATA/mermaid-file-part2.mmd");
     printf("\n");
 
 
     printf("Part 2: step 3 validation :\n");
-    display_graph_characteristics(partition, &class_links);
+    const int *transient = ContextTransient(&step3);
+    if (transient) {
+        t_writer w;
+        writer_init(&w, stdout, 0);
+        write_graph_characteristics(&w, partition, transient, NULL);
+        writer_close(&w);
+    }
+    FreeAnalysisContext(&step3);
 
 
     printf("Part 3: step 1 validation:\n");
-    p_matrix  Meteo = CreateMatFromAdjList(graph_meteo);
+    t_analysis_context meteo;
+    InitAnalysisContext(&meteo, graph_meteo, 1);
+    p_matrix  Meteo = ContextMatrix(&meteo);
     printf ("Meteo Matrix");
     printMatrix(Meteo);
     PowerMatrix (Meteo, 3);
@@ -80,10 +663,35 @@ int main() {
     printMatrix(Meteo);
 
     printf("Part 3: step 2 validation\n");
-    step2_validation(graph_meteo);
+    step2_validationContext(&meteo);
     printf("\n");
 
     printf("Part 3: step 3 validation:");
-    periodicity(graph_meteo);
-    return 0;
+    periodicityContext(&meteo);
+    FreeAnalysisContext(&meteo);
+}
+
+int main(int argc, char **argv) {
+    t_cli_options opt;
+    int status = parse_options(argc, argv, &opt);
+    if (status != 0) return status > 0 ? 0 : 1;
+
+    opt.export.seed = opt.seed;
+    if (opt.profile) prof_report_at_exit(opt.profile == 2);
+
+    if (opt.output && freopen(opt.output, "wt", stdout) == NULL) {
+        fprintf(stderr, "Could not open '%s' for writing\n", opt.output);
+        return 1;
+    }
+
+    // one set of threads for the whole run, shared by the loader, the
+    // per-class analyses, the matrix kernels and the simulation
+    t_scheduler *scheduler = opt.threads > 1 ? scheduler_create(opt.threads) : NULL;
+    scheduler_set_default(scheduler);
+
+    if (opt.demo) run_demo();
+    if (opt.input != NULL) status = run_analysis(&opt);
+    if (opt.batch != NULL && status == 0) status = run_batch(&opt);
+    scheduler_destroy(scheduler);
+    return status;
 }
@@ -0,0 +1,52 @@
+#ifndef MARKOV_CORE_H
+#define MARKOV_CORE_H
+
+/*
+ * Public header of the markov_core library: include this file and link with
+ * markov_core to embed the analyzer in another program.
+ *
+ * Library functions never print on the error path nor stop the program:
+ * they report failures through their return value (NULL, -1 or a negative
+ * t_markov_status, see status/status.h). AnalyzeGraph() and the other
+ * compute functions return result structures and never print; the Format*
+ * functions (report/report.h) turn them into text through a buffered writer.
+ * The functions that print directly (display_*, print_*, periodicity, ...)
+ * are kept for the command-line driver.
+ */
+
+#define MARKOV_CORE_VERSION_MAJOR 1
+#define MARKOV_CORE_VERSION_MINOR 0
+
+#include "status/status.h"
+#include "cell/cell.h"
+#include "list/list.h"
+#include "adjacency_list/adjacency_list.h"
+#include "tarjan/tarjan.h"
+#include "hasse/hasse.h"
+#include "matrix/matrix.h"
+#include "utils/utils.h"
+#include "sparse/sparse.h"
+#include "ctmc/ctmc.h"
+#include "simulation/simulation.h"
+#include "spectral/spectral.h"
+#include "absorption/absorption.h"
+#include "profiling/profiling.h"
+#include "writer/writer.h"
+#include "analysis/analysis.h"
+#include "context/context.h"
+#include "report/report.h"
+#include "export/export.h"
+#include "validation/validation.h"
+#include "idmap/idmap.h"
+#include "incremental/incremental.h"
+#include "scheduler/scheduler.h"
+#include "fwbw/fwbw.h"
+#include "reorder/reorder.h"
+#include "blocks/blocks.h"
+#include "reach/reach.h"
+#include "small_matrix/small_matrix.h"
+#include "arena/arena.h"
+#include "batch/batch.h"
+#include "results/results.h"
+
+#endif //MARKOV_CORE_H
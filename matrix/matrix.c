@@ -1,9 +1,23 @@
 #include "matrix.h"
 #include "../cell/cell.h"
 #include "../utils/utils.h"
+#include "../profiling/profiling.h"
+#include "../scheduler/scheduler.h"
+#include "../small_matrix/small_matrix.h"
 #include <stdio.h>
 #include <stdlib.h>
 
+// multiply-adds below which a loop is not worth splitting between threads
+#define MATRIX_PARALLEL_WORK (1 << 16)
+
+/**
+ * @brief Smallest number of iterations of a parallel loop given the work of
+ *        one iteration, so that each range does at least MATRIX_PARALLEL_WORK.
+ */
+static int parallel_grain(long long work_per_iteration, int min_grain) {
+    long long grain = MATRIX_PARALLEL_WORK / (work_per_iteration > 0 ? work_per_iteration : 1);
+    return grain > min_grain ? (int)grain : min_grain;
+}
 
 /**
  * @brief Allocates and initializes a square matrix of size n x n with zeros.
@@ -23,12 +37,20 @@ p_matrix CreateEmptyMatrix(int n) {
     M->size = n;
 
     // Allocate an array of n pointers, one pointer for each row
-    M->data = malloc(n * sizeof(float *));
-
-    // For each row, allocate n floats and initialize them to 0 using calloc
-    for (int i = 0; i < n; i++) {
-        M->data[i] = calloc(n, sizeof(float));
-        // calloc sets all entries in the row to 0.0
+    M->data = malloc((n > 0 ? n : 1) * sizeof(float *));
+    // All the rows in one zeroed block (calloc sets the entries to 0.0):
+    // row i starts at entry i * n
+    float *entries = calloc(n > 0 ? (size_t)n * n : 1, sizeof(float));
+    PROF_COUNT(PROF_ALLOCATIONS, 3);
+    if (!M->data || !entries) {
+        free(M->data);
+        free(entries);
+        free(M);
+        return NULL;
+    }
+    M->data[0] = entries;
+    for (int i = 1; i < n; i++) {
+        M->data[i] = entries + (size_t)i * n;
     }
 
     return M;
@@ -44,9 +66,14 @@ p_matrix CreateEmptyMatrix(int n) {
  * @return p_matrix Pointer to the resulting matrix.
  */
 p_matrix CreateMatFromAdjList(t_adjacency_list graph) {
+    PROF_BEGIN(PROF_STAGE_DENSIFY);
     int n = graph.size;
     // Create an empty n×n matrix initialized with zeros
     p_matrix M = CreateEmptyMatrix(n);
+    if (M == NULL) {
+        PROF_END(PROF_STAGE_DENSIFY);
+        return NULL;
+    }
     // For each vertex i in the graph
     for (int i = 0; i < n; i++) {
         // Pointer to the adjacency list of vertex i
@@ -55,13 +82,16 @@ p_matrix CreateMatFromAdjList(t_adjacency_list graph) {
         while (neigh != NULL) {
             // j = index of the destination vertex
             int j = neigh->arrival - 1;
+            PROF_COUNT(PROF_EDGES_SCANNED, 1);
             // Fill the matrix entry M[i][j] with the transition probability
-            M->data[i][j] = neigh->probability;
+            // (an arrival outside the graph has no column, see ValidateGraph())
+            if (j >= 0 && j < n) M->data[i][j] = neigh->probability;
             // Move to next neighbor in the adjacency list
             neigh = neigh->next;
         }
     }
 
+    PROF_END(PROF_STAGE_DENSIFY);
     return M;
 }
 
@@ -87,6 +117,32 @@ void CopyMatrix(p_matrix mat, p_matrix matsrc) {
     }
 }
 
+/**
+ * @brief Rows [begin, end) of a product R = A * B (body of a parallel loop).
+ */
+typedef struct s_multiply_job {
+    p_matrix A;
+    p_matrix B;
+    p_matrix R;
+} t_multiply_job;
+
+static void multiply_rows(void *ctx, int begin, int end) {
+    t_multiply_job *job = (t_multiply_job *)ctx;
+    int n = job->A->size;
+    for (int i = begin; i < end; i++) {    // Row index of A and R
+        for (int j = 0; j < n; j++) {      // Column index of B and R
+            float sum = 0.0f;
+
+            // Compute the dot product of row i of A and column j of B
+            for (int k = 0; k < n; k++) {
+                sum += job->A->data[i][k] * job->B->data[k][j];
+            }
+
+            job->R->data[i][j] = sum;
+        }
+    }
+}
+
 /**
  * @brief Performs matrix multiplication (A * B).
  *
@@ -101,24 +157,32 @@ p_matrix MultiplyMatrices(p_matrix A, p_matrix B) {
         // Incompatible sizes
         return NULL;
     }
+    PROF_BEGIN(PROF_STAGE_MULTIPLY);
     int n = A->size;
     // Create an empty n x n result matrix, initialized with 0
     p_matrix R = CreateEmptyMatrix(n);
+    if (!R) {
+        PROF_END(PROF_STAGE_MULTIPLY);
+        return NULL;
+    }
 
-    // Standard matrix multiplication: R = A * B
-    for (int i = 0; i < n; i++) {          // Row index of A and R
-        for (int j = 0; j < n; j++) {      // Column index of B and R
-            float sum = 0.0f;
-
-            // Compute the dot product of row i of A and column j of B
-            for (int k = 0; k < n; k++) {
-                sum += A->data[i][k] * B->data[k][j];
-            }
-
-            R->data[i][j] = sum;
-        }
+    // small chains: the unrolled kernel of their size, on stack copies
+    if (n <= SMALL_MATRIX_MAX) {
+        t_small_matrix a, b, r;
+        SmallMatrixLoad(&a, A);
+        SmallMatrixLoad(&b, B);
+        SmallMatrixMultiply(&a, &b, &r);
+        SmallMatrixStore(R, &r);
+        PROF_END(PROF_STAGE_MULTIPLY);
+        return R;
     }
 
+    // Standard matrix multiplication: R = A * B, rows split between the
+    // threads of the current scheduler (each row is computed as before)
+    t_multiply_job job = { A, B, R };
+    scheduler_parallel_for(scheduler_current(), 0, n, parallel_grain((long long)n * n, 1), multiply_rows, &job);
+
+    PROF_END(PROF_STAGE_MULTIPLY);
     return R;  // Return the resulting matrix
 }
 
@@ -168,16 +232,177 @@ float DiffMatrix(p_matrix M, p_matrix N) {
  * @param M The matrix to display.
  */
 void printMatrix(p_matrix M) {
+    t_writer w;
+    writer_init(&w, stdout, 0);
+    WriteMatrix(&w, M);
+    writer_close(&w);
+}
+
+/**
+ * @brief Writes the matrix in the format of printMatrix().
+ *
+ * @param w The destination writer.
+ * @param M The matrix to write.
+ */
+void WriteMatrix(t_writer *w, p_matrix M) {
     int n = M->size;
     for (int i = 0; i<n ; i++) {
-        printf("[");
+        writer_puts(w, "[");
         for (int j = 0; j<n ; j++) {
-            printf("%.2f  ",M->data[i][j]);
+            writer_printf(w, "%.2f  ",M->data[i][j]);
         }
-        printf("]\n");
+        writer_puts(w, "]\n");
     }
-    printf("\n");
-    printf("\n");
+    writer_puts(w, "\n\n");
+}
+
+/**
+ * @brief Computes M^power by repeated squaring.
+ *
+ * @param M The matrix.
+ * @param power The exponent (>= 0).
+ * @return p_matrix A new matrix, NULL on error.
+ */
+p_matrix MatrixPower(p_matrix M, int power) {
+    if (M == NULL || power < 0) return NULL;
+    if (M->size <= SMALL_MATRIX_MAX) {
+        // every intermediate product stays on the stack
+        p_matrix R = CreateEmptyMatrix(M->size);
+        if (!R) return NULL;
+        t_small_matrix m, r;
+        SmallMatrixLoad(&m, M);
+        SmallMatrixPower(&m, power, &r);
+        SmallMatrixStore(R, &r);
+        return R;
+    }
+    p_matrix result = CreateIdentityMatrix(M->size);
+    p_matrix base = CreateEmptyMatrix(M->size);
+    if (!result || !base) {
+        DestroyMatrix(result);
+        DestroyMatrix(base);
+        return NULL;
+    }
+    CopyMatrix(base, M);
+
+    // binary exponentiation: result *= base for every bit set in power
+    while (power > 0 && result && base) {
+        if (power & 1) {
+            p_matrix tmp = MultiplyMatrices(result, base);
+            DestroyMatrix(result);
+            result = tmp;
+        }
+        power >>= 1;
+        if (power > 0) {
+            p_matrix tmp = MultiplyMatrices(base, base);
+            DestroyMatrix(base);
+            base = tmp;
+        }
+    }
+    if (!base) {
+        DestroyMatrix(result);
+        result = NULL;
+    }
+    DestroyMatrix(base);
+    return result;
+}
+
+/**
+ * @brief Approximates the limit of the powers of M.
+ *
+ * @param M The transition matrix.
+ * @param eps The convergence threshold.
+ * @param max_steps The maximum number of steps.
+ * @param keep_diffs 1 to record the difference of every step.
+ * @param result Output (free with FreeMatrixLimit).
+ * @return int 0 on success, -1 on error.
+ */
+int StationaryMatrixLimit(p_matrix M, float eps, int max_steps, int keep_diffs, t_matrix_limit *result) {
+    if (M == NULL || result == NULL || max_steps < 1) return -1;
+    result->limit = NULL;
+    result->diffs = NULL;
+    result->steps = 0;
+    result->converged = 0;
+
+    if (keep_diffs) {
+        result->diffs = (float *)malloc(max_steps * sizeof(float));
+        if (!result->diffs) return -1;
+    }
+
+    if (M->size <= SMALL_MATRIX_MAX) {
+        // same steps on three stack matrices, only the limit is allocated
+        result->limit = CreateEmptyMatrix(M->size);
+        if (!result->limit) {
+            FreeMatrixLimit(result);
+            return -1;
+        }
+        t_small_matrix buf[3];
+        t_small_matrix *prev = &buf[0], *next = &buf[1], *tmp = &buf[2];
+        SmallMatrixLoad(prev, M);
+        SmallMatrixMultiply(prev, prev, next);
+        float diff = SmallMatrixDiff(prev, next);
+        int steps = 1;
+        if (keep_diffs) result->diffs[0] = diff;
+        while (diff > eps && steps < max_steps) {
+            SmallMatrixMultiply(next, prev, tmp);
+            steps++;
+            diff = SmallMatrixDiff(next, tmp);
+            if (keep_diffs) result->diffs[steps - 1] = diff;
+            t_small_matrix *old = prev;
+            prev = next;
+            next = tmp;
+            tmp = old;
+        }
+        SmallMatrixStore(result->limit, next);
+        result->steps = steps;
+        result->diff = diff;
+        result->converged = diff <= eps;
+        return 0;
+    }
+
+    p_matrix prev = CreateEmptyMatrix(M->size);
+    p_matrix next = MultiplyMatrices(M, M);
+    if (!prev || !next) {
+        DestroyMatrix(prev);
+        DestroyMatrix(next);
+        FreeMatrixLimit(result);
+        return -1;
+    }
+    CopyMatrix(prev, M);
+
+    float diff = DiffMatrix(prev, next);
+    int steps = 1;
+    if (keep_diffs) result->diffs[0] = diff;
+
+    while (diff > eps && steps < max_steps) {
+        p_matrix tmp = MultiplyMatrices(next, prev);
+        if (!tmp) break;
+        steps++;
+        diff = DiffMatrix(next, tmp);
+        if (keep_diffs) result->diffs[steps - 1] = diff;
+        DestroyMatrix(prev);
+        prev = next;
+        next = tmp;
+    }
+    DestroyMatrix(prev);
+
+    result->limit = next;
+    result->steps = steps;
+    result->diff = diff;
+    result->converged = diff <= eps;
+    return 0;
+}
+
+/**
+ * @brief Frees the matrix and the differences of a t_matrix_limit.
+ *
+ * @param result The result to free.
+ */
+void FreeMatrixLimit(t_matrix_limit *result) {
+    if (result == NULL) return;
+    DestroyMatrix(result->limit);
+    free(result->diffs);
+    result->limit = NULL;
+    result->diffs = NULL;
 }
 
 /**
@@ -216,7 +441,7 @@ p_matrix subMatrix(p_matrix M, t_partition part, int compo_index)
 
     // Copy each row and column from M corresponding to the vertices of the class
     for (int i = 0; i < n; i++) {
-        int row = cls->vertices[i] - 1;''
+        int row = cls->vertices[i] - 1;
         for (int j = 0; j < n; j++) {
             int col = cls->vertices[j] - 1;
             sub->data[i][j] = M->data[row][col]; // Copy the value from the full matrix into the submatrix
@@ -226,6 +451,43 @@ p_matrix subMatrix(p_matrix M, t_partition part, int compo_index)
     return sub;
 }
 
+/**
+ * @brief Builds the submatrix of a class straight from the adjacency list.
+ *
+ * Only the edges leaving the vertices of the class are read, so the cost is
+ * O(size of the class + its outgoing edges) instead of O(n^2) for the full matrix.
+ *
+ * @param graph The graph.
+ * @param cls The class to extract.
+ * @param position Scratch array of graph.size ints set to -1 (restored on return).
+ * @return p_matrix The submatrix, NULL on error.
+ */
+p_matrix SubMatrixFromAdjList(t_adjacency_list graph, const t_class *cls, int *position) {
+    if (!cls || !position || cls->nb_vertices <= 0) return NULL;
+    int n = cls->nb_vertices;
+
+    p_matrix sub = CreateEmptyMatrix(n);
+    if (!sub) return NULL;
+
+    // position[v] = row/column of vertex v inside the class
+    for (int i = 0; i < n; i++) position[cls->vertices[i] - 1] = i;
+
+    for (int i = 0; i < n; i++) {
+        t_cell *neigh = graph.array[cls->vertices[i] - 1].head;
+        while (neigh != NULL) {
+            int j = neigh->arrival - 1;
+            // keep only the edges that stay inside the class
+            if (j >= 0 && j < graph.size && position[j] >= 0) {
+                sub->data[i][position[j]] = neigh->probability;
+            }
+            neigh = neigh->next;
+        }
+    }
+
+    for (int i = 0; i < n; i++) position[cls->vertices[i] - 1] = -1;
+    return sub;
+}
+
 /**
  * @brief Computes the stationary probability vector (Pi) for a submatrix.
  *
@@ -234,9 +496,51 @@ p_matrix subMatrix(p_matrix M, t_partition part, int compo_index)
  * @param S The submatrix (transition matrix of an SCC).
  * @param max_iter Maximum number of iterations.
  * @param eps Convergence threshold (epsilon).
- * @return float* A dynamically allocated array representing the stationary vector.
+ * @return float* A dynamically allocated array representing the stationary vector,
+ *         NULL without convergence.
  */
 float *StationaryVectorFromSubmatrix(p_matrix S, int max_iter, float eps) {
+    return StationaryVectorFromGuess(S, NULL, max_iter, eps, NULL);
+}
+
+/**
+ * @brief Columns [begin, end) of pi2 = pi * S (body of a parallel loop). The
+ *        k loop stays outside, so every pi2[j] is summed in the same order
+ *        whatever the split.
+ */
+typedef struct s_vector_job {
+    p_matrix S;
+    const float *pi;
+    float *pi2;
+} t_vector_job;
+
+static void vector_product_columns(void *ctx, int begin, int end) {
+    t_vector_job *job = (t_vector_job *)ctx;
+    int n = job->S->size;
+    for (int j = begin; j < end; ++j) job->pi2[j] = 0.0f;
+    for (int k = 0; k < n; ++k) {
+        float pik = job->pi[k];
+        if (pik == 0.0f) continue;
+        const float *row = job->S->data[k];
+        for (int j = begin; j < end; ++j) {
+            job->pi2[j] += pik * row[j];
+        }
+    }
+}
+
+/**
+ * @brief Power method started from a given vector instead of the uniform one.
+ *
+ * @param S The submatrix (transition matrix of an SCC).
+ * @param guess Initial vector (e.g. the solution before an update), NULL for uniform.
+ * @param max_iter Maximum number of iterations.
+ * @param eps Convergence threshold (epsilon).
+ * @param iterations Output: number of iterations done (may be NULL).
+ * @return float* A dynamically allocated array representing the stationary vector,
+ *         NULL without convergence.
+ */
+float *StationaryVectorFromGuess(p_matrix S, const float *guess, int max_iter, float eps, int *iterations) {
+    if (iterations) *iterations = 0;
     if (!S || S->size <= 0 || max_iter <= 0 || eps <= 0.0f) return NULL;
     int n = S->size;
 
@@ -250,20 +554,43 @@ float *StationaryVectorFromSubmatrix(p_matrix S, int max_iter, float eps) {
     float *pi  = (float*)malloc(n * sizeof(float));
     float *pi2 = (float*)malloc(n * sizeof(float));
     if (!pi || !pi2) { free(pi); free(pi2); return NULL; }
+    PROF_COUNT(PROF_ALLOCATIONS, 2);
+    PROF_BEGIN(PROF_STAGE_STATIONARY);
+
+    /* init : the guess (clamped and normalized), uniform without a usable guess */
+    float start_sum = 0.0f;
+    for (int j = 0; guess && j < n; ++j) {
+        pi[j] = guess[j] > 0.0f ? guess[j] : 0.0f;
+        start_sum += pi[j];
+    }
+    if (start_sum > 0.0f) {
+        for (int j = 0; j < n; ++j) pi[j] /= start_sum;
+    } else {
+        for (int j = 0; j < n; ++j) pi[j] = 1.0f / (float)n;
+    }
 
-    /* init uniforme */
-    for (int j = 0; j < n; ++j) pi[j] = 1.0f / (float)n;
-
-    for (int it = 0; it < max_iter; ++it) {
-        /* pi2 = pi * S */
-        for (int j = 0; j < n; ++j) pi2[j] = 0.0f;
-        for (int k = 0; k < n; ++k) {
-            float pik = pi[k];
-            if (pik == 0.0f) continue;
-            for (int j = 0; j < n; ++j) {
-                pi2[j] += pik * S->data[k][j];
-            }
+    if (n <= SMALL_MATRIX_MAX) {
+        t_small_matrix small;
+        SmallMatrixLoad(&small, S);
+        int done = SmallStationaryVector(&small, pi, max_iter, eps);
+        PROF_COUNT(PROF_ITERATIONS, done < 0 ? max_iter : done);
+        if (iterations) *iterations = done < 0 ? max_iter : done;
+        free(pi2);
+        PROF_END(PROF_STAGE_STATIONARY);
+        if (done < 0) {
+            free(pi);
+            return NULL;
         }
+        return pi;
+    }
+
+    int converged = 0;
+    for (int it = 0; it < max_iter && !converged; ++it) {
+        PROF_COUNT(PROF_ITERATIONS, 1);
+        if (iterations) *iterations = it + 1;
+        /* pi2 = pi * S, by column ranges on large classes */
+        t_vector_job job = { S, pi, pi2 };
+        scheduler_parallel_for(scheduler_current(), 0, n, parallel_grain(n, 64), vector_product_columns, &job);
 
         /* normalisation */
         float sum = 0.0f;
@@ -281,10 +608,16 @@ float *StationaryVectorFromSubmatrix(p_matrix S, int max_iter, float eps) {
         /* copie pi2 -> pi */
         for (int j = 0; j < n; ++j) pi[j] = pi2[j];
 
-        if (diff < eps) break;
+        converged = diff < eps;
     }
 
     free(pi2);
+    PROF_END(PROF_STAGE_STATIONARY);
+    if (!converged) {
+        /* the last iterate is not a stationary vector */
+        free(pi);
+        return NULL;
+    }
     return pi;   /* à free par l’appelant */
 }
 
@@ -297,9 +630,8 @@ void DestroyMatrix(p_matrix M) {
     if (M == NULL) {
         return;
     }
-    for (int i = 0; i < M->size; i++) {
-        free(M->data[i]);
-    }
+    // the rows share one block, starting at row 0
+    if (M->data) free(M->data[0]);
     free(M->data);
     free(M);
 }
@@ -336,9 +668,20 @@ int getPeriod(p_matrix sub_matrix) //we put a pointer since we did that in the c
     int n = sub_matrix->size; //we use ->since its now a pointer
     if (n == 0) return 0;
 
+    //small classes: the powers are computed on the stack by the unrolled kernels
+    if (n <= SMALL_MATRIX_MAX) {
+        PROF_BEGIN(PROF_STAGE_PERIOD);
+        t_small_matrix small;
+        SmallMatrixLoad(&small, sub_matrix);
+        int period = SmallMatrixPeriod(&small);
+        PROF_END(PROF_STAGE_PERIOD);
+        return period;
+    }
+
     //allocate a dynamic array so that it can store all the cycle
     int *periods = (int *)malloc(n * sizeof(int));
     if (!periods) return 0; //safety check
+    PROF_BEGIN(PROF_STAGE_PERIOD);
     //initialize a counter
     int period_count = 0;
 
@@ -383,5 +726,6 @@ int getPeriod(p_matrix sub_matrix) //we put a pointer since we did that in the c
     DestroyMatrix(power_matrix);
 
     //return the period
+    PROF_END(PROF_STAGE_PERIOD);
     return period;
 }
@@ -2,6 +2,7 @@
 #define MATRIX_H
 #include "../adjacency_list/adjacency_list.h"
 #include "../tarjan/tarjan.h"
+#include "../writer/writer.h"
 
 /**
  * @brief Structure representing a square matrix of floating point numbers.
@@ -16,6 +17,8 @@ typedef struct s_matrix {
 /**
  * @brief Allocates and initializes an empty square matrix (filled with 0.0).
  *
+ * The rows point into a single block of n * n floats (data[0] is its start).
+ *
  * @param n The dimension of the matrix (n x n).
  * @return p_matrix Pointer to the allocated matrix.
  */
@@ -62,6 +65,56 @@ float DiffMatrix(p_matrix M, p_matrix N);
  */
 void printMatrix(p_matrix M);
 
+/**
+ * @brief Writes the matrix in the format of printMatrix().
+ *
+ * @param w The destination writer.
+ * @param M The matrix to write.
+ */
+void WriteMatrix(t_writer *w, p_matrix M);
+
+/**
+ * @brief Computes M^power by repeated squaring (O(n^3 log power)).
+ *
+ * @param M The matrix.
+ * @param power The exponent (>= 0, M^0 is the identity).
+ * @return p_matrix A new matrix, NULL on error.
+ */
+p_matrix MatrixPower(p_matrix M, int power);
+
+/**
+ * @brief Result of StationaryMatrixLimit().
+ */
+typedef struct s_matrix_limit {
+    p_matrix limit;  // last product computed
+    int steps;       // number of products computed
+    float diff;      // difference between the last two products
+    int converged;   // 1 if diff <= eps
+    float *diffs;    // diffs[s - 1] = difference at step s, NULL if not requested
+} t_matrix_limit;
+
+/**
+ * @brief Approximates the limit of the powers of M.
+ *
+ * Step 1 compares M and M^2; each next step multiplies the last product by
+ * the previous one and compares them, until the difference is below eps.
+ *
+ * @param M The transition matrix.
+ * @param eps The convergence threshold.
+ * @param max_steps The maximum number of steps.
+ * @param keep_diffs 1 to record the difference of every step in result->diffs.
+ * @param result Output (free with FreeMatrixLimit).
+ * @return int 0 on success, -1 on error.
+ */
+int StationaryMatrixLimit(p_matrix M, float eps, int max_steps, int keep_diffs, t_matrix_limit *result);
+
+/**
+ * @brief Frees the matrix and the differences of a t_matrix_limit.
+ *
+ * @param result The result to free.
+ */
+void FreeMatrixLimit(t_matrix_limit *result);
+
 /**
  * @brief Extracts the submatrix corresponding to a specific component (Class) from the partition.
  *
@@ -69,9 +122,22 @@ void printMatrix(p_matrix M);
  * @param part The partition containing the components.
  * @param compo_index The index of the component to extract.
  * @return p_matrix The submatrix restricted to the vertices of the specified component.
+ *         (AnalyzeGraph() reads the classes in place through a t_sparse_view instead.)
  */
 p_matrix subMatrix(p_matrix M, t_partition part, int compo_index);
 
+/**
+ * @brief Builds the submatrix of a class directly from the adjacency list,
+ *        without creating the full n x n matrix first.
+ *
+ * @param graph The graph.
+ * @param cls The class to extract.
+ * @param position Scratch array of graph.size ints, all equal to -1; it is
+ *        restored to -1 before returning, so it can be reused for every class.
+ * @return p_matrix The submatrix (rows/columns in the order of cls->vertices), NULL on error.
+ */
+p_matrix SubMatrixFromAdjList(t_adjacency_list graph, const t_class *cls, int *position);
+
 //need to add this to be sure that there is no memory leaks
 /**
  * @brief Frees the memory allocated for a matrix.
@@ -104,7 +170,24 @@ int getPeriod(p_matrix sub_matrix);
  * @param S The submatrix (stochastic matrix).
  * @param max_iter The maximum number of iterations for the power method.
  * @param eps The convergence threshold (epsilon).
- * @return float* A dynamically allocated array containing the stationary probabilities.
+ * @return float* A dynamically allocated array containing the stationary probabilities,
+ *         NULL if eps was not reached within max_iter iterations.
  */
 float *StationaryVectorFromSubmatrix(p_matrix S, int max_iter, float eps);
+
+/**
+ * @brief Same as StationaryVectorFromSubmatrix(), started from a previous
+ *        solution: after a small change of S it converges in a few iterations.
+ *
+ * @param S The submatrix (stochastic matrix).
+ * @param guess Initial vector of S->size entries (clamped to >= 0 and
+ *        normalized), NULL or all zero for the uniform vector.
+ * @param max_iter The maximum number of iterations for the power method.
+ * @param eps The convergence threshold (epsilon).
+ * @param iterations Output: number of iterations done (may be NULL).
+ * @return float* A dynamically allocated array containing the stationary probabilities,
+ *         NULL if eps was not reached within max_iter iterations (*iterations
+ *         is then max_iter).
+ */
+float *StationaryVectorFromGuess(p_matrix S, const float *guess, int max_iter, float eps, int *iterations);
 #endif //MATRIX_H
\ No newline at end of file
@@ -0,0 +1,127 @@
+#include "profiling.h"
+#include <stdatomic.h>
+#include <stdlib.h>
+#include <time.h>
+
+static const char *stage_names[PROF_NB_STAGES] = {
+    "readGraph", "tarjan", "list_class_links", "removeTransitiveLinks",
+    "CreateMatFromAdjList", "MultiplyMatrices", "period", "stationary",
+    "vertex_order_build"
+};
+
+static const char *counter_names[PROF_NB_COUNTERS] = {
+    "edges_scanned", "allocations", "iterations", "bytes_read"
+};
+
+// totals are kept in nanoseconds so they can be updated atomically
+static atomic_llong stage_ns[PROF_NB_STAGES];
+static atomic_llong stage_calls[PROF_NB_STAGES];
+static atomic_llong counters[PROF_NB_COUNTERS];
+
+static int exit_as_json = 0;
+
+/**
+ * @brief Monotonic clock in milliseconds.
+ * @return Current time in ms
+ */
+double prof_now_ms(void) {
+    struct timespec ts;
+#ifdef CLOCK_MONOTONIC
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+#else
+    timespec_get(&ts, TIME_UTC); // no monotonic clock on this platform
+#endif
+    return (double)ts.tv_sec * 1000.0 + (double)ts.tv_nsec / 1e6;
+}
+
+/**
+ * @brief Adds a duration to a stage and counts one call.
+ * @param stage Stage to update
+ * @param ms Duration in milliseconds
+ */
+void prof_add_time(t_prof_stage stage, double ms) {
+    if (stage < 0 || stage >= PROF_NB_STAGES) return;
+    atomic_fetch_add_explicit(&stage_ns[stage], (long long)(ms * 1e6), memory_order_relaxed);
+    atomic_fetch_add_explicit(&stage_calls[stage], 1, memory_order_relaxed);
+}
+
+/**
+ * @brief Adds a value to a counter.
+ * @param counter Counter to update
+ * @param value Amount to add
+ */
+void prof_add_count(t_prof_counter counter, long long value) {
+    if (counter < 0 || counter >= PROF_NB_COUNTERS) return;
+    atomic_fetch_add_explicit(&counters[counter], value, memory_order_relaxed);
+}
+
+/**
+ * @brief Resets every stage and counter.
+ */
+void prof_reset(void) {
+    for (int s = 0; s < PROF_NB_STAGES; s++) {
+        atomic_store(&stage_ns[s], 0);
+        atomic_store(&stage_calls[s], 0);
+    }
+    for (int c = 0; c < PROF_NB_COUNTERS; c++) atomic_store(&counters[c], 0);
+}
+
+/**
+ * @brief Prints the report as a table.
+ * @param out Output stream
+ */
+void prof_print_report(FILE *out) {
+#ifndef MARKOV_PROFILE
+    fprintf(out, "Profiling report: instrumentation disabled (build with -DMARKOV_PROFILE=ON)\n");
+#else
+    fprintf(out, "Profiling report:\n");
+    fprintf(out, "  %-32s %10s %14s\n", "stage", "calls", "total ms");
+    for (int s = 0; s < PROF_NB_STAGES; s++) {
+        fprintf(out, "  %-32s %10lld %14.3f\n", stage_names[s],
+                atomic_load(&stage_calls[s]), (double)atomic_load(&stage_ns[s]) / 1e6);
+    }
+    fprintf(out, "  %-32s %10s\n", "counter", "value");
+    for (int c = 0; c < PROF_NB_COUNTERS; c++) {
+        fprintf(out, "  %-32s %10lld\n", counter_names[c], atomic_load(&counters[c]));
+    }
+#endif
+}
+
+/**
+ * @brief Writes the report as a JSON object.
+ * @param out Output stream
+ */
+void prof_write_json(FILE *out) {
+#ifdef MARKOV_PROFILE
+    fprintf(out, "{\"enabled\": true, \"stages\": {");
+#else
+    fprintf(out, "{\"enabled\": false, \"stages\": {");
+#endif
+    for (int s = 0; s < PROF_NB_STAGES; s++) {
+        fprintf(out, "%s\"%s\": {\"calls\": %lld, \"total_ms\": %.6f}", s ? ", " : "", stage_names[s],
+                atomic_load(&stage_calls[s]), (double)atomic_load(&stage_ns[s]) / 1e6);
+    }
+    fprintf(out, "}, \"counters\": {");
+    for (int c = 0; c < PROF_NB_COUNTERS; c++) {
+        fprintf(out, "%s\"%s\": %lld", c ? ", " : "", counter_names[c], atomic_load(&counters[c]));
+    }
+    fprintf(out, "}}\n");
+}
+
+static void report_at_exit(void) {
+    if (exit_as_json) prof_write_json(stderr);
+    else prof_print_report(stderr);
+}
+
+/**
+ * @brief Prints the report on stderr when the program exits.
+ * @param as_json 1 for JSON, 0 for the table
+ */
+void prof_report_at_exit(int as_json) {
+    static int registered = 0;
+    exit_as_json = as_json;
+    if (!registered) {
+        atexit(report_at_exit);
+        registered = 1;
+    }
+}
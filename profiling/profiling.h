@@ -0,0 +1,94 @@
+#ifndef PROFILING_H
+#define PROFILING_H
+
+#include <stdio.h>
+
+/**
+ * @brief Timed stages of the pipeline.
+ */
+typedef enum e_prof_stage {
+    PROF_STAGE_READ_GRAPH,
+    PROF_STAGE_TARJAN,
+    PROF_STAGE_CLASS_LINKS,
+    PROF_STAGE_TRANSITIVE_REDUCTION,
+    PROF_STAGE_DENSIFY,
+    PROF_STAGE_MULTIPLY,
+    PROF_STAGE_PERIOD,      // getPeriod(), GetPeriodFromView()
+    PROF_STAGE_STATIONARY,  // StationaryVectorFromGuess(), StationaryVectorFromView()
+    PROF_STAGE_REORDER,
+    PROF_NB_STAGES
+} t_prof_stage;
+
+/**
+ * @brief Event counters of the pipeline.
+ */
+typedef enum e_prof_counter {
+    PROF_EDGES_SCANNED, // adjacency cells visited
+    PROF_ALLOCATIONS,   // calls to malloc / calloc / realloc
+    PROF_ITERATIONS,    // iterations of the iterative solvers
+    PROF_BYTES_READ,    // bytes read from graph files
+    PROF_NB_COUNTERS
+} t_prof_counter;
+
+/**
+ * @brief Monotonic clock in milliseconds.
+ * @return Current time in ms from an arbitrary origin
+ */
+double prof_now_ms(void);
+
+/**
+ * @brief Adds a duration to a stage and counts one call.
+ * @param stage Stage to update
+ * @param ms Duration in milliseconds
+ */
+void prof_add_time(t_prof_stage stage, double ms);
+
+/**
+ * @brief Adds a value to a counter (thread-safe).
+ * @param counter Counter to update
+ * @param value Amount to add
+ */
+void prof_add_count(t_prof_counter counter, long long value);
+
+/**
+ * @brief Resets every stage and counter to 0.
+ */
+void prof_reset(void);
+
+/**
+ * @brief Prints the report as a table.
+ * @param out Output stream
+ */
+void prof_print_report(FILE *out);
+
+/**
+ * @brief Writes the report as a JSON object.
+ * @param out Output stream
+ */
+void prof_write_json(FILE *out);
+
+/**
+ * @brief Prints the report on stderr when the program exits.
+ * @param as_json 1 for JSON, 0 for the table
+ */
+void prof_report_at_exit(int as_json);
+
+/*
+ * Instrumentation macros. They are compiled in only when MARKOV_PROFILE is
+ * defined (cmake -DMARKOV_PROFILE=ON); otherwise they expand to nothing and
+ * cost nothing. PROF_BEGIN / PROF_END must be used in the same block, with
+ * the same stage, and PROF_END must be reached on every path.
+ */
+#ifdef MARKOV_PROFILE
+#define PROF_BEGIN(stage) double prof_start_##stage = prof_now_ms()
+#define PROF_END(stage) prof_add_time(stage, prof_now_ms() - prof_start_##stage)
+#define PROF_COUNT(counter, value) prof_add_count(counter, (long long)(value))
+#define PROF_REPORT_AT_EXIT(as_json) prof_report_at_exit(as_json)
+#else
+#define PROF_BEGIN(stage) ((void)0)
+#define PROF_END(stage) ((void)0)
+#define PROF_COUNT(counter, value) ((void)0)
+#define PROF_REPORT_AT_EXIT(as_json) ((void)0)
+#endif
+
+#endif //PROFILING_H
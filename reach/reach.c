@@ -0,0 +1,200 @@
+#include "reach.h"
+#include "../profiling/profiling.h"
+#include <stdlib.h>
+#include <string.h>
+
+#define REACH_BIT(c) ((uint64_t)1 << ((c) & 63))
+
+/**
+ * @brief Shared by the row fills of one build.
+ */
+typedef struct s_reach_job {
+    t_reach_index *index;
+    const int *succ_start;  // nb_classes + 1 offsets into succ
+    const int *succ;
+} t_reach_job;
+
+/**
+ * @brief Row of one class: itself and the rows of its successors, all of a
+ *        lower level and already filled.
+ */
+static void fill_row(void *arg, int c) {
+    t_reach_job *job = (t_reach_job *)arg;
+    int words = job->index->nb_words;
+    uint64_t *row = job->index->rows + (size_t)c * words;
+    row[c >> 6] |= REACH_BIT(c);
+    for (int e = job->succ_start[c]; e < job->succ_start[c + 1]; e++) {
+        const uint64_t *other = job->index->rows + (size_t)job->succ[e] * words;
+        for (int k = 0; k < words; k++) row[k] |= other[k];
+    }
+}
+
+/**
+ * @brief Builds the reachability index.
+ * @param partition The classes
+ * @param vertex_to_class Vertex (0-based) -> class
+ * @param nb_vertices Number of vertices
+ * @param links Links between the classes
+ * @param index Output
+ * @return 0 on success, -1 on error
+ */
+int reach_index_build(const t_partition *partition, const int *vertex_to_class, int nb_vertices,
+                      const t_link_array *links, t_reach_index *index) {
+    if (index == NULL) return -1;
+    memset(index, 0, sizeof(t_reach_index));
+    if (partition == NULL || vertex_to_class == NULL || links == NULL || nb_vertices < 0) return -1;
+    int nb = partition->nb_class;
+    int words = nb > 0 ? (nb + 63) / 64 : 1;
+
+    // heights: the successors of a class are on lower levels, and a class
+    // with no outgoing link (persistent) is on level 0
+    t_class_levels levels;
+    if (class_levels_build(nb, links, 1, &levels) != 0) return -1;
+
+    index->nb_classes = nb;
+    index->nb_vertices = nb_vertices;
+    index->nb_words = words;
+    index->rows = (uint64_t *)calloc((size_t)(nb > 0 ? nb : 1) * words, sizeof(uint64_t));
+    index->persistent = (uint64_t *)calloc(words, sizeof(uint64_t));
+    index->absorbing = (uint64_t *)calloc(words, sizeof(uint64_t));
+    index->vertex_class = (int *)malloc((nb_vertices > 0 ? nb_vertices : 1) * sizeof(int));
+    int *succ_start = (int *)calloc(nb + 1, sizeof(int));
+    int *succ = (int *)malloc((links->size > 0 ? links->size : 1) * sizeof(int));
+    PROF_COUNT(PROF_ALLOCATIONS, 6);
+    int status = (index->rows && index->persistent && index->absorbing && index->vertex_class
+                  && succ_start && succ) ? 0 : -1;
+
+    if (status == 0) {
+        for (int v = 0; v < nb_vertices; v++) {
+            int c = vertex_to_class[v];
+            index->vertex_class[v] = (c >= 0 && c < nb) ? c : -1;
+        }
+        for (int c = 0; c < nb; c++) {
+            if (levels.level[c] != 0) continue;
+            index->persistent[c >> 6] |= REACH_BIT(c);
+            if (partition->classes[c]->nb_vertices == 1) index->absorbing[c >> 6] |= REACH_BIT(c);
+        }
+
+        // successors in compressed rows (class_levels_build() checked the links)
+        for (int i = 0; i < links->size; i++) succ_start[links->links[i].start + 1]++;
+        for (int c = 0; c < nb; c++) succ_start[c + 1] += succ_start[c];
+        int *fill = (int *)malloc((nb > 0 ? nb : 1) * sizeof(int));
+        PROF_COUNT(PROF_ALLOCATIONS, 1);
+        if (fill == NULL) status = -1;
+        else {
+            memcpy(fill, succ_start, nb * sizeof(int));
+            for (int i = 0; i < links->size; i++) succ[fill[links->links[i].start]++] = links->links[i].end;
+            free(fill);
+        }
+    }
+
+    // rows sinks first; the rows of one level are disjoint and filled in parallel
+    if (status == 0) {
+        t_reach_job job = { index, succ_start, succ };
+        for_each_class_level(&levels, fill_row, &job);
+    }
+
+    free(succ_start);
+    free(succ);
+    class_levels_free(&levels);
+    if (status != 0) reach_index_free(index);
+    return status;
+}
+
+/**
+ * @brief Frees the arrays of a reachability index.
+ * @param index The index
+ */
+void reach_index_free(t_reach_index *index) {
+    if (index == NULL) return;
+    free(index->rows);
+    free(index->persistent);
+    free(index->absorbing);
+    free(index->vertex_class);
+    memset(index, 0, sizeof(t_reach_index));
+}
+
+/**
+ * @brief Tells if class to is reachable from class from.
+ * @return 1 if reachable, 0 otherwise
+ */
+int reach_class_reaches(const t_reach_index *index, int from, int to) {
+    if (from < 0 || from >= index->nb_classes || to < 0 || to >= index->nb_classes) return 0;
+    return (index->rows[(size_t)from * index->nb_words + (to >> 6)] & REACH_BIT(to)) != 0;
+}
+
+/**
+ * @brief Class of a state, -1 if out of range or in no class.
+ */
+static int state_class(const t_reach_index *index, int state) {
+    if (state < 0 || state >= index->nb_vertices) return -1;
+    return index->vertex_class[state];
+}
+
+/**
+ * @brief Tells if state v is reachable from state u.
+ * @return 1 if reachable, 0 otherwise
+ */
+int reach_state_reaches(const t_reach_index *index, int u, int v) {
+    int a = state_class(index, u), b = state_class(index, v);
+    if (a < 0 || b < 0) return 0;
+    return reach_class_reaches(index, a, b);
+}
+
+/**
+ * @brief Lists the persistent classes reachable from a state.
+ * @param index The index
+ * @param state The state (0-based)
+ * @param classes Output (may be NULL)
+ * @return Number of classes, -1 on error
+ */
+int reach_state_persistent(const t_reach_index *index, int state, int *classes) {
+    int c = state_class(index, state);
+    if (c < 0) return -1;
+    const uint64_t *row = index->rows + (size_t)c * index->nb_words;
+    int count = 0;
+    for (int k = 0; k < index->nb_words; k++) {
+        uint64_t bits = row[k] & index->persistent[k];
+        // the set bits of the word, lowest first
+        for (int b = 0; bits != 0; b++, bits >>= 1) {
+            if (!(bits & 1)) continue;
+            if (classes) classes[count] = k * 64 + b;
+            count++;
+        }
+    }
+    return count;
+}
+
+/**
+ * @brief Tells if a state can reach an absorbing state.
+ * @return 1 if it can, 0 otherwise
+ */
+int reach_state_absorbing(const t_reach_index *index, int state) {
+    int c = state_class(index, state);
+    if (c < 0) return 0;
+    const uint64_t *row = index->rows + (size_t)c * index->nb_words;
+    for (int k = 0; k < index->nb_words; k++) {
+        if (row[k] & index->absorbing[k]) return 1;
+    }
+    return 0;
+}
+
+/**
+ * @brief Lists the states that can reach a target state.
+ * @param index The index
+ * @param target The target state (0-based)
+ * @param states Output (may be NULL)
+ * @return Number of states, -1 on error
+ */
+int reach_states_reaching(const t_reach_index *index, int target, int *states) {
+    int t = state_class(index, target);
+    if (t < 0) return -1;
+    int count = 0;
+    for (int v = 0; v < index->nb_vertices; v++) {
+        int c = index->vertex_class[v];
+        if (c < 0 || !reach_class_reaches(index, c, t)) continue;
+        if (states) states[count] = v;
+        count++;
+    }
+    return count;
+}
@@ -0,0 +1,84 @@
+#ifndef REACH_H
+#define REACH_H
+
+#include <stdint.h>
+#include "../hasse/hasse.h"
+
+/**
+ * @brief Reachability index over the class graph.
+ *
+ * Row c is a packed bitset of the classes reachable from class c (c itself
+ * included), nb_words 64-bit words long. The rows are filled once, sinks
+ * first, each one being the OR of the rows of its successors, so a query
+ * between two states is one lookup through vertex_class and one bit test,
+ * and the set of classes reachable from a state is read in
+ * O(nb_classes / 64) words.
+ */
+typedef struct s_reach_index {
+    int nb_classes;
+    int nb_vertices;
+    int nb_words;          // 64-bit words per row
+    uint64_t *rows;        // nb_classes rows: classes reachable from each class
+    uint64_t *persistent;  // one row: the persistent classes (no outgoing link)
+    uint64_t *absorbing;   // one row: the persistent classes of a single vertex
+    int *vertex_class;     // vertex (0-based) -> class, -1 if in no class
+} t_reach_index;
+
+/**
+ * @brief Builds the reachability index, in O(V + nb_classes + links) plus
+ *        one word-parallel OR per link.
+ * @param partition The classes (tarjan(), ForwardBackwardSCC(), ...)
+ * @param vertex_to_class Vertex (0-based) -> class (create_vertex_class_array())
+ * @param nb_vertices Number of vertices
+ * @param links Links between the classes (list_class_links())
+ * @param index Output (free with reach_index_free)
+ * @return 0 on success, -1 on allocation error or if the links have a cycle
+ */
+int reach_index_build(const t_partition *partition, const int *vertex_to_class, int nb_vertices,
+                      const t_link_array *links, t_reach_index *index);
+
+/**
+ * @brief Frees the arrays of a reachability index.
+ * @param index The index (may be NULL)
+ */
+void reach_index_free(t_reach_index *index);
+
+/**
+ * @brief Tells if class to is reachable from class from, in O(1).
+ * @return 1 if reachable (always for from == to), 0 if not or out of range
+ */
+int reach_class_reaches(const t_reach_index *index, int from, int to);
+
+/**
+ * @brief Tells if state v is reachable from state u (0-based), in O(1).
+ * @return 1 if reachable, 0 if not or if a state is in no class
+ */
+int reach_state_reaches(const t_reach_index *index, int u, int v);
+
+/**
+ * @brief Lists the persistent classes reachable from a state, in
+ *        O(nb_classes / 64) plus the size of the answer.
+ * @param index The index
+ * @param state The state (0-based)
+ * @param classes Output, room for nb_classes entries (may be NULL to count)
+ * @return Number of classes, -1 if the state is out of range or in no class
+ */
+int reach_state_persistent(const t_reach_index *index, int state, int *classes);
+
+/**
+ * @brief Tells if a state can reach an absorbing state, in O(nb_classes / 64).
+ * @return 1 if it can, 0 if not (or out of range)
+ */
+int reach_state_absorbing(const t_reach_index *index, int state);
+
+/**
+ * @brief Lists the states that can reach a target state, in O(V).
+ * @param index The index
+ * @param target The target state (0-based)
+ * @param states Output, room for nb_vertices entries (may be NULL to count)
+ * @return Number of states (the target included), -1 if the target is out
+ *         of range or in no class
+ */
+int reach_states_reaching(const t_reach_index *index, int target, int *states);
+
+#endif //REACH_H
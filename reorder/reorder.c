@@ -0,0 +1,328 @@
+#include "reorder.h"
+#include "../profiling/profiling.h"
+#include <stdlib.h>
+#include <string.h>
+
+/**
+ * @brief Edges inside the classes, in compressed rows (0-based vertices).
+ */
+typedef struct s_class_rows {
+    int *start;  // n + 1 offsets
+    int *target;
+} t_class_rows;
+
+/**
+ * @brief Builds the rows of the edges that stay inside a class: forward
+ *        only, or both ways (for RCM, which works on the undirected graph).
+ * @return 0 on success, -1 on allocation error
+ */
+static int build_class_rows(t_adjacency_list graph, const int *class_of, int both_ways, t_class_rows *rows) {
+    int n = graph.size;
+    rows->start = (int *)calloc(n + 1, sizeof(int));
+    if (rows->start == NULL) return -1;
+    for (int u = 0; u < n; u++) {
+        for (t_cell *c = graph.array[u].head; c != NULL; c = c->next) {
+            int v = c->arrival - 1;
+            if (v < 0 || v >= n || v == u || class_of[v] != class_of[u]) continue;
+            rows->start[u + 1]++;
+            if (both_ways) rows->start[v + 1]++;
+        }
+    }
+    for (int u = 0; u < n; u++) rows->start[u + 1] += rows->start[u];
+
+    rows->target = (int *)malloc((rows->start[n] > 0 ? rows->start[n] : 1) * sizeof(int));
+    int *fill = (int *)malloc((n > 0 ? n : 1) * sizeof(int));
+    if (rows->target == NULL || fill == NULL) {
+        free(fill);
+        return -1;
+    }
+    memcpy(fill, rows->start, n * sizeof(int));
+    for (int u = 0; u < n; u++) {
+        for (t_cell *c = graph.array[u].head; c != NULL; c = c->next) {
+            int v = c->arrival - 1;
+            if (v < 0 || v >= n || v == u || class_of[v] != class_of[u]) continue;
+            rows->target[fill[u]++] = v;
+            if (both_ways) rows->target[fill[v]++] = u;
+        }
+    }
+    free(fill);
+    return 0;
+}
+
+/**
+ * @brief A neighbor and its degree, sorted by RCM.
+ */
+typedef struct s_ranked_vertex {
+    int degree;
+    int vertex;
+} t_ranked_vertex;
+
+static int compare_ranked(const void *a, const void *b) {
+    const t_ranked_vertex *x = (const t_ranked_vertex *)a;
+    const t_ranked_vertex *y = (const t_ranked_vertex *)b;
+    if (x->degree != y->degree) return x->degree < y->degree ? -1 : 1;
+    return (x->vertex > y->vertex) - (x->vertex < y->vertex);
+}
+
+/**
+ * @brief Orders the vertices of one class in old_of_new[first, first + count):
+ *        breadth-first (Cuthill-McKee with rcm, then reversed).
+ * @param members The vertices of the class (0-based), in partition order
+ * @param seen Per vertex: 1 once placed (set here)
+ * @param ranked Scratch of the size of the largest row (RCM only)
+ * @return Number of vertices placed (count unless a member was already placed)
+ */
+static int order_class(const t_class_rows *rows, const int *members, int count, int rcm,
+                       int *old_of_new, int first, char *seen, t_ranked_vertex *ranked) {
+    int tail = first;
+    // members before cursor are all placed: a search placed them, and
+    // seen[] is never cleared, so the next root is never before it
+    int cursor = 0;
+    for (;;) {
+        // start: the first unplaced vertex of the class (BFS), one of smallest
+        // degree (RCM); a class is strongly connected, so one search usually
+        // places all of it, but any partition is accepted
+        while (cursor < count && seen[members[cursor]]) cursor++;
+        if (cursor == count) break;
+        int root = members[cursor];
+        for (int j = cursor + 1; rcm && j < count; j++) {
+            int v = members[j];
+            if (seen[v]) continue;
+            if (rows->start[v + 1] - rows->start[v] < rows->start[root + 1] - rows->start[root]) root = v;
+        }
+        seen[root] = 1;
+        old_of_new[tail++] = root;
+
+        for (int head = tail - 1; head < tail; head++) {
+            int v = old_of_new[head];
+            int nb = 0;
+            for (int e = rows->start[v]; e < rows->start[v + 1]; e++) {
+                int w = rows->target[e];
+                if (seen[w]) continue;
+                seen[w] = 1;
+                if (rcm) ranked[nb++] = (t_ranked_vertex){ rows->start[w + 1] - rows->start[w], w };
+                else old_of_new[tail++] = w;
+            }
+            // Cuthill-McKee: the new neighbors by increasing degree
+            if (rcm) {
+                qsort(ranked, nb, sizeof(t_ranked_vertex), compare_ranked);
+                for (int i = 0; i < nb; i++) old_of_new[tail++] = ranked[i].vertex;
+            }
+        }
+    }
+    if (rcm) {
+        for (int i = first, j = tail - 1; i < j; i++, j--) {
+            int t = old_of_new[i];
+            old_of_new[i] = old_of_new[j];
+            old_of_new[j] = t;
+        }
+    }
+    return tail - first;
+}
+
+/**
+ * @brief Builds the class-contiguous order of a graph.
+ * @param graph The graph
+ * @param partition Its classes
+ * @param method Order inside each class
+ * @param order Output
+ * @return 0 on success, -1 on error
+ */
+int vertex_order_build(t_adjacency_list graph, const t_partition *partition, t_reorder_method method, t_vertex_order *order) {
+    if (order == NULL) return -1;
+    memset(order, 0, sizeof(t_vertex_order));
+    if (partition == NULL || graph.size <= 0) return -1;
+    int n = graph.size;
+    int nb_classes = partition->nb_class;
+
+    order->size = n;
+    order->nb_classes = nb_classes;
+    order->new_of_old = (int *)malloc(n * sizeof(int));
+    order->old_of_new = (int *)malloc(n * sizeof(int));
+    order->class_start = (int *)malloc((nb_classes + 1) * sizeof(int));
+    int *class_of = (int *)malloc(n * sizeof(int));
+    char *seen = (char *)calloc(n, 1);
+    if (!order->new_of_old || !order->old_of_new || !order->class_start || !class_of || !seen) {
+        free(class_of);
+        free(seen);
+        vertex_order_free(order);
+        return -1;
+    }
+    PROF_BEGIN(PROF_STAGE_REORDER);
+
+    // class of each vertex, -1 for a vertex in no class (placed at the end)
+    int status = 0;
+    for (int v = 0; v < n; v++) class_of[v] = -1;
+    for (int c = 0; c < nb_classes && status == 0; c++) {
+        const t_class *cls = partition->classes[c];
+        for (int k = 0; k < cls->nb_vertices; k++) {
+            int v = cls->vertices[k] - 1;
+            if (v < 0 || v >= n || class_of[v] >= 0) {
+                status = -1;
+                break;
+            }
+            class_of[v] = c;
+        }
+    }
+
+    t_class_rows rows = { NULL, NULL };
+    t_ranked_vertex *ranked = NULL;
+    int *members = NULL;
+    if (status == 0 && method != REORDER_CLASS) {
+        status = build_class_rows(graph, class_of, method == REORDER_RCM, &rows);
+        int max_row = 0;
+        for (int v = 0; status == 0 && v < n; v++) {
+            if (rows.start[v + 1] - rows.start[v] > max_row) max_row = rows.start[v + 1] - rows.start[v];
+        }
+        ranked = (t_ranked_vertex *)malloc((max_row > 0 ? max_row : 1) * sizeof(t_ranked_vertex));
+        members = (int *)malloc(n * sizeof(int));
+        if (ranked == NULL || members == NULL) status = -1;
+    }
+
+    int next = 0;
+    for (int c = 0; c < nb_classes && status == 0; c++) {
+        const t_class *cls = partition->classes[c];
+        order->class_start[c] = next;
+        if (method == REORDER_CLASS) {
+            for (int k = 0; k < cls->nb_vertices; k++) {
+                order->old_of_new[next++] = cls->vertices[k] - 1;
+                seen[cls->vertices[k] - 1] = 1;
+            }
+        } else {
+            for (int k = 0; k < cls->nb_vertices; k++) members[k] = cls->vertices[k] - 1;
+            int placed = order_class(&rows, members, cls->nb_vertices, method == REORDER_RCM, order->old_of_new, next,
+                                     seen, ranked);
+            if (placed != cls->nb_vertices) status = -1;
+            next += placed;
+        }
+    }
+    if (status == 0) {
+        order->class_start[nb_classes] = next;
+        for (int v = 0; v < n; v++) {
+            if (!seen[v]) order->old_of_new[next++] = v;
+        }
+        for (int i = 0; i < n; i++) order->new_of_old[order->old_of_new[i]] = i;
+    }
+
+    free(rows.start);
+    free(rows.target);
+    free(ranked);
+    free(members);
+    free(class_of);
+    free(seen);
+    if (status != 0) vertex_order_free(order);
+    PROF_END(PROF_STAGE_REORDER);
+    return status;
+}
+
+/**
+ * @brief Frees the arrays of an order.
+ * @param order The order
+ */
+void vertex_order_free(t_vertex_order *order) {
+    if (order == NULL) return;
+    free(order->new_of_old);
+    free(order->old_of_new);
+    free(order->class_start);
+    memset(order, 0, sizeof(t_vertex_order));
+}
+
+/**
+ * @brief Copies a graph with its vertices renumbered.
+ * @param graph The graph
+ * @param order The order
+ * @param permuted Output graph
+ * @return 0 on success, -1 on error
+ */
+int reorder_graph(t_adjacency_list graph, const t_vertex_order *order, t_adjacency_list *permuted) {
+    if (order == NULL || permuted == NULL || graph.size != order->size) return -1;
+    int n = graph.size;
+    t_adjacency_list *gp = empty_adjacency_list(n);
+    if (gp == NULL) return -1;
+
+    // the cells of a list are appended through a tail pointer, so the
+    // list keeps the order of its edges
+    for (int u = 0; u < n; u++) {
+        t_cell **tail = &gp->array[order->new_of_old[u]].head;
+        for (t_cell *c = graph.array[u].head; c != NULL; c = c->next) {
+            int v = c->arrival;
+            if (v >= 1 && v <= n) v = order->new_of_old[v - 1] + 1;
+            t_cell *copy = create_cell(v, c->probability);
+            if (copy == NULL) {
+                free_adjacency_list(gp);
+                free(gp);
+                return -1;
+            }
+            *tail = copy;
+            tail = &copy->next;
+        }
+    }
+    *permuted = *gp;
+    free(gp);
+    return 0;
+}
+
+/**
+ * @brief Copies a partition, each vertex translated by map (0-based -> 0-based),
+ *        or replaced by the contiguous ranges of the order if map is NULL.
+ */
+static p_partition map_partition(const t_vertex_order *order, const t_partition *partition, const int *map) {
+    p_partition part = CreatePartition();
+    if (part == NULL) return NULL;
+    for (int c = 0; c < partition->nb_class; c++) {
+        const t_class *cls = partition->classes[c];
+        p_class copy = CreateClass(cls->name);
+        if (copy == NULL || AddClassToPartition(part, copy) != 0) {
+            DestroyClass(copy);
+            DestroyPartition(part);
+            return NULL;
+        }
+        int count = map ? cls->nb_vertices : order->class_start[c + 1] - order->class_start[c];
+        for (int k = 0; k < count; k++) {
+            int v = map ? map[cls->vertices[k] - 1] : order->class_start[c] + k;
+            if (AddVertexToClass(copy, v + 1) != 0) {
+                DestroyPartition(part);
+                return NULL;
+            }
+        }
+    }
+    return part;
+}
+
+/**
+ * @brief The classes of the order in the new numbering.
+ * @param order The order
+ * @param partition The partition the order was built from
+ * @return The partition, NULL on error
+ */
+p_partition reorder_partition(const t_vertex_order *order, const t_partition *partition) {
+    if (order == NULL || partition == NULL || partition->nb_class != order->nb_classes) return NULL;
+    return map_partition(order, partition, NULL);
+}
+
+/**
+ * @brief Translates a partition of the renumbered graph back to the original numbering.
+ * @param order The order
+ * @param permuted Partition in the new numbering
+ * @return The partition, NULL on error
+ */
+p_partition restore_partition(const t_vertex_order *order, const t_partition *permuted) {
+    if (order == NULL || permuted == NULL) return NULL;
+    for (int c = 0; c < permuted->nb_class; c++) {
+        for (int k = 0; k < permuted->classes[c]->nb_vertices; k++) {
+            int v = permuted->classes[c]->vertices[k];
+            if (v < 1 || v > order->size) return NULL;
+        }
+    }
+    return map_partition(order, permuted, order->old_of_new);
+}
+
+/**
+ * @brief Translates a per-vertex vector back to the original numbering.
+ * @param order The order
+ * @param permuted Vector indexed by new vertex
+ * @param original Output vector indexed by old vertex
+ */
+void reorder_values_back(const t_vertex_order *order, const float *permuted, float *original) {
+    for (int v = 0; v < order->size; v++) original[v] = permuted[order->new_of_old[v]];
+}
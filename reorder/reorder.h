@@ -0,0 +1,89 @@
+#ifndef REORDER_H
+#define REORDER_H
+
+#include "../adjacency_list/adjacency_list.h"
+#include "../tarjan/tarjan.h"
+
+/**
+ * @brief Order of the vertices inside a class.
+ */
+typedef enum e_reorder_method {
+    REORDER_CLASS, // vertices of a class keep the order of the partition
+    REORDER_BFS,   // breadth-first along the edges of the class
+    REORDER_RCM    // reverse Cuthill-McKee on the edges of the class, both ways
+} t_reorder_method;
+
+/**
+ * @brief A renumbering of the vertices where every class is a contiguous
+ *        range, the classes following each other in partition order.
+ *
+ * Vertex numbers are 0-based in the arrays: new vertex i (0-based) is old
+ * vertex old_of_new[i], and class c is made of the new vertices
+ * class_start[c] .. class_start[c + 1] - 1. A graph numbered this way keeps
+ * the edges of a class close together in memory, for Tarjan, the products
+ * and the class submatrices.
+ */
+typedef struct s_vertex_order {
+    int size;          // number of vertices
+    int *new_of_old;   // old vertex -> new vertex
+    int *old_of_new;   // new vertex -> old vertex
+    int nb_classes;
+    int *class_start;  // nb_classes + 1 offsets
+} t_vertex_order;
+
+/**
+ * @brief Builds the class-contiguous order of a graph.
+ * @param graph The graph
+ * @param partition Its classes (tarjan() or ForwardBackwardSCC())
+ * @param method Order inside each class
+ * @param order Output (free with vertex_order_free)
+ * @return 0 on success, -1 on allocation error or if a class vertex is out of range
+ */
+int vertex_order_build(t_adjacency_list graph, const t_partition *partition, t_reorder_method method, t_vertex_order *order);
+
+/**
+ * @brief Frees the arrays of an order.
+ * @param order The order (may be NULL)
+ */
+void vertex_order_free(t_vertex_order *order);
+
+/**
+ * @brief Copies a graph with its vertices renumbered. Each list keeps the
+ *        order of its edges; arrivals outside [1, n] are copied unchanged.
+ * @param graph The graph
+ * @param order The order
+ * @param permuted Output graph (free with free_adjacency_list)
+ * @return 0 on success, -1 on allocation error or if the sizes differ
+ */
+int reorder_graph(t_adjacency_list graph, const t_vertex_order *order, t_adjacency_list *permuted);
+
+/**
+ * @brief The classes of the order in the new numbering: class c is the
+ *        range class_start[c] + 1 .. class_start[c + 1], in increasing order,
+ *        with the name of class c of the original partition.
+ * @param order The order
+ * @param partition The partition the order was built from
+ * @return The partition (free with DestroyPartition), NULL on allocation error
+ */
+p_partition reorder_partition(const t_vertex_order *order, const t_partition *partition);
+
+/**
+ * @brief Translates a partition of the renumbered graph back to the original
+ *        numbering. The vertices of each class keep their position, so
+ *        vectors aligned on the class lists (stationary vectors) stay aligned.
+ * @param order The order
+ * @param permuted Partition in the new numbering
+ * @return The partition (free with DestroyPartition), NULL on allocation error
+ */
+p_partition restore_partition(const t_vertex_order *order, const t_partition *permuted);
+
+/**
+ * @brief Translates a per-vertex vector back to the original numbering:
+ *        original[old] = permuted[new_of_old[old]].
+ * @param order The order
+ * @param permuted Vector indexed by new vertex (0-based)
+ * @param original Output vector indexed by old vertex (size order->size)
+ */
+void reorder_values_back(const t_vertex_order *order, const float *permuted, float *original);
+
+#endif //REORDER_H
@@ -0,0 +1,177 @@
+#include "report.h"
+
+/**
+ * @brief Writes "prefix[ v0 v1 ... ]" with 4 decimals.
+ */
+static void write_vector(t_writer *w, const char *prefix, const float *v, int n) {
+    writer_puts(w, prefix);
+    writer_puts(w, "[ ");
+    for (int j = 0; j < n; ++j) writer_printf(w, "%.4f ", v[j]);
+    writer_puts(w, "]\n");
+}
+
+/**
+ * @brief Writes the solver part of a class result.
+ * @param w Destination writer
+ * @param ca Class result
+ */
+void FormatStationarySolve(t_writer *w, const t_class_analysis *ca) {
+    if (ca->lazy) writer_printf(w, "      [Periodic d=%d] Using Lazy Walk (0.5M + 0.5I).\n", ca->period);
+    writer_printf(w, "   SLEM: %.4f, iteration cap: %d\n", ca->slem, ca->max_iter);
+    if (ca->stationary) write_vector(w, "   Stationary Distribution: ", ca->stationary, ca->size);
+    else writer_puts(w, "      [Error] Did not converge.\n");
+}
+
+/**
+ * @brief Writes the period and stationary vector of every class.
+ * @param w Destination writer
+ * @param analysis Graph result
+ */
+void FormatPeriodicity(t_writer *w, const t_graph_analysis *analysis) {
+    for (int i = 0; i < analysis->partition->nb_class; i++) {
+        const t_class *cls = analysis->partition->classes[i];
+
+        writer_printf(w, "\nAnalyzing Class #%d (Vertices: ", i + 1);
+        for (int v = 0; v < cls->nb_vertices; v++) writer_printf(w, "%d ", cls->vertices[v]);
+        writer_puts(w, "):\n");
+
+        writer_printf(w, "   Period: %d\n", analysis->classes[i].period);
+        FormatStationarySolve(w, &analysis->classes[i]);
+    }
+}
+
+/**
+ * @brief Writes the limit distribution of every class.
+ * @param w Destination writer
+ * @param analysis Graph result
+ */
+void FormatLimitDistributions(t_writer *w, const t_graph_analysis *analysis) {
+    for (int c = 0; c < analysis->partition->nb_class; ++c) {
+        const t_class *cls = analysis->partition->classes[c];
+        const t_class_analysis *ca = &analysis->classes[c];
+
+        writer_printf(w, "Classe C%d (", c + 1);
+        for (int k = 0; k < cls->nb_vertices; ++k) writer_printf(w, k > 0 ? ", %d" : "%d", cls->vertices[k]);
+        writer_printf(w, ") : %s\n", ca->persistent ? "Persistent" : "Transient");
+
+        if (!ca->persistent) {
+            // transient classes eventually have 0 probability in the long run
+            writer_puts(w, "  Distribution limit: [ ");
+            for (int j = 0; j < ca->size; ++j) writer_puts(w, "0.0000 ");
+            writer_puts(w, "]\n");
+        } else if (ca->stationary) {
+            write_vector(w, "   Stationary Distribution: ", ca->stationary, ca->size);
+        } else {
+            writer_puts(w, "  Error on computing\n");
+        }
+    }
+}
+
+/**
+ * @brief Writes one block per class with what was computed.
+ * @param w Destination writer
+ * @param analysis Graph result
+ * @param flags Parts to write
+ * @param ids External ids of the vertices, NULL to print the vertex numbers
+ */
+void FormatClassAnalyses(t_writer *w, const t_graph_analysis *analysis, unsigned flags, const t_id_map *ids) {
+    for (int c = 0; c < analysis->partition->nb_class; c++) {
+        const t_class *cls = analysis->partition->classes[c];
+        const t_class_analysis *ca = &analysis->classes[c];
+        // without periods, only the persistent classes have something to show
+        if (!(flags & ANALYSIS_PERIOD) && !ca->persistent) continue;
+
+        writer_printf(w, "Class %s (", cls->name);
+        for (int k = 0; k < cls->nb_vertices; k++) {
+            if (k) writer_puts(w, ", ");
+            write_vertex_id(w, ids, cls->vertices[k]);
+        }
+        writer_printf(w, ") : %s\n", ca->persistent ? "persistent" : "transient");
+
+        if (flags & ANALYSIS_PERIOD) writer_printf(w, "   Period: %d\n", ca->period);
+        if ((flags & ANALYSIS_STATIONARY) && ca->persistent) {
+            if (ca->stationary) {
+                write_vector(w, ca->lazy ? "   Stationary Distribution (lazy walk): " : "   Stationary Distribution: ",
+                             ca->stationary, ca->size);
+            } else if (ca->max_iter > 0 && ca->iterations == ca->max_iter) {
+                writer_printf(w, "   [Error] The stationary distribution did not converge in %d iterations.\n", ca->max_iter);
+            } else {
+                writer_puts(w, "   [Error] Could not compute the stationary distribution.\n");
+            }
+        }
+    }
+    writer_puts(w, "\n");
+}
+
+/**
+ * @brief Writes the convergence trace and the limit of StationaryMatrixLimit().
+ * @param w Destination writer
+ * @param limit The result
+ * @param graph_name Name of the graph
+ */
+void FormatStationaryMatrix(t_writer *w, const t_matrix_limit *limit, const char *graph_name) {
+    if (limit->diffs) {
+        for (int s = 2; s <= limit->steps; s++) {
+            writer_printf(w, "For iteration %d, the difference is %.5f\n", s, limit->diffs[s - 1]);
+        }
+    }
+    if (!limit->converged) {
+        writer_printf(w, "For %s, this criterion does not work\n", graph_name);
+    } else {
+        writer_printf(w, "Convergence reached afeter %d multiplications (diff = %.5f)\n", limit->steps, limit->diff);
+        writer_puts(w, "Stationary Matrix :\n");
+        WriteMatrix(w, limit->limit);
+    }
+}
+
+/**
+ * @brief Writes every issue of a validation report, then the verdict.
+ * @param w Destination writer
+ * @param report The report
+ * @param ids External ids of the vertices, NULL to print the vertex numbers
+ */
+void FormatValidationReport(t_writer *w, const t_validation_report *report, const t_id_map *ids) {
+    for (int i = 0; i < report->nb_issues; i++) {
+        const t_validation_issue *issue = &report->issues[i];
+        long long vertex = id_map_external(ids, issue->vertex);
+        long long arrival = id_map_external(ids, issue->arrival);
+        switch (issue->kind) {
+            case ISSUE_ROW_SUM:
+                writer_printf(w, "Vertex %lld does not respect the Markov property: sum is %.2f\n", vertex, issue->value);
+                break;
+            case ISSUE_EMPTY_ROW:
+                writer_printf(w, "Vertex %lld has no outgoing edge\n", vertex);
+                break;
+            case ISSUE_NEGATIVE:
+                writer_printf(w, "Edge %lld -> %lld has a negative probability (%.4f)\n", vertex, arrival, issue->value);
+                break;
+            case ISSUE_OUT_OF_RANGE:
+                writer_printf(w, "Edge %lld -> %d leaves the graph (%d vertices)\n", vertex, issue->arrival, report->nb_vertices);
+                break;
+            case ISSUE_DUPLICATE:
+                writer_printf(w, "Edge %lld -> %lld is given more than once\n", vertex, arrival);
+                break;
+        }
+    }
+    long long total = report->bad_rows + report->empty_rows + report->negative + report->out_of_range + report->duplicates;
+    if (total > report->nb_issues) writer_printf(w, "... and %lld more problems\n", total - report->nb_issues);
+    if (report->renormalized_rows > 0) writer_printf(w, "%d rows renormalized\n", report->renormalized_rows);
+    if (report->valid && report->renormalized_rows > 0) writer_puts(w, "The graph is a Markov graph after renormalization\n");
+    else writer_puts(w, report->valid ? "The graph is a Markov graph\n" : "The graph is not a Markov graph\n");
+}
+
+/**
+ * @brief Writes the result of a rate graph check.
+ * @param w Destination writer
+ * @param report The report
+ * @param ids External ids of the vertices, NULL to print the vertex numbers
+ */
+void FormatRateReport(t_writer *w, const t_rate_report *report, const t_id_map *ids) {
+    if (report->negative > 0) {
+        long long vertex = id_map_external(ids, report->vertex);
+        long long arrival = id_map_external(ids, report->arrival);
+        writer_printf(w, "Vertex %lld has a negative rate to %lld: %.2f\n", vertex, arrival, report->rate);
+        if (report->negative > 1) writer_printf(w, "... and %lld more negative rates\n", report->negative - 1);
+    }
+    writer_puts(w, report->valid ? "The graph is a rate graph\n" : "The graph is not a rate graph\n");
+}
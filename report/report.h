@@ -0,0 +1,72 @@
+#ifndef REPORT_H
+#define REPORT_H
+
+#include "../analysis/analysis.h"
+#include "../writer/writer.h"
+#include "../validation/validation.h"
+#include "../ctmc/ctmc.h"
+#include "../idmap/idmap.h"
+
+/*
+ * Text formatters of the analysis results. They only read the result
+ * structures, so a program that does not need a report skips them.
+ */
+
+/**
+ * @brief Writes the solver part of a class result (lazy walk note, SLEM,
+ *        iteration cap, stationary vector), as printed by SolveStationaryDistribution().
+ * @param w Destination writer
+ * @param ca Class result
+ */
+void FormatStationarySolve(t_writer *w, const t_class_analysis *ca);
+
+/**
+ * @brief Writes the period and stationary vector of every class, as printed by periodicity().
+ * @param w Destination writer
+ * @param analysis Graph result (computed with ANALYSIS_PERIOD | ANALYSIS_STATIONARY | ANALYSIS_ALL_CLASSES)
+ */
+void FormatPeriodicity(t_writer *w, const t_graph_analysis *analysis);
+
+/**
+ * @brief Writes the limit distribution of every class, as printed by step2_validation().
+ * @param w Destination writer
+ * @param analysis Graph result (computed with ANALYSIS_STATIONARY)
+ */
+void FormatLimitDistributions(t_writer *w, const t_graph_analysis *analysis);
+
+/**
+ * @brief Writes one block per class with what was computed (type, period, stationary vector).
+ * @param w Destination writer
+ * @param analysis Graph result
+ * @param flags ANALYSIS_PERIOD and/or ANALYSIS_STATIONARY: parts to write
+ * @param ids External ids of the vertices, NULL to print the vertex numbers
+ */
+void FormatClassAnalyses(t_writer *w, const t_graph_analysis *analysis, unsigned flags, const t_id_map *ids);
+
+/**
+ * @brief Writes the convergence trace and the limit of StationaryMatrixLimit(),
+ *        as printed by ComputeStationaryMatrix().
+ * @param w Destination writer
+ * @param limit The result
+ * @param graph_name Name of the graph
+ */
+void FormatStationaryMatrix(t_writer *w, const t_matrix_limit *limit, const char *graph_name);
+
+/**
+ * @brief Writes every issue of a validation report, then the verdict, as printed by checkIfMarkov().
+ * @param w Destination writer
+ * @param report The report
+ * @param ids External ids of the vertices, NULL to print the vertex numbers
+ */
+void FormatValidationReport(t_writer *w, const t_validation_report *report, const t_id_map *ids);
+
+/**
+ * @brief Writes the first negative rate of a rate graph check (with the
+ *        number of the others), then the verdict, as printed by checkIfRateGraph().
+ * @param w Destination writer
+ * @param report The report
+ * @param ids External ids of the vertices, NULL to print the vertex numbers
+ */
+void FormatRateReport(t_writer *w, const t_rate_report *report, const t_id_map *ids);
+
+#endif //REPORT_H
@@ -0,0 +1,495 @@
+#include "results.h"
+#include "../status/status.h"
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+// same buffer as the graph exports: a large result is written in a few fwrite calls
+#define RESULTS_BUFFER_SIZE (1 << 20)
+
+static const char results_magic[4] = { 'M', 'K', 'V', 'R' };
+
+/**
+ * @brief Format of a file from its extension: .csv, .jsonl / .json, else binary.
+ * @param filename The file name
+ * @return The format
+ */
+t_results_format ResultsFormatOf(const char *filename) {
+    const char *dot = filename ? strrchr(filename, '.') : NULL;
+    if (dot == NULL) return RESULTS_BINARY;
+    if (strcmp(dot, ".csv") == 0) return RESULTS_CSV;
+    if (strcmp(dot, ".jsonl") == 0 || strcmp(dot, ".json") == 0) return RESULTS_JSONL;
+    return RESULTS_BINARY;
+}
+
+/**
+ * @brief 1 if the result can be written: a partition and one entry per class.
+ */
+static int is_complete(const t_graph_analysis *analysis) {
+    return analysis != NULL && analysis->partition != NULL && analysis->classes != NULL
+           && (analysis->links.size == 0 || analysis->links.links != NULL);
+}
+
+/**
+ * @brief Writes a probability with 9 significant digits (enough for a float
+ *        to be read back exactly), or missing if it is not finite.
+ */
+static void write_probability(t_writer *w, float value, const char *missing) {
+    if (isfinite(value)) writer_printf(w, "%.9g", value);
+    else writer_puts(w, missing);
+}
+
+/**
+ * @brief Writes a string between quotes, with the JSON escapes.
+ */
+static void write_json_string(t_writer *w, const char *s) {
+    writer_char(w, '"');
+    for (; *s; s++) {
+        unsigned char c = (unsigned char)*s;
+        if (c == '"' || c == '\\') {
+            writer_char(w, '\\');
+            writer_char(w, (char)c);
+        } else if (c < 0x20) {
+            writer_printf(w, "\\u%04x", c);
+        } else {
+            writer_char(w, (char)c);
+        }
+    }
+    writer_char(w, '"');
+}
+
+/**
+ * @brief Writes a graph result in CSV.
+ * @param w Destination writer
+ * @param analysis Graph result
+ * @param ids External ids of the vertices, NULL to write the vertex numbers
+ * @return MARKOV_OK or MARKOV_ERR_ARG
+ */
+int WriteResultsCSV(t_writer *w, const t_graph_analysis *analysis, const t_id_map *ids) {
+    if (w == NULL || !is_complete(analysis)) return MARKOV_ERR_ARG;
+    const t_partition *partition = analysis->partition;
+
+    writer_puts(w, "graph,");
+    writer_int(w, analysis->nb_vertices);
+    writer_char(w, ',');
+    writer_int(w, partition->nb_class);
+    writer_char(w, ',');
+    writer_int(w, analysis->links.size);
+    writer_char(w, ',');
+    writer_int(w, analysis->irreducible);
+    writer_char(w, ',');
+    writer_int(w, analysis->nb_absorbing);
+    writer_char(w, '\n');
+
+    for (int c = 0; c < partition->nb_class; c++) {
+        const t_class *cls = partition->classes[c];
+        const t_class_analysis *ca = &analysis->classes[c];
+        writer_puts(w, "class,");
+        writer_int(w, c);
+        writer_char(w, ',');
+        writer_puts(w, cls->name);
+        writer_char(w, ',');
+        writer_int(w, cls->nb_vertices);
+        writer_char(w, ',');
+        writer_int(w, ca->persistent);
+        writer_char(w, ',');
+        writer_int(w, ca->absorbing);
+        writer_char(w, ',');
+        if (ca->period > 0) writer_int(w, ca->period);
+        writer_char(w, ',');
+        if (ca->slem >= 0.0f) write_probability(w, ca->slem, "");
+        writer_char(w, ',');
+        writer_int(w, ca->lazy);
+        writer_char(w, ',');
+        writer_int(w, ca->iterations);
+        writer_char(w, '\n');
+    }
+
+    // one row per vertex, class by class, so that a stationary vector stays contiguous
+    for (int c = 0; c < partition->nb_class; c++) {
+        const t_class *cls = partition->classes[c];
+        const float *stationary = analysis->classes[c].stationary;
+        for (int k = 0; k < cls->nb_vertices; k++) {
+            writer_puts(w, "vertex,");
+            write_vertex_id(w, ids, cls->vertices[k]);
+            writer_char(w, ',');
+            writer_int(w, c);
+            writer_char(w, ',');
+            if (stationary) write_probability(w, stationary[k], "");
+            writer_char(w, '\n');
+        }
+    }
+
+    for (int i = 0; i < analysis->links.size; i++) {
+        writer_puts(w, "link,");
+        writer_int(w, analysis->links.links[i].start);
+        writer_char(w, ',');
+        writer_int(w, analysis->links.links[i].end);
+        writer_char(w, '\n');
+    }
+    return MARKOV_OK;
+}
+
+/**
+ * @brief Writes a graph result in JSON lines.
+ * @param w Destination writer
+ * @param analysis Graph result
+ * @param ids External ids of the vertices, NULL to write the vertex numbers
+ * @return MARKOV_OK or MARKOV_ERR_ARG
+ */
+int WriteResultsJSONL(t_writer *w, const t_graph_analysis *analysis, const t_id_map *ids) {
+    if (w == NULL || !is_complete(analysis)) return MARKOV_ERR_ARG;
+    const t_partition *partition = analysis->partition;
+
+    writer_puts(w, "{\"type\":\"graph\",\"vertices\":");
+    writer_int(w, analysis->nb_vertices);
+    writer_puts(w, ",\"classes\":");
+    writer_int(w, partition->nb_class);
+    writer_puts(w, ",\"links\":");
+    writer_int(w, analysis->links.size);
+    writer_puts(w, analysis->irreducible ? ",\"irreducible\":true" : ",\"irreducible\":false");
+    writer_puts(w, ",\"absorbing_states\":");
+    writer_int(w, analysis->nb_absorbing);
+    writer_puts(w, "}\n");
+
+    for (int c = 0; c < partition->nb_class; c++) {
+        const t_class *cls = partition->classes[c];
+        const t_class_analysis *ca = &analysis->classes[c];
+        writer_puts(w, "{\"type\":\"class\",\"index\":");
+        writer_int(w, c);
+        writer_puts(w, ",\"name\":");
+        write_json_string(w, cls->name);
+        writer_puts(w, ",\"size\":");
+        writer_int(w, cls->nb_vertices);
+        writer_puts(w, ca->persistent ? ",\"persistent\":true" : ",\"persistent\":false");
+        writer_puts(w, ca->absorbing ? ",\"absorbing\":true" : ",\"absorbing\":false");
+        writer_puts(w, ",\"period\":");
+        if (ca->period > 0) writer_int(w, ca->period);
+        else writer_puts(w, "null");
+        writer_puts(w, ",\"slem\":");
+        if (ca->slem >= 0.0f) write_probability(w, ca->slem, "null");
+        else writer_puts(w, "null");
+        writer_puts(w, ca->lazy ? ",\"lazy\":true" : ",\"lazy\":false");
+        writer_puts(w, ",\"iterations\":");
+        writer_int(w, ca->iterations);
+
+        writer_puts(w, ",\"vertices\":[");
+        for (int k = 0; k < cls->nb_vertices; k++) {
+            if (k) writer_char(w, ',');
+            write_vertex_id(w, ids, cls->vertices[k]);
+        }
+        writer_puts(w, "],\"stationary\":");
+        if (ca->stationary) {
+            writer_char(w, '[');
+            for (int k = 0; k < cls->nb_vertices; k++) {
+                if (k) writer_char(w, ',');
+                write_probability(w, ca->stationary[k], "null");
+            }
+            writer_char(w, ']');
+        } else {
+            writer_puts(w, "null");
+        }
+        writer_puts(w, "}\n");
+    }
+
+    for (int i = 0; i < analysis->links.size; i++) {
+        writer_puts(w, "{\"type\":\"link\",\"from\":");
+        writer_int(w, analysis->links.links[i].start);
+        writer_puts(w, ",\"to\":");
+        writer_int(w, analysis->links.links[i].end);
+        writer_puts(w, "}\n");
+    }
+    return MARKOV_OK;
+}
+
+/* ------------------------------------------------------------------ */
+/* Binary format                                                       */
+/* ------------------------------------------------------------------ */
+
+// the bytes are written one by one, so the file is the same on any host
+static void put_u32(t_writer *w, uint32_t value) {
+    char bytes[4] = { (char)(value & 0xff), (char)((value >> 8) & 0xff),
+                      (char)((value >> 16) & 0xff), (char)((value >> 24) & 0xff) };
+    writer_write(w, bytes, 4);
+}
+
+static void put_i32(t_writer *w, int value) {
+    put_u32(w, (uint32_t)value);
+}
+
+static void put_f32(t_writer *w, float value) {
+    uint32_t bits;
+    memcpy(&bits, &value, sizeof(bits));
+    put_u32(w, bits);
+}
+
+static void put_i64(t_writer *w, int64_t value) {
+    put_u32(w, (uint32_t)((uint64_t)value & 0xffffffffu));
+    put_u32(w, (uint32_t)((uint64_t)value >> 32));
+}
+
+/**
+ * @brief Writes a graph result in the binary format, at full precision.
+ * @param w Destination writer
+ * @param analysis Graph result
+ * @param ids External ids of the vertices, NULL for none
+ * @return MARKOV_OK or MARKOV_ERR_ARG
+ */
+int WriteResultsBinary(t_writer *w, const t_graph_analysis *analysis, const t_id_map *ids) {
+    if (w == NULL || !is_complete(analysis)) return MARKOV_ERR_ARG;
+    const t_partition *partition = analysis->partition;
+    int has_ids = ids != NULL && ids->count >= analysis->nb_vertices;
+
+    writer_write(w, results_magic, sizeof(results_magic));
+    put_u32(w, RESULTS_BINARY_VERSION);
+    put_u32(w, (has_ids ? RESULTS_HAS_IDS : 0) | (analysis->irreducible ? RESULTS_IRREDUCIBLE : 0));
+    put_i32(w, analysis->nb_vertices);
+    put_i32(w, partition->nb_class);
+    put_i32(w, analysis->links.size);
+    put_i32(w, analysis->nb_absorbing);
+
+    for (int c = 0; c < partition->nb_class; c++) {
+        const t_class *cls = partition->classes[c];
+        const t_class_analysis *ca = &analysis->classes[c];
+        char flags[4] = { (char)(ca->persistent != 0), (char)(ca->absorbing != 0),
+                          (char)(ca->lazy != 0), (char)(ca->stationary != NULL) };
+        put_i32(w, cls->nb_vertices);
+        writer_write(w, flags, 4);
+        put_i32(w, ca->period);
+        put_f32(w, ca->slem);
+        put_i32(w, ca->max_iter);
+        put_i32(w, ca->iterations);
+        size_t name_len = strlen(cls->name);
+        writer_char(w, (char)name_len);
+        writer_write(w, cls->name, name_len);
+        for (int k = 0; k < cls->nb_vertices; k++) put_i32(w, cls->vertices[k]);
+        if (ca->stationary) {
+            for (int k = 0; k < cls->nb_vertices; k++) put_f32(w, ca->stationary[k]);
+        }
+    }
+
+    for (int i = 0; i < analysis->links.size; i++) {
+        put_i32(w, analysis->links.links[i].start);
+        put_i32(w, analysis->links.links[i].end);
+    }
+
+    if (has_ids) {
+        for (int v = 1; v <= analysis->nb_vertices; v++) put_i64(w, id_map_external(ids, v));
+    }
+    return MARKOV_OK;
+}
+
+/**
+ * @brief Writes a graph result to a file.
+ * @param analysis Graph result
+ * @param filename Output file
+ * @param format Output format
+ * @param ids External ids of the vertices, NULL for the vertex numbers
+ * @return MARKOV_OK, MARKOV_ERR_IO, MARKOV_ERR_ALLOC or MARKOV_ERR_ARG
+ */
+int ExportResults(const t_graph_analysis *analysis, const char *filename, t_results_format format, const t_id_map *ids) {
+    if (filename == NULL || !is_complete(analysis)) return MARKOV_ERR_ARG;
+    FILE *file = fopen(filename, format == RESULTS_BINARY ? "wb" : "w");
+    if (file == NULL) return MARKOV_ERR_IO;
+    t_writer w;
+    if (writer_init(&w, file, RESULTS_BUFFER_SIZE) != 0) {
+        fclose(file);
+        return MARKOV_ERR_ALLOC;
+    }
+
+    int status;
+    if (format == RESULTS_CSV) status = WriteResultsCSV(&w, analysis, ids);
+    else if (format == RESULTS_JSONL) status = WriteResultsJSONL(&w, analysis, ids);
+    else status = WriteResultsBinary(&w, analysis, ids);
+
+    if (writer_close(&w) != 0 && status == MARKOV_OK) status = MARKOV_ERR_IO;
+    if (fclose(file) != 0 && status == MARKOV_OK) status = MARKOV_ERR_IO;
+    return status;
+}
+
+/**
+ * @brief Input of ReadResultsBinary(): the file and whether a read fell
+ *        short. After a failed read every value reads as 0.
+ */
+typedef struct s_results_reader {
+    FILE *file;
+    int error;
+} t_results_reader;
+
+static void get_bytes(t_results_reader *r, void *out, size_t len) {
+    if (r->error || fread(out, 1, len, r->file) != len) {
+        r->error = 1;
+        memset(out, 0, len);
+    }
+}
+
+static uint32_t get_u32(t_results_reader *r) {
+    unsigned char b[4];
+    get_bytes(r, b, 4);
+    return (uint32_t)b[0] | ((uint32_t)b[1] << 8) | ((uint32_t)b[2] << 16) | ((uint32_t)b[3] << 24);
+}
+
+static int get_i32(t_results_reader *r) {
+    return (int)(int32_t)get_u32(r);
+}
+
+static float get_f32(t_results_reader *r) {
+    uint32_t bits = get_u32(r);
+    float value;
+    memcpy(&value, &bits, sizeof(value));
+    return value;
+}
+
+static int64_t get_i64(t_results_reader *r) {
+    uint64_t low = get_u32(r);
+    uint64_t high = get_u32(r);
+    return (int64_t)(low | (high << 32));
+}
+
+/**
+ * @brief Reads one class record into the result.
+ * @return MARKOV_OK, MARKOV_ERR_ALLOC or MARKOV_ERR_FORMAT
+ */
+static int read_class(t_results_reader *r, t_graph_analysis *result, int c, int *remaining) {
+    t_class_analysis *ca = &result->classes[c];
+    int size = get_i32(r);
+    unsigned char flags[4];
+    get_bytes(r, flags, 4);
+    ca->size = size;
+    ca->persistent = flags[0] != 0;
+    ca->absorbing = flags[1] != 0;
+    ca->lazy = flags[2] != 0;
+    ca->period = get_i32(r);
+    ca->slem = get_f32(r);
+    ca->max_iter = get_i32(r);
+    ca->iterations = get_i32(r);
+    unsigned char name_len;
+    get_bytes(r, &name_len, 1);
+    char name[sizeof(((t_class *)NULL)->name)];
+    if (r->error || size < 1 || size > *remaining || name_len >= sizeof(name)) return MARKOV_ERR_FORMAT;
+    get_bytes(r, name, name_len);
+    name[name_len] = '\0';
+    *remaining -= size;
+
+    p_class cls = CreateClass(name);
+    if (cls == NULL) return MARKOV_ERR_ALLOC;
+    if (AddClassToPartition(result->partition, cls) != 0) {
+        DestroyClass(cls);
+        return MARKOV_ERR_ALLOC;
+    }
+    for (int k = 0; k < size; k++) {
+        int v = get_i32(r);
+        // each vertex of the graph in exactly one class
+        if (r->error || v < 1 || v > result->nb_vertices || result->vertex_to_class[v - 1] >= 0) return MARKOV_ERR_FORMAT;
+        if (AddVertexToClass(cls, v) != 0) return MARKOV_ERR_ALLOC;
+        result->vertex_to_class[v - 1] = c;
+    }
+    if (flags[3]) {
+        ca->stationary = (float *)malloc(size * sizeof(float));
+        if (ca->stationary == NULL) return MARKOV_ERR_ALLOC;
+        for (int k = 0; k < size; k++) ca->stationary[k] = get_f32(r);
+    }
+    return r->error ? MARKOV_ERR_FORMAT : MARKOV_OK;
+}
+
+/**
+ * @brief Reads the header and the records of a binary result.
+ * @return MARKOV_OK, MARKOV_ERR_ALLOC or MARKOV_ERR_FORMAT
+ */
+static int read_results(t_results_reader *r, long file_size, t_graph_analysis *result, t_id_map *ids) {
+    char magic[4];
+    get_bytes(r, magic, 4);
+    uint32_t version = get_u32(r);
+    uint32_t flags = get_u32(r);
+    int nb_vertices = get_i32(r);
+    int nb_classes = get_i32(r);
+    int nb_links = get_i32(r);
+    int nb_absorbing = get_i32(r);
+    // the counts must fit in the file before anything is allocated from them
+    if (r->error || memcmp(magic, results_magic, 4) != 0 || version != RESULTS_BINARY_VERSION
+        || nb_vertices < 0 || nb_classes < 0 || nb_classes > nb_vertices || nb_links < 0 || nb_absorbing < 0
+        || 4.0 * nb_vertices + 8.0 * nb_links + 29.0 * nb_classes > (double)file_size) {
+        return MARKOV_ERR_FORMAT;
+    }
+
+    result->nb_vertices = nb_vertices;
+    result->irreducible = (flags & RESULTS_IRREDUCIBLE) != 0;
+    result->nb_absorbing = nb_absorbing;
+    result->partition = CreatePartition();
+    result->vertex_to_class = (int *)malloc((nb_vertices > 0 ? nb_vertices : 1) * sizeof(int));
+    result->classes = (t_class_analysis *)calloc(nb_classes > 0 ? nb_classes : 1, sizeof(t_class_analysis));
+    if (result->partition == NULL || result->vertex_to_class == NULL || result->classes == NULL) return MARKOV_ERR_ALLOC;
+    for (int v = 0; v < nb_vertices; v++) result->vertex_to_class[v] = -1;
+
+    int remaining = nb_vertices;
+    for (int c = 0; c < nb_classes; c++) {
+        int status = read_class(r, result, c, &remaining);
+        if (status != MARKOV_OK) return status;
+    }
+    if (remaining != 0) return MARKOV_ERR_FORMAT;
+
+    // the links are stored without duplicates, so they are copied as they are
+    // rather than through links_add()
+    if (nb_links > 0) {
+        result->links.links = (t_link *)malloc(nb_links * sizeof(t_link));
+        if (result->links.links == NULL) return MARKOV_ERR_ALLOC;
+        result->links.length = nb_links;
+    }
+    for (int i = 0; i < nb_links; i++) {
+        int start = get_i32(r), end = get_i32(r);
+        if (r->error || start < 0 || start >= nb_classes || end < 0 || end >= nb_classes) return MARKOV_ERR_FORMAT;
+        result->links.links[i].start = start;
+        result->links.links[i].end = end;
+        result->links.size++;
+    }
+
+    if (flags & RESULTS_HAS_IDS) {
+        if (ids == NULL) return MARKOV_OK;
+        if (id_map_init(ids, nb_vertices) != 0) return MARKOV_ERR_ALLOC;
+        for (int v = 0; v < nb_vertices; v++) {
+            int64_t id = get_i64(r);
+            if (r->error) return MARKOV_ERR_FORMAT;
+            int index = id_map_insert(ids, id);
+            if (index < 0) return MARKOV_ERR_ALLOC;
+            if (index != v) return MARKOV_ERR_FORMAT; // an id given twice
+        }
+    } else if (ids != NULL && id_map_init(ids, 0) != 0) {
+        return MARKOV_ERR_ALLOC;
+    }
+    return MARKOV_OK;
+}
+
+/**
+ * @brief Reads back a graph result written by WriteResultsBinary().
+ * @param filename The file
+ * @param result Output (free with FreeGraphAnalysis)
+ * @param ids Output, NULL to skip the ids: initialized here, empty if the
+ *        file has none (free with id_map_free)
+ * @return MARKOV_OK, MARKOV_ERR_IO, MARKOV_ERR_ALLOC, or MARKOV_ERR_FORMAT if
+ *         the file is truncated or inconsistent
+ */
+int ReadResultsBinary(const char *filename, t_graph_analysis *result, t_id_map *ids) {
+    if (filename == NULL || result == NULL) return MARKOV_ERR_ARG;
+    memset(result, 0, sizeof(t_graph_analysis));
+    links_init(&result->links);
+    if (ids != NULL) memset(ids, 0, sizeof(t_id_map));
+
+    FILE *file = fopen(filename, "rb");
+    if (file == NULL) return MARKOV_ERR_IO;
+    long file_size = -1;
+    if (fseek(file, 0, SEEK_END) == 0) file_size = ftell(file);
+    if (file_size < 0 || fseek(file, 0, SEEK_SET) != 0) {
+        fclose(file);
+        return MARKOV_ERR_IO;
+    }
+
+    t_results_reader r = { file, 0 };
+    int status = read_results(&r, file_size, result, ids);
+    fclose(file);
+    if (status != MARKOV_OK) {
+        FreeGraphAnalysis(result);
+        if (ids != NULL) id_map_free(ids);
+    }
+    return status;
+}
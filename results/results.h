@@ -0,0 +1,115 @@
+#ifndef RESULTS_H
+#define RESULTS_H
+
+#include <stdint.h>
+#include "../analysis/analysis.h"
+#include "../writer/writer.h"
+#include "../idmap/idmap.h"
+
+/*
+ * Machine-readable dumps of a graph result, for the programs that consume
+ * the analysis instead of reading the report: the partition, the class
+ * links, the classification, the periods and the stationary vectors. Every
+ * format goes through a buffered writer, one record at a time.
+ *
+ * CSV: one record per line, the first field gives its kind.
+ *   graph,<vertices>,<classes>,<links>,<irreducible>,<absorbing states>
+ *   class,<index>,<name>,<size>,<persistent>,<absorbing>,<period>,<slem>,<lazy>,<iterations>
+ *   vertex,<id>,<class index>,<stationary probability>
+ *   link,<from class>,<to class>
+ * JSON lines: one object per line, "type" being "graph", "class" (with its
+ * "vertices" and "stationary" arrays) or "link".
+ * Class indices are 0-based, in partition order; vertices are written with
+ * their external ids. A value that was not computed (period, SLEM,
+ * stationary probability) is an empty field in CSV and null in JSON. The
+ * probabilities are written with 9 significant digits, enough to read back
+ * the same float.
+ *
+ * Binary (all integers little-endian, floats as IEEE 754 single precision):
+ *   header  "MKVR", u32 version, u32 flags (RESULTS_HAS_IDS, RESULTS_IRREDUCIBLE),
+ *           i32 vertices, i32 classes, i32 links, i32 absorbing states
+ *   class   i32 size, u8 persistent, u8 absorbing, u8 lazy, u8 has stationary,
+ *           i32 period, f32 slem, i32 max_iter, i32 iterations,
+ *           u8 name length, name, i32 vertices[size] (1-based),
+ *           f32 stationary[size] if present
+ *   link    i32 from, i32 to
+ *   ids     i64 external id of each vertex, if RESULTS_HAS_IDS
+ * The values are stored as they are in memory, so ReadResultsBinary() gives
+ * back the same result.
+ */
+
+#define RESULTS_BINARY_VERSION 1
+
+/**
+ * @brief Flags of the binary header.
+ */
+enum {
+    RESULTS_HAS_IDS = 1 << 0,     // the file ends with the external ids
+    RESULTS_IRREDUCIBLE = 1 << 1  // the graph has a single class
+};
+
+/**
+ * @brief Output formats.
+ */
+typedef enum e_results_format {
+    RESULTS_BINARY,
+    RESULTS_CSV,
+    RESULTS_JSONL
+} t_results_format;
+
+/**
+ * @brief Format of a file from its extension: .csv, .jsonl / .json, else binary.
+ * @param filename The file name
+ * @return The format
+ */
+t_results_format ResultsFormatOf(const char *filename);
+
+/**
+ * @brief Writes a graph result in CSV.
+ * @param w Destination writer
+ * @param analysis Graph result
+ * @param ids External ids of the vertices, NULL to write the vertex numbers
+ * @return MARKOV_OK or MARKOV_ERR_ARG
+ */
+int WriteResultsCSV(t_writer *w, const t_graph_analysis *analysis, const t_id_map *ids);
+
+/**
+ * @brief Writes a graph result in JSON lines.
+ * @param w Destination writer
+ * @param analysis Graph result
+ * @param ids External ids of the vertices, NULL to write the vertex numbers
+ * @return MARKOV_OK or MARKOV_ERR_ARG
+ */
+int WriteResultsJSONL(t_writer *w, const t_graph_analysis *analysis, const t_id_map *ids);
+
+/**
+ * @brief Writes a graph result in the binary format, at full precision.
+ * @param w Destination writer
+ * @param analysis Graph result
+ * @param ids External ids of the vertices, NULL for none
+ * @return MARKOV_OK or MARKOV_ERR_ARG
+ */
+int WriteResultsBinary(t_writer *w, const t_graph_analysis *analysis, const t_id_map *ids);
+
+/**
+ * @brief Writes a graph result to a file.
+ * @param analysis Graph result
+ * @param filename Output file
+ * @param format Output format
+ * @param ids External ids of the vertices, NULL for the vertex numbers
+ * @return MARKOV_OK, MARKOV_ERR_IO, MARKOV_ERR_ALLOC or MARKOV_ERR_ARG
+ */
+int ExportResults(const t_graph_analysis *analysis, const char *filename, t_results_format format, const t_id_map *ids);
+
+/**
+ * @brief Reads back a graph result written by WriteResultsBinary().
+ * @param filename The file
+ * @param result Output (free with FreeGraphAnalysis)
+ * @param ids Output, NULL to skip the ids: initialized here, empty if the
+ *        file has none (free with id_map_free)
+ * @return MARKOV_OK, MARKOV_ERR_IO, MARKOV_ERR_ALLOC, or MARKOV_ERR_FORMAT if
+ *         the file is truncated or inconsistent
+ */
+int ReadResultsBinary(const char *filename, t_graph_analysis *result, t_id_map *ids);
+
+#endif //RESULTS_H
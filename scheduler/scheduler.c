@@ -0,0 +1,462 @@
+#include "scheduler.h"
+#include <pthread.h>
+#include <sched.h>
+#include <stdlib.h>
+
+/**
+ * @brief A queued task.
+ */
+typedef struct s_task {
+    t_task_fn fn;
+    void *arg;
+    t_task_group *group;
+    struct s_task *next; // next task of the injection queue
+} t_task;
+
+/**
+ * @brief Circular array of a deque. When it is full, the deque moves to an
+ *        array twice as large; the old one may still be read by a thief, so
+ *        it is only freed with the scheduler.
+ */
+typedef struct s_task_array {
+    long long capacity; // power of 2
+    _Atomic(t_task *) *slots;
+    struct s_task_array *previous; // array replaced by this one
+} t_task_array;
+
+/**
+ * @brief Chase-Lev deque: the owner pushes and pops at the bottom, the
+ *        thieves take from the top.
+ */
+typedef struct s_deque {
+    atomic_llong top;
+    atomic_llong bottom;
+    _Atomic(t_task_array *) array;
+} t_deque;
+
+/**
+ * @brief A worker thread and its deque.
+ */
+typedef struct s_worker {
+    t_scheduler *scheduler;
+    t_deque deque;
+    unsigned seed; // picks the first victim of a steal
+} t_worker;
+
+struct s_scheduler {
+    int nb_threads;      // workers + the waiting thread
+    int nb_workers;      // workers started
+    int nb_deques;       // deques of workers[], fixed before the first start
+    t_worker *workers;
+    pthread_t *threads;
+
+    // tasks spawned outside the workers
+    pthread_mutex_t inject_lock;
+    t_task *inject_head;
+    t_task *inject_tail;
+    atomic_int nb_injected;
+
+    // idle workers sleep on wake while no task is queued
+    pthread_mutex_t sleep_lock;
+    pthread_cond_t wake;
+    atomic_int queued;   // tasks spawned and not yet taken
+    atomic_int sleeping; // workers waiting on wake
+    atomic_int stop;
+};
+
+// worker running on this thread, NULL outside the workers
+static _Thread_local t_worker *current_worker = NULL;
+// scheduler returned by scheduler_current() outside the workers
+static _Atomic(t_scheduler *) default_scheduler = NULL;
+
+#define DEQUE_INITIAL_CAPACITY 64
+
+static t_task_array *create_task_array(long long capacity) {
+    t_task_array *a = (t_task_array *)malloc(sizeof(t_task_array));
+    if (a == NULL) return NULL;
+    a->slots = (_Atomic(t_task *) *)malloc((size_t)capacity * sizeof(_Atomic(t_task *)));
+    if (a->slots == NULL) {
+        free(a);
+        return NULL;
+    }
+    a->capacity = capacity;
+    a->previous = NULL;
+    return a;
+}
+
+static int deque_init(t_deque *d) {
+    t_task_array *a = create_task_array(DEQUE_INITIAL_CAPACITY);
+    if (a == NULL) return -1;
+    atomic_init(&d->top, 0);
+    atomic_init(&d->bottom, 0);
+    atomic_init(&d->array, a);
+    return 0;
+}
+
+static void deque_free(t_deque *d) {
+    t_task_array *a = atomic_load(&d->array);
+    while (a != NULL) {
+        t_task_array *previous = a->previous;
+        free(a->slots);
+        free(a);
+        a = previous;
+    }
+    atomic_store(&d->array, NULL);
+}
+
+/**
+ * @brief Pushes a task at the bottom (owner only).
+ * @return 0 on success, -1 if the deque is full and cannot grow
+ */
+static int deque_push(t_deque *d, t_task *task) {
+    long long b = atomic_load(&d->bottom);
+    long long t = atomic_load(&d->top);
+    t_task_array *a = atomic_load(&d->array);
+
+    if (b - t >= a->capacity) {
+        // full: copy the live tasks in a twice larger array
+        t_task_array *larger = create_task_array(2 * a->capacity);
+        if (larger == NULL) return -1;
+        for (long long i = t; i < b; i++) {
+            atomic_store(&larger->slots[i & (larger->capacity - 1)], atomic_load(&a->slots[i & (a->capacity - 1)]));
+        }
+        larger->previous = a;
+        atomic_store(&d->array, larger);
+        a = larger;
+    }
+    atomic_store(&a->slots[b & (a->capacity - 1)], task);
+    atomic_store(&d->bottom, b + 1);
+    return 0;
+}
+
+/**
+ * @brief Pops the last pushed task (owner only).
+ * @return The task, NULL if the deque is empty
+ */
+static t_task *deque_pop(t_deque *d) {
+    long long b = atomic_load(&d->bottom) - 1;
+    t_task_array *a = atomic_load(&d->array);
+    atomic_store(&d->bottom, b);
+    long long t = atomic_load(&d->top);
+
+    if (t > b) {
+        // empty
+        atomic_store(&d->bottom, b + 1);
+        return NULL;
+    }
+    t_task *task = atomic_load(&a->slots[b & (a->capacity - 1)]);
+    if (t == b) {
+        // last task: race with the thieves for it
+        if (!atomic_compare_exchange_strong(&d->top, &t, t + 1)) task = NULL;
+        atomic_store(&d->bottom, b + 1);
+    }
+    return task;
+}
+
+/**
+ * @brief Takes the oldest task (any thread).
+ * @return The task, NULL if the deque is empty or another thread took it first
+ */
+static t_task *deque_steal(t_deque *d) {
+    long long t = atomic_load(&d->top);
+    long long b = atomic_load(&d->bottom);
+    if (t >= b) return NULL;
+
+    t_task_array *a = atomic_load(&d->array);
+    t_task *task = atomic_load(&a->slots[t & (a->capacity - 1)]);
+    if (!atomic_compare_exchange_strong(&d->top, &t, t + 1)) return NULL;
+    return task;
+}
+
+static void inject_push(t_scheduler *s, t_task *task) {
+    task->next = NULL;
+    pthread_mutex_lock(&s->inject_lock);
+    if (s->inject_tail) s->inject_tail->next = task;
+    else s->inject_head = task;
+    s->inject_tail = task;
+    atomic_fetch_add(&s->nb_injected, 1);
+    pthread_mutex_unlock(&s->inject_lock);
+}
+
+static t_task *inject_pop(t_scheduler *s) {
+    if (atomic_load(&s->nb_injected) == 0) return NULL;
+    pthread_mutex_lock(&s->inject_lock);
+    t_task *task = s->inject_head;
+    if (task) {
+        s->inject_head = task->next;
+        if (s->inject_head == NULL) s->inject_tail = NULL;
+        atomic_fetch_sub(&s->nb_injected, 1);
+    }
+    pthread_mutex_unlock(&s->inject_lock);
+    return task;
+}
+
+/**
+ * @brief Finds a task to run: own deque first (newest task, still in cache),
+ *        then the injection queue, then the oldest task of another worker.
+ * @param s The scheduler
+ * @param self Worker of the calling thread, NULL for an outside thread
+ * @return The task, NULL if none was found
+ */
+static t_task *find_task(t_scheduler *s, t_worker *self) {
+    t_task *task = self ? deque_pop(&self->deque) : NULL;
+    if (task == NULL) task = inject_pop(s);
+
+    if (task == NULL && s->nb_deques > 0) {
+        unsigned first = 0;
+        if (self) {
+            self->seed = self->seed * 1103515245u + 12345u;
+            first = (self->seed >> 16) % (unsigned)s->nb_deques;
+        }
+        for (int k = 0; task == NULL && k < s->nb_deques; k++) {
+            t_worker *victim = &s->workers[(first + (unsigned)k) % (unsigned)s->nb_deques];
+            if (victim != self) task = deque_steal(&victim->deque);
+        }
+    }
+    if (task) atomic_fetch_sub(&s->queued, 1);
+    return task;
+}
+
+static void run_task(t_task *task) {
+    t_task_group *group = task->group;
+    task->fn(task->arg);
+    free(task);
+    // last: the group may live on the stack of the waiting thread
+    atomic_fetch_sub(&group->pending, 1);
+}
+
+static void *worker_run(void *arg) {
+    t_worker *self = (t_worker *)arg;
+    t_scheduler *s = self->scheduler;
+    current_worker = self;
+
+    while (!atomic_load(&s->stop)) {
+        t_task *task = find_task(s, self);
+        if (task) {
+            run_task(task);
+            continue;
+        }
+        // nothing to take: sleep until a task is spawned. queued is raised
+        // before the push and sleeping before the check, so either the
+        // spawner sees this worker sleeping or the worker sees the task.
+        pthread_mutex_lock(&s->sleep_lock);
+        atomic_fetch_add(&s->sleeping, 1);
+        while (!atomic_load(&s->stop) && atomic_load(&s->queued) == 0) {
+            pthread_cond_wait(&s->wake, &s->sleep_lock);
+        }
+        atomic_fetch_sub(&s->sleeping, 1);
+        pthread_mutex_unlock(&s->sleep_lock);
+        // a task counted in queued may still be on its way to a deque
+        sched_yield();
+    }
+    current_worker = NULL;
+    return NULL;
+}
+
+/**
+ * @brief Starts a scheduler.
+ * @param nb_threads Number of threads running tasks, the waiting thread included.
+ * @return t_scheduler* The scheduler, NULL on error.
+ */
+t_scheduler *scheduler_create(int nb_threads) {
+    if (nb_threads < 1) nb_threads = 1;
+    t_scheduler *s = (t_scheduler *)calloc(1, sizeof(t_scheduler));
+    if (s == NULL) return NULL;
+    s->nb_threads = nb_threads;
+    atomic_init(&s->nb_injected, 0);
+    atomic_init(&s->queued, 0);
+    atomic_init(&s->sleeping, 0);
+    atomic_init(&s->stop, 0);
+    pthread_mutex_init(&s->inject_lock, NULL);
+    pthread_mutex_init(&s->sleep_lock, NULL);
+    pthread_cond_init(&s->wake, NULL);
+
+    int nb_workers = nb_threads - 1;
+    if (nb_workers > 0) {
+        s->workers = (t_worker *)calloc(nb_workers, sizeof(t_worker));
+        s->threads = (pthread_t *)malloc(nb_workers * sizeof(pthread_t));
+        if (s->workers == NULL || s->threads == NULL) {
+            scheduler_destroy(s);
+            return NULL;
+        }
+    }
+    // every deque exists before the first worker starts stealing
+    for (int k = 0; k < nb_workers; k++) {
+        s->workers[k].scheduler = s;
+        s->workers[k].seed = 2654435761u * (unsigned)(k + 1);
+        if (deque_init(&s->workers[k].deque) != 0) {
+            for (int j = 0; j < k; j++) deque_free(&s->workers[j].deque);
+            free(s->workers);
+            s->workers = NULL;
+            scheduler_destroy(s);
+            return NULL;
+        }
+    }
+    s->nb_deques = nb_workers;
+    // if a thread cannot be started, the started ones do the work
+    int started = 0;
+    while (started < nb_workers && pthread_create(&s->threads[started], NULL, worker_run, &s->workers[started]) == 0) {
+        started++;
+    }
+    s->nb_workers = started;
+    return s;
+}
+
+/**
+ * @brief Stops the workers and frees the scheduler.
+ * @param s The scheduler.
+ */
+void scheduler_destroy(t_scheduler *s) {
+    if (s == NULL) return;
+    if (atomic_load(&default_scheduler) == s) atomic_store(&default_scheduler, NULL);
+
+    pthread_mutex_lock(&s->sleep_lock);
+    atomic_store(&s->stop, 1);
+    pthread_cond_broadcast(&s->wake);
+    pthread_mutex_unlock(&s->sleep_lock);
+    for (int k = 0; k < s->nb_workers; k++) pthread_join(s->threads[k], NULL);
+
+    if (s->workers) {
+        for (int k = 0; k < s->nb_deques; k++) deque_free(&s->workers[k].deque);
+    }
+    free(s->workers);
+    free(s->threads);
+    pthread_cond_destroy(&s->wake);
+    pthread_mutex_destroy(&s->sleep_lock);
+    pthread_mutex_destroy(&s->inject_lock);
+    free(s);
+}
+
+/**
+ * @brief Number of threads that run tasks.
+ * @param s The scheduler.
+ * @return int The number of threads.
+ */
+int scheduler_nb_threads(const t_scheduler *s) {
+    return s ? s->nb_workers + 1 : 1;
+}
+
+/**
+ * @brief Sets the scheduler used by scheduler_current() outside the workers.
+ * @param s The scheduler.
+ */
+void scheduler_set_default(t_scheduler *s) {
+    atomic_store(&default_scheduler, s);
+}
+
+/**
+ * @brief Scheduler to use from the calling thread.
+ * @return t_scheduler* The scheduler, NULL if there is none.
+ */
+t_scheduler *scheduler_current(void) {
+    if (current_worker) return current_worker->scheduler;
+    return atomic_load(&default_scheduler);
+}
+
+/**
+ * @brief Initializes an empty group.
+ * @param g The group.
+ */
+void task_group_init(t_task_group *g) {
+    atomic_init(&g->pending, 0);
+}
+
+/**
+ * @brief Queues fn(arg) in a group.
+ * @param s The scheduler.
+ * @param g The group of the task.
+ * @param fn The function.
+ * @param arg Its argument.
+ */
+void scheduler_spawn(t_scheduler *s, t_task_group *g, t_task_fn fn, void *arg) {
+    t_task *task = s ? (t_task *)malloc(sizeof(t_task)) : NULL;
+    if (task == NULL) {
+        fn(arg);
+        return;
+    }
+    task->fn = fn;
+    task->arg = arg;
+    task->group = g;
+    atomic_fetch_add(&g->pending, 1);
+
+    atomic_fetch_add(&s->queued, 1);
+    t_worker *self = current_worker;
+    if (self == NULL || self->scheduler != s || deque_push(&self->deque, task) != 0) inject_push(s, task);
+    if (atomic_load(&s->sleeping) > 0) {
+        pthread_mutex_lock(&s->sleep_lock);
+        pthread_cond_signal(&s->wake);
+        pthread_mutex_unlock(&s->sleep_lock);
+    }
+}
+
+/**
+ * @brief Waits until every task of a group is finished, running tasks in the meantime.
+ * @param s The scheduler.
+ * @param g The group.
+ */
+void scheduler_wait(t_scheduler *s, t_task_group *g) {
+    if (s == NULL) return;
+    t_worker *self = (current_worker && current_worker->scheduler == s) ? current_worker : NULL;
+    while (atomic_load(&g->pending) > 0) {
+        // the task found may belong to another group: it has to run anyway,
+        // and running it here is what makes nested waits progress
+        t_task *task = find_task(s, self);
+        if (task) run_task(task);
+        else sched_yield();
+    }
+}
+
+/**
+ * @brief One sub-range of scheduler_parallel_for().
+ */
+typedef struct s_range_task {
+    t_range_fn body;
+    void *ctx;
+    int begin;
+    int end;
+} t_range_task;
+
+static void run_range(void *arg) {
+    t_range_task *r = (t_range_task *)arg;
+    r->body(r->ctx, r->begin, r->end);
+}
+
+/**
+ * @brief Calls body(ctx, b, e) on sub-ranges covering [begin, end) in parallel.
+ * @param s The scheduler.
+ * @param begin First index.
+ * @param end One past the last index.
+ * @param grain Smallest range worth a task.
+ * @param body The loop body.
+ * @param ctx Argument of the body.
+ */
+void scheduler_parallel_for(t_scheduler *s, int begin, int end, int grain, t_range_fn body, void *ctx) {
+    if (end <= begin) return;
+    if (grain < 1) grain = 1;
+    long long n = (long long)end - begin;
+
+    // a few ranges per thread, so that a thread slowed down by other work
+    // does not hold the others back, but none smaller than grain
+    long long nb_ranges = scheduler_nb_threads(s) > 1 ? 4LL * scheduler_nb_threads(s) : 1;
+    if (n / grain < nb_ranges) nb_ranges = n / grain;
+    t_range_task *ranges = nb_ranges > 1 ? (t_range_task *)malloc((size_t)nb_ranges * sizeof(t_range_task)) : NULL;
+    if (s == NULL || ranges == NULL) {
+        free(ranges);
+        body(ctx, begin, end);
+        return;
+    }
+
+    for (long long k = 0; k < nb_ranges; k++) {
+        ranges[k].body = body;
+        ranges[k].ctx = ctx;
+        ranges[k].begin = begin + (int)(n * k / nb_ranges);
+        ranges[k].end = begin + (int)(n * (k + 1) / nb_ranges);
+    }
+    t_task_group group;
+    task_group_init(&group);
+    for (long long k = 1; k < nb_ranges; k++) scheduler_spawn(s, &group, run_range, &ranges[k]);
+    // the first range runs here, the others are stolen meanwhile
+    run_range(&ranges[0]);
+    scheduler_wait(s, &group);
+    free(ranges);
+}
@@ -0,0 +1,116 @@
+#ifndef SCHEDULER_H
+#define SCHEDULER_H
+
+#include <stdatomic.h>
+
+/**
+ * @brief Work-stealing task scheduler shared by the parallel parts of the
+ *        library (matrix kernels, per-class analysis, FW-BW SCC, simulation,
+ *        parallel loading).
+ *
+ * Each worker thread owns a Chase-Lev deque: it pushes and pops its own
+ * tasks at the bottom without locks, and idle workers steal from the top of
+ * the others with a single compare-and-swap. Tasks spawned from outside the
+ * workers go through a locked injection queue.
+ *
+ * The scheduler is nestable: a thread waiting for a group of tasks runs
+ * other tasks meanwhile, so a task can spawn and wait for sub-tasks (e.g. a
+ * per-class solve calling a parallel kernel) on the same workers, without
+ * creating more threads than the scheduler has.
+ */
+typedef struct s_scheduler t_scheduler;
+
+/**
+ * @brief A task: fn(arg), run by any thread of the scheduler.
+ */
+typedef void (*t_task_fn)(void *arg);
+
+/**
+ * @brief Body of a parallel loop, called on sub-ranges [begin, end).
+ */
+typedef void (*t_range_fn)(void *ctx, int begin, int end);
+
+/**
+ * @brief A set of tasks that can be waited for together.
+ */
+typedef struct s_task_group {
+    atomic_int pending; // tasks spawned in the group and not finished
+} t_task_group;
+
+/**
+ * @brief Starts a scheduler.
+ * @param nb_threads Number of threads running tasks, the thread that waits
+ *        included (nb_threads - 1 workers are started; <= 1 = none, the
+ *        tasks then run in scheduler_wait())
+ * @return The scheduler, NULL on error
+ */
+t_scheduler *scheduler_create(int nb_threads);
+
+/**
+ * @brief Stops the workers and frees the scheduler. Every group must have
+ *        been waited for.
+ * @param s The scheduler (may be NULL)
+ */
+void scheduler_destroy(t_scheduler *s);
+
+/**
+ * @brief Number of threads that run tasks (workers + the waiting thread).
+ * @param s The scheduler (NULL counts as 1)
+ * @return The number of threads
+ */
+int scheduler_nb_threads(const t_scheduler *s);
+
+/**
+ * @brief Sets the scheduler used by scheduler_current() outside the workers.
+ * @param s The scheduler, NULL for none (sequential kernels)
+ */
+void scheduler_set_default(t_scheduler *s);
+
+/**
+ * @brief Scheduler to use from the calling thread: the one of the worker
+ *        running the call, or else the default one.
+ * @return The scheduler, NULL if there is none
+ */
+t_scheduler *scheduler_current(void);
+
+/**
+ * @brief Initializes an empty group.
+ * @param g The group
+ */
+void task_group_init(t_task_group *g);
+
+/**
+ * @brief Queues fn(arg) in a group. Without a scheduler, or if the task
+ *        cannot be allocated, fn(arg) runs at once.
+ * @param s The scheduler (may be NULL)
+ * @param g The group of the task
+ * @param fn The function
+ * @param arg Its argument
+ */
+void scheduler_spawn(t_scheduler *s, t_task_group *g, t_task_fn fn, void *arg);
+
+/**
+ * @brief Waits until every task of a group is finished, running tasks in
+ *        the meantime.
+ * @param s The scheduler (may be NULL)
+ * @param g The group
+ */
+void scheduler_wait(t_scheduler *s, t_task_group *g);
+
+/**
+ * @brief Calls body(ctx, b, e) on sub-ranges covering [begin, end) in
+ *        parallel, and returns when they are all done.
+ *
+ * Ranges of at most grain elements are not split. Without a scheduler
+ * (or with a single thread), body(ctx, begin, end) is called directly.
+ *
+ * @param s The scheduler (may be NULL)
+ * @param begin First index
+ * @param end One past the last index
+ * @param grain Smallest range worth a task
+ * @param body The loop body
+ * @param ctx Argument of the body
+ */
+void scheduler_parallel_for(t_scheduler *s, int begin, int end, int grain, t_range_fn body, void *ctx);
+
+#endif //SCHEDULER_H
@@ -0,0 +1,269 @@
+#include "simulation.h"
+#include "../scheduler/scheduler.h"
+#include <stdlib.h>
+#include <string.h>
+
+/**
+ * @brief Builds the alias tables (Vose's method) of every vertex.
+ * @param S The sparse transition matrix.
+ * @return p_alias_table The alias tables, NULL on error.
+ */
+p_alias_table CreateAliasTable(p_sparse_matrix S) {
+    if (S == NULL || S->size <= 0) return NULL;
+    int n = S->size;
+
+    // vertices without outgoing edge get one extra slot (a self-loop)
+    int slots = 0;
+    for (int i = 0; i < n; i++) {
+        int deg = S->row_start[i + 1] - S->row_start[i];
+        slots += deg > 0 ? deg : 1;
+    }
+
+    p_alias_table A = (p_alias_table)malloc(sizeof(t_alias_table));
+    if (!A) return NULL;
+    A->size = n;
+    A->row_start = (int *)malloc((n + 1) * sizeof(int));
+    A->col = (int *)malloc(slots * sizeof(int));
+    A->prob = (float *)malloc(slots * sizeof(float));
+    A->alias = (int *)malloc(slots * sizeof(int));
+
+    // work lists of Vose's method, reused for every vertex
+    int max_deg = 1;
+    for (int i = 0; i < n; i++) {
+        int deg = S->row_start[i + 1] - S->row_start[i];
+        if (deg > max_deg) max_deg = deg;
+    }
+    double *scaled = (double *)malloc(max_deg * sizeof(double));
+    int *small = (int *)malloc(max_deg * sizeof(int));
+    int *large = (int *)malloc(max_deg * sizeof(int));
+
+    if (!A->row_start || !A->col || !A->prob || !A->alias || !scaled || !small || !large) {
+        free(scaled); free(small); free(large);
+        DestroyAliasTable(A);
+        return NULL;
+    }
+
+    int slot = 0;
+    for (int i = 0; i < n; i++) {
+        A->row_start[i] = slot;
+        int first = S->row_start[i];
+        int deg = S->row_start[i + 1] - first;
+
+        if (deg == 0) {
+            A->col[slot] = i;
+            A->prob[slot] = 1.0f;
+            A->alias[slot] = slot;
+            slot++;
+            continue;
+        }
+
+        double sum = 0.0;
+        for (int e = 0; e < deg; e++) sum += S->val[first + e] > 0.0f ? S->val[first + e] : 0.0f;
+
+        // scale the probabilities so that their mean is 1, then split them
+        // into the slots below 1 (small) and above 1 (large)
+        int nb_small = 0, nb_large = 0;
+        for (int e = 0; e < deg; e++) {
+            A->col[slot + e] = S->col[first + e];
+            double p = S->val[first + e] > 0.0f ? S->val[first + e] : 0.0f;
+            scaled[e] = sum > 0.0 ? p * deg / sum : 1.0;
+            if (scaled[e] < 1.0) small[nb_small++] = e;
+            else large[nb_large++] = e;
+        }
+
+        // fill each small slot with a piece of a large one
+        while (nb_small > 0 && nb_large > 0) {
+            int s = small[--nb_small];
+            int l = large[nb_large - 1];
+            A->prob[slot + s] = (float)scaled[s];
+            A->alias[slot + s] = slot + l;
+            scaled[l] -= 1.0 - scaled[s];
+            if (scaled[l] < 1.0) {
+                nb_large--;
+                small[nb_small++] = l;
+            }
+        }
+        // what is left is full (up to rounding)
+        while (nb_large > 0) {
+            int l = large[--nb_large];
+            A->prob[slot + l] = 1.0f;
+            A->alias[slot + l] = slot + l;
+        }
+        while (nb_small > 0) {
+            int s = small[--nb_small];
+            A->prob[slot + s] = 1.0f;
+            A->alias[slot + s] = slot + s;
+        }
+        slot += deg;
+    }
+    A->row_start[n] = slot;
+
+    free(scaled);
+    free(small);
+    free(large);
+    return A;
+}
+
+/**
+ * @brief Frees the alias tables.
+ * @param A The alias tables to destroy.
+ */
+void DestroyAliasTable(p_alias_table A) {
+    if (A == NULL) return;
+    free(A->row_start);
+    free(A->col);
+    free(A->prob);
+    free(A->alias);
+    free(A);
+}
+
+/**
+ * @brief SplitMix64 finalizer: a bijective 64-bit mixing function.
+ */
+static inline uint64_t mix64(uint64_t z) {
+    z = (z ^ (z >> 30)) * 0xbf58476d1ce4e5b9ULL;
+    z = (z ^ (z >> 27)) * 0x94d049bb133111ebULL;
+    return z ^ (z >> 31);
+}
+
+/**
+ * @brief Counter-based generator: the i-th number of a stream is mix64(key + i * gamma).
+ *        No state is shared between streams, so any thread can run any trajectory.
+ */
+typedef struct s_counter_rng {
+    uint64_t key;
+    uint64_t counter;
+} t_counter_rng;
+
+static inline uint64_t rng_next(t_counter_rng *rng) {
+    return mix64(rng->key + (rng->counter++) * 0x9e3779b97f4a7c15ULL);
+}
+
+/**
+ * @brief Samples the next vertex from vertex v with a single 64-bit draw:
+ *        the high half picks the slot, the low half is the coin.
+ */
+static inline int sample_next(const t_alias_table *A, int v, t_counter_rng *rng) {
+    uint64_t r = rng_next(rng);
+    uint32_t deg = (uint32_t)(A->row_start[v + 1] - A->row_start[v]);
+    int s = A->row_start[v] + (int)(((r >> 32) * deg) >> 32);
+    float coin = (float)(r & 0xffffffffu) * (1.0f / 4294967296.0f);
+    return coin < A->prob[s] ? A->col[s] : A->col[A->alias[s]];
+}
+
+/**
+ * @brief Work of one thread: a contiguous range of trajectories.
+ */
+typedef struct s_sim_worker {
+    const t_alias_table *A;
+    const t_sim_config *config;
+    int first;             // first trajectory of the range
+    int last;              // one past the last trajectory
+    long long *visits;     // per-thread visit counters
+    long long nb_hits;
+    long long sum_hitting; // sum of the hitting times
+} t_sim_worker;
+
+static void sim_worker_run(void *arg) {
+    t_sim_worker *w = (t_sim_worker *)arg;
+    const t_alias_table *A = w->A;
+    const t_sim_config *cfg = w->config;
+    int target = cfg->target - 1;
+
+    for (int t = w->first; t < w->last; t++) {
+        t_counter_rng rng = { mix64(cfg->seed ^ mix64((uint64_t)t + 1)), 0 };
+
+        int v;
+        if (cfg->start > 0) v = cfg->start - 1;
+        else v = (int)(((rng_next(&rng) >> 32) * (uint64_t)A->size) >> 32);
+
+        int hit = (v == target) ? 0 : -1;
+        for (int step = 1; step <= cfg->nb_steps; step++) {
+            v = sample_next(A, v, &rng);
+            w->visits[v]++;
+            if (hit < 0 && v == target) hit = step;
+        }
+        if (hit >= 0) {
+            w->nb_hits++;
+            w->sum_hitting += hit;
+        }
+    }
+}
+
+/**
+ * @brief Simulates independent trajectories across threads.
+ * @param A The alias tables.
+ * @param config Parameters of the run.
+ * @param result Output statistics.
+ * @return 0 on success, -1 on error.
+ */
+int SimulateTrajectories(p_alias_table A, const t_sim_config *config, t_sim_result *result) {
+    if (!A || !config || !result) return -1;
+    if (config->nb_trajectories <= 0 || config->nb_steps < 0) return -1;
+    if (config->start < 0 || config->start > A->size) return -1;
+    if (config->target < 0 || config->target > A->size) return -1;
+
+    int n = A->size;
+    int nb_threads = config->nb_threads > 0 ? config->nb_threads : 1;
+    if (nb_threads > config->nb_trajectories) nb_threads = config->nb_trajectories;
+
+    t_sim_worker *workers = (t_sim_worker *)calloc(nb_threads, sizeof(t_sim_worker));
+    if (!workers) return -1;
+
+    // split the trajectories in nb_threads contiguous ranges (the split, not
+    // the threads that run the ranges, fixes the random streams)
+    int ok = 1;
+    for (int k = 0; k < nb_threads; k++) {
+        workers[k].A = A;
+        workers[k].config = config;
+        workers[k].first = (int)((long long)config->nb_trajectories * k / nb_threads);
+        workers[k].last = (int)((long long)config->nb_trajectories * (k + 1) / nb_threads);
+        workers[k].visits = (long long *)calloc(n, sizeof(long long));
+        if (!workers[k].visits) { ok = 0; break; }
+    }
+    if (ok) {
+        // ranges 1.. go to the current scheduler (a temporary one if there
+        // is none), range 0 runs on the calling thread
+        t_scheduler *s = scheduler_current();
+        t_scheduler *own = NULL;
+        if (s == NULL && nb_threads > 1) s = own = scheduler_create(nb_threads);
+        t_task_group group;
+        task_group_init(&group);
+        for (int k = 1; k < nb_threads; k++) scheduler_spawn(s, &group, sim_worker_run, &workers[k]);
+        sim_worker_run(&workers[0]);
+        scheduler_wait(s, &group);
+        scheduler_destroy(own);
+    }
+
+    if (ok) {
+        result->size = n;
+        result->total_steps = (long long)config->nb_trajectories * config->nb_steps;
+        result->visit_freq = (double *)calloc(n, sizeof(double));
+        result->nb_hits = 0;
+        long long sum_hitting = 0;
+        if (!result->visit_freq) ok = 0;
+        for (int k = 0; ok && k < nb_threads; k++) {
+            for (int v = 0; v < n; v++) result->visit_freq[v] += (double)workers[k].visits[v];
+            result->nb_hits += workers[k].nb_hits;
+            sum_hitting += workers[k].sum_hitting;
+        }
+        if (ok && result->total_steps > 0) {
+            for (int v = 0; v < n; v++) result->visit_freq[v] /= (double)result->total_steps;
+        }
+        result->mean_hitting_time = result->nb_hits > 0 ? (double)sum_hitting / (double)result->nb_hits : -1.0;
+    }
+
+    for (int k = 0; k < nb_threads; k++) free(workers[k].visits);
+    free(workers);
+    return ok ? 0 : -1;
+}
+
+/**
+ * @brief Frees the arrays of a simulation result.
+ * @param result The result to free.
+ */
+void FreeSimResult(t_sim_result *result) {
+    if (result == NULL) return;
+    free(result->visit_freq);
+    result->visit_freq = NULL;
+}
@@ -0,0 +1,82 @@
+#ifndef SIMULATION_H
+#define SIMULATION_H
+
+#include <stdint.h>
+#include "../sparse/sparse.h"
+
+/**
+ * @brief Walker alias tables of every vertex of a graph.
+ *
+ * The outgoing edges of vertex i are slots row_start[i] .. row_start[i+1]-1.
+ * To sample a successor, pick a slot s uniformly, then keep col[s] with
+ * probability prob[s] or jump to col[alias[s]] otherwise: O(1) per step
+ * whatever the degree of the vertex.
+ */
+typedef struct s_alias_table {
+    int size;       // number of vertices
+    int *row_start; // size+1 offsets into prob / alias / col
+    int *col;       // 0-based destination of each slot
+    float *prob;    // probability of keeping the slot's own destination
+    int *alias;     // global index of the slot used otherwise
+} t_alias_table, *p_alias_table;
+
+/**
+ * @brief Parameters of a Monte Carlo run.
+ */
+typedef struct s_sim_config {
+    int nb_trajectories; // number of independent trajectories
+    int nb_steps;        // number of steps of each trajectory
+    int start;           // start vertex (1..n), 0 = uniformly random start
+    int target;          // vertex whose hitting time is measured (1..n), 0 = none
+    int nb_threads;      // number of worker threads (<= 0 means 1)
+    uint64_t seed;       // seed of the counter-based generators
+} t_sim_config;
+
+/**
+ * @brief Empirical results of a Monte Carlo run.
+ */
+typedef struct s_sim_result {
+    int size;                 // number of vertices
+    long long total_steps;    // number of simulated steps (all trajectories)
+    double *visit_freq;       // fraction of the steps spent in each vertex
+    long long nb_hits;        // trajectories that reached the target
+    double mean_hitting_time; // mean hitting time over those trajectories (-1 if none)
+} t_sim_result;
+
+/**
+ * @brief Builds the alias table of every vertex from a sparse matrix.
+ *
+ * The probabilities of each vertex are normalized by their sum, and a vertex
+ * without outgoing edge gets a self-loop (it becomes absorbing).
+ *
+ * @param S The sparse transition matrix.
+ * @return p_alias_table The alias tables, NULL on allocation error.
+ */
+p_alias_table CreateAliasTable(p_sparse_matrix S);
+
+/**
+ * @brief Frees the alias tables.
+ * @param A The alias tables to destroy.
+ */
+void DestroyAliasTable(p_alias_table A);
+
+/**
+ * @brief Simulates independent trajectories of the chain across several threads.
+ *
+ * Trajectory number t uses its own counter-based generator keyed by (seed, t),
+ * so the results only depend on the seed, not on the number of threads.
+ *
+ * @param A The alias tables of the chain.
+ * @param config Parameters of the run.
+ * @param result Output statistics (free with FreeSimResult).
+ * @return 0 on success, -1 on invalid argument or error.
+ */
+int SimulateTrajectories(p_alias_table A, const t_sim_config *config, t_sim_result *result);
+
+/**
+ * @brief Frees the arrays of a simulation result.
+ * @param result The result to free.
+ */
+void FreeSimResult(t_sim_result *result);
+
+#endif //SIMULATION_H
@@ -0,0 +1,216 @@
+#include "small_matrix.h"
+#include <string.h>
+
+// ask for the loops of the kernels to be unrolled completely (they have at
+// most SMALL_MATRIX_MAX iterations); other compilers unroll on their own
+#if defined(__GNUC__)
+#define SMALL_UNROLL _Pragma("GCC unroll 16")
+#else
+#define SMALL_UNROLL
+#endif
+
+typedef float (*t_small_rows)[SMALL_MATRIX_MAX];
+typedef const float (*t_small_const_rows)[SMALL_MATRIX_MAX];
+
+/**
+ * @brief Kernels of one size: product of two matrices and of a row vector by
+ *        a matrix, with N a constant.
+ *
+ * The product runs i, k, j with a row of accumulators: every R[i][j] is
+ * still summed from k = 0 to N - 1, as in MultiplyMatrices(), while the j
+ * loop becomes straight vector code. The vector product keeps the skip of
+ * the zero entries of pi, as in StationaryVectorFromGuess().
+ */
+#define SMALL_KERNELS(N)                                                                                    \
+    static void small_multiply_##N(t_small_const_rows restrict A, t_small_const_rows restrict B,            \
+                                   t_small_rows restrict R) {                                               \
+        for (int i = 0; i < N; i++) {                                                                       \
+            float acc[N];                                                                                   \
+            SMALL_UNROLL                                                                                    \
+            for (int j = 0; j < N; j++) acc[j] = 0.0f;                                                      \
+            SMALL_UNROLL                                                                                    \
+            for (int k = 0; k < N; k++) {                                                                   \
+                float a = A[i][k];                                                                          \
+                SMALL_UNROLL                                                                                \
+                for (int j = 0; j < N; j++) acc[j] += a * B[k][j];                                          \
+            }                                                                                               \
+            SMALL_UNROLL                                                                                    \
+            for (int j = 0; j < N; j++) R[i][j] = acc[j];                                                   \
+        }                                                                                                   \
+    }                                                                                                       \
+    static void small_vector_##N(const float *restrict pi, t_small_const_rows restrict S, float *restrict pi2) { \
+        SMALL_UNROLL                                                                                        \
+        for (int j = 0; j < N; j++) pi2[j] = 0.0f;                                                          \
+        for (int k = 0; k < N; k++) {                                                                       \
+            float pik = pi[k];                                                                              \
+            if (pik == 0.0f) continue;                                                                      \
+            SMALL_UNROLL                                                                                    \
+            for (int j = 0; j < N; j++) pi2[j] += pik * S[k][j];                                            \
+        }                                                                                                   \
+    }
+
+SMALL_KERNELS(1)
+SMALL_KERNELS(2)
+SMALL_KERNELS(3)
+SMALL_KERNELS(4)
+SMALL_KERNELS(5)
+SMALL_KERNELS(6)
+SMALL_KERNELS(7)
+SMALL_KERNELS(8)
+SMALL_KERNELS(9)
+SMALL_KERNELS(10)
+SMALL_KERNELS(11)
+SMALL_KERNELS(12)
+SMALL_KERNELS(13)
+SMALL_KERNELS(14)
+SMALL_KERNELS(15)
+SMALL_KERNELS(16)
+
+/**
+ * @brief The kernels of one size.
+ */
+typedef struct s_small_kernels {
+    void (*multiply)(t_small_const_rows, t_small_const_rows, t_small_rows);
+    void (*vector)(const float *, t_small_const_rows, float *);
+} t_small_kernels;
+
+#define SMALL_ENTRY(N) { small_multiply_##N, small_vector_##N }
+
+// indexed by size; entry 0 is unused
+static const t_small_kernels small_kernels[SMALL_MATRIX_MAX + 1] = {
+    { NULL, NULL },
+    SMALL_ENTRY(1), SMALL_ENTRY(2), SMALL_ENTRY(3), SMALL_ENTRY(4),
+    SMALL_ENTRY(5), SMALL_ENTRY(6), SMALL_ENTRY(7), SMALL_ENTRY(8),
+    SMALL_ENTRY(9), SMALL_ENTRY(10), SMALL_ENTRY(11), SMALL_ENTRY(12),
+    SMALL_ENTRY(13), SMALL_ENTRY(14), SMALL_ENTRY(15), SMALL_ENTRY(16)
+};
+
+/**
+ * @brief Copies a matrix of at most SMALL_MATRIX_MAX rows.
+ * @param S Destination.
+ * @param M Source.
+ */
+void SmallMatrixLoad(t_small_matrix *S, p_matrix M) {
+    S->size = M->size;
+    for (int i = 0; i < M->size; i++) memcpy(S->data[i], M->data[i], M->size * sizeof(float));
+}
+
+/**
+ * @brief Copies a small matrix into an allocated matrix of the same size.
+ * @param M Destination.
+ * @param S Source.
+ */
+void SmallMatrixStore(p_matrix M, const t_small_matrix *S) {
+    for (int i = 0; i < S->size; i++) memcpy(M->data[i], S->data[i], S->size * sizeof(float));
+}
+
+/**
+ * @brief R = A * B.
+ * @param A The first matrix.
+ * @param B The second matrix.
+ * @param R Output.
+ */
+void SmallMatrixMultiply(const t_small_matrix *A, const t_small_matrix *B, t_small_matrix *R) {
+    R->size = A->size;
+    if (A->size <= 0) return;
+    small_kernels[A->size].multiply(A->data, B->data, R->data);
+}
+
+/**
+ * @brief Sum of absolute differences.
+ * @param M The first matrix.
+ * @param N The second matrix.
+ * @return float The difference.
+ */
+float SmallMatrixDiff(const t_small_matrix *M, const t_small_matrix *N) {
+    float sum = 0.0f;
+    for (int i = 0; i < M->size; i++) {
+        for (int j = 0; j < M->size; j++) {
+            float diff = M->data[i][j] - N->data[i][j];
+            sum += diff < 0.0f ? -diff : diff;
+        }
+    }
+    return sum;
+}
+
+/**
+ * @brief R = M^power by repeated squaring.
+ * @param M The matrix.
+ * @param power The exponent.
+ * @param R Output.
+ */
+void SmallMatrixPower(const t_small_matrix *M, int power, t_small_matrix *R) {
+    int n = M->size;
+    t_small_matrix base = *M, tmp;
+    R->size = n;
+    for (int i = 0; i < n; i++) {
+        for (int j = 0; j < n; j++) R->data[i][j] = i == j ? 1.0f : 0.0f;
+    }
+    // same products as MatrixPower(): result *= base for every bit set in power
+    while (power > 0) {
+        if (power & 1) {
+            SmallMatrixMultiply(R, &base, &tmp);
+            *R = tmp;
+        }
+        power >>= 1;
+        if (power > 0) {
+            SmallMatrixMultiply(&base, &base, &tmp);
+            base = tmp;
+        }
+    }
+}
+
+/**
+ * @brief Period of a class from the diagonals of M^1 .. M^n.
+ * @param M The matrix of the class.
+ * @return int The period.
+ */
+int SmallMatrixPeriod(const t_small_matrix *M) {
+    int n = M->size;
+    int periods[SMALL_MATRIX_MAX];
+    int period_count = 0;
+    t_small_matrix power[2];
+    power[0] = *M;
+    for (int cpt = 1, cur = 0; cpt <= n; cpt++, cur ^= 1) {
+        // a return path of length cpt exists if M^cpt has a positive diagonal entry
+        for (int i = 0; i < n; i++) {
+            if (power[cur].data[i][i] > 0.0f) {
+                periods[period_count++] = cpt;
+                break;
+            }
+        }
+        if (cpt < n) SmallMatrixMultiply(&power[cur], M, &power[cur ^ 1]);
+    }
+    return gcd(periods, period_count);
+}
+
+/**
+ * @brief Power method on a small matrix.
+ * @param S The matrix.
+ * @param pi In: start vector; out: stationary vector.
+ * @param max_iter Maximum number of iterations.
+ * @param eps Convergence threshold.
+ * @return int Number of iterations done, -1 without convergence.
+ */
+int SmallStationaryVector(const t_small_matrix *S, float *pi, int max_iter, float eps) {
+    int n = S->size;
+    float pi2[SMALL_MATRIX_MAX];
+    int it = 0;
+    while (it < max_iter) {
+        it++;
+        small_kernels[n].vector(pi, S->data, pi2);
+
+        // normalization and L1 test of StationaryVectorFromGuess()
+        float sum = 0.0f;
+        for (int j = 0; j < n; ++j) { if (pi2[j] < 0.0f) pi2[j] = 0.0f; sum += pi2[j]; }
+        if (sum > 0.0f) for (int j = 0; j < n; ++j) pi2[j] /= sum;
+        float diff = 0.0f;
+        for (int j = 0; j < n; ++j) {
+            float d = pi2[j] - pi[j];
+            diff += d < 0 ? -d : d;
+        }
+        memcpy(pi, pi2, n * sizeof(float));
+        if (diff < eps) return it;
+    }
+    return -1;
+}
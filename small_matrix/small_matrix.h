@@ -0,0 +1,80 @@
+#ifndef SMALL_MATRIX_H
+#define SMALL_MATRIX_H
+
+#include "../matrix/matrix.h"
+
+// largest chain handled by the fixed-size kernels
+#define SMALL_MATRIX_MAX 16
+
+/**
+ * @brief Square matrix of at most SMALL_MATRIX_MAX rows, stored in place
+ *        (one contiguous block, no allocation: it lives on the stack).
+ *
+ * Only the first size rows and columns are meaningful. The kernels are
+ * generated once per size with the size as a compile-time constant, so the
+ * compiler unrolls and vectorizes their loops; the functions below pick the
+ * kernel of M->size. They do the floating point operations of the generic
+ * functions of matrix.c in the same order and give the same results.
+ */
+typedef struct s_small_matrix {
+    int size;
+    float data[SMALL_MATRIX_MAX][SMALL_MATRIX_MAX];
+} t_small_matrix;
+
+/**
+ * @brief Copies a matrix of at most SMALL_MATRIX_MAX rows.
+ * @param S Destination.
+ * @param M Source (M->size <= SMALL_MATRIX_MAX).
+ */
+void SmallMatrixLoad(t_small_matrix *S, p_matrix M);
+
+/**
+ * @brief Copies a small matrix into an allocated matrix of the same size.
+ * @param M Destination.
+ * @param S Source.
+ */
+void SmallMatrixStore(p_matrix M, const t_small_matrix *S);
+
+/**
+ * @brief R = A * B (R must not be A or B).
+ * @param A The first matrix.
+ * @param B The second matrix (same size).
+ * @param R Output.
+ */
+void SmallMatrixMultiply(const t_small_matrix *A, const t_small_matrix *B, t_small_matrix *R);
+
+/**
+ * @brief Sum of absolute differences, as DiffMatrix().
+ * @param M The first matrix.
+ * @param N The second matrix (same size).
+ * @return float The difference.
+ */
+float SmallMatrixDiff(const t_small_matrix *M, const t_small_matrix *N);
+
+/**
+ * @brief R = M^power by repeated squaring, as MatrixPower().
+ * @param M The matrix.
+ * @param power The exponent (>= 0).
+ * @param R Output (must not be M).
+ */
+void SmallMatrixPower(const t_small_matrix *M, int power, t_small_matrix *R);
+
+/**
+ * @brief Period of a class from the diagonals of M^1 .. M^n, as getPeriod().
+ * @param M The matrix of the class.
+ * @return int The period, 0 for an empty matrix.
+ */
+int SmallMatrixPeriod(const t_small_matrix *M);
+
+/**
+ * @brief Power method of StationaryVectorFromGuess() on a small matrix.
+ * @param S The matrix.
+ * @param pi In: the normalized start vector; out: the stationary vector.
+ * @param max_iter Maximum number of iterations.
+ * @param eps Convergence threshold (L1).
+ * @return int Number of iterations done, -1 if eps was not reached within
+ *         max_iter iterations (pi then holds the last iterate).
+ */
+int SmallStationaryVector(const t_small_matrix *S, float *pi, int max_iter, float eps);
+
+#endif //SMALL_MATRIX_H
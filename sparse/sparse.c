@@ -0,0 +1,537 @@
+#include "sparse.h"
+#include "../cell/cell.h"
+#include "../profiling/profiling.h"
+#include "../small_matrix/small_matrix.h"
+#include <stdlib.h>
+#include <string.h>
+
+/**
+ * @brief Builds a CSR matrix from a graph adjacency list.
+ *
+ * Two passes over the lists: the first one counts the valid edges of each
+ * vertex (to get the row offsets), the second one fills the arrays.
+ *
+ * @param graph The source adjacency list.
+ * @return p_sparse_matrix The new sparse matrix, NULL on allocation error.
+ */
+p_sparse_matrix CreateSparseFromAdjList(t_adjacency_list graph) {
+    int n = graph.size;
+    if (n <= 0) return NULL;
+
+    p_sparse_matrix S = (p_sparse_matrix)malloc(sizeof(t_sparse_matrix));
+    if (!S) return NULL;
+    S->size = n;
+    S->row_start = (int *)malloc((n + 1) * sizeof(int));
+    if (!S->row_start) {
+        free(S);
+        return NULL;
+    }
+
+    // first pass: count the valid outgoing edges of each vertex
+    S->row_start[0] = 0;
+    for (int i = 0; i < n; i++) {
+        int count = 0;
+        for (t_cell *c = graph.array[i].head; c != NULL; c = c->next) {
+            if (c->arrival >= 1 && c->arrival <= n) count++;
+        }
+        S->row_start[i + 1] = S->row_start[i] + count;
+    }
+    S->nb_edges = S->row_start[n];
+
+    // allocate at least one slot so an edgeless graph still gives valid pointers
+    int cap = S->nb_edges > 0 ? S->nb_edges : 1;
+    S->col = (int *)malloc(cap * sizeof(int));
+    S->val = (float *)malloc(cap * sizeof(float));
+    if (!S->col || !S->val) {
+        DestroySparseMatrix(S);
+        return NULL;
+    }
+
+    // second pass: copy destination and probability of each edge
+    for (int i = 0; i < n; i++) {
+        int e = S->row_start[i];
+        for (t_cell *c = graph.array[i].head; c != NULL; c = c->next) {
+            if (c->arrival < 1 || c->arrival > n) continue;
+            S->col[e] = c->arrival - 1; // 0-based index of the destination
+            S->val[e] = c->probability;
+            e++;
+        }
+    }
+    return S;
+}
+
+/**
+ * @brief Builds a CSR matrix from the non-zero entries of a dense matrix.
+ * @param M The dense matrix.
+ * @return p_sparse_matrix The new sparse matrix, NULL on allocation error.
+ */
+p_sparse_matrix CreateSparseFromMatrix(p_matrix M) {
+    if (M == NULL || M->size <= 0) return NULL;
+    int n = M->size;
+
+    p_sparse_matrix S = (p_sparse_matrix)malloc(sizeof(t_sparse_matrix));
+    if (!S) return NULL;
+    S->size = n;
+    S->col = NULL;
+    S->val = NULL;
+    S->row_start = (int *)malloc((n + 1) * sizeof(int));
+    if (!S->row_start) {
+        free(S);
+        return NULL;
+    }
+
+    // count the non-zero entries of each row
+    S->row_start[0] = 0;
+    for (int i = 0; i < n; i++) {
+        int count = 0;
+        for (int j = 0; j < n; j++) {
+            if (M->data[i][j] != 0.0f) count++;
+        }
+        S->row_start[i + 1] = S->row_start[i] + count;
+    }
+    S->nb_edges = S->row_start[n];
+
+    int cap = S->nb_edges > 0 ? S->nb_edges : 1;
+    S->col = (int *)malloc(cap * sizeof(int));
+    S->val = (float *)malloc(cap * sizeof(float));
+    if (!S->col || !S->val) {
+        DestroySparseMatrix(S);
+        return NULL;
+    }
+
+    int e = 0;
+    for (int i = 0; i < n; i++) {
+        for (int j = 0; j < n; j++) {
+            if (M->data[i][j] == 0.0f) continue;
+            S->col[e] = j;
+            S->val[e] = M->data[i][j];
+            e++;
+        }
+    }
+    return S;
+}
+
+/**
+ * @brief Keeps the last transition of each (row, column) pair.
+ *
+ * A row is scanned backwards: the first time a column is met is its last
+ * occurrence, the earlier ones are dropped. last[] remembers the row where a
+ * column was last met, so it never needs to be cleared.
+ *
+ * @param S The sparse matrix.
+ * @return int 0 on success, -1 on error.
+ */
+int SparseRemoveDuplicates(p_sparse_matrix S) {
+    if (S == NULL) return -1;
+    int n = S->size;
+    int *last = (int *)malloc(n * sizeof(int));
+    char *keep = (char *)malloc(S->nb_edges > 0 ? S->nb_edges : 1);
+    if (!last || !keep) {
+        free(last);
+        free(keep);
+        return -1;
+    }
+    for (int j = 0; j < n; j++) last[j] = -1;
+
+    int out = 0;
+    for (int i = 0; i < n; i++) {
+        int begin = S->row_start[i], end = S->row_start[i + 1];
+        for (int e = end - 1; e >= begin; e--) {
+            keep[e] = last[S->col[e]] != i;
+            last[S->col[e]] = i;
+        }
+        // compact the row, in its original order
+        S->row_start[i] = out;
+        for (int e = begin; e < end; e++) {
+            if (!keep[e]) continue;
+            S->col[out] = S->col[e];
+            S->val[out] = S->val[e];
+            out++;
+        }
+    }
+    S->row_start[n] = out;
+    S->nb_edges = out;
+    free(last);
+    free(keep);
+    return 0;
+}
+
+/**
+ * @brief Frees all memory associated with a sparse matrix.
+ * @param S The sparse matrix to destroy.
+ */
+void DestroySparseMatrix(p_sparse_matrix S) {
+    if (S == NULL) return;
+    free(S->row_start);
+    free(S->col);
+    free(S->val);
+    free(S);
+}
+
+/**
+ * @brief Allocates a zero-filled row-major block of k distributions.
+ * @param n Number of vertices.
+ * @param k Number of distribution vectors.
+ * @return float* The block, NULL on error.
+ */
+float *CreateDistributionBlock(int n, int k) {
+    if (n <= 0 || k <= 0) return NULL;
+    return (float *)calloc((size_t)n * (size_t)k, sizeof(float));
+}
+
+/**
+ * @brief One step of the chain for k distributions at once: out = in * S.
+ *
+ * For each transition i -> j with probability p, the k values of vertex i
+ * are scaled by p and added to the k values of vertex j. The inner loop runs
+ * over contiguous memory with no dependency between iterations, so the
+ * compiler can turn it into SIMD instructions.
+ *
+ * @param S The sparse transition matrix.
+ * @param in Input block (row-major, S->size x k).
+ * @param out Output block (row-major, S->size x k), must not alias in.
+ * @param k Number of distribution vectors.
+ */
+void PropagateBlock(p_sparse_matrix S, const float *in, float *out, int k) {
+    int n = S->size;
+    memset(out, 0, (size_t)n * (size_t)k * sizeof(float));
+
+    // single vector: plain scalar loop
+    if (k == 1) {
+        for (int i = 0; i < n; i++) {
+            float x = in[i];
+            if (x == 0.0f) continue;
+            for (int e = S->row_start[i]; e < S->row_start[i + 1]; e++) {
+                out[S->col[e]] += x * S->val[e];
+            }
+        }
+        return;
+    }
+
+    for (int i = 0; i < n; i++) {
+        const float *restrict src = in + (size_t)i * k; // the k values of vertex i
+        for (int e = S->row_start[i]; e < S->row_start[i + 1]; e++) {
+            float p = S->val[e];
+            float *restrict dst = out + (size_t)S->col[e] * k; // the k values of vertex j
+            for (int b = 0; b < k; b++) {
+                dst[b] += p * src[b];
+            }
+        }
+    }
+}
+
+/**
+ * @brief Evolves a block of k distributions for a number of steps (in place).
+ * @param S The sparse transition matrix.
+ * @param block Row-major block of k distributions, overwritten with the result.
+ * @param k Number of distribution vectors.
+ * @param steps Number of steps.
+ * @return int 0 on success, -1 on error.
+ */
+int EvolveBlock(p_sparse_matrix S, float *block, int k, int steps) {
+    if (!S || !block || k <= 0 || steps < 0) return -1;
+    if (steps == 0) return 0;
+
+    size_t count = (size_t)S->size * (size_t)k;
+    float *tmp = (float *)malloc(count * sizeof(float));
+    if (!tmp) return -1;
+
+    // ping-pong between the two buffers to avoid a copy at every step
+    float *cur = block;
+    float *next = tmp;
+    for (int s = 0; s < steps; s++) {
+        PropagateBlock(S, cur, next, k);
+        float *swap = cur;
+        cur = next;
+        next = swap;
+    }
+
+    // after an odd number of steps the result lives in tmp
+    if (cur != block) memcpy(block, cur, count * sizeof(float));
+    free(tmp);
+    return 0;
+}
+
+/**
+ * @brief Position of every vertex in the vertex list of its class.
+ * @param partition The classes.
+ * @param n Number of vertices.
+ * @return int* The positions (-1 outside the classes), NULL on error.
+ */
+int *CreateClassPositions(const t_partition *partition, int n) {
+    if (partition == NULL || n <= 0) return NULL;
+    int *position = (int *)malloc(n * sizeof(int));
+    if (!position) return NULL;
+    for (int v = 0; v < n; v++) position[v] = -1;
+    for (int c = 0; c < partition->nb_class; c++) {
+        const t_class *cls = partition->classes[c];
+        for (int k = 0; k < cls->nb_vertices; k++) {
+            int v = cls->vertices[k] - 1;
+            if (v >= 0 && v < n) position[v] = k;
+        }
+    }
+    return position;
+}
+
+/**
+ * @brief View of the submatrix of a class (a range view if it is contiguous).
+ * @param S The matrix of the whole graph.
+ * @param cls The class.
+ * @param position Positions of the vertices in their class.
+ * @return t_sparse_view The view.
+ */
+t_sparse_view SparseClassView(const t_sparse_matrix *S, const t_class *cls, const int *position) {
+    t_sparse_view V = { S, cls->nb_vertices, cls->vertices, position, 0 };
+    int k = 1;
+    while (k < cls->nb_vertices && cls->vertices[k] == cls->vertices[0] + k) k++;
+    if (cls->nb_vertices > 0 && k == cls->nb_vertices) return SparseRangeView(S, cls->vertices[0] - 1, cls->nb_vertices);
+    return V;
+}
+
+/**
+ * @brief View of the submatrix of a range of vertices.
+ * @param S The matrix.
+ * @param first First vertex (0-based).
+ * @param size Number of vertices.
+ * @return t_sparse_view The view.
+ */
+t_sparse_view SparseRangeView(const t_sparse_matrix *S, int first, int size) {
+    t_sparse_view V = { S, size, NULL, NULL, first };
+    return V;
+}
+
+/**
+ * @brief Vertex behind row i of a view.
+ * @param V The view.
+ * @param i Row.
+ * @return int The vertex (0-based).
+ */
+int SparseViewVertex(const t_sparse_view *V, int i) {
+    return V->vertices ? V->vertices[i] - 1 : V->first + i;
+}
+
+/**
+ * @brief Column of a vertex in a view.
+ * @param V The view.
+ * @param vertex Vertex (0-based).
+ * @return int The column, -1 outside the view.
+ */
+int SparseViewColumn(const t_sparse_view *V, int vertex) {
+    if (V->vertices == NULL) {
+        int j = vertex - V->first;
+        return j >= 0 && j < V->size ? j : -1;
+    }
+    // the position is only valid if the vertex belongs to this class
+    int j = V->position[vertex];
+    return j >= 0 && j < V->size && V->vertices[j] == vertex + 1 ? j : -1;
+}
+
+/**
+ * @brief Greatest common divisor of two non-negative integers.
+ */
+static int gcd2(int a, int b) {
+    while (b != 0) {
+        int t = a % b;
+        a = b;
+        b = t;
+    }
+    return a;
+}
+
+/**
+ * @brief Period of a class from its view, by breadth-first levels.
+ *
+ * In a strongly connected graph every cycle length is a multiple of the
+ * period, and the period divides level(u) + 1 - level(v) for every edge
+ * u -> v; the gcd of these differences is therefore the period.
+ *
+ * @param V The view of a class.
+ * @return int The period, 0 without inner transition.
+ */
+int GetPeriodFromView(const t_sparse_view *V) {
+    if (V == NULL || V->size <= 0) return 0;
+    int n = V->size;
+    int *level = (int *)malloc(n * sizeof(int));
+    int *queue = (int *)malloc(n * sizeof(int));
+    if (!level || !queue) {
+        free(level);
+        free(queue);
+        return 0;
+    }
+    PROF_BEGIN(PROF_STAGE_PERIOD);
+    for (int i = 0; i < n; i++) level[i] = -1;
+
+    const t_sparse_matrix *S = V->S;
+    int period = 0, head = 0, tail = 0;
+    level[0] = 0;
+    queue[tail++] = 0;
+    while (head < tail) {
+        int i = queue[head++];
+        int u = SparseViewVertex(V, i);
+        for (int e = S->row_start[u]; e < S->row_start[u + 1]; e++) {
+            int j = SparseViewColumn(V, S->col[e]);
+            if (j < 0 || !(S->val[e] > 0.0f)) continue;
+            if (level[j] < 0) {
+                level[j] = level[i] + 1;
+                queue[tail++] = j;
+            } else {
+                int d = level[i] + 1 - level[j];
+                period = gcd2(period, d < 0 ? -d : d);
+            }
+        }
+    }
+
+    free(level);
+    free(queue);
+    PROF_END(PROF_STAGE_PERIOD);
+    return period;
+}
+
+/**
+ * @brief Copies a view of at most SMALL_MATRIX_MAX rows into a small matrix,
+ *        with the lazy weights of StationaryVectorFromView() applied.
+ */
+static void small_matrix_from_view(t_small_matrix *M, const t_sparse_view *V, int lazy) {
+    const t_sparse_matrix *S = V->S;
+    const float alpha = LAZY_WALK_WEIGHT;
+    int n = V->size;
+    M->size = n;
+    for (int k = 0; k < n; k++) {
+        for (int j = 0; j < n; j++) M->data[k][j] = 0.0f;
+        int u = SparseViewVertex(V, k);
+        int loop = 0;
+        for (int e = S->row_start[u]; e < S->row_start[u + 1]; e++) {
+            int j = SparseViewColumn(V, S->col[e]);
+            if (j < 0) continue;
+            float p = S->val[e];
+            if (lazy) {
+                p = alpha * p + (1.0f - alpha) * (j == k ? 1.0f : 0.0f);
+                loop |= j == k;
+            }
+            M->data[k][j] += p;
+        }
+        if (lazy && !loop) M->data[k][k] = alpha * 0.0f + (1.0f - alpha) * 1.0f;
+    }
+}
+
+/**
+ * @brief Power method on a view.
+ *
+ * Row k is scattered into pi2 for k = 0 .. n-1, so every pi2[j] receives its
+ * terms pi[k] * S[k][j] in increasing k, as in the dense product, and the
+ * lazy weights are computed as MixMatrices() does. Only the transitions of
+ * the class are read: O(transitions) per iteration instead of O(n^2).
+ * A class of at most SMALL_MATRIX_MAX vertices is copied once into a stack
+ * matrix and solved by the unrolled kernel of its size: the terms come in
+ * the same order (a zero entry adds nothing), so the result is the same.
+ *
+ * @param V The view of a class.
+ * @param guess Initial vector, NULL for uniform.
+ * @param lazy 1 to solve the lazy walk.
+ * @param max_iter Maximum number of iterations.
+ * @param eps Convergence threshold.
+ * @param iterations Output: number of iterations done (may be NULL).
+ * @return float* The stationary vector, NULL on error or without convergence.
+ */
+float *StationaryVectorFromView(const t_sparse_view *V, const float *guess, int lazy, int max_iter, float eps, int *iterations) {
+    if (iterations) *iterations = 0;
+    if (!V || V->size <= 0 || max_iter <= 0 || eps <= 0.0f) return NULL;
+    int n = V->size;
+
+    if (n == 1) {
+        float *pi = (float *)malloc(sizeof(float));
+        if (!pi) return NULL;
+        pi[0] = 1.0f;
+        return pi;
+    }
+
+    // a small class is iterated on the stack, without pi2
+    int small = n <= SMALL_MATRIX_MAX;
+    float *pi = (float *)malloc(n * sizeof(float));
+    float *pi2 = small ? NULL : (float *)malloc(n * sizeof(float));
+    if (!pi || (!small && !pi2)) {
+        free(pi);
+        free(pi2);
+        return NULL;
+    }
+    PROF_COUNT(PROF_ALLOCATIONS, small ? 1 : 2);
+    PROF_BEGIN(PROF_STAGE_STATIONARY);
+
+    // the guess (clamped and normalized), uniform without a usable guess
+    float start_sum = 0.0f;
+    for (int j = 0; guess && j < n; ++j) {
+        pi[j] = guess[j] > 0.0f ? guess[j] : 0.0f;
+        start_sum += pi[j];
+    }
+    if (start_sum > 0.0f) {
+        for (int j = 0; j < n; ++j) pi[j] /= start_sum;
+    } else {
+        for (int j = 0; j < n; ++j) pi[j] = 1.0f / (float)n;
+    }
+
+    if (small) {
+        t_small_matrix M;
+        small_matrix_from_view(&M, V, lazy);
+        int it = SmallStationaryVector(&M, pi, max_iter, eps);
+        PROF_COUNT(PROF_ITERATIONS, it < 0 ? max_iter : it);
+        if (iterations) *iterations = it < 0 ? max_iter : it;
+        PROF_END(PROF_STAGE_STATIONARY);
+        if (it < 0) {
+            free(pi);
+            return NULL;
+        }
+        return pi;
+    }
+
+    const t_sparse_matrix *S = V->S;
+    const float alpha = LAZY_WALK_WEIGHT;
+    int converged = 0;
+    for (int it = 0; it < max_iter && !converged; ++it) {
+        PROF_COUNT(PROF_ITERATIONS, 1);
+        if (iterations) *iterations = it + 1;
+
+        // pi2 = pi * S (or pi * (alpha S + (1 - alpha) I))
+        for (int j = 0; j < n; ++j) pi2[j] = 0.0f;
+        for (int k = 0; k < n; ++k) {
+            float pik = pi[k];
+            if (pik == 0.0f) continue;
+            int u = SparseViewVertex(V, k);
+            int loop = 0;
+            for (int e = S->row_start[u]; e < S->row_start[u + 1]; e++) {
+                int j = SparseViewColumn(V, S->col[e]);
+                if (j < 0) continue;
+                float p = S->val[e];
+                if (lazy) {
+                    p = alpha * p + (1.0f - alpha) * (j == k ? 1.0f : 0.0f);
+                    loop |= j == k;
+                }
+                pi2[j] += pik * p;
+            }
+            if (lazy && !loop) pi2[k] += pik * (alpha * 0.0f + (1.0f - alpha) * 1.0f);
+        }
+
+        // normalization
+        float sum = 0.0f;
+        for (int j = 0; j < n; ++j) { if (pi2[j] < 0.0f) pi2[j] = 0.0f; sum += pi2[j]; }
+        if (sum > 0.0f) for (int j = 0; j < n; ++j) pi2[j] /= sum;
+
+        // L1 convergence test
+        float diff = 0.0f;
+        for (int j = 0; j < n; ++j) {
+            float d = pi2[j] - pi[j];
+            if (d < 0) d = -d;
+            diff += d;
+        }
+        for (int j = 0; j < n; ++j) pi[j] = pi2[j];
+        converged = diff < eps;
+    }
+
+    free(pi2);
+    PROF_END(PROF_STAGE_STATIONARY);
+    if (!converged) {
+        // the last iterate would look like a valid result
+        free(pi);
+        return NULL;
+    }
+    return pi;
+}
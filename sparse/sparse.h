@@ -0,0 +1,191 @@
+#ifndef SPARSE_H
+#define SPARSE_H
+
+#include "../adjacency_list/adjacency_list.h"
+#include "../matrix/matrix.h"
+
+/**
+ * @brief Transition matrix stored in compressed sparse row (CSR) form.
+ *
+ * The outgoing edges of vertex i are stored contiguously in
+ * col[row_start[i] .. row_start[i+1]-1] and val[...], so a full pass over
+ * the matrix streams three flat arrays instead of walking the t_cell lists.
+ */
+typedef struct s_sparse_matrix {
+    int size;       // number of vertices (rows)
+    int nb_edges;   // number of stored transitions
+    int *row_start; // size+1 offsets into col / val
+    int *col;       // 0-based destination vertex of each transition
+    float *val;     // probability of each transition
+} t_sparse_matrix, *p_sparse_matrix;
+
+/**
+ * @brief Builds a CSR matrix from a graph adjacency list.
+ *
+ * Edges whose arrival vertex is outside 1..graph.size are skipped.
+ *
+ * @param graph The source adjacency list.
+ * @return p_sparse_matrix The new sparse matrix, NULL on allocation error.
+ */
+p_sparse_matrix CreateSparseFromAdjList(t_adjacency_list graph);
+
+/**
+ * @brief Builds a CSR matrix from the non-zero entries of a dense matrix.
+ *
+ * @param M The dense matrix (e.g. a class submatrix).
+ * @return p_sparse_matrix The new sparse matrix, NULL on allocation error.
+ */
+p_sparse_matrix CreateSparseFromMatrix(p_matrix M);
+
+/**
+ * @brief Keeps one transition per (row, column): the last one of the row,
+ *        which is the value CreateMatFromAdjList() stores for an edge given
+ *        more than once. The rows are compacted in place.
+ *
+ * @param S The sparse matrix.
+ * @return int 0 on success, -1 on allocation error (S is left unchanged).
+ */
+int SparseRemoveDuplicates(p_sparse_matrix S);
+
+/**
+ * @brief Frees all memory associated with a sparse matrix.
+ * @param S The sparse matrix to destroy.
+ */
+void DestroySparseMatrix(p_sparse_matrix S);
+
+/**
+ * @brief Allocates a block of k distribution vectors, filled with 0.
+ *
+ * The block is stored row-major: entry (vertex v, vector b) is at
+ * block[v * k + b], so the k values of one vertex are contiguous.
+ *
+ * @param n Number of vertices.
+ * @param k Number of distribution vectors.
+ * @return float* The zero-filled block, NULL on error.
+ */
+float *CreateDistributionBlock(int n, int k);
+
+/**
+ * @brief Propagates k distributions through one step of the chain: out = in * S.
+ *
+ * Every transition is read once and applied to the k vectors at the same
+ * time, so the matrix is streamed once per step instead of once per vector.
+ *
+ * @param S The sparse transition matrix.
+ * @param in Block of k input distributions (row-major, S->size x k).
+ * @param out Block of k output distributions (row-major, S->size x k), must not alias in.
+ * @param k Number of distribution vectors.
+ */
+void PropagateBlock(p_sparse_matrix S, const float *in, float *out, int k);
+
+/**
+ * @brief Evolves a block of k distributions for a given number of steps (in place).
+ *
+ * @param S The sparse transition matrix.
+ * @param block Block of k distributions (row-major), overwritten with Pi_0 * S^steps.
+ * @param k Number of distribution vectors.
+ * @param steps Number of steps to apply.
+ * @return int 0 on success, -1 on invalid argument or allocation error.
+ */
+int EvolveBlock(p_sparse_matrix S, float *block, int k, int steps);
+
+// weight of the chain in the lazy walk alpha * S + (1 - alpha) * I
+#define LAZY_WALK_WEIGHT 0.5f
+
+/**
+ * @brief Read-only view of the submatrix of one class inside a CSR matrix
+ *        shared by all the classes: the rows of the class are read in place
+ *        and the transitions leaving the class are skipped, nothing is copied.
+ *
+ * Row and column i of the view are vertex i of the class. A class view finds
+ * the column of an arrival through position[] (see CreateClassPositions());
+ * a range view covers the vertices first .. first + size - 1 and needs no
+ * lookup (classes made contiguous by reorder_graph()). Duplicate transitions
+ * add up, as in the other CSR kernels; SparseRemoveDuplicates() gives the
+ * values of the dense class matrix.
+ */
+typedef struct s_sparse_view {
+    const t_sparse_matrix *S; // matrix of the whole graph
+    int size;                 // number of vertices of the class
+    const int *vertices;      // vertices of the class (1-based), NULL for a range view
+    const int *position;      // position of every vertex in its class (class views)
+    int first;                // first vertex (0-based) of a range view
+} t_sparse_view;
+
+/**
+ * @brief Position of every vertex in the vertex list of its class.
+ *
+ * @param partition The classes.
+ * @param n Number of vertices of the graph.
+ * @return int* Array of n positions (-1 for a vertex in no class), NULL on error.
+ */
+int *CreateClassPositions(const t_partition *partition, int n);
+
+/**
+ * @brief View of the submatrix of a class. A class whose vertices are
+ *        consecutive and increasing gets a range view.
+ *
+ * @param S The matrix of the whole graph.
+ * @param cls The class.
+ * @param position Positions from CreateClassPositions() for the partition of cls.
+ * @return t_sparse_view The view (it points into S, cls and position).
+ */
+t_sparse_view SparseClassView(const t_sparse_matrix *S, const t_class *cls, const int *position);
+
+/**
+ * @brief View of the submatrix of the vertices first .. first + size - 1.
+ *
+ * @param S The matrix.
+ * @param first First vertex (0-based).
+ * @param size Number of vertices.
+ * @return t_sparse_view The view.
+ */
+t_sparse_view SparseRangeView(const t_sparse_matrix *S, int first, int size);
+
+/**
+ * @brief Vertex of the matrix behind row i of a view.
+ *
+ * @param V The view.
+ * @param i Row of the view.
+ * @return int The vertex (0-based).
+ */
+int SparseViewVertex(const t_sparse_view *V, int i);
+
+/**
+ * @brief Column of a vertex in a view.
+ *
+ * @param V The view.
+ * @param vertex Vertex of the matrix (0-based).
+ * @return int The column, -1 if the vertex is not in the view.
+ */
+int SparseViewColumn(const t_sparse_view *V, int vertex);
+
+/**
+ * @brief Period of a class from its view, by breadth-first levels: the gcd
+ *        of level(u) + 1 - level(v) over the transitions u -> v of the class.
+ *        O(size + transitions) instead of the O(n^4) of getPeriod().
+ *
+ * @param V The view of a class (strongly connected; transitions with a
+ *        probability <= 0 are ignored, as in getPeriod()).
+ * @return int The period, 0 if the class has no inner transition (as getPeriod()).
+ */
+int GetPeriodFromView(const t_sparse_view *V);
+
+/**
+ * @brief StationaryVectorFromGuess() on a view, optionally on its lazy walk,
+ *        without building the class matrix. Each entry gets its terms in the
+ *        same order as the dense product, so the result is the same.
+ *
+ * @param V The view of a class.
+ * @param guess Initial vector of V->size entries, NULL for uniform.
+ * @param lazy 1 to solve LAZY_WALK_WEIGHT * S + (1 - LAZY_WALK_WEIGHT) * I.
+ * @param max_iter The maximum number of iterations.
+ * @param eps The convergence threshold.
+ * @param iterations Output: number of iterations done (may be NULL).
+ * @return float* The stationary vector (to free), NULL on error or if eps
+ *         was not reached within max_iter iterations (*iterations is then
+ *         max_iter).
+ */
+float *StationaryVectorFromView(const t_sparse_view *V, const float *guess, int lazy, int max_iter, float eps, int *iterations);
+
+#endif //SPARSE_H
@@ -0,0 +1,320 @@
+#include "spectral.h"
+#include "../sparse/sparse.h"
+#include <math.h>
+#include <stdlib.h>
+#include <string.h>
+
+// maximum dimension of the Krylov subspace
+#define ARNOLDI_MAX_DIM 30
+// number of repeated squarings used to get the spectral radius of H
+#define GELFAND_SQUARINGS 30
+// iteration caps returned by SuggestIterationCap
+#define MIN_ITERATIONS 10
+#define MAX_ITERATIONS 1000000
+
+/**
+ * @brief Left action of a CSR matrix: out = x * S (double precision).
+ */
+static void left_multiply(p_sparse_matrix S, const double *x, double *out) {
+    memset(out, 0, S->size * sizeof(double));
+    for (int i = 0; i < S->size; i++) {
+        if (x[i] == 0.0) continue;
+        for (int e = S->row_start[i]; e < S->row_start[i + 1]; e++) {
+            out[S->col[e]] += x[i] * S->val[e];
+        }
+    }
+}
+
+/**
+ * @brief Removes the mean of a vector so that its entries sum to 0.
+ */
+static void remove_mean(double *x, int n) {
+    double mean = 0.0;
+    for (int i = 0; i < n; i++) mean += x[i];
+    mean /= n;
+    for (int i = 0; i < n; i++) x[i] -= mean;
+}
+
+static double dot(const double *a, const double *b, int n) {
+    double s = 0.0;
+    for (int i = 0; i < n; i++) s += a[i] * b[i];
+    return s;
+}
+
+/**
+ * @brief Spectral radius of a small dense m x m matrix by Gelfand's formula.
+ *
+ * rho(H) = lim ||H^k||^(1/k); H is squared repeatedly (k = 2^s) and
+ * renormalized at each step, the scale being accumulated in log form.
+ */
+static double spectral_radius(const double *H, int m) {
+    double *A = (double *)malloc(m * m * sizeof(double));
+    double *B = (double *)malloc(m * m * sizeof(double));
+    if (!A || !B) {
+        free(A); free(B);
+        return -1.0;
+    }
+    memcpy(A, H, m * m * sizeof(double));
+
+    double log_scale = 0.0; // log of ||H^(2^s)|| accumulated so far
+    double power = 1.0;     // 2^s
+    for (int s = 0; s <= GELFAND_SQUARINGS; s++) {
+        double norm = 0.0;
+        for (int i = 0; i < m * m; i++) {
+            double a = fabs(A[i]);
+            if (a > norm) norm = a;
+        }
+        if (norm == 0.0) { // nilpotent: every eigenvalue is 0
+            free(A); free(B);
+            return 0.0;
+        }
+        for (int i = 0; i < m * m; i++) A[i] /= norm;
+        log_scale += log(norm);
+        if (s == GELFAND_SQUARINGS) break;
+
+        // B = A * A
+        for (int i = 0; i < m; i++) {
+            for (int j = 0; j < m; j++) {
+                double sum = 0.0;
+                for (int k = 0; k < m; k++) sum += A[i * m + k] * A[k * m + j];
+                B[i * m + j] = sum;
+            }
+        }
+        double *swap = A;
+        A = B;
+        B = swap;
+        log_scale *= 2.0;
+        power *= 2.0;
+    }
+
+    free(A);
+    free(B);
+    return exp(log_scale / power);
+}
+
+/**
+ * @brief Left action x -> x * S of the matrix whose SLEM is estimated: a
+ *        CSR matrix or a class view, possibly as its lazy walk.
+ */
+typedef struct s_left_action {
+    p_sparse_matrix csr;          // CSR matrix, or NULL for the view
+    const t_sparse_view *view;
+    int lazy;                     // view only: alpha * S + (1 - alpha) * I
+} t_left_action;
+
+/**
+ * @brief Entry of a view as seen by the estimator (lazy weight applied as MixMatrices() does).
+ */
+static float view_entry(const t_left_action *A, float p, int i, int j) {
+    if (!A->lazy) return p;
+    return LAZY_WALK_WEIGHT * p + (1.0f - LAZY_WALK_WEIGHT) * (i == j ? 1.0f : 0.0f);
+}
+
+/**
+ * @brief Left action of a view: out = x * S, terms in increasing row order.
+ */
+static void view_left_multiply(const t_left_action *A, const double *x, double *out) {
+    const t_sparse_view *V = A->view;
+    memset(out, 0, V->size * sizeof(double));
+    for (int i = 0; i < V->size; i++) {
+        if (x[i] == 0.0) continue;
+        int u = SparseViewVertex(V, i), loop = 0;
+        for (int e = V->S->row_start[u]; e < V->S->row_start[u + 1]; e++) {
+            int j = SparseViewColumn(V, V->S->col[e]);
+            if (j < 0) continue;
+            out[j] += x[i] * view_entry(A, V->S->val[e], i, j);
+            loop |= j == i;
+        }
+        if (A->lazy && !loop) out[i] += x[i] * view_entry(A, 0.0f, i, i);
+    }
+}
+
+static void apply_left(const t_left_action *A, const double *x, double *out) {
+    if (A->csr) left_multiply(A->csr, x, out);
+    else view_left_multiply(A, x, out);
+}
+
+/**
+ * @brief Arnoldi estimate of the SLEM (see EstimateSLEM()).
+ * @param A The left action.
+ * @param n Dimension.
+ * @param stochastic 1 if the rows sum to 1 (the eigenvalue 1 is deflated).
+ */
+static float estimate_slem(const t_left_action *A, int n, int stochastic) {
+    if (stochastic && n == 1) return 0.0f;
+
+    int m = stochastic ? n - 1 : n;
+    if (m > ARNOLDI_MAX_DIM) m = ARNOLDI_MAX_DIM;
+
+    double *V = (double *)malloc((size_t)(m + 1) * n * sizeof(double)); // orthonormal basis
+    double *H = (double *)calloc((size_t)(m + 1) * m, sizeof(double));  // Hessenberg matrix
+    double *w = (double *)malloc(n * sizeof(double));
+    if (!V || !H || !w) {
+        free(V); free(H); free(w);
+        return -1.0f;
+    }
+
+    // deterministic pseudo-random start vector
+    unsigned int seed = 12345u;
+    for (int i = 0; i < n; i++) {
+        seed = seed * 1103515245u + 12345u;
+        V[i] = (double)(seed >> 8) / 16777216.0 - 0.5;
+    }
+    if (stochastic) remove_mean(V, n);
+    double norm = sqrt(dot(V, V, n));
+    for (int i = 0; i < n; i++) V[i] /= norm;
+
+    int dim = m;
+    for (int j = 0; j < m; j++) {
+        double *vj = V + (size_t)j * n;
+        apply_left(A, vj, w);
+        if (stochastic) remove_mean(w, n); // keep rounding errors out of the stationary direction
+
+        // modified Gram-Schmidt, done twice for stability
+        for (int pass = 0; pass < 2; pass++) {
+            for (int i = 0; i <= j; i++) {
+                double h = dot(w, V + (size_t)i * n, n);
+                H[i * m + j] += h;
+                for (int x = 0; x < n; x++) w[x] -= h * V[(size_t)i * n + x];
+            }
+        }
+
+        double h = sqrt(dot(w, w, n));
+        H[(j + 1) * m + j] = h;
+        if (h < 1e-10) { // invariant subspace found
+            dim = j + 1;
+            break;
+        }
+        for (int x = 0; x < n; x++) V[(size_t)(j + 1) * n + x] = w[x] / h;
+    }
+
+    // copy the leading dim x dim block of H
+    double *Hd = (double *)malloc((size_t)dim * dim * sizeof(double));
+    double rho = -1.0;
+    if (Hd) {
+        for (int i = 0; i < dim; i++)
+            for (int j = 0; j < dim; j++) Hd[i * dim + j] = H[i * m + j];
+        rho = spectral_radius(Hd, dim);
+        free(Hd);
+    }
+
+    free(V);
+    free(H);
+    free(w);
+
+    if (rho < 0.0) return -1.0f;
+    if (rho > 1.0) rho = 1.0; // Ritz values can overshoot slightly
+    return (float)rho;
+}
+
+/**
+ * @brief Estimates the SLEM of a class submatrix with Arnoldi.
+ * @param S The submatrix of a class.
+ * @return float The estimate in [0, 1], or -1 on error.
+ */
+float EstimateSLEM(p_matrix S) {
+    if (S == NULL || S->size <= 0) return -1.0f;
+    int n = S->size;
+
+    // deflate the eigenvalue 1 only if the matrix is stochastic
+    int stochastic = 1;
+    for (int i = 0; i < n && stochastic; i++) {
+        double sum = 0.0;
+        for (int j = 0; j < n; j++) sum += S->data[i][j];
+        if (fabs(sum - 1.0) > 1e-3) stochastic = 0;
+    }
+    if (stochastic && n == 1) return 0.0f;
+
+    p_sparse_matrix CSR = CreateSparseFromMatrix(S);
+    if (!CSR) return -1.0f;
+    t_left_action A = { CSR, NULL, 0 };
+    float slem = estimate_slem(&A, n, stochastic);
+    DestroySparseMatrix(CSR);
+    return slem;
+}
+
+/**
+ * @brief EstimateSLEM() on a class view, without building its matrix.
+ * @param V The view of a class.
+ * @param lazy 1 for its lazy walk.
+ * @return float The estimate in [0, 1], or -1 on error.
+ */
+float EstimateSLEMFromView(const t_sparse_view *V, int lazy) {
+    if (V == NULL || V->size <= 0) return -1.0f;
+    t_left_action A = { NULL, V, lazy };
+
+    // row sums over the transitions that stay in the class
+    int stochastic = 1;
+    for (int i = 0; i < V->size && stochastic; i++) {
+        int u = SparseViewVertex(V, i), loop = 0;
+        double sum = 0.0;
+        for (int e = V->S->row_start[u]; e < V->S->row_start[u + 1]; e++) {
+            int j = SparseViewColumn(V, V->S->col[e]);
+            if (j < 0) continue;
+            sum += view_entry(&A, V->S->val[e], i, j);
+            loop |= j == i;
+        }
+        if (lazy && !loop) sum += view_entry(&A, 0.0f, i, i);
+        if (fabs(sum - 1.0) > 1e-3) stochastic = 0;
+    }
+    return estimate_slem(&A, V->size, stochastic);
+}
+
+/**
+ * @brief Mixing time bound from the spectral gap.
+ * @param slem Second largest eigenvalue modulus.
+ * @param eps Distance to stationarity to reach.
+ * @param pi_min Smallest stationary probability.
+ * @return int The number of steps, -1 if the chain does not mix.
+ */
+int MixingTimeBound(float slem, float eps, float pi_min) {
+    if (slem < 0.0f || eps <= 0.0f || pi_min <= 0.0f) return -1;
+    double gap = 1.0 - (double)slem;
+    if (gap <= 1e-9) return -1;
+    double t = log(1.0 / ((double)eps * (double)pi_min)) / gap;
+    if (t < 0.0) t = 0.0;
+    if (t > (double)MAX_ITERATIONS) return MAX_ITERATIONS;
+    return (int)ceil(t);
+}
+
+/**
+ * @brief Iteration cap for a given SLEM estimate.
+ * @param slem SLEM estimate, -1 if unknown.
+ * @param eps Convergence threshold.
+ * @return int The iteration cap, -1 if periodic.
+ */
+int IterationCapFromSLEM(float slem, float eps) {
+    if (eps <= 0.0f) return MAX_ITERATIONS;
+    if (slem < 0.0f) return MAX_ITERATIONS; // estimation failed: be generous
+    if (slem >= 1.0f - 1e-6f) return -1;
+    if (slem <= 1e-6f) return MIN_ITERATIONS;
+
+    // slem^k < eps  <=>  k > log(eps) / log(slem); twice that as a margin
+    double k = 2.0 * log((double)eps) / log((double)slem);
+    if (k < MIN_ITERATIONS) return MIN_ITERATIONS;
+    if (k > MAX_ITERATIONS) return MAX_ITERATIONS;
+    return (int)ceil(k);
+}
+
+/**
+ * @brief Iteration cap of the power method from the estimated SLEM.
+ * @param S The matrix that will be solved.
+ * @param eps Convergence threshold.
+ * @return int The iteration cap, -1 if S is periodic.
+ */
+int SuggestIterationCap(p_matrix S, float eps) {
+    if (S == NULL || eps <= 0.0f) return MAX_ITERATIONS;
+    return IterationCapFromSLEM(EstimateSLEM(S), eps);
+}
+
+/**
+ * @brief SuggestIterationCap() on a class view.
+ * @param V The view of a class.
+ * @param lazy 1 if its lazy walk will be solved.
+ * @param eps Convergence threshold.
+ * @return int The iteration cap, -1 if the matrix solved is periodic.
+ */
+int SuggestIterationCapFromView(const t_sparse_view *V, int lazy, float eps) {
+    if (V == NULL || eps <= 0.0f) return MAX_ITERATIONS;
+    return IterationCapFromSLEM(EstimateSLEMFromView(V, lazy), eps);
+}
@@ -0,0 +1,76 @@
+#ifndef SPECTRAL_H
+#define SPECTRAL_H
+
+#include "../matrix/matrix.h"
+#include "../sparse/sparse.h"
+
+/**
+ * @brief Estimates the second largest eigenvalue modulus (SLEM) of a class submatrix.
+ *
+ * Runs an Arnoldi iteration with the left action x -> x * S restricted to the
+ * vectors whose entries sum to 0. When S is stochastic this subspace is
+ * invariant and does not contain the stationary direction, so the spectral
+ * radius of the Arnoldi Hessenberg matrix approximates the SLEM. When the
+ * rows of S sum to less than 1 (transient class), nothing is deflated and the
+ * estimate is the spectral radius of S, i.e. the decay rate of the mass.
+ *
+ * @param S The submatrix of a class.
+ * @return float The estimate in [0, 1], or -1 on error.
+ */
+float EstimateSLEM(p_matrix S);
+
+/**
+ * @brief Upper bound on the mixing time derived from the spectral gap.
+ *
+ * t_mix(eps) <= log(1 / (eps * pi_min)) / (1 - slem). The bound is exact for
+ * reversible chains and a good order of magnitude for the others.
+ *
+ * @param slem Second largest eigenvalue modulus.
+ * @param eps Distance to stationarity to reach.
+ * @param pi_min Smallest stationary probability (use 1/n if unknown).
+ * @return int The number of steps, -1 if the chain does not mix (slem >= 1).
+ */
+int MixingTimeBound(float slem, float eps, float pi_min);
+
+/**
+ * @brief Number of power iterations needed for the stationary solver.
+ *
+ * The error of the power method shrinks like slem^k, so about
+ * log(eps) / log(slem) iterations reach eps; a safety margin is added.
+ *
+ * @param S The matrix that will be solved.
+ * @param eps Convergence threshold of the solver.
+ * @return int The iteration cap, -1 if S has another eigenvalue of modulus 1
+ *         (periodic class: the lazy walk must be used instead).
+ */
+int SuggestIterationCap(p_matrix S, float eps);
+
+/**
+ * @brief Iteration cap of SuggestIterationCap() for an SLEM already estimated.
+ *
+ * @param slem SLEM estimate of the matrix that will be solved (-1 if unknown).
+ * @param eps Convergence threshold of the solver.
+ * @return int The iteration cap, -1 if slem is 1 (periodic).
+ */
+int IterationCapFromSLEM(float slem, float eps);
+
+/**
+ * @brief EstimateSLEM() on the view of a class, without building its matrix.
+ *
+ * @param V The view of a class.
+ * @param lazy 1 for its lazy walk (see StationaryVectorFromView()).
+ * @return float The estimate in [0, 1], or -1 on error.
+ */
+float EstimateSLEMFromView(const t_sparse_view *V, int lazy);
+
+/**
+ * @brief SuggestIterationCap() on the view of a class.
+ *
+ * @param V The view of a class.
+ * @param lazy 1 if its lazy walk will be solved.
+ * @param eps Convergence threshold of the solver.
+ * @return int The iteration cap, -1 if the matrix solved is periodic.
+ */
+int SuggestIterationCapFromView(const t_sparse_view *V, int lazy, float eps);
+
+#endif //SPECTRAL_H
@@ -0,0 +1,17 @@
+#include "status.h"
+
+/**
+ * @brief Describes a status code.
+ * @param status A t_markov_status value
+ * @return Static string describing the status
+ */
+const char *markov_strerror(int status) {
+    switch (status) {
+        case MARKOV_OK: return "success";
+        case MARKOV_ERR_ALLOC: return "memory allocation failed";
+        case MARKOV_ERR_IO: return "input/output error";
+        case MARKOV_ERR_FORMAT: return "malformed graph file";
+        case MARKOV_ERR_ARG: return "invalid argument";
+        default: return "unknown error";
+    }
+}
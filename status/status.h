@@ -0,0 +1,25 @@
+#ifndef STATUS_H
+#define STATUS_H
+
+/**
+ * @brief Status codes returned by the library functions.
+ *
+ * 0 is success and every error is negative, so the functions that already
+ * return -1 on error stay compatible (-1 is the allocation failure).
+ */
+typedef enum e_markov_status {
+    MARKOV_OK = 0,
+    MARKOV_ERR_ALLOC = -1,  // memory allocation failed
+    MARKOV_ERR_IO = -2,     // file could not be opened, read or written
+    MARKOV_ERR_FORMAT = -3, // malformed graph file
+    MARKOV_ERR_ARG = -4     // invalid argument
+} t_markov_status;
+
+/**
+ * @brief Describes a status code.
+ * @param status A t_markov_status value
+ * @return Static string describing the status
+ */
+const char *markov_strerror(int status);
+
+#endif //STATUS_H
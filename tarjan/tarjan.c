@@ -1,6 +1,7 @@
 #include "tarjan.h"
 #include "../cell/cell.h"
 #include "../utils/utils.h"
+#include "../profiling/profiling.h"
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
@@ -9,16 +10,14 @@
  * @brief Allocates and initializes an array of Tarjan vertices.
  *
  * @param n The number of vertices to allocate.
- * @return t_tarjan_vertex* Pointer to the allocated array.
+ * @return t_tarjan_vertex* Pointer to the allocated array, NULL on allocation error.
  */
 t_tarjan_vertex * CreateArr (int n) {
     // allocate an array of n Tarjan vertices.
     // each element will store the state of one vertex during Tarjan's algorithm.
     t_tarjan_vertex * array = malloc (n * sizeof (t_tarjan_vertex));
-    if (!array) {
-        printf("Allocation failed\n");
-        exit (EXIT_FAILURE);
-    }
+    PROF_COUNT(PROF_ALLOCATIONS, 1);
+    if (!array) return NULL;
     // initialize each Tarjan vertex with default values
     for (int i=0; i<n; i++) {
         array[i].id = i+1; // identifier: vertex number in the graph (1..n)
@@ -33,20 +32,17 @@ t_tarjan_vertex * CreateArr (int n) {
  * @brief Creates a new class structure with a specified name.
  *
  * @param name_of_class The name to assign to the class.
- * @return p_class Pointer to the newly created class.
+ * @return p_class Pointer to the newly created class, NULL on allocation error.
  */
 p_class CreateClass (const char * name_of_class) {
     p_class c = malloc(sizeof(t_class));
-    if (!c) {
-        printf("Allocation of class failed\n");
-        exit (EXIT_FAILURE);
-    }
+    if (!c) return NULL;
     strcpy(c->name, name_of_class);
     c->vertices = malloc (4 * sizeof (int));
+    PROF_COUNT(PROF_ALLOCATIONS, 2);
     if (!c ->vertices) {
         free(c);
-        printf("Allocation of vertices failed\n");
-        exit(EXIT_FAILURE);
+        return NULL;
     }
     c->nb_vertices = 0;
     c->size = 4;
@@ -59,37 +55,34 @@ p_class CreateClass (const char * name_of_class) {
  *
  * @param c The class to which the vertex is added.
  * @param vertex_id The ID of the vertex.
+ * @return 0 on success, -1 on error (the class is left unchanged).
  */
-void AddVertexToClass (p_class c, int vertex_id) {
-    if (!c) return;
+int AddVertexToClass (p_class c, int vertex_id) {
+    if (!c) return -1;
     if (c->nb_vertices >= c->size) {
-        c->size *=2;
-        int *temp = realloc(c->vertices, c->size * sizeof(int));
-        if (!temp) {
-            printf("Reallocation failed\n");
-            exit(EXIT_FAILURE);
-        }
+        int *temp = realloc(c->vertices, 2 * c->size * sizeof(int));
+        PROF_COUNT(PROF_ALLOCATIONS, 1);
+        if (!temp) return -1;
         c->vertices = temp;
+        c->size *= 2;
     }
     c->vertices[c->nb_vertices++] = vertex_id;
+    return 0;
 }
 
 /**
  * @brief Creates a new partition structure to hold a collection of classes.
  *
- * @return t_partition* Pointer to the newly created partition.
+ * @return t_partition* Pointer to the newly created partition, NULL on allocation error.
  */
 t_partition *CreatePartition() {
     t_partition *p = malloc(sizeof(t_partition));
-    if (!p) {
-        printf("Allocation of partition failed\n");
-        exit (EXIT_FAILURE);
-    }
+    if (!p) return NULL;
     p->classes = malloc (4 * sizeof(t_class*));
+    PROF_COUNT(PROF_ALLOCATIONS, 2);
     if (!p->classes) {
         free(p);
-        printf("Allocation of classes array failed\n");
-        exit(EXIT_FAILURE);
+        return NULL;
     }
     p->nb_class = 0;
     p->size = 4;
@@ -101,19 +94,44 @@ t_partition *CreatePartition() {
  *
  * @param p The partition to modify.
  * @param c The class to add to the partition.
+ * @return 0 on success, -1 on error (the partition is left unchanged).
  */
-void AddClassToPartition (p_partition p, p_class c) {
-    if (!p || !c) return;
+int AddClassToPartition (p_partition p, p_class c) {
+    if (!p || !c) return -1;
     if (p->nb_class >= p->size) {
-        p->size *= 2;
-        t_class **temp = realloc(p->classes, p->size * sizeof(t_class*));
-        if (!temp) {
-            printf("Reallocation failed\n");
-            exit(EXIT_FAILURE);
-        }
+        t_class **temp = realloc(p->classes, 2 * p->size * sizeof(t_class*));
+        PROF_COUNT(PROF_ALLOCATIONS, 1);
+        if (!temp) return -1;
         p->classes = temp;
+        p->size *= 2;
     }
     p->classes[p->nb_class++] = c;
+    return 0;
+}
+
+/**
+ * @brief Frees a class and its vertex array.
+ *
+ * @param c The class to destroy.
+ */
+void DestroyClass (p_class c) {
+    if (!c) return;
+    free(c->vertices);
+    free(c);
+}
+
+/**
+ * @brief Frees a partition, its classes and their vertex arrays.
+ *
+ * @param p The partition to destroy.
+ */
+void DestroyPartition (p_partition p) {
+    if (!p) return;
+    for (int i = 0; i < p->nb_class; i++) {
+        DestroyClass(p->classes[i]);
+    }
+    free(p->classes);
+    free(p);
 }
 
 
@@ -128,13 +146,14 @@ void AddClassToPartition (p_partition p, p_class c) {
  * @param stack The stack used for the algorithm.
  * @param partition The partition where classes will be stored.
  * @param index Pointer to the global traversal index.
+ * @return 0 on success, -1 on allocation error.
  */
 //most important function of tarjan (it will allow to go from the matrix with some adjancencies to some classes (which tarjan will use to return a partition(so a group of classes)
 //so parcours is the function that will test all the possible path to see if they are forming classes (are doing a cicle (1->3->5->1))
-void Parcours (int currvertex, t_adjacency_list graph, p_tarjan_vertex Ver, t_stack *stack, p_partition partition, int *index) {
+int Parcours (int currvertex, t_adjacency_list graph, p_tarjan_vertex Ver, t_stack *stack, p_partition partition, int *index) {
 
     // if no tarjan_vertex OR no stack OR no partition OR no index --> return
-    if (Ver == NULL  || stack == NULL || partition == NULL || index == NULL) return;
+    if (Ver == NULL  || stack == NULL || partition == NULL || index == NULL) return -1;
 
     //we initialize the current class number (so the order of visit at 1)
     Ver[currvertex].class_nb = *index;
@@ -143,7 +162,7 @@ void Parcours (int currvertex, t_adjacency_list graph, p_tarjan_vertex Ver, t_st
     //we increment the index to go to the next vertex
     (*index)++;
     //we push the current element in the stack since its currently processing (in the stack)
-    push(stack,currvertex);
+    if (push(stack,currvertex) != 0) return -1;
     //put the current vertex in stack so we put the in_stack to 1.
     Ver[currvertex].in_stack=1; // Mark v as being in the stack
     //we get from the adjacency list all the neighbors of the current vertex
@@ -152,9 +171,15 @@ void Parcours (int currvertex, t_adjacency_list graph, p_tarjan_vertex Ver, t_st
     //we explore all the neighborgs of the current vortex (ALL)
     while (neigh != NULL) {
         int currentneigh = neigh->arrival -1;
+        PROF_COUNT(PROF_EDGES_SCANNED, 1);
+        //an arrival outside the graph is not a vertex: skip it
+        if (currentneigh < 0 || currentneigh >= graph.size) {
+            neigh = neigh->next;
+            continue;
+        }
         //case 1: the neighborgs is new so we recurcivly call parcours to cherche the neighborgs of the neighborg of vertex
         if (Ver[currentneigh].class_nb == -1) {
-            Parcours(currentneigh, graph, Ver, stack, partition, index);
+            if (Parcours(currentneigh, graph, Ver, stack, partition, index) != 0) return -1;
             //we check if the recursion manage to find a path to an ancestor if so than the current vertex have a path to an ancestor
             if (Ver[currentneigh].link_nb < Ver[currvertex].link_nb)
                 Ver[currvertex].link_nb = Ver[currentneigh].link_nb;
@@ -178,18 +203,26 @@ void Parcours (int currvertex, t_adjacency_list graph, p_tarjan_vertex Ver, t_st
         snprintf(name, sizeof(name), "C%d", partition->nb_class + 1);
         //create a name for the newclass
         p_class newclass = CreateClass(name);
+        if (!newclass) return -1;
 
         int w;
         //create name and building the class by popping the stack
         do {
             w = pop(stack); // Get top vertex from stack
             Ver[w].in_stack = 0; // Mark it as no longer in the stack
-            AddVertexToClass(newclass, Ver[w].id); // Add the vertex to the current class
+            if (AddVertexToClass(newclass, Ver[w].id) != 0) { // Add the vertex to the current class
+                DestroyClass(newclass);
+                return -1;
+            }
         } while (w != currvertex); // Stop when we have popped v
 
         //we add the newclass to the top
-        AddClassToPartition(partition, newclass); // Add the completed class to the partition of the graph
+        if (AddClassToPartition(partition, newclass) != 0) { // Add the completed class to the partition of the graph
+            DestroyClass(newclass);
+            return -1;
+        }
     }
+    return 0;
 }
 
 
@@ -199,31 +232,36 @@ void Parcours (int currvertex, t_adjacency_list graph, p_tarjan_vertex Ver, t_st
  * Initializes memory and iterates through all vertices to find Strongly Connected Components.
  *
  * @param graph The adjacency list representation of the graph.
- * @return p_partition A partition containing all identified classes (SCCs).
+ * @return p_partition A partition containing all identified classes (SCCs), NULL on allocation error.
  */
 //tarjan is the main function. it will use parcours to setup a partition (group of classes) and will do the allocation of memory etc.
 //its like a support for his sub-function parcours. but parcours is more important.
 p_partition tarjan (t_adjacency_list graph) {
+    PROF_BEGIN(PROF_STAGE_TARJAN);
     int n = graph.size; //get the size of the graph (of size n)
     p_tarjan_vertex Ver = CreateArr(n); //create the tarjan vertex array
     t_stack *Stack = CreateStack(); //create the stack for the parcours function
 
-    //check if the rceation worked
-    if (!Stack) {
+    //create the empty partition that will store the classes found in the parcours function
+    p_partition part = CreatePartition();
+
+    //check if the creation worked
+    if (!Ver || !Stack || !part) {
         free(Ver);
-        printf("Stack creation failed\n");
+        free(Stack);
+        DestroyPartition(part);
+        PROF_END(PROF_STAGE_TARJAN);
         return NULL;
     }
-
-    //create the empty partition that will store the classes found in the parcours function
-    p_partition part = CreatePartition();
     //the global index
     int index = 0;
 
     //the main algo, if the tarjan function (function that create the partition)
-    for (int i = 0; i < n; i++) {
-        if (Ver[i].class_nb == -1) {
-            Parcours(i, graph, Ver, Stack, part, &index);
+    for (int i = 0; i < n && part; i++) {
+        if (Ver[i].class_nb == -1 && Parcours(i, graph, Ver, Stack, part, &index) != 0) {
+            // out of memory: drop the partial partition
+            DestroyPartition(part);
+            part = NULL;
         }
     }
 
@@ -234,5 +272,6 @@ p_partition tarjan (t_adjacency_list graph) {
     }
     free(Stack);
 
+    PROF_END(PROF_STAGE_TARJAN);
     return part;
 }
\ No newline at end of file
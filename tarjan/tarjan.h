@@ -26,7 +26,7 @@ typedef struct s_tarjan_vertex {
 /**
  * @brief Allocates an array of Tarjan vertex states.
  * @param n The number of vertices to allocate.
- * @return Pointer to the allocated array.
+ * @return Pointer to the allocated array, NULL on allocation error.
  */
 t_tarjan_vertex * CreateArr (int n);
 
@@ -46,7 +46,7 @@ typedef struct s_class {
 /**
  * @brief Creates a new class instance.
  * @param name_of_class The label for the class.
- * @return Pointer to the new class.
+ * @return Pointer to the new class, NULL on allocation error.
  */
 t_class * CreateClass (const char * name_of_class);
 
@@ -54,8 +54,15 @@ t_class * CreateClass (const char * name_of_class);
  * @brief Adds a vertex to a specific class.
  * @param c The class to modify.
  * @param vertex_id The ID of the vertex to add.
+ * @return 0 on success, -1 on error.
  */
-void AddVertexToClass (p_class c, int vertex_id);
+int AddVertexToClass (p_class c, int vertex_id);
+
+/**
+ * @brief Frees a class and its vertex array.
+ * @param c The class to destroy.
+ */
+void DestroyClass (p_class c);
 
 /**
  * @brief Represents the result of the algorithm: a partition of the graph.
@@ -70,7 +77,7 @@ typedef struct s_partition {
 
 /**
  * @brief Creates a new empty partition.
- * @return Pointer to the new partition.
+ * @return Pointer to the new partition, NULL on allocation error.
  */
 t_partition *CreatePartition();
 
@@ -78,8 +85,15 @@ t_partition *CreatePartition();
  * @brief Adds a class to the partition.
  * @param p The partition to modify.
  * @param c The class to add.
+ * @return 0 on success, -1 on error.
+ */
+int AddClassToPartition (p_partition p, p_class c);
+
+/**
+ * @brief Frees a partition and all of its classes.
+ * @param p The partition to destroy.
  */
-void AddClassToPartition (p_partition p, p_class c);
+void DestroyPartition (p_partition p);
 
 /**
  * @brief Recursive DFS step (StrongConnect) for Tarjan's algorithm.
@@ -89,13 +103,14 @@ void AddClassToPartition (p_partition p, p_class c);
  * @param S The recursion stack.
  * @param part The partition to store results.
  * @param index Pointer to the global discovery index.
+ * @return 0 on success, -1 on allocation error.
  */
-void Parcours (int ver, t_adjacency_list graph, p_tarjan_vertex Ver, t_stack *S, p_partition part, int *index);
+int Parcours (int ver, t_adjacency_list graph, p_tarjan_vertex Ver, t_stack *S, p_partition part, int *index);
 
 /**
  * @brief Main entry point for computing Strongly Connected Components.
  * @param graph The graph to analyze.
- * @return A partition containing all found SCCs.
+ * @return A partition containing all found SCCs, NULL on allocation error.
  */
 p_partition tarjan (t_adjacency_list graph);
 
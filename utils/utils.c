@@ -1,3 +1,7 @@
+#include <ctype.h>
+#include <errno.h>
+#include <limits.h>
+#include <stdatomic.h>
 #include <stdio.h>
 #include <stdlib.h>
 
@@ -5,118 +9,490 @@
 #include "../adjacency_list/adjacency_list.h"
 #include "../hasse/hasse.h"
 #include "../tarjan/tarjan.h"
+#include "../spectral/spectral.h"
+#include "../profiling/profiling.h"
+#include "../status/status.h"
+#include "../analysis/analysis.h"
+#include "../report/report.h"
+#include "../export/export.h"
+#include "../validation/validation.h"
 
 
 /**
  * @brief Reads a graph from a file and creates its adjacency list
  * @param filename Path to the file containing graph data
- * @return Adjacency list representation of the graph
+ * @param graph Output adjacency list (left empty on error)
+ * @return MARKOV_OK, MARKOV_ERR_IO if the file cannot be opened,
+ *         MARKOV_ERR_FORMAT if it is malformed, MARKOV_ERR_ALLOC on allocation error
  * @note File format: first line = number of vertices,
  * following lines = "start end probability"
- * @note Exits program on file error
  */
-t_adjacency_list readGraph(const char *filename) {
+int loadGraph(const char *filename, t_adjacency_list *graph) {
+    if (filename == NULL || graph == NULL) return MARKOV_ERR_ARG;
+    graph->size = 0;
+    graph->array = NULL;
+
+    PROF_BEGIN(PROF_STAGE_READ_GRAPH);
     // open the file in text mode for reading ("rt")
     FILE *file = fopen(filename, "rt");
     if (!file) {
-        // if the file could not be opened, print an error message and stop the program
-        perror("Could not open file for reading");
-        exit(EXIT_FAILURE);
+        PROF_END(PROF_STAGE_READ_GRAPH);
+        return MARKOV_ERR_IO;
     }
 
     int nb_vertices, start, end;
     float proba;
     // read the number of vertices (first integer in the file) (fscanf sent 0 or 1)
-    if (fscanf(file, "%d", &nb_vertices) != 1) {
-        // if we cannot read it, print an error and exit
-        perror("Could not read number of vertices");
+    if (fscanf(file, "%d", &nb_vertices) != 1 || nb_vertices <= 0) {
         fclose(file);
-        exit(EXIT_FAILURE);
+        PROF_END(PROF_STAGE_READ_GRAPH);
+        return MARKOV_ERR_FORMAT;
     }
     // create an empty adjacency list with nb_vertices vertices
     t_adjacency_list *gp = empty_adjacency_list(nb_vertices);
+    if (gp == NULL) {
+        fclose(file);
+        PROF_END(PROF_STAGE_READ_GRAPH);
+        return MARKOV_ERR_ALLOC;
+    }
+    int status = MARKOV_OK;
     // read each line: start vertex, end vertex, and probability
     // Continue while fscanf successfully reads 3 values
     while (fscanf(file, "%d %d %f", &start, &end, &proba) == 3) {
+        // an edge leaving the graph would be written outside of the array
+        if (start < 1 || start > nb_vertices || end < 1 || end > nb_vertices) {
+            status = MARKOV_ERR_FORMAT;
+            break;
+        }
         // add an edge from 'start' to 'end' with probability 'proba'
         // we use start - 1 because array indices go from 0 to nb_vertices - 1
-        addCellToList(&gp->array[start - 1], end, proba);
+        if (addCellToList(&gp->array[start - 1], end, proba) != 0) {
+            status = MARKOV_ERR_ALLOC;
+            break;
+        }
+        PROF_COUNT(PROF_ALLOCATIONS, 1);
     }
 
+    PROF_COUNT(PROF_BYTES_READ, ftell(file));
     fclose(file);
-    t_adjacency_list g = *gp;
+    if (status != MARKOV_OK) {
+        free_adjacency_list(gp);
+    } else {
+        *graph = *gp;
+    }
     free(gp);
-    return g;
+    PROF_END(PROF_STAGE_READ_GRAPH);
+    return status;
 }
 
+// smallest piece of a file parsed by one task of loadGraphParallel()
+#define PARALLEL_LOAD_CHUNK (64 * 1024)
 
 /**
- * @brief Converts vertex index to alphabetic ID (1->A, 27->AA, etc.)
- * @param i Vertex index (1-based)
- * @return Static string containing the alphabetic ID
- * @note Uses rotating buffer to allow multiple calls in same expression
- * @warning Returned pointer is static and will be overwritten after 20 calls
+ * @brief File being read by loadGraphParallel(): the text, cut at blanks into
+ *        chunks, and the edges parsed from it.
  */
-static char *getID(int i)
-{
-    static char buffer[20][10];  // Array of buffers
-    static int idx = 0;
-    idx = (idx + 1) % 20;        // Rotate through them
+typedef struct s_parallel_load {
+    const char *text;
+    long long *bound;       // chunk k = text[bound[k], bound[k + 1])
+    long long *first_token; // number of tokens before chunk k
+    int nb_vertices;
+    int *start;             // edge k: start vertex (1-based)
+    int *end;               // edge k: end vertex (1-based)
+    float *proba;           // edge k: probability
+    int *row_start;         // edges of vertex u: row_edge[row_start[u] .. row_start[u + 1])
+    int *row_edge;          // edge numbers, in file order within a row
+    t_adjacency_list *graph;
+    atomic_int irregular;   // a token is not a plain number: use loadGraph()
+    atomic_int out_of_range;
+    atomic_int failed;      // allocation error
+} t_parallel_load;
 
-    char *result = buffer[idx];
-    char temp[10];
-    int index = 0;
+/**
+ * @brief Counts the blank-separated tokens of chunks [begin, end).
+ */
+static void count_tokens(void *ctx, int begin, int end) {
+    t_parallel_load *pl = (t_parallel_load *)ctx;
+    for (int k = begin; k < end; k++) {
+        long long count = 0;
+        for (long long i = pl->bound[k]; i < pl->bound[k + 1]; i++) {
+            // a chunk starts on a blank, so a token starts after one
+            if (!isspace((unsigned char)pl->text[i]) && isspace((unsigned char)pl->text[i - 1])) count++;
+        }
+        pl->first_token[k + 1] = count;
+    }
+}
 
-    i--;
-    while (i >= 0)
-    {
-        temp[index++] = 'A' + (i % 26);
-        i = (i / 26) - 1;
+/**
+ * @brief Parses the tokens of chunks [begin, end): token t is the start vertex,
+ *        end vertex or probability of edge t / 3, as fscanf("%d %d %f") reads them.
+ */
+static void parse_tokens(void *ctx, int begin, int end) {
+    t_parallel_load *pl = (t_parallel_load *)ctx;
+    for (int k = begin; k < end; k++) {
+        long long t = pl->first_token[k];
+        const char *p = pl->text + pl->bound[k];
+        const char *stop = pl->text + pl->bound[k + 1];
+        while (p < stop) {
+            while (p < stop && isspace((unsigned char)*p)) p++;
+            if (p >= stop) break;
+            char *after;
+            long long e = t / 3;
+            if (t % 3 == 2) {
+                pl->proba[e] = strtof(p, &after);
+            } else {
+                errno = 0;
+                long value = strtol(p, &after, 10);
+                if (errno == ERANGE || value < INT_MIN || value > INT_MAX) after = (char *)p;
+                if (value < 1 || value > pl->nb_vertices) atomic_store(&pl->out_of_range, 1);
+                if (t % 3 == 0) pl->start[e] = (int)value;
+                else pl->end[e] = (int)value;
+            }
+            // the whole token must be the number, as for fscanf
+            if (after == p || (after < stop && !isspace((unsigned char)*after))) {
+                atomic_store(&pl->irregular, 1);
+                return;
+            }
+            p = after;
+            t++;
+        }
     }
+}
 
-    for (int j = 0; j < index; j++)
-    {
-        result[j] = temp[index - j - 1];
+/**
+ * @brief Builds the lists of vertices [begin, end), each in the order of the
+ *        sequential loader (file order, each edge put in front of the list).
+ */
+static void build_rows(void *ctx, int begin, int end) {
+    t_parallel_load *pl = (t_parallel_load *)ctx;
+    for (int u = begin; u < end; u++) {
+        for (int i = pl->row_start[u]; i < pl->row_start[u + 1]; i++) {
+            int e = pl->row_edge[i];
+            if (addCellToList(&pl->graph->array[u], pl->end[e], pl->proba[e]) != 0) {
+                atomic_store(&pl->failed, 1);
+                return;
+            }
+        }
     }
-    result[index] = '\0';
+}
 
-    return result;
+/**
+ * @brief Reads a whole file in memory.
+ * @return The text, NUL-terminated and preceded by a blank (free with free), NULL on error
+ */
+static char *read_whole_file(const char *filename, long long *length, int *status) {
+    FILE *file = fopen(filename, "rb");
+    if (!file) {
+        *status = MARKOV_ERR_IO;
+        return NULL;
+    }
+    long long size = -1;
+    if (fseek(file, 0, SEEK_END) == 0) size = ftell(file);
+    if (size < 0 || fseek(file, 0, SEEK_SET) != 0) {
+        fclose(file);
+        *status = MARKOV_ERR_IO;
+        return NULL;
+    }
+    char *text = (char *)malloc((size_t)size + 2);
+    if (text == NULL) {
+        fclose(file);
+        *status = MARKOV_ERR_ALLOC;
+        return NULL;
+    }
+    // the leading blank lets every token be found by the blank before it
+    text[0] = ' ';
+    size_t got = fread(text + 1, 1, (size_t)size, file);
+    fclose(file);
+    text[got + 1] = '\0';
+    *length = (long long)got + 1;
+    *status = MARKOV_OK;
+    return text;
 }
-//
+
 /**
- * @brief Checks if the graph satisfies Markov chain properties
- * @param list Adjacency list to check
- * @note Verifies that outgoing probabilities from each vertex sum to 1.0
- * @note Tolerance: ±0.01 for floating-point comparison
+ * @brief Reads a graph file with the tasks of a scheduler.
+ *
+ * The file is read at once and cut at blanks into chunks: the tokens of each
+ * chunk are counted, then parsed, in parallel; then the lists are built by
+ * ranges of start vertices. The graph is the one loadGraph() builds, with
+ * the lists in the same order. Files that are not a plain list of
+ * "start end probability" numbers (trailing text, incomplete last edge, ...)
+ * are handed to loadGraph(), which knows where to stop.
+ *
+ * @param filename Path to the file containing graph data
+ * @param graph Output adjacency list (left empty on error)
+ * @param s Scheduler (NULL or one thread = loadGraph())
+ * @return MARKOV_OK, MARKOV_ERR_IO, MARKOV_ERR_FORMAT or MARKOV_ERR_ALLOC
  */
-void checkIfMarkov(t_adjacency_list list) {
-    int is_markov = 1; // it indicates if the graph satisfies the Markov property
+int loadGraphParallel(const char *filename, t_adjacency_list *graph, t_scheduler *s) {
+    if (filename == NULL || graph == NULL) return MARKOV_ERR_ARG;
+    if (scheduler_nb_threads(s) <= 1) return loadGraph(filename, graph);
+    graph->size = 0;
+    graph->array = NULL;
+
+    PROF_BEGIN(PROF_STAGE_READ_GRAPH);
+    long long length = 0;
+    int status;
+    char *text = read_whole_file(filename, &length, &status);
+    if (text == NULL) {
+        PROF_END(PROF_STAGE_READ_GRAPH);
+        return status;
+    }
+    PROF_COUNT(PROF_BYTES_READ, length - 1);
+
+    t_parallel_load pl = { 0 };
+    pl.text = text;
+    atomic_init(&pl.irregular, 0);
+    atomic_init(&pl.out_of_range, 0);
+    atomic_init(&pl.failed, 0);
+
+    // the vertex count, as fscanf("%d") reads it
+    char *p = text;
+    errno = 0;
+    long header = strtol(p, &p, 10);
+    int regular = p != text && (*p == '\0' || isspace((unsigned char)*p)) && errno != ERANGE && header <= INT_MAX;
+    if (regular && header <= 0) status = MARKOV_ERR_FORMAT;
+    pl.nb_vertices = (int)header;
+
+    // chunks of at least PARALLEL_LOAD_CHUNK bytes, a few per thread
+    long long body = p - text;
+    int nb_chunks = 4 * scheduler_nb_threads(s);
+    if ((length - body) / PARALLEL_LOAD_CHUNK < nb_chunks) nb_chunks = (int)((length - body) / PARALLEL_LOAD_CHUNK) + 1;
+    if (regular && status == MARKOV_OK) {
+        pl.bound = (long long *)malloc((nb_chunks + 1) * sizeof(long long));
+        pl.first_token = (long long *)calloc(nb_chunks + 1, sizeof(long long));
+        if (!pl.bound || !pl.first_token) status = MARKOV_ERR_ALLOC;
+    }
+    if (regular && status == MARKOV_OK) {
+        // move each cut forward to a blank, so that no token is split
+        pl.bound[0] = body;
+        for (int k = 1; k < nb_chunks; k++) {
+            long long cut = body + (length - body) * k / nb_chunks;
+            if (cut < pl.bound[k - 1]) cut = pl.bound[k - 1];
+            while (cut < length && !isspace((unsigned char)text[cut])) cut++;
+            pl.bound[k] = cut;
+        }
+        pl.bound[nb_chunks] = length;
 
-    // loop through each vertex in the graph
-    for (int i = 0; i < list.size; i++) {
-        float total_proba = 0;
-        t_cell *curr = list.array[i].head;
+        scheduler_parallel_for(s, 0, nb_chunks, 1, count_tokens, &pl);
+        for (int k = 0; k < nb_chunks; k++) pl.first_token[k + 1] += pl.first_token[k];
+        long long nb_tokens = pl.first_token[nb_chunks];
+        // an incomplete last edge: loadGraph() decides
+        if (nb_tokens % 3 != 0 || nb_tokens / 3 > INT_MAX) regular = 0;
+    }
 
-        // sum all probabilities for the current vertex
-        while (curr != NULL) {
-            total_proba += curr->probability;
-            curr = curr->next;
-        }
+    long long nb_edges = regular ? pl.first_token[nb_chunks] / 3 : 0;
+    if (regular && status == MARKOV_OK) {
+        size_t m = (size_t)(nb_edges > 0 ? nb_edges : 1);
+        pl.start = (int *)malloc(m * sizeof(int));
+        pl.end = (int *)malloc(m * sizeof(int));
+        pl.proba = (float *)malloc(m * sizeof(float));
+        if (!pl.start || !pl.end || !pl.proba) status = MARKOV_ERR_ALLOC;
+    }
+    if (regular && status == MARKOV_OK) {
+        scheduler_parallel_for(s, 0, nb_chunks, 1, parse_tokens, &pl);
+        if (atomic_load(&pl.irregular)) regular = 0;
+        else if (atomic_load(&pl.out_of_range)) status = MARKOV_ERR_FORMAT;
+    }
 
-        // sum all outgoing probabilities for the current vertex
-        if (total_proba < 0.99 || total_proba > 1) {
-            is_markov = 0;
+    // edges grouped by start vertex, in file order (a counting sort)
+    if (regular && status == MARKOV_OK) {
+        int n = pl.nb_vertices;
+        pl.row_start = (int *)calloc((size_t)n + 1, sizeof(int));
+        pl.row_edge = (int *)malloc((size_t)(nb_edges > 0 ? nb_edges : 1) * sizeof(int));
+        pl.graph = empty_adjacency_list(n);
+        if (!pl.row_start || !pl.row_edge || !pl.graph) status = MARKOV_ERR_ALLOC;
+    }
+    if (regular && status == MARKOV_OK) {
+        int n = pl.nb_vertices;
+        for (long long e = 0; e < nb_edges; e++) pl.row_start[pl.start[e]]++;
+        for (int u = 0; u < n; u++) pl.row_start[u + 1] += pl.row_start[u];
+        // row_start[u] is the start of row u, and moves to its end as the row fills
+        for (long long e = 0; e < nb_edges; e++) pl.row_edge[pl.row_start[pl.start[e] - 1]++] = (int)e;
+        for (int u = n; u > 0; u--) pl.row_start[u] = pl.row_start[u - 1];
+        pl.row_start[0] = 0;
+
+        // a few thousand edges per task at least
+        int grain = nb_edges > 0 ? (int)((4096LL * n) / nb_edges) + 1 : n;
+        scheduler_parallel_for(s, 0, n, grain, build_rows, &pl);
+        PROF_COUNT(PROF_ALLOCATIONS, nb_edges);
+        if (atomic_load(&pl.failed)) status = MARKOV_ERR_ALLOC;
+    }
+
+    if (regular && status == MARKOV_OK) *graph = *pl.graph;
+    else if (pl.graph) free_adjacency_list(pl.graph);
+    free(pl.graph);
+    free(pl.bound);
+    free(pl.first_token);
+    free(pl.start);
+    free(pl.end);
+    free(pl.proba);
+    free(pl.row_start);
+    free(pl.row_edge);
+    free(text);
+    PROF_END(PROF_STAGE_READ_GRAPH);
+    if (!regular) return loadGraph(filename, graph);
+    return status;
+}
 
-            // print detailed error
-            printf( "Vertex %d does not respect the Markov property: sum is %.2f\n", i + 1, total_proba );
-            break; // stop at the first error
+/**
+ * @brief Edges read by loadGraphMapped() before the graph size is known.
+ */
+typedef struct s_edge_buffer {
+    int *start;   // dense index of the start vertex
+    int *end;     // dense index of the end vertex
+    float *proba; // probability
+    long long size, capacity;
+} t_edge_buffer;
+
+/**
+ * @brief Appends an edge to the buffer.
+ * @return 0 on success, -1 on allocation error
+ */
+static int edge_buffer_push(t_edge_buffer *b, int start, int end, float proba) {
+    if (b->size == b->capacity) {
+        long long capacity = b->capacity ? 2 * b->capacity : 1024;
+        int *s = (int *)realloc(b->start, capacity * sizeof(int));
+        if (s) b->start = s;
+        int *e = (int *)realloc(b->end, capacity * sizeof(int));
+        if (e) b->end = e;
+        float *p = (float *)realloc(b->proba, capacity * sizeof(float));
+        if (p) b->proba = p;
+        if (!s || !e || !p) return -1;
+        b->capacity = capacity;
+    }
+    b->start[b->size] = start;
+    b->end[b->size] = end;
+    b->proba[b->size] = proba;
+    b->size++;
+    return 0;
+}
+
+/**
+ * @brief Reads a graph whose vertices have arbitrary 64-bit ids
+ * @param filename Path to the file containing graph data
+ * @param graph Output adjacency list (left empty on error)
+ * @param ids Output id map (initialized here, free with id_map_free; left empty on error)
+ * @return MARKOV_OK, MARKOV_ERR_IO, MARKOV_ERR_FORMAT (also for more distinct
+ *         ids than the vertex count) or MARKOV_ERR_ALLOC
+ */
+int loadGraphMapped(const char *filename, t_adjacency_list *graph, t_id_map *ids) {
+    if (filename == NULL || graph == NULL || ids == NULL) return MARKOV_ERR_ARG;
+    graph->size = 0;
+    graph->array = NULL;
+
+    PROF_BEGIN(PROF_STAGE_READ_GRAPH);
+    FILE *file = fopen(filename, "rt");
+    if (!file) {
+        PROF_END(PROF_STAGE_READ_GRAPH);
+        return MARKOV_ERR_IO;
+    }
+
+    // the vertex count sizes the id table, and bounds the number of distinct ids
+    int size_hint;
+    if (fscanf(file, "%d", &size_hint) != 1 || size_hint <= 0) {
+        fclose(file);
+        PROF_END(PROF_STAGE_READ_GRAPH);
+        return MARKOV_ERR_FORMAT;
+    }
+    if (id_map_init(ids, size_hint) != 0) {
+        fclose(file);
+        PROF_END(PROF_STAGE_READ_GRAPH);
+        return MARKOV_ERR_ALLOC;
+    }
+
+    // first pass: give every id a dense index in order of appearance
+    t_edge_buffer edges = { NULL, NULL, NULL, 0, 0 };
+    long long start, end, last_start = 0;
+    float proba;
+    int status = MARKOV_OK, s = -1;
+    while (status == MARKOV_OK && fscanf(file, "%lld %lld %f", &start, &end, &proba) == 3) {
+        // the edges of a vertex usually follow each other: one lookup for the whole row
+        if (s < 0 || start != last_start) s = id_map_insert(ids, start);
+        last_start = start;
+        int e = s < 0 ? -1 : id_map_insert(ids, end);
+        if (e < 0 || edge_buffer_push(&edges, s, e, proba) != 0) status = MARKOV_ERR_ALLOC;
+    }
+    // as in loadGraph(), the edges end at the first line that is not one (a
+    // trailing comment for instance); more ids than the header announced is
+    // the error loadGraph() gives for a vertex above the count
+    if (status == MARKOV_OK && (ids->count == 0 || ids->count > size_hint)) status = MARKOV_ERR_FORMAT;
+    PROF_COUNT(PROF_BYTES_READ, ftell(file));
+    fclose(file);
+
+    // then number the ids in increasing order and build the lists in file order
+    int *perm = status == MARKOV_OK ? id_map_sort(ids) : NULL;
+    t_adjacency_list *gp = perm ? empty_adjacency_list(ids->count) : NULL;
+    if (status == MARKOV_OK && gp == NULL) status = MARKOV_ERR_ALLOC;
+    for (long long k = 0; status == MARKOV_OK && k < edges.size; k++) {
+        if (addCellToList(&gp->array[perm[edges.start[k]]], perm[edges.end[k]] + 1, edges.proba[k]) != 0) {
+            status = MARKOV_ERR_ALLOC;
         }
+        PROF_COUNT(PROF_ALLOCATIONS, 1);
     }
-    if (is_markov) {
-        printf("The graph is a Markov graph\n");
+
+    free(perm);
+    free(edges.start);
+    free(edges.end);
+    free(edges.proba);
+    if (status != MARKOV_OK) {
+        free_adjacency_list(gp);
+        id_map_free(ids);
     } else {
-        printf("The graph is not a Markov graph\n");
+        *graph = *gp;
     }
+    free(gp);
+    PROF_END(PROF_STAGE_READ_GRAPH);
+    return status;
+}
+
+/**
+ * @brief Reads a graph from a file and creates its adjacency list
+ * @param filename Path to the file containing graph data
+ * @return Adjacency list representation of the graph, empty (size 0,
+ *         NULL array) if the file cannot be loaded
+ * @note Use loadGraph() to know why a file could not be loaded
+ */
+t_adjacency_list readGraph(const char *filename) {
+    t_adjacency_list graph;
+    loadGraph(filename, &graph);
+    return graph;
+}
+
+
+//
+/**
+ * @brief Checks if the graph satisfies Markov chain properties
+ * @param list Adjacency list to check
+ * @note Verifies that outgoing probabilities from each vertex sum to 1.0 and
+ *       reports every problem (see ValidateGraph() for the report alone)
+ * @note Tolerance: ±MARKOV_DEFAULT_TOLERANCE (0.01) for floating-point comparison
+ */
+void checkIfMarkov(t_adjacency_list list) {
+    t_validation_options options = DefaultValidationOptions();
+    checkIfMarkovWith(list, &options, NULL);
+}
+
+/**
+ * @brief Checks the graph with explicit validation options and prints the report
+ * @param list Adjacency list to check
+ * @param options Tolerance, renormalization and detail level
+ * @param ids External ids of the vertices, NULL to print the vertex numbers
+ * @return 1 if the graph is a Markov graph, 0 if not, negative status on error
+ */
+int checkIfMarkovWith(t_adjacency_list list, const t_validation_options *options, const t_id_map *ids) {
+    t_validation_report report;
+    int status = ValidateGraph(list, options, &report);
+    if (status != MARKOV_OK) return status;
+
+    t_writer w;
+    writer_init(&w, stdout, 0);
+    FormatValidationReport(&w, &report, ids);
+    writer_close(&w);
+
+    int valid = report.valid;
+    FreeValidationReport(&report);
+    return valid;
 }
 
 
@@ -125,49 +501,12 @@ void checkIfMarkov(t_adjacency_list list) {
  * @brief Exports the graph to Mermaid diagram format
  * @param graph Adjacency list to export
  * @param filename Output file path
+ * @return MARKOV_OK, or MARKOV_ERR_IO if the file cannot be written
  * @note Creates a flowchart with ELK layout and neo theme
- * @note Exits program on file error
+ * @note See ExportGraphMermaid() to cap or sample the edges of a large graph
  */
-void exportToMermaid(t_adjacency_list graph, const char *filename) {
-    FILE *file = fopen(filename, "wt");
-    if (file == NULL) {
-        printf("Error: cannot open file '%s'\n", filename);
-        return;    // failure
-    }
-
-    // write the Mermaid configuration header.
-    // these settings control the appearance of the graph in MermaidChart.
-    fprintf(file, "---\n");
-    fprintf(file, "config:\n");
-    fprintf(file, "   layout: elk\n");
-    fprintf(file, "   theme: neo\n");
-    fprintf(file, "   look: neo\n");
-    fprintf(file, "---\n\n");
-
-    // start a flowchart that goes from left to right.
-    fprintf(file, "flowchart LR\n");
-
-    // write each vertex definition.
-    // example: A((1)), B((2)), C((3)), etc.
-    // getID(i + 1) converts 1 → A, 2 → B, ..., 27 → AA.
-    for (int i = 0; i < graph.size; i++) {
-        fprintf(file, "%s((%d))\n", getID(i + 1), i + 1);
-    }
-    fprintf(file, "\n");
-    // write all edges based on the adjacency list.
-    // for each vertex i, traverse its linked list of outgoing edges.
-    for (int i = 0; i < graph.size; i++) {
-        t_cell *current = graph.array[i].head;
-        // for every outgoing edge: print
-        // source -->|proba| destination
-        while (current != NULL) {
-            fprintf(file, "%s -->|%.2f|%s\n",getID(i + 1), current->probability,  getID(current->arrival)); // Convert source vertex index to letter,Display probability,Convert destination vertex number to letter
-            current = current->next; // Move to the next outgoing edge
-        }
-    }
-
-    fclose(file);
-    printf("Mermaid file '%s' generated successfully.\n", filename);
+int exportToMermaid(t_adjacency_list graph, const char *filename) {
+    return ExportGraphMermaid(graph, filename, NULL);
 }
 
 /**
@@ -186,6 +525,7 @@ t_tarjan_vertex * GraphIntoTar (t_adjacency_list* graph) {
  */
 t_stack * CreateStack () {
     t_stack * s = malloc (sizeof(t_stack));
+    if (s == NULL) return NULL;
     s->head = NULL;
     return s;
 }
@@ -194,12 +534,16 @@ t_stack * CreateStack () {
  * @brief Pushes a vertex ID onto the stack
  * @param s Pointer to stack
  * @param vertex_id ID of vertex to push
+ * @return 0 on success, -1 on allocation error
  */
-void push (t_stack *s, int vertex_id) {
+int push (t_stack *s, int vertex_id) {
     t_stack_node * new = malloc (sizeof(t_stack_node));
+    PROF_COUNT(PROF_ALLOCATIONS, 1);
+    if (new == NULL) return -1;
     new->vertex_id = vertex_id;
     new->next = s->head;
     s->head = new;
+    return 0;
 }
 
 /**
@@ -225,6 +569,19 @@ int isEmpty (t_stack *s) {
     return (s->head == NULL);
 }
 
+/**
+ * @brief Prints a title and one line per link, with the names of the classes.
+ */
+static void print_links(const char *title, const t_partition *partition, const t_link_array *links) {
+    printf("%s\n", title);
+    for (int i = 0; i < links->size; i++) {
+        printf("  %s --> %s\n",
+               partition->classes[links->links[i].start]->name,
+               partition->classes[links->links[i].end]->name);
+    }
+    printf("\n");
+}
+
 /**
  * @brief Prints links between classes before and after removing transitive edges.
  *
@@ -232,23 +589,32 @@ int isEmpty (t_stack *s) {
  * @param class_links Structure containing all links between classes.
  */
 void print_class(p_partition partition,  t_link_array class_links) {
-    printf("Links between classes:\n");
-    for (int i = 0; i < class_links.size; i++) {
-        printf("  %s --> %s\n",
-               partition->classes[class_links.links[i].start]->name,
-               partition->classes[class_links.links[i].end]->name);
-    }
-    printf("\n");
-
-    removeTransitiveLinks(&class_links);
+    print_links("Links between classes:", partition, &class_links);
+
+    // class_links shares its buffer with the caller: reduce a copy so the caller's links stay intact
+    t_link_array reduced = class_links;
+    reduced.links = (t_link *)malloc((class_links.size > 0 ? class_links.size : 1) * sizeof(t_link));
+    if (reduced.links == NULL) return;
+    for (int i = 0; i < class_links.size; i++) reduced.links[i] = class_links.links[i];
+    reduced.length = class_links.size;
+    removeTransitiveLinks(&reduced);
+
+    print_links("Links after removing transitive ones:", partition, &reduced);
+    free(reduced.links);
+}
 
-    printf("Links after removing transitive ones:\n");
-    for (int i = 0; i < class_links.size; i++) {
-        printf("  %s --> %s\n",
-               partition->classes[class_links.links[i].start]->name,
-               partition->classes[class_links.links[i].end]->name);
-    }
-    printf("\n");
+/**
+ * @brief Prints the links and the Hasse links of a context, as print_class() does.
+ *
+ * @param ctx The analysis context.
+ */
+void print_class_context(t_analysis_context *ctx) {
+    const t_partition *partition = ContextPartition(ctx);
+    const t_link_array *class_links = ContextClassLinks(ctx);
+    const t_link_array *hasse = ContextHasseLinks(ctx);
+    if (partition == NULL || class_links == NULL || hasse == NULL) return;
+    print_links("Links between classes:", partition, class_links);
+    print_links("Links after removing transitive ones:", partition, hasse);
 }
 
 /**
@@ -257,16 +623,43 @@ void print_class(p_partition partition,  t_link_array class_links) {
  * @param partition The partition structure containing the components.
  */
 void print_component(p_partition partition) {
+    t_writer w;
+    writer_init(&w, stdout, 0);
+    write_components(&w, partition, NULL);
+    writer_close(&w);
+}
+
+/**
+ * @brief Prints the vertices of each class of a context.
+ *
+ * @param ctx The analysis context.
+ */
+void print_component_context(t_analysis_context *ctx) {
+    const t_partition *partition = ContextPartition(ctx);
+    if (partition == NULL) return;
+    t_writer w;
+    writer_init(&w, stdout, 0);
+    write_components(&w, partition, NULL);
+    writer_close(&w);
+}
+
+/**
+ * @brief Writes the vertices of each component, as print_component() does.
+ * @param w Destination writer
+ * @param partition The partition
+ * @param ids External ids of the vertices, NULL to print the vertex numbers
+ */
+void write_components(t_writer *w, const t_partition *partition, const t_id_map *ids) {
     for (int i = 0; i < partition->nb_class; i++) {
-        p_class c = partition->classes[i];
-        printf("Component %s: {", c->name);
+        const t_class *c = partition->classes[i];
+        writer_printf(w, "Component %s: {", c->name);
         for (int j = 0; j < c->nb_vertices; j++) {
-            printf("%d", c->vertices[j]);
-            if (j < c->nb_vertices - 1) printf(",");
+            if (j > 0) writer_char(w, ',');
+            write_vertex_id(w, ids, c->vertices[j]);
         }
-        printf("}\n");
+        writer_puts(w, "}\n");
     }
-    printf("\n");
+    writer_char(w, '\n');
 }
 
 /**
@@ -276,49 +669,51 @@ void print_component(p_partition partition) {
  * @param power The exponent.
  */
 void PowerMatrix (p_matrix M, int power) {
-    for (int i=0; i<power-1; i++) {
-        M = MultiplyMatrices(M, M);
-    }
-    printf("Meteo Matrix Power %d\n", power);
-    printMatrix(M);
+    p_matrix P = MatrixPower(M, power);
+    if (P == NULL) return;
+    t_writer w;
+    writer_init(&w, stdout, 0);
+    writer_printf(&w, "Meteo Matrix Power %d\n", power);
+    WriteMatrix(&w, P);
+    writer_close(&w);
+    DestroyMatrix(P);
 }
 
 /**
- * @brief Computes and prints the stationary matrix by repeated squaring until convergence.
+ * @brief Computes and prints the stationary matrix by repeated products until convergence.
  *
- * Checks for convergence using the difference between successive powers (M^2^k).
+ * Checks for convergence using the difference between successive products
+ * (see StationaryMatrixLimit() for the computation alone).
  *
  * @param graph The source graph.
  * @param epsilon The convergence threshold.
  * @param graph_name Name of the graph for display purposes.
  */
 void ComputeStationaryMatrix (t_adjacency_list graph, float epsilon, const char *graph_name) {
-    p_matrix M = CreateMatFromAdjList(graph);
-    p_matrix MNext = MultiplyMatrices(M, M);
-    float diff = DiffMatrix(M, MNext);
-    int power = 1;
-
-    while (diff > epsilon && power < 100) {
-        power ++;
-        p_matrix tmp = MultiplyMatrices(MNext, M);
-        diff = DiffMatrix(MNext, tmp);
-
-        printf("For iteration %d, the difference is %.5f\n", power, diff);
+    t_analysis_context ctx;
+    InitAnalysisContext(&ctx, graph, 1);
+    ComputeStationaryMatrixContext(&ctx, epsilon, graph_name);
+    FreeAnalysisContext(&ctx);
+}
 
-        free(M);
-        M = MNext;
-        MNext = tmp;
+/**
+ * @brief ComputeStationaryMatrix() on the transition matrix of a context.
+ *
+ * @param ctx The analysis context.
+ * @param epsilon The convergence threshold.
+ * @param graph_name Name of the graph for display purposes.
+ */
+void ComputeStationaryMatrixContext(t_analysis_context *ctx, float epsilon, const char *graph_name) {
+    p_matrix M = ContextMatrix(ctx);
+    t_matrix_limit limit;
+    if (M == NULL || StationaryMatrixLimit(M, epsilon, 100, 1, &limit) != 0) return;
 
-    }
-    if (power > 100) printf ("For %s, this criterion does not work\n", graph_name);
-    else {
-        printf ("Convergence reached afeter %d multiplications (diff = %.5f)\n", power, diff);
-        printf("Stationary Matrix :\n");
-        printMatrix(MNext);
-    }
-    free(M);
-    free(MNext);
+    t_writer w;
+    writer_init(&w, stdout, 0);
+    FormatStationaryMatrix(&w, &limit, graph_name);
+    writer_close(&w);
 
+    FreeMatrixLimit(&limit);
 }
 
 /**
@@ -363,39 +758,26 @@ p_matrix MixMatrices(p_matrix A, p_matrix B, float alpha) {
 /**
  * @brief Computes and prints the stationary distribution vector for a matrix.
  *
- * Handles periodic matrices by applying a "Lazy Walk" transformation before solving.
+ * Handles periodic matrices by applying a "Lazy Walk" transformation before solving
+ * (see AnalyzeClassMatrix() for the computation alone).
  *
  * @param M The transition matrix.
  * @param period The period of the matrix (1 if aperiodic).
  */
 //calculates stationary distribution for a specific class matrix. In other word we forec the matrix to settle into its natural equilibrium (which is called the stationnary distribution)
 void SolveStationaryDistribution(p_matrix M, int period) {
-    p_matrix MatrixToSolve;
-    p_matrix I = NULL;
-    p_matrix Lazy = NULL;
-
-    if (period > 1) {
-        printf("      [Periodic d=%d] Using Lazy Walk (0.5M + 0.5I).\n", period);
-        I = CreateIdentityMatrix(M->size);
-        Lazy = MixMatrices(M, I, 0.5f);
-        MatrixToSolve = Lazy;
-    } else {
-        MatrixToSolve = M;
-    }
-
-    float *pi = StationaryVectorFromSubmatrix(MatrixToSolve, 10000, 1e-6f);
-
-    if (pi) {
-        printf("   Stationary Distribution: [ ");
-        for (int j = 0; j < M->size; ++j) printf("%.4f ", pi[j]);
-        printf("]\n");
-        free(pi);
-    } else {
-        printf("      [Error] Did not converge.\n");
-    }
-
-    if (I) DestroyMatrix(I);
-    if (Lazy) DestroyMatrix(Lazy);
+    t_analysis_options options = DefaultAnalysisOptions();
+    // the period is known by the caller: a periodic class is solved as a lazy walk
+    if (period > 1) options.flags |= ANALYSIS_FORCE_LAZY;
+    t_class_analysis result;
+    if (AnalyzeClassMatrix(M, &options, &result) != MARKOV_OK) return;
+    result.period = period;
+
+    t_writer w;
+    writer_init(&w, stdout, 0);
+    FormatStationarySolve(&w, &result);
+    writer_close(&w);
+    FreeClassAnalysis(&result);
 }
 
 /**
@@ -406,37 +788,38 @@ void SolveStationaryDistribution(p_matrix M, int period) {
  * @param graph The graph to analyze.
  */
 void periodicity(t_adjacency_list graph) {
-    //get partition using tarjan
-    p_partition partition = tarjan(graph);
-    p_matrix FullMatrix = CreateMatFromAdjList(graph);
-
-    //iterate over each classes found
-    for (int i = 0; i < partition->nb_class; i++) {
-        t_class *cls = partition->classes[i];
-
-        printf("\nAnalyzing Class #%d (Vertices: ", i + 1);
-        for(int v=0; v < cls->nb_vertices; v++) printf("%d ", cls->vertices[v]);
-        printf("):\n");
-
-        //extract submatrix
-        p_matrix subM = subMatrix(FullMatrix, *partition, i);
-
-        if (subM == NULL) {
-            printf("   Could not extract matrix (likely size 0 or invalid index).\n");
-            continue;
-        }
-
-        //calculate the period
-        int period = getPeriod(subM);
-        printf("   Period: %d\n", period);
-
-        // calculate the stationnary distribution
-        SolveStationaryDistribution(subM, period);
+    periodicityWith(graph, 1);
+}
 
-        DestroyMatrix(subM);
-    }
+/**
+ * @brief periodicity() with the classes analysed by several threads.
+ *
+ * @param graph The graph to analyze.
+ * @param nb_threads Number of threads (1 = sequential).
+ */
+void periodicityWith(t_adjacency_list graph, int nb_threads) {
+    t_analysis_context ctx;
+    InitAnalysisContext(&ctx, graph, nb_threads);
+    periodicityContext(&ctx);
+    FreeAnalysisContext(&ctx);
+}
 
-    DestroyMatrix(FullMatrix);
+/**
+ * @brief periodicity() on a context, reusing what was already computed on it.
+ *
+ * @param ctx The analysis context.
+ */
+void periodicityContext(t_analysis_context *ctx) {
+    t_analysis_options options = DefaultAnalysisOptions();
+    options.flags = ANALYSIS_PERIOD | ANALYSIS_STATIONARY | ANALYSIS_ALL_CLASSES;
+    options.nb_threads = ctx->nb_threads;
+    const t_graph_analysis *analysis = ContextAnalysis(ctx, &options);
+    if (analysis == NULL) return;
+
+    t_writer w;
+    writer_init(&w, stdout, 0);
+    FormatPeriodicity(&w, analysis);
+    writer_close(&w);
 }
 
 /**
@@ -447,64 +830,35 @@ void periodicity(t_adjacency_list graph) {
  * @param graph The graph to analyze.
  */
 void step2_validation(t_adjacency_list graph) {
-    p_matrix M = CreateMatFromAdjList(graph);
-
-    p_partition P = tarjan(graph);
-
-    int *map = create_vertex_class_array(graph.size, P);
-    t_link_array L;
-    links_init(&L);
-    list_class_links(&graph, map, &L);
-
-    const int MAX_IT = 1000;
-    const float EPS = 1e-6f;
-
-    for (int c = 0; c < P->nb_class; ++c) {
-        p_class cls = P->classes[c];
-
-        // Check if the class is persistent (no edges leaving the class)
-        int persistent = is_class_persistent(c, &L);
-
-        // Print Class Name and Vertices
-        printf("Classe C%d (", c + 1);
-        for (int k = 0; k < cls->nb_vertices; ++k) {
-            if (k > 0) printf(", ");
-            printf("%d", cls->vertices[k]);
-        }
-        printf(") : %s\n", persistent ? "Persistent" : "Transient");
-
-        // Extract the sub-matrix for this specific class
-        p_matrix S = subMatrix(M, *P, c);
-
-        if (!S) {
-            printf("  (Sub-matrices can't found)\n");
-            continue;
-        }
-
-        if (!persistent) {
-            // Transient classes eventually have 0 probability in the long run
-            printf("  Distribution limit: [ ");
-            for (int j = 0; j < S->size; ++j) printf("0.0000 ");
-            printf("]\n");
-        } else {
-            // Persistent classes have a stationary distribution (Equilibrium)
-            float *pi = StationaryVectorFromSubmatrix(S, MAX_IT, EPS);
-            if (!pi) {
-                printf("  Error on computing\n");
-            } else {
-                printf("   Stationary Distribution: [ ");
-                for (int j = 0; j < S->size; ++j) {
-                    printf("%.4f ", pi[j]);
-                }
-                printf("]\n");
-                free(pi); // Don't forget to free the vector
-            }
-        }
+    step2_validationWith(graph, 1);
+}
 
-        DestroyMatrix(S);
-    }
+/**
+ * @brief step2_validation() with the classes analysed by several threads.
+ *
+ * @param graph The graph to analyze.
+ * @param nb_threads Number of threads (1 = sequential).
+ */
+void step2_validationWith(t_adjacency_list graph, int nb_threads) {
+    t_analysis_context ctx;
+    InitAnalysisContext(&ctx, graph, nb_threads);
+    step2_validationContext(&ctx);
+    FreeAnalysisContext(&ctx);
+}
 
-    DestroyMatrix(M);
-    if (map) free(map);
-    if (L.links) free(L.links);
-}
\ No newline at end of file
+/**
+ * @brief step2_validation() on a context, reusing what was already computed on it.
+ *
+ * @param ctx The analysis context.
+ */
+void step2_validationContext(t_analysis_context *ctx) {
+    t_analysis_options options = DefaultAnalysisOptions();
+    options.nb_threads = ctx->nb_threads;
+    const t_graph_analysis *analysis = ContextAnalysis(ctx, &options);
+    if (analysis == NULL) return;
+
+    t_writer w;
+    writer_init(&w, stdout, 0);
+    FormatLimitDistributions(&w, analysis);
+    writer_close(&w);
+}
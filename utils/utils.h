@@ -5,11 +5,49 @@
 #include "../tarjan/tarjan.h"
 #include "../hasse/hasse.h"
 #include "../matrix/matrix.h"
+#include "../status/status.h"
+#include "../validation/validation.h"
+#include "../idmap/idmap.h"
+#include "../scheduler/scheduler.h"
+#include "../context/context.h"
 
 /**
  * @brief Reads graph from file
  * @param filename Path to graph file
- * @return Adjacency list
+ * @param graph Output adjacency list (empty on error)
+ * @return MARKOV_OK or a negative t_markov_status
+ */
+int loadGraph(const char *filename, t_adjacency_list *graph);
+
+/**
+ * @brief Reads graph from file with the tasks of a scheduler (same graph,
+ *        same list order as loadGraph)
+ * @param filename Path to graph file
+ * @param graph Output adjacency list (empty on error)
+ * @param s Scheduler (NULL or one thread = loadGraph)
+ * @return MARKOV_OK or a negative t_markov_status
+ */
+int loadGraphParallel(const char *filename, t_adjacency_list *graph, t_scheduler *s);
+
+/**
+ * @brief Reads graph from file whose vertex ids are any 64-bit integers
+ *
+ * The edges end at the first line that is not an edge, as in loadGraph().
+ * The first line is the vertex count: more distinct ids than that is an
+ * error; the graph has one vertex per distinct id, so a vertex that appears
+ * in no edge is not created.
+ *
+ * @param filename Path to graph file (same format as loadGraph())
+ * @param graph Output adjacency list, vertices numbered 1..n by increasing id
+ * @param ids Output id map (free with id_map_free)
+ * @return MARKOV_OK or a negative t_markov_status
+ */
+int loadGraphMapped(const char *filename, t_adjacency_list *graph, t_id_map *ids);
+
+/**
+ * @brief Reads graph from file
+ * @param filename Path to graph file
+ * @return Adjacency list, empty (size 0) if the file cannot be loaded
  */
 t_adjacency_list readGraph(const char *filename);
 
@@ -19,12 +57,22 @@ t_adjacency_list readGraph(const char *filename);
  */
 void checkIfMarkov(t_adjacency_list list);
 
+/**
+ * @brief Checks graph with explicit options and prints every problem
+ * @param list Adjacency list
+ * @param options Validation options
+ * @param ids External ids of the vertices, NULL to print the vertex numbers
+ * @return 1 if Markov, 0 if not, negative status on error
+ */
+int checkIfMarkovWith(t_adjacency_list list, const t_validation_options *options, const t_id_map *ids);
+
 /**
  * @brief Exports graph to Mermaid format
  * @param graph Graph to export
  * @param filename Output file
+ * @return MARKOV_OK or MARKOV_ERR_IO
  */
-void exportToMermaid(t_adjacency_list graph, const char *filename);
+int exportToMermaid(t_adjacency_list graph, const char *filename);
 
 /**
  * @brief Converts graph to Tarjan array
@@ -55,8 +103,9 @@ t_stack *CreateStack();
 
 /**
  * @brief Pushes vertex to stack
+ * @return 0 on success, -1 on allocation error
  */
-void push(t_stack *s, int vertex_id);
+int push(t_stack *s, int vertex_id);
 
 /**
  * @brief Pops vertex from stack
@@ -77,12 +126,32 @@ int isEmpty(t_stack *s);
  */
 void print_class(p_partition ,  t_link_array);
 
+/**
+ * @brief print_class() on the classes, links and Hasse links of a context.
+ * @param ctx The analysis context.
+ */
+void print_class_context(t_analysis_context *ctx);
+
 /**
  * @brief Prints the list of vertices contained in each class of the partition.
  * @param part The partition to display.
  */
 void print_component(p_partition);
 
+/**
+ * @brief print_component() on the classes of a context.
+ * @param ctx The analysis context.
+ */
+void print_component_context(t_analysis_context *ctx);
+
+/**
+ * @brief Writes the list of vertices contained in each class of the partition.
+ * @param w Destination writer
+ * @param partition The partition
+ * @param ids External ids of the vertices, NULL to print the vertex numbers
+ */
+void write_components(t_writer *w, const t_partition *partition, const t_id_map *ids);
+
 /**
  * @brief Raises a matrix to a specific power and prints the result.
  * @param M The matrix to multiply.
@@ -101,6 +170,14 @@ void PowerMatrix (p_matrix M, int power);
  */
 void ComputeStationaryMatrix (t_adjacency_list graph, float epsilon, const char *graph_name);
 
+/**
+ * @brief ComputeStationaryMatrix() on the transition matrix of a context.
+ * @param ctx The analysis context.
+ * @param epsilon The convergence threshold.
+ * @param graph_name Name of the graph (for display purposes).
+ */
+void ComputeStationaryMatrixContext(t_analysis_context *ctx, float epsilon, const char *graph_name);
+
 /**
  * @brief Creates an identity matrix of size n.
  * @param n The dimension of the matrix.
@@ -136,6 +213,22 @@ void SolveStationaryDistribution(p_matrix M, int);
  */
 void periodicity(t_adjacency_list);
 
+/**
+ * @brief periodicity() with the per-class work (class matrix, period,
+ *        stationary solve) spread over several threads, largest class first.
+ *        The output is the same as periodicity().
+ * @param graph The graph to analyze.
+ * @param nb_threads Number of threads (1 = sequential).
+ */
+void periodicityWith(t_adjacency_list graph, int nb_threads);
+
+/**
+ * @brief periodicity() on a context: the classes, the CSR matrix and the
+ *        per-class results already computed on it are reused.
+ * @param ctx The analysis context (its threads are used).
+ */
+void periodicityContext(t_analysis_context *ctx);
+
 /**
  * @brief Performs validation step 2: Classification of states.
  *
@@ -145,4 +238,17 @@ void periodicity(t_adjacency_list);
  */
 void step2_validation(t_adjacency_list );
 
+/**
+ * @brief step2_validation() with the per-class work spread over several threads.
+ * @param graph The graph to validate.
+ * @param nb_threads Number of threads (1 = sequential).
+ */
+void step2_validationWith(t_adjacency_list graph, int nb_threads);
+
+/**
+ * @brief step2_validation() on a context.
+ * @param ctx The analysis context (its threads are used).
+ */
+void step2_validationContext(t_analysis_context *ctx);
+
 #endif
@@ -0,0 +1,200 @@
+#include "validation.h"
+#include "../cell/cell.h"
+#include "../status/status.h"
+#include <math.h>
+#include <stdlib.h>
+#include <string.h>
+
+// slack for the rounding of float probabilities, so 1.0000001 passes a tolerance of 0
+#define ROUNDING_SLACK 1e-6
+
+/**
+ * @brief Default options: MARKOV_DEFAULT_TOLERANCE, no renormalization, 64 detailed issues.
+ * @return The options
+ */
+t_validation_options DefaultValidationOptions(void) {
+    t_validation_options options = { MARKOV_DEFAULT_TOLERANCE, 0, 64 };
+    return options;
+}
+
+/**
+ * @brief Stores an issue if there is still room in the report.
+ */
+static void add_issue(t_validation_report *report, int max_issues, t_validation_issue_kind kind,
+                      int vertex, int arrival, double value) {
+    if (report->nb_issues >= max_issues) return;
+    t_validation_issue *issue = &report->issues[report->nb_issues++];
+    issue->kind = kind;
+    issue->vertex = vertex;
+    issue->arrival = arrival;
+    issue->value = value;
+}
+
+/**
+ * @brief Sums val[begin..end[ in double with four independent accumulators,
+ *        so the additions pipeline (and vectorize) instead of forming one chain.
+ */
+static double row_sum(const float *val, int begin, int end) {
+    double s0 = 0.0, s1 = 0.0, s2 = 0.0, s3 = 0.0;
+    int k = begin;
+    for (; k + 4 <= end; k += 4) {
+        s0 += val[k];
+        s1 += val[k + 1];
+        s2 += val[k + 2];
+        s3 += val[k + 3];
+    }
+    for (; k < end; k++) s0 += val[k];
+    return (s0 + s1) + (s2 + s3);
+}
+
+/**
+ * @brief Validates a CSR matrix in one pass over its arrays.
+ * @param S The matrix
+ * @param options Options (NULL for the defaults)
+ * @param report Output (free with FreeValidationReport)
+ * @return MARKOV_OK or a negative t_markov_status
+ */
+int ValidateSparse(p_sparse_matrix S, const t_validation_options *options, t_validation_report *report) {
+    if (S == NULL || report == NULL || S->size < 0) return MARKOV_ERR_ARG;
+    t_validation_options defaults = DefaultValidationOptions();
+    if (options == NULL) options = &defaults;
+    int max_issues = options->max_issues > 0 ? options->max_issues : 0;
+    double tolerance = (options->tolerance > 0.0 ? options->tolerance : 0.0) + ROUNDING_SLACK;
+
+    memset(report, 0, sizeof(*report));
+    report->nb_vertices = S->size;
+    report->nb_edges = S->nb_edges;
+    int n = S->size;
+
+    // last_row[j] = last row with an edge towards j, to spot duplicates in O(1)
+    int *last_row = (int *)malloc((n > 0 ? n : 1) * sizeof(int));
+    if (max_issues > 0) report->issues = (t_validation_issue *)malloc(max_issues * sizeof(t_validation_issue));
+    if (last_row == NULL || (max_issues > 0 && report->issues == NULL)) {
+        free(last_row);
+        FreeValidationReport(report);
+        return MARKOV_ERR_ALLOC;
+    }
+    for (int j = 0; j < n; j++) last_row[j] = -1;
+
+    for (int i = 0; i < n; i++) {
+        int begin = S->row_start[i], end = S->row_start[i + 1];
+        if (begin == end) {
+            report->empty_rows++;
+            add_issue(report, max_issues, ISSUE_EMPTY_ROW, i + 1, 0, 0.0);
+            continue;
+        }
+
+        double sum = row_sum(S->val, begin, end);
+        double deviation = fabs(sum - 1.0);
+        if (deviation > report->max_deviation) {
+            report->max_deviation = deviation;
+            report->worst_vertex = i + 1;
+        }
+        int bad_sum = !(deviation <= tolerance);
+        if (bad_sum) {
+            report->bad_rows++;
+            add_issue(report, max_issues, ISSUE_ROW_SUM, i + 1, 0, sum);
+        }
+
+        // per-edge checks
+        int has_negative = 0;
+        for (int k = begin; k < end; k++) {
+            int j = S->col[k];
+            if (!(S->val[k] >= 0.0f)) { // also catches NaN
+                report->negative++;
+                has_negative = 1;
+                add_issue(report, max_issues, ISSUE_NEGATIVE, i + 1, j + 1, S->val[k]);
+            }
+            if ((unsigned)j >= (unsigned)n) {
+                report->out_of_range++;
+                add_issue(report, max_issues, ISSUE_OUT_OF_RANGE, i + 1, j + 1, S->val[k]);
+            } else if (last_row[j] == i) {
+                report->duplicates++;
+                add_issue(report, max_issues, ISSUE_DUPLICATE, i + 1, j + 1, S->val[k]);
+            } else {
+                last_row[j] = i;
+            }
+        }
+
+        // only the rows out of tolerance: a row within it is left as written
+        if (options->renormalize && bad_sum && !has_negative && sum > 0.0) {
+            float scale = (float)(1.0 / sum);
+            for (int k = begin; k < end; k++) S->val[k] *= scale;
+            report->renormalized_rows++;
+        }
+    }
+    free(last_row);
+
+    // a rescaled row now sums to 1: it is reported, but no longer makes the graph invalid
+    report->valid = report->bad_rows == report->renormalized_rows && report->empty_rows == 0 && report->negative == 0
+                    && report->out_of_range == 0 && report->duplicates == 0;
+    return MARKOV_OK;
+}
+
+/**
+ * @brief Validates a graph through a flat copy of its lists.
+ * @param graph The graph
+ * @param options Options (NULL for the defaults)
+ * @param report Output (free with FreeValidationReport)
+ * @return MARKOV_OK or a negative t_markov_status
+ */
+int ValidateGraph(t_adjacency_list graph, const t_validation_options *options, t_validation_report *report) {
+    if (report == NULL || graph.size < 0 || (graph.size > 0 && graph.array == NULL)) return MARKOV_ERR_ARG;
+    int n = graph.size;
+
+    // flat copy that keeps every edge, out-of-range ones included
+    t_sparse_matrix flat;
+    flat.size = n;
+    flat.row_start = (int *)malloc((n + 1) * sizeof(int));
+    if (flat.row_start == NULL) return MARKOV_ERR_ALLOC;
+    flat.row_start[0] = 0;
+    for (int i = 0; i < n; i++) {
+        int count = 0;
+        for (t_cell *c = graph.array[i].head; c != NULL; c = c->next) count++;
+        flat.row_start[i + 1] = flat.row_start[i] + count;
+    }
+    flat.nb_edges = flat.row_start[n];
+    int cap = flat.nb_edges > 0 ? flat.nb_edges : 1;
+    flat.col = (int *)malloc(cap * sizeof(int));
+    flat.val = (float *)malloc(cap * sizeof(float));
+    if (flat.col == NULL || flat.val == NULL) {
+        free(flat.row_start);
+        free(flat.col);
+        free(flat.val);
+        return MARKOV_ERR_ALLOC;
+    }
+    int e = 0;
+    for (int i = 0; i < n; i++) {
+        for (t_cell *c = graph.array[i].head; c != NULL; c = c->next) {
+            flat.col[e] = c->arrival - 1;
+            flat.val[e] = c->probability;
+            e++;
+        }
+    }
+
+    int status = ValidateSparse(&flat, options, report);
+
+    // copy the rescaled probabilities back, in the same order
+    if (status == MARKOV_OK && report->renormalized_rows > 0) {
+        e = 0;
+        for (int i = 0; i < n; i++) {
+            for (t_cell *c = graph.array[i].head; c != NULL; c = c->next) c->probability = flat.val[e++];
+        }
+    }
+
+    free(flat.row_start);
+    free(flat.col);
+    free(flat.val);
+    return status;
+}
+
+/**
+ * @brief Frees the issues of a report.
+ * @param report The report
+ */
+void FreeValidationReport(t_validation_report *report) {
+    if (report == NULL) return;
+    free(report->issues);
+    report->issues = NULL;
+    report->nb_issues = 0;
+}
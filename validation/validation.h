@@ -0,0 +1,99 @@
+#ifndef VALIDATION_H
+#define VALIDATION_H
+
+#include "../adjacency_list/adjacency_list.h"
+#include "../sparse/sparse.h"
+
+// default |row sum - 1| accepted by checkIfMarkov (probabilities written with 2 decimals)
+#define MARKOV_DEFAULT_TOLERANCE 0.01
+
+/**
+ * @brief Kinds of problems found by the validation.
+ */
+typedef enum e_validation_issue_kind {
+    ISSUE_ROW_SUM,      // row sum outside [1 - tolerance, 1 + tolerance]
+    ISSUE_EMPTY_ROW,    // vertex without outgoing edge
+    ISSUE_NEGATIVE,     // negative (or NaN) probability
+    ISSUE_OUT_OF_RANGE, // arrival vertex outside 1..size
+    ISSUE_DUPLICATE     // same (start, arrival) edge given twice
+} t_validation_issue_kind;
+
+/**
+ * @brief One problem found by the validation.
+ */
+typedef struct s_validation_issue {
+    t_validation_issue_kind kind;
+    int vertex;   // start vertex (1-based)
+    int arrival;  // arrival vertex (1-based as stored), 0 for row issues
+    double value; // row sum or probability
+} t_validation_issue;
+
+/**
+ * @brief Options of the validation.
+ */
+typedef struct s_validation_options {
+    double tolerance; // accepted |row sum - 1|
+    int renormalize;  // 1 to divide the rows out of tolerance by their sum (rows with a negative value
+                      // or a zero sum are left alone)
+    int max_issues;   // number of issues kept in detail (counters are always complete)
+} t_validation_options;
+
+/**
+ * @brief Complete result of a validation pass.
+ */
+typedef struct s_validation_report {
+    int nb_vertices;
+    long long nb_edges;
+    int valid;                  // 1 if no issue at all once the renormalized rows are fixed
+    int bad_rows;               // rows whose sum is out of tolerance
+    int empty_rows;             // rows without edge
+    long long negative;         // negative or NaN probabilities
+    long long out_of_range;     // arrival outside 1..size
+    long long duplicates;       // repeated edges
+    double max_deviation;       // largest |row sum - 1| over the non-empty rows
+    int worst_vertex;           // vertex of max_deviation (1-based), 0 if none
+    int renormalized_rows;      // rows out of tolerance rescaled to sum to 1 (renormalize option)
+    int nb_issues;              // issues stored in issues[] (at most max_issues)
+    t_validation_issue *issues; // first issues, in vertex order
+} t_validation_report;
+
+/**
+ * @brief Default options: MARKOV_DEFAULT_TOLERANCE, no renormalization, 64 detailed issues.
+ * @return The options
+ */
+t_validation_options DefaultValidationOptions(void);
+
+/**
+ * @brief Validates a CSR matrix in one pass over its arrays.
+ *
+ * Every row is checked (the pass does not stop at the first problem). The
+ * renormalization, if asked, rescales S->val in place for the rows out of
+ * tolerance; they are still counted in bad_rows and listed as issues, but
+ * the verdict (valid) is the one of the rescaled matrix.
+ *
+ * @param S The matrix
+ * @param options Options (NULL for the defaults)
+ * @param report Output (free with FreeValidationReport)
+ * @return MARKOV_OK or a negative t_markov_status
+ */
+int ValidateSparse(p_sparse_matrix S, const t_validation_options *options, t_validation_report *report);
+
+/**
+ * @brief Validates a graph: flattens its lists into contiguous arrays (keeping
+ *        the out-of-range edges) and runs ValidateSparse on them. The
+ *        renormalization, if asked, rescales the probabilities of the lists.
+ *
+ * @param graph The graph
+ * @param options Options (NULL for the defaults)
+ * @param report Output (free with FreeValidationReport)
+ * @return MARKOV_OK or a negative t_markov_status
+ */
+int ValidateGraph(t_adjacency_list graph, const t_validation_options *options, t_validation_report *report);
+
+/**
+ * @brief Frees the issues of a report.
+ * @param report The report
+ */
+void FreeValidationReport(t_validation_report *report);
+
+#endif //VALIDATION_H
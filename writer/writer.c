@@ -0,0 +1,183 @@
+#include "writer.h"
+#include <math.h>
+#include <stdarg.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define WRITER_DEFAULT_SIZE (64 * 1024)
+
+/**
+ * @brief Initializes a writer.
+ * @param w The writer
+ * @param file Destination file (not owned)
+ * @param size Buffer size in bytes, 0 for the default (64 KiB)
+ * @return 0 on success, -1 on allocation error
+ */
+int writer_init(t_writer *w, FILE *file, size_t size) {
+    if (w == NULL || file == NULL) return -1;
+    // below a few hundred bytes a formatted line would not fit
+    if (size < 256) size = WRITER_DEFAULT_SIZE;
+    w->file = file;
+    w->size = size;
+    w->used = 0;
+    w->error = 0;
+    w->buffer = (char *)malloc(size);
+    if (w->buffer == NULL) {
+        w->size = 0;
+        return -1;
+    }
+    return 0;
+}
+
+/**
+ * @brief Writes the pending bytes to the file.
+ * @param w The writer
+ * @return 0 on success, -1 if a write failed since the initialization
+ */
+int writer_flush(t_writer *w) {
+    if (w->used > 0) {
+        if (fwrite(w->buffer, 1, w->used, w->file) != w->used) w->error = 1;
+        w->used = 0;
+    }
+    if (fflush(w->file) != 0) w->error = 1;
+    return w->error ? -1 : 0;
+}
+
+/**
+ * @brief Appends raw bytes.
+ * @param w The writer
+ * @param data Bytes to append
+ * @param len Number of bytes
+ */
+void writer_write(t_writer *w, const char *data, size_t len) {
+    if (w->used + len > w->size) {
+        // make room; a block larger than the buffer goes straight to the file
+        if (w->used > 0 && fwrite(w->buffer, 1, w->used, w->file) != w->used) w->error = 1;
+        w->used = 0;
+        if (len > w->size) {
+            if (fwrite(data, 1, len, w->file) != len) w->error = 1;
+            return;
+        }
+    }
+    memcpy(w->buffer + w->used, data, len);
+    w->used += len;
+}
+
+/**
+ * @brief Appends a string.
+ * @param w The writer
+ * @param s Null-terminated string
+ */
+void writer_puts(t_writer *w, const char *s) {
+    writer_write(w, s, strlen(s));
+}
+
+/**
+ * @brief Appends one character.
+ * @param w The writer
+ * @param c The character
+ */
+void writer_char(t_writer *w, char c) {
+    if (w->used < w->size) w->buffer[w->used++] = c;
+    else writer_write(w, &c, 1);
+}
+
+/**
+ * @brief Appends an integer in decimal.
+ * @param w The writer
+ * @param value The integer
+ */
+void writer_int(t_writer *w, long long value) {
+    char digits[24];
+    int pos = sizeof(digits);
+    // work on the unsigned magnitude so LLONG_MIN does not overflow
+    unsigned long long magnitude = value < 0 ? 0ULL - (unsigned long long)value : (unsigned long long)value;
+    do {
+        digits[--pos] = (char)('0' + magnitude % 10);
+        magnitude /= 10;
+    } while (magnitude > 0);
+    if (value < 0) digits[--pos] = '-';
+    writer_write(w, digits + pos, sizeof(digits) - pos);
+}
+
+/**
+ * @brief Appends a number with a fixed number of decimals.
+ * @param w The writer
+ * @param value The number
+ * @param decimals Number of decimals (0 to 9)
+ */
+void writer_fixed(t_writer *w, double value, int decimals) {
+    static const double scales[10] = { 1e0, 1e1, 1e2, 1e3, 1e4, 1e5, 1e6, 1e7, 1e8, 1e9 };
+    if (decimals < 0) decimals = 0;
+    if (decimals > 9) decimals = 9;
+
+    // a float times 10^d is exact in double for d <= 9, so llrint (ties to even)
+    // rounds like printf does
+    double scaled = value * scales[decimals];
+    if (!(fabs(scaled) < 9e18)) {
+        writer_printf(w, "%.*f", decimals, value);
+        return;
+    }
+    long long units = llrint(scaled);
+    if (units == 0 && signbit(value)) writer_char(w, '-'); // printf keeps the sign of -0.00
+    else if (units < 0) writer_char(w, '-');
+    unsigned long long magnitude = units < 0 ? 0ULL - (unsigned long long)units : (unsigned long long)units;
+
+    unsigned long long divisor = (unsigned long long)scales[decimals];
+    writer_int(w, (long long)(magnitude / divisor));
+    if (decimals == 0) return;
+    writer_char(w, '.');
+    char frac[9];
+    unsigned long long rest = magnitude % divisor;
+    for (int d = decimals - 1; d >= 0; d--) {
+        frac[d] = (char)('0' + rest % 10);
+        rest /= 10;
+    }
+    writer_write(w, frac, decimals);
+}
+
+/**
+ * @brief Appends formatted text (printf syntax).
+ * @param w The writer
+ * @param format printf format string
+ */
+void writer_printf(t_writer *w, const char *format, ...) {
+    va_list args;
+    va_start(args, format);
+    size_t room = w->size - w->used;
+    int len = vsnprintf(w->buffer + w->used, room, format, args);
+    va_end(args);
+    if (len < 0) {
+        w->error = 1;
+        return;
+    }
+    if ((size_t)len < room) {
+        w->used += (size_t)len;
+        return;
+    }
+
+    // did not fit: format again in a buffer of the right size
+    char *tmp = (char *)malloc((size_t)len + 1);
+    if (tmp == NULL) {
+        w->error = 1;
+        return;
+    }
+    va_start(args, format);
+    vsnprintf(tmp, (size_t)len + 1, format, args);
+    va_end(args);
+    writer_write(w, tmp, (size_t)len);
+    free(tmp);
+}
+
+/**
+ * @brief Flushes and releases the buffer.
+ * @param w The writer
+ * @return 0 on success, -1 if a write failed
+ */
+int writer_close(t_writer *w) {
+    int status = writer_flush(w);
+    free(w->buffer);
+    w->buffer = NULL;
+    w->size = 0;
+    return status;
+}
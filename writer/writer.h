@@ -0,0 +1,96 @@
+#ifndef WRITER_H
+#define WRITER_H
+
+#include <stdio.h>
+#include <stddef.h>
+
+/**
+ * @brief Buffered text output.
+ *
+ * Text is accumulated in a user-space buffer and written to the file with
+ * one fwrite() per buffer, instead of one stdio call per number. The writer
+ * does not own the file. Nothing reaches the file before writer_flush() or
+ * writer_close(), so flush before mixing with other output on the same file.
+ */
+typedef struct s_writer {
+    FILE *file;     // destination
+    char *buffer;   // pending text
+    size_t size;    // capacity of the buffer
+    size_t used;    // number of pending bytes
+    int error;      // 1 once a write failed
+} t_writer;
+
+/**
+ * @brief Initializes a writer.
+ * @param w The writer
+ * @param file Destination file (not owned)
+ * @param size Buffer size in bytes, 0 for the default (64 KiB)
+ * @return 0 on success, -1 on allocation error
+ */
+int writer_init(t_writer *w, FILE *file, size_t size);
+
+/**
+ * @brief Appends raw bytes.
+ * @param w The writer
+ * @param data Bytes to append
+ * @param len Number of bytes
+ */
+void writer_write(t_writer *w, const char *data, size_t len);
+
+/**
+ * @brief Appends a string.
+ * @param w The writer
+ * @param s Null-terminated string
+ */
+void writer_puts(t_writer *w, const char *s);
+
+/**
+ * @brief Appends one character.
+ * @param w The writer
+ * @param c The character
+ */
+void writer_char(t_writer *w, char c);
+
+/**
+ * @brief Appends an integer in decimal, without going through printf.
+ * @param w The writer
+ * @param value The integer
+ */
+void writer_int(t_writer *w, long long value);
+
+/**
+ * @brief Appends a number with a fixed number of decimals, without going
+ *        through printf. Same digits as printf("%.*f") for values read as
+ *        float; falls back to printf for huge values, NaN and infinities.
+ * @param w The writer
+ * @param value The number
+ * @param decimals Number of decimals (0 to 9)
+ */
+void writer_fixed(t_writer *w, double value, int decimals);
+
+/**
+ * @brief Appends formatted text (printf syntax).
+ * @param w The writer
+ * @param format printf format string
+ */
+void writer_printf(t_writer *w, const char *format, ...)
+#if defined(__GNUC__)
+    __attribute__((format(printf, 2, 3)))
+#endif
+    ;
+
+/**
+ * @brief Writes the pending bytes to the file.
+ * @param w The writer
+ * @return 0 on success, -1 if a write failed since the initialization
+ */
+int writer_flush(t_writer *w);
+
+/**
+ * @brief Flushes and releases the buffer.
+ * @param w The writer
+ * @return 0 on success, -1 if a write failed
+ */
+int writer_close(t_writer *w);
+
+#endif //WRITER_H